@@ -0,0 +1,19 @@
+//
+//  allocations.js
+//  libecc
+//
+//  Creates short-lived objects and strings in a tight loop
+//
+
+var count = 300000, sum = 0;
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+{
+	var o = { x: i, y: i };
+	var s = 'n' + i;
+	sum += o.x + s.length;
+}
+
+var time = Date.now() - start;
+print('allocations: ' + count * 2 + ' in ' + time + ' ms, ' + Math.round(count * 2 / time * 1000) + ' per second');
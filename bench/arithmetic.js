@@ -0,0 +1,48 @@
+//
+//  arithmetic.js
+//  libecc
+//
+//  Runs small arithmetic kernels, dominated by op dispatch
+//
+
+function kernel(name, run) {
+	var start = Date.now();
+	var result = run();
+	var time = Date.now() - start;
+	print('arithmetic: ' + name + ' ' + result + ' in ' + time + ' ms');
+}
+
+kernel('integer loop', function () {
+	var sum = 0;
+	for (var i = 0; i < 1000000; ++i)
+		sum = (sum + i * 3) % 1000003;
+	
+	return sum;
+});
+
+kernel('binary loop', function () {
+	var x = 0.5;
+	for (var i = 0; i < 500000; ++i)
+		x = x * 1.000001 + 0.25 / (i + 1);
+	
+	return x.toFixed(6);
+});
+
+kernel('statements', function () {
+	var a = 1, b = 2, c = 3;
+	for (var i = 0; i < 200000; ++i)
+	{
+		if (a > b) a -= b; else a += c;
+		b = b + 1 & 1023;
+		c = c ^ a;
+		if (c < 0) c = -c;
+	}
+	return a + b + c;
+});
+
+kernel('recursion', function () {
+	function fib(n) {
+		return n < 2? n: fib(n - 1) + fib(n - 2);
+	}
+	return fib(24);
+});
@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+#  bytecode.sh
+#  libecc
+#
+#  Compares a build running functions as ops to one running register bytecode
+#
+
+ops=${1:?usage: bytecode.sh <binary> <bytecode binary>}
+bytecode=${2:?usage: bytecode.sh <binary> <bytecode binary>}
+bench=$(dirname "$0")
+
+for binary in "$ops" "$bytecode"; do
+	echo "bytecode: $binary"
+	"$binary" --test-quiet 2>&1 | tail -n 1 | sed 's/^/bytecode: /'
+	"$binary" "$bench/arithmetic.js" || exit 1
+done
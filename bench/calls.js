@@ -0,0 +1,43 @@
+//
+//  calls.js
+//  libecc
+//
+//  Calls functions whose environment lives on the heap: closures, callbacks & arguments
+//
+
+var count = 300000, sum = 0;
+
+function closure (x)
+{
+	function get () { return x; }
+	return get() + 1;
+}
+
+function each (x, f)
+{
+	f(x);
+	f(x + 1);
+}
+
+function callback (x)
+{
+	var k = 2;
+	each(x, function (value) { sum += value * k; });
+}
+
+function args ()
+{
+	return arguments.length;
+}
+
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+{
+	sum += closure(i);
+	callback(i);
+	sum += args(i, i);
+}
+
+var time = Date.now() - start;
+print('calls: ' + count * 3 + ' in ' + time + ' ms, ' + Math.round(count * 3 / time * 1000) + ' per second');
@@ -0,0 +1,16 @@
+//
+//  concat.js
+//  libecc
+//
+//  Builds a long string by appending fragments in a loop
+//
+
+var count = 100000, s = '';
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+	s += 'fragment ' + i + ';';
+
+var check = s.charAt(s.length - 2);
+var time = Date.now() - start;
+print('concat: ' + count + ' fragments, ' + s.length + ' chars (' + check + ') in ' + time + ' ms');
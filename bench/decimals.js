@@ -0,0 +1,62 @@
+//
+//  decimals.js
+//  libecc
+//
+//  Reads back number-heavy JSON and number strings, checking every value
+//  round-trips, then times JSON.parse, Number() and parseFloat
+//
+
+var count = 100000, rounds = 5;
+var values = [], strings = [];
+
+for (var i = 0; i < count; ++i)
+{
+	var value;
+
+	if (i % 3 == 0)
+		value = Math.floor(Math.random() * 1e6);
+	else if (i % 3 == 1)
+		value = Math.round(Math.random() * 1e5) / 100;
+	else
+		value = Math.random() * Math.pow(10, Math.floor(Math.random() * 40) - 20);
+
+	values[i] = value;
+	strings[i] = String(value);
+}
+
+var text = '[' + strings.join(',') + ']';
+var parsed = JSON.parse(text), failures = 0;
+
+for (var i = 0; i < count; ++i)
+	if (parsed[i] !== values[i] || Number(strings[i]) !== values[i] || parseFloat(strings[i]) !== values[i])
+		if (++failures < 10)
+			print('decimals: ' + strings[i] + ' read back as ' + parsed[i]);
+
+print('decimals: ' + count + ' checked, ' + failures + ' failures');
+
+var start = Date.now();
+
+for (var r = 0; r < rounds; ++r)
+	parsed = JSON.parse(text);
+
+var time = Date.now() - start;
+print('decimals: JSON.parse ' + count * rounds + ' numbers in ' + time + ' ms, ' + Math.round(text.length * rounds / 1024 / 1024 / time * 1000) + ' MB per second');
+
+start = Date.now();
+var sum = 0;
+
+for (var r = 0; r < rounds; ++r)
+	for (var i = 0; i < count; ++i)
+		sum += Number(strings[i]);
+
+time = Date.now() - start;
+print('decimals: Number() ' + count * rounds + ' strings in ' + time + ' ms, ' + Math.round(time * 1e6 / (count * rounds)) + ' ns each');
+
+start = Date.now();
+
+for (var r = 0; r < rounds; ++r)
+	for (var i = 0; i < count; ++i)
+		sum += parseFloat(strings[i]);
+
+time = Date.now() - start;
+print('decimals: parseFloat ' + count * rounds + ' strings in ' + time + ' ms, ' + Math.round(time * 1e6 / (count * rounds)) + ' ns each');
@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+#  dispatch.sh
+#  libecc
+#
+#  Compares a build with calls between ops to one with a flat dispatch loop
+#
+
+called=${1:?usage: dispatch.sh <binary> <flat binary>}
+flat=${2:?usage: dispatch.sh <binary> <flat binary>}
+bench=$(dirname "$0")
+
+for binary in "$called" "$flat"; do
+	echo "dispatch: $binary"
+	"$binary" --test-quiet 2>&1 | tail -n 1 | sed 's/^/dispatch: /'
+	"$binary" "$bench/arithmetic.js" || exit 1
+done
@@ -0,0 +1,56 @@
+//
+//  enumerate.js
+//  libecc
+//
+//  Enumerates a large array, a large object and many small objects that inherit enumerable methods
+//
+
+function Point (x, y) { this.x = x; this.y = y; }
+Point.prototype.norm = function () { return this.x * this.x + this.y * this.y; };
+Point.prototype.scale = function (f) { this.x *= f; this.y *= f; };
+
+var size = 1000000, array = new Array(size), object = {}, points = [], i;
+
+for (i = 0; i < size; ++i)
+	array[i] = i;
+
+// object slots are numbered on 16 bits
+for (i = 0; i < 20000; ++i)
+	object['key' + i] = i;
+
+for (i = 0; i < size / 10; ++i)
+	points[i] = new Point(i, i + 1);
+
+function run (name, f)
+{
+	var start = Date.now(), result = f();
+	print('enumerate: ' + name + ' ' + result + ' keys in ' + (Date.now() - start) + ' ms');
+}
+
+run('array', function () {
+	var count = 0, k;
+	for (k in array)
+		++count;
+	
+	return count;
+});
+
+run('object', function () {
+	var count = 0, k;
+	for (k in object)
+		++count;
+	
+	return count;
+});
+
+run('inherited', function () {
+	var count = 0, k, p, i;
+	for (i = 0; i < points.length; ++i)
+	{
+		p = points[i];
+		for (k in p)
+			++count;
+	}
+	
+	return count;
+});
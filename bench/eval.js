@@ -0,0 +1,23 @@
+//
+//  eval.js
+//  libecc
+//
+//  Evaluates the same sources over and over
+//
+
+var count = 100000, sum = 0;
+var start = Date.now();
+
+function square(n) {
+	var k = n;
+	return eval('k * k');
+}
+
+for (var i = 0; i < count; ++i)
+{
+	sum += eval('(i % 7) + (i % 11) * 2');
+	sum += square(i % 13);
+}
+
+var time = Date.now() - start;
+print('eval: ' + count * 2 + ' evals, sum ' + sum + ' in ' + time + ' ms');
@@ -0,0 +1,35 @@
+//
+//  indices.js
+//  libecc
+//
+//  Walks a long non-ASCII string by UTF-16 index
+//
+
+var unit = 'aé€𝄞', s = '';
+for (var i = 0; i < 5000; ++i)
+	s += unit;
+
+var count = s.length, sum = 0;
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+	sum += s.charCodeAt(i) + s.charAt(i).length + s[i].length;
+
+sum += s.slice(count / 2).length + s.substring(count / 4, count / 2).length + s.indexOf('€', count / 2);
+
+var time = Date.now() - start;
+print('indices: ' + count + ' units, sum ' + sum + ' in ' + time + ' ms');
+
+// more strings than a small cache of indices would hold, each indexed in turn
+var strings = Array(33).join(s + '#').split('#');
+strings.pop();
+
+sum = 0;
+start = Date.now();
+
+for (var i = 0; i < count; i += 50)
+	for (var j = 0; j < strings.length; ++j)
+		sum += strings[j].charCodeAt(i);
+
+time = Date.now() - start;
+print('indices: ' + strings.length + ' strings of ' + strings[0].length + ' units in turn, sum ' + sum + ' in ' + time + ' ms');
@@ -0,0 +1,50 @@
+//
+//  json.js
+//  libecc
+//
+//  Parses generated documents of growing size, then stringifies them back
+//
+
+var sizes = [ 1, 10, 100 ];
+
+function record (i)
+{
+	return '{"id":' + i + ',"name":"user ' + i + '","email":"user' + i + '@example.com","active":' + (i % 2? 'true': 'false')
+		+ ',"score":' + (i * 0.25) + ',"tags":["alpha","beta","gamma"],"note":"line\\nbreak \\"quoted\\" \\u00e9"'
+		+ ',"address":{"street":"' + i + ' main street","city":"Springfield","zip":"' + (10000 + i % 90000) + '"}}';
+}
+
+function documentOf (megabytes)
+{
+	var parts = [], length = 0, i = 0, part;
+	
+	while (length < megabytes * 1024 * 1024)
+	{
+		part = record(i++);
+		parts[parts.length] = part;
+		length += part.length + 1;
+	}
+	return { text: '[\n' + parts.join(',\n') + '\n]', count: i };
+}
+
+for (var s = 0; s < sizes.length; ++s)
+{
+	var doc = documentOf(sizes[s]);
+	var start = Date.now();
+	var result = JSON.parse(doc.text);
+	var time = Date.now() - start;
+	
+	if (result.length != doc.count || result[doc.count - 1].address.city != 'Springfield')
+		throw Error('json: wrong result');
+	
+	print('json: ' + sizes[s] + ' MB in ' + time + ' ms, ' + Math.round(doc.text.length / 1024 / 1024 / time * 1000) + ' MB per second');
+	
+	start = Date.now();
+	var text = JSON.stringify(result);
+	time = Date.now() - start;
+	
+	if (JSON.parse(text).length != doc.count)
+		throw Error('json: wrong round trip');
+	
+	print('json: stringify ' + sizes[s] + ' MB in ' + time + ' ms, ' + Math.round(text.length / 1024 / 1024 / time * 1000) + ' MB per second');
+}
@@ -0,0 +1,20 @@
+//
+//  keys.js
+//  libecc
+//
+//  Interns 60k distinct identifiers through computed property access
+//
+
+var count = 60000, object = {}, found = 0;
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+	if (object['key' + i] === undefined)
+		++found;
+
+for (var i = 0; i < count; ++i)
+	if (object['key' + i] === undefined)
+		++found;
+
+var time = Date.now() - start;
+print('keys: ' + count + ' interned, ' + found + ' lookups in ' + time + ' ms');
@@ -0,0 +1,26 @@
+//
+//  members.js
+//  libecc
+//
+//  Reads, writes and calls members of same-layout objects
+//
+
+function Point (x, y) { this.x = x; this.y = y; }
+Point.prototype.norm = function () { return this.x * this.x + this.y * this.y; };
+
+var count = 100, rounds = 3000, points = [], sum = 0;
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+	points[i] = new Point(i, i + 1);
+
+for (var n = 0; n < rounds; ++n)
+	for (var i = 0; i < count; ++i)
+	{
+		var p = points[i];
+		sum += p.x + p.y + p.norm();
+		p.x = p.y;
+	}
+
+var time = Date.now() - start;
+print('members: ' + count * rounds + ' iterations, sum ' + sum + ' in ' + time + ' ms');
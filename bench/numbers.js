@@ -0,0 +1,90 @@
+//
+//  numbers.js
+//  libecc
+//
+//  Checks that numbers convert to their shortest round-trip string,
+//  then times the conversion of doubles and integers
+//
+
+var count = 20000, rounds = 20;
+var values = [], integers = [];
+
+for (var i = 0; i < count; ++i)
+{
+	var exponent = Math.floor(Math.random() * 630) - 322;
+	var value = Math.random() * Math.pow(10, exponent);
+
+	if (i % 4 == 1)
+		value = Math.round(Math.random() * 1e6) / 1000;
+	else if (i % 4 == 2)
+		value = -value;
+
+	values[i] = value;
+	integers[i] = (Math.random() * 2147483647) | 0;
+}
+
+// the shortest digits that read back, and the closest of those: what a
+// correctly rounded toPrecision gives at that digit count
+
+function digitCount (s)
+{
+	var digits = 0, leading = 1;
+
+	for (var c = 0; c < s.length; ++c)
+	{
+		var ch = s.charAt(c);
+
+		if (ch == 'e')
+			break;
+		else if (ch >= '0' && ch <= '9' && !(leading && ch == '0'))
+		{
+			leading = 0;
+			++digits;
+		}
+	}
+
+	// integer output is not shortened to its significant digits
+	if (s.indexOf('.') < 0 && s.indexOf('e') < 0)
+		while (s.charAt(s.length - 1) == '0' && digits > 1)
+		{
+			s = s.substring(0, s.length - 1);
+			--digits;
+		}
+
+	return digits;
+}
+
+var failures = 0;
+
+for (var i = 0; i < count; ++i)
+{
+	var value = values[i], s = String(value), digits = digitCount(s);
+
+	if (Number(s) !== value
+		|| Number(value.toPrecision(digits)) !== value
+		|| (digits > 1 && Number(value.toPrecision(digits - 1)) === value))
+	{
+		if (++failures < 10)
+			print('numbers: ' + value.toPrecision(17) + ' gave ' + s);
+	}
+}
+
+print('numbers: ' + count + ' checked, ' + failures + ' failures');
+
+var start = Date.now(), length = 0;
+
+for (var r = 0; r < rounds; ++r)
+	for (var i = 0; i < count; ++i)
+		length += ('' + values[i]).length;
+
+var time = Date.now() - start;
+print('numbers: ' + count * rounds + ' doubles in ' + time + ' ms, ' + Math.round(time * 1e6 / (count * rounds)) + ' ns each');
+
+start = Date.now();
+
+for (var r = 0; r < rounds; ++r)
+	for (var i = 0; i < count; ++i)
+		length += ('' + integers[i]).length;
+
+time = Date.now() - start;
+print('numbers: ' + count * rounds + ' integers in ' + time + ' ms, ' + Math.round(time * 1e6 / (count * rounds)) + ' ns each');
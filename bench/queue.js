@@ -0,0 +1,29 @@
+//
+//  queue.js
+//  libecc
+//
+//  Runs a work queue through shift and push, then a deque through unshift and splice
+//
+
+var count = 100000, queue = [], sum = 0;
+var start = Date.now();
+
+for (var i = 0; i < count; ++i)
+	queue.push(i);
+
+while (queue.length)
+{
+	var item = queue.shift();
+	sum += item;
+	if (item % 3 == 0)
+		queue.push(item + 1);
+}
+
+for (var i = 0; i < count; ++i)
+	queue.unshift(i);
+
+while (queue.length > 1)
+	sum += queue.splice(1, 1)[0];
+
+var time = Date.now() - start;
+print('queue: ' + count + ' items, sum ' + sum + ' in ' + time + ' ms');
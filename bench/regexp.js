@@ -0,0 +1,69 @@
+//
+//  regexp.js
+//  libecc
+//
+//  Runs literal, class and alternation patterns over generated text,
+//  checking the match counts, then times them in MB per second
+//
+
+var words = ['quick', 'brown', 'fox', 'jumps', 'over', 'lazy', 'dog', 'lorem', 'ipsum', 'dolor'];
+var text = '', needles = 0, sizes = 0, mails = 0, foxes = 0;
+
+for (var i = 0; i < 6000; ++i)
+{
+	var k = (i * 7919) % 97;
+	
+	if (k < 3)
+	{
+		text += 'needle ';
+		++needles;
+	}
+	else if (k < 10)
+	{
+		text += (i % 300) + 'px ';
+		++sizes;
+	}
+	else if (k < 14)
+	{
+		text += words[i % 10] + '@' + words[(i + 3) % 10] + '.com ';
+		++mails;
+		foxes += (i % 10 == 2 || i % 10 == 6) + ((i + 3) % 10 == 2 || (i + 3) % 10 == 6);
+	}
+	else
+	{
+		text += words[i % 10] + ' ';
+		foxes += i % 10 == 2 || i % 10 == 6;
+	}
+}
+
+var rounds = 10;
+var ab = '';
+while (ab.length < 6000)
+	ab += 'ab';
+
+function count (regexp, input)
+{
+	var n = 0;
+	input.replace(regexp, function () { ++n; return ''; });
+	return n;
+}
+
+function run (name, regexp, input, expect)
+{
+	var n = count(regexp, input), start = Date.now(), time;
+	
+	if (n != expect)
+		print('regexp: ' + name + ' found ' + n + ' instead of ' + expect);
+	
+	for (var r = 0; r < rounds; ++r)
+		count(regexp, input);
+	
+	time = Date.now() - start;
+	print('regexp: ' + name + ' ' + rounds + ' rounds in ' + time + ' ms, ' + Math.round(input.length * rounds / 1024 / 1024 / time * 1000) + ' MB per second');
+}
+
+run('literal', /needle/g, text, needles);
+run('required', /\d+px/g, text, sizes);
+run('captures', /(\w+)@(\w+)\.com/g, text, mails);
+run('alternation', /(?:fox|dog|cat)s?\b/g, text, foxes);
+run('backtracking', /(a|b)*[cd]/, ab, 0);
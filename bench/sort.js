@@ -0,0 +1,39 @@
+//
+//  sort.js
+//  libecc
+//
+//  Sorts a million numbers and strings, by default order and by comparator
+//
+
+var count = 1000000, numbers = [], strings = [], seed = 1;
+
+for (var i = 0; i < count; ++i)
+{
+	seed = (seed * 1103515245 + 12345) % 2147483648;
+	numbers.push(seed % 1000000);
+	strings.push('key' + (seed % 100000));
+}
+
+function check (name, array, less)
+{
+	for (var i = 1; i < array.length; ++i)
+		if (less(array[i], array[i - 1]))
+			print('sort: ' + name + ' out of order at ' + i);
+}
+
+function run (name, array, comparator, less)
+{
+	var start = Date.now(), time;
+	
+	array = array.slice();
+	array.sort(comparator);
+	time = Date.now() - start;
+	
+	check(name, array, less);
+	print('sort: ' + name + ' ' + array.length + ' items in ' + time + ' ms');
+}
+
+run('numbers', numbers, undefined, function (a, b) { return String(a) < String(b); });
+run('numbers by comparator', numbers, function (a, b) { return a - b; }, function (a, b) { return a < b; });
+run('strings', strings, undefined, function (a, b) { return a < b; });
+run('strings by comparator', strings, function (a, b) { return a < b? -1: a > b? 1: 0; }, function (a, b) { return a < b; });
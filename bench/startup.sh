@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+#  startup.sh
+#  libecc
+#
+#  Compares cold starts of a large bundle, from source and from a snapshot
+#
+
+binary=${1:-ecc}
+count=${2:-20000}
+directory=$(mktemp -d)
+trap 'rm -rf "$directory"' EXIT
+
+awk -v count=$count 'BEGIN {
+	for (i = 0; i < count; ++i)
+		printf "function f%d(a, b) { var t = a * %d + b; if (t > 10) return [t, \"s%d\", { k: t }]; return t %% 7; }\n", i, i, i;
+	print "print(\"startup: \" + f" count - 1 "(1, 2)[1]);";
+}' > "$directory/bundle.js"
+
+"$binary" --compile "$directory/bundle.js" "$directory/bundle.snap" || exit 1
+
+run () {
+	start=$(date +%s%N)
+	for run in 1 2 3 4 5; do "$binary" "$@" > /dev/null || exit 1; done
+	echo $(( ($(date +%s%N) - start) / 5000000 ))
+}
+
+source=$(run "$directory/bundle.js")
+snapshot=$(run --compiled "$directory/bundle.snap")
+echo "startup: $count functions, source in $source ms, snapshot in $snapshot ms"
@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+#  threads.sh
+#  libecc
+#
+#  Runs one script in 1 to 8 runtimes at once, each on its own thread
+#
+
+binary=${1:-ecc}
+script=${2:-$(dirname "$0")/members.js}
+
+for count in 1 2 4 8; do
+	start=$(date +%s%N)
+	"$binary" --threads $count "$script" > /dev/null || exit 1
+	elapsed=$(( ($(date +%s%N) - start) / 1000000 ))
+	echo "threads: $count x $(basename "$script") in $elapsed ms, $(( elapsed / count )) ms per run"
+done
@@ -0,0 +1,58 @@
+//
+//  try.js
+//  libecc
+//
+//  Enters try blocks on every iteration of loops that never throw, then of one that always does
+//
+
+var count = 1000000;
+
+function plain ()
+{
+	var sum = 0;
+	for (var i = 0; i < count; ++i)
+		sum += i;
+	
+	return sum;
+}
+
+function guarded ()
+{
+	var sum = 0;
+	for (var i = 0; i < count; ++i)
+		try { sum += i; }
+		catch (e) { sum = 0; }
+	
+	return sum;
+}
+
+function nested ()
+{
+	var sum = 0;
+	for (var i = 0; i < count; ++i)
+		try { try { sum += i; } finally { ++sum; } }
+		catch (e) { sum = 0; }
+	
+	return sum;
+}
+
+function throwing ()
+{
+	var sum = 0;
+	for (var i = 0; i < count / 10; ++i)
+		try { throw i; }
+		catch (e) { sum += e; }
+	
+	return sum;
+}
+
+function run (name, f)
+{
+	var start = Date.now(), result = f();
+	print('try: ' + name + ' ' + result + ' in ' + (Date.now() - start) + ' ms');
+}
+
+run('plain', plain);
+run('guarded', guarded);
+run('nested', nested);
+run('throwing', throwing);
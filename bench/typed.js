@@ -0,0 +1,29 @@
+//
+//  typed.js
+//  libecc
+//
+//  Fills and sums a million numbers held in a plain array and in typed arrays
+//
+
+var count = 1000000;
+
+function run (name, array)
+{
+	var start = Date.now(), sum = 0, i;
+	
+	for (i = 0; i < count; ++i)
+		array[i] = i * 0.5;
+	
+	for (i = 0; i < count; ++i)
+		array[i] += 1;
+	
+	for (i = 0; i < count; ++i)
+		sum += array[i];
+	
+	print('typed: ' + name + ' ' + count + ' items in ' + (Date.now() - start) + ' ms, sum ' + sum);
+}
+
+run('Array', new Array(count));
+run('Float64Array', new Float64Array(count));
+run('Float32Array', new Float32Array(count));
+run('Int32Array', new Int32Array(count));
@@ -17,7 +17,7 @@
 
 	#include "global.h"
 
-	extern struct Object * Arguments(prototype);
+	extern Ecc(threadlocal) struct Object * Arguments(prototype);
 	extern const struct Object(Type) Arguments(type);
 
 #endif
@@ -12,11 +12,12 @@
 #include "../ecc.h"
 #include "../op.h"
 #include "../oplist.h"
+#include "../pool.h"
 
 // MARK: - Private
 
-struct Object * Array(prototype) = NULL;
-struct Function * Array(constructor) = NULL;
+Ecc(threadlocal) struct Object * Array(prototype) = NULL;
+Ecc(threadlocal) struct Function * Array(constructor) = NULL;
 
 const struct Object(Type) Array(type) = {
 	.text = &Text(arrayType),
@@ -24,6 +25,19 @@ const struct Object(Type) Array(type) = {
 
 // MARK: - Static Members
 
+static
+struct Value retain (struct Value value)
+{
+	// values stored into an existing object must outlive the loop collecting around the call
+	
+	if (value.type == Value(charsType))
+		++value.data.chars->referenceCount;
+	if (value.type >= Value(objectType))
+		++value.data.object->referenceCount;
+	
+	return value;
+}
+
 static
 int valueIsArray (struct Value value)
 {
@@ -63,6 +77,28 @@ void objectResize (struct Context * const context, struct Object *object, uint32
 		Object.putMember(context, object, Key(length), Value.binary(length));
 }
 
+static
+int objectIsPlain (struct Object *object)
+{
+	struct Object *prototype;
+	
+	// elements of a plain array can move as they are:
+	// none has an accessor or a flag to honour, none is looked up along the prototypes
+	
+	if (object->type != &Array(type)
+		|| object->flags & (Object(sealed) | Object(flaggedElement))
+		|| object->elementCount > object->elementCapacity
+		|| object->elementCount > Object(ElementMax)
+		)
+		return 0;
+	
+	for (prototype = object->prototype; prototype; prototype = prototype->prototype)
+		if (prototype->elementCount)
+			return 0;
+	
+	return 1;
+}
+
 static
 void valueAppendFromElement (struct Context * const context, struct Value value, struct Object *object, uint32_t *element)
 {
@@ -206,11 +242,11 @@ struct Value push (struct Context * const context)
 	objectResize(context, this, length);
 	
 	for (index = base; index < length; ++index)
-		Object.putElement(context, this, index, Context.argument(context, index - base));
+		Object.putElement(context, this, index, retain(Context.argument(context, index - base)));
 	
 	if (UINT32_MAX - base < count)
 	{
-		Object.putElement(context, this, index, Context.argument(context, index - base));
+		Object.putElement(context, this, index, retain(Context.argument(context, index - base)));
 		
 		if (this->type == &Array(type))
 			Context.rangeError(context, Chars.create("max length exeeded"));
@@ -218,7 +254,7 @@ struct Value push (struct Context * const context)
 		{
 			double index, length = (double)base + count;
 			for (index = (double)UINT32_MAX + 1; index < length; ++index)
-				Object.putProperty(context, this, Value.binary(index), Context.argument(context, index - base));
+				Object.putProperty(context, this, Value.binary(index), retain(Context.argument(context, index - base)));
 			
 			Object.putMember(context, this, Key(length), Value.binary(length));
 			return Value.binary(length);
@@ -265,6 +301,13 @@ struct Value shift (struct Context * const context)
 	
 	Context.setTextIndex(context, Context(callIndex));
 	
+	if (length && objectIsPlain(this))
+	{
+		result = this->element[0].value.check == 1? this->element[0].value: Value(undefined);
+		Object.shiftElement(this, 1);
+		return result;
+	}
+	
 	if (length)
 	{
 		length--;
@@ -296,6 +339,16 @@ struct Value unshift (struct Context * const context)
 	this = Value.toObject(context, Context.this(context)).data.object;
 	count = Context.argumentCount(context);
 	
+	if (objectIsPlain(this) && this->elementCount + count <= Object(ElementMax))
+	{
+		Object.unshiftElement(this, count);
+		
+		for (index = 0; index < count; ++index)
+			Object.putElement(context, this, index, retain(Context.argument(context, index)));
+		
+		return Value.binary(this->elementCount);
+	}
+	
 	length = objectLength(context, this) + count;
 	objectResize(context, this, length);
 	
@@ -305,7 +358,7 @@ struct Value unshift (struct Context * const context)
 		Object.putElement(context, this, index, Object.getElement(context, this, index - count));
 	
 	for (index = 0; index < count; ++index)
-		Object.putElement(context, this, index, Context.argument(context, index));
+		Object.putElement(context, this, index, retain(Context.argument(context, index)));
 	
 	return Value.binary(length);
 }
@@ -359,7 +412,7 @@ struct Compare {
 	struct Context context;
 	struct Function * function;
 	struct Object * arguments;
-	const struct Op * ops;
+	struct Op * ops;
 };
 
 static
@@ -454,7 +507,7 @@ int compare (struct Compare *cmp, struct Value left, struct Value right)
 	cmp->arguments->element[0].value = left;
 	cmp->arguments->element[1].value = right;
 	
-	return Value.toInteger(&cmp->context, cmp->context.ops->native(&cmp->context)).data.integer < 0;
+	return Value.toInteger(&cmp->context, Op.dispatch(&cmp->context)).data.integer < 0;
 }
 
 static inline
@@ -549,11 +602,588 @@ void sortAndMerge(struct Object *object, struct Compare *cmp, uint32_t first, ui
 	merge(object, cmp, first, half, last, half - first, last - half);
 }
 
+// dense arrays are sorted as a copy of their values by timsort,
+// the default comparison on string keys made once per element
+
+enum {
+	sortMinGallop = 7,
+	sortRunCapacity = 64,
+};
+
+struct Sorted {
+	struct Value value;
+	struct Value key;
+};
+
+struct Run {
+	uint32_t base;
+	uint32_t length;
+};
+
+struct TimSort {
+	struct Compare *cmp;
+	struct Sorted *items;
+	struct Sorted *buffer;
+	uint32_t bufferCapacity;
+	int32_t minGallop;
+	struct Run runs[sortRunCapacity];
+	int runCount;
+};
+
+static inline
+int sortedLess (struct TimSort *sort, const struct Sorted *a, const struct Sorted *b)
+{
+	int32_t aLength, bLength;
+	int result;
+	
+	if (sort->cmp->function)
+		return compare(sort->cmp, a->value, b->value);
+	
+	aLength = Value.stringLength(&a->key);
+	bLength = Value.stringLength(&b->key);
+	result = memcmp(Value.stringBytes(&a->key), Value.stringBytes(&b->key), aLength < bLength? aLength: bLength);
+	
+	return result < 0 || (!result && aLength < bLength);
+}
+
+static
+uint32_t countRun (struct TimSort *sort, uint32_t first, uint32_t last)
+{
+	struct Sorted *items = sort->items, swap;
+	uint32_t next = first + 1, a, b;
+	
+	if (next == last)
+		return 1;
+	
+	if (sortedLess(sort, &items[next], &items[first]))
+	{
+		// strictly descending only, reversing keeps equal items in order
+		while (++next < last && sortedLess(sort, &items[next], &items[next - 1]));
+		
+		for (a = first, b = next - 1; a < b; ++a, --b)
+			swap = items[a], items[a] = items[b], items[b] = swap;
+	}
+	else
+		while (++next < last && !sortedLess(sort, &items[next], &items[next - 1]));
+	
+	return next - first;
+}
+
+static
+void insertionSort (struct TimSort *sort, uint32_t first, uint32_t last, uint32_t start)
+{
+	struct Sorted *items = sort->items, pivot;
+	uint32_t left, right, half;
+	
+	for (; start < last; ++start)
+	{
+		pivot = items[start];
+		left = first;
+		right = start;
+		
+		while (left < right)
+		{
+			half = (left + right) >> 1;
+			if (sortedLess(sort, &pivot, &items[half]))
+				right = half;
+			else
+				left = half + 1;
+		}
+		
+		memmove(items + left + 1, items + left, sizeof(*items) * (start - left));
+		items[left] = pivot;
+	}
+}
+
+static
+uint32_t gallopLeft (struct TimSort *sort, const struct Sorted *key, const struct Sorted *items, int32_t length, int32_t hint)
+{
+	int32_t last = 0, offset = 1, limit, half, swap;
+	
+	// first index whose item is not less than key
+	
+	if (sortedLess(sort, &items[hint], key))
+	{
+		limit = length - hint;
+		while (offset < limit && sortedLess(sort, &items[hint + offset], key))
+		{
+			last = offset;
+			offset = (offset << 1) + 1;
+			if (offset <= 0)
+				offset = limit;
+		}
+		if (offset > limit)
+			offset = limit;
+		
+		last += hint;
+		offset += hint;
+	}
+	else
+	{
+		limit = hint + 1;
+		while (offset < limit && !sortedLess(sort, &items[hint - offset], key))
+		{
+			last = offset;
+			offset = (offset << 1) + 1;
+			if (offset <= 0)
+				offset = limit;
+		}
+		if (offset > limit)
+			offset = limit;
+		
+		swap = last;
+		last = hint - offset;
+		offset = hint - swap;
+	}
+	
+	++last;
+	while (last < offset)
+	{
+		half = last + ((offset - last) >> 1);
+		if (sortedLess(sort, &items[half], key))
+			last = half + 1;
+		else
+			offset = half;
+	}
+	return offset;
+}
+
+static
+uint32_t gallopRight (struct TimSort *sort, const struct Sorted *key, const struct Sorted *items, int32_t length, int32_t hint)
+{
+	int32_t last = 0, offset = 1, limit, half, swap;
+	
+	// first index whose item is greater than key
+	
+	if (sortedLess(sort, key, &items[hint]))
+	{
+		limit = hint + 1;
+		while (offset < limit && sortedLess(sort, key, &items[hint - offset]))
+		{
+			last = offset;
+			offset = (offset << 1) + 1;
+			if (offset <= 0)
+				offset = limit;
+		}
+		if (offset > limit)
+			offset = limit;
+		
+		swap = last;
+		last = hint - offset;
+		offset = hint - swap;
+	}
+	else
+	{
+		limit = length - hint;
+		while (offset < limit && !sortedLess(sort, key, &items[hint + offset]))
+		{
+			last = offset;
+			offset = (offset << 1) + 1;
+			if (offset <= 0)
+				offset = limit;
+		}
+		if (offset > limit)
+			offset = limit;
+		
+		last += hint;
+		offset += hint;
+	}
+	
+	++last;
+	while (last < offset)
+	{
+		half = last + ((offset - last) >> 1);
+		if (sortedLess(sort, key, &items[half]))
+			offset = half;
+		else
+			last = half + 1;
+	}
+	return offset;
+}
+
+static
+struct Sorted * reserveBuffer (struct TimSort *sort, uint32_t count)
+{
+	if (sort->bufferCapacity < count)
+	{
+		sort->bufferCapacity = count;
+		sort->buffer = realloc(sort->buffer, sizeof(*sort->buffer) * count);
+	}
+	return sort->buffer;
+}
+
+static
+void mergeLow (struct TimSort *sort, uint32_t base1, uint32_t length1, uint32_t base2, uint32_t length2)
+{
+	struct Sorted *items = sort->items, *buffer = reserveBuffer(sort, length1);
+	uint32_t cursor1 = 0, cursor2 = base2, target = base1, count1, count2;
+	int32_t minGallop = sort->minGallop;
+	
+	// the first run moves to the buffer, both merge from the left
+	
+	memcpy(buffer, items + base1, sizeof(*items) * length1);
+	items[target++] = items[cursor2++];
+	
+	if (--length2 == 0)
+		goto done;
+	
+	if (length1 == 1)
+		goto done;
+	
+	for (;;)
+	{
+		count1 = count2 = 0;
+		
+		do
+		{
+			if (sortedLess(sort, &items[cursor2], &buffer[cursor1]))
+			{
+				items[target++] = items[cursor2++];
+				++count2;
+				count1 = 0;
+				if (--length2 == 0)
+					goto done;
+			}
+			else
+			{
+				items[target++] = buffer[cursor1++];
+				++count1;
+				count2 = 0;
+				if (--length1 == 1)
+					goto done;
+			}
+		}
+		while ((count1 | count2) < (uint32_t)minGallop);
+		
+		do
+		{
+			if (( count1 = gallopRight(sort, &items[cursor2], buffer + cursor1, length1, 0) ))
+			{
+				memcpy(items + target, buffer + cursor1, sizeof(*items) * count1);
+				target += count1;
+				cursor1 += count1;
+				length1 -= count1;
+				if (length1 <= 1)
+					goto done;
+			}
+			
+			items[target++] = items[cursor2++];
+			if (--length2 == 0)
+				goto done;
+			
+			if (( count2 = gallopLeft(sort, &buffer[cursor1], items + cursor2, length2, 0) ))
+			{
+				memmove(items + target, items + cursor2, sizeof(*items) * count2);
+				target += count2;
+				cursor2 += count2;
+				length2 -= count2;
+				if (length2 == 0)
+					goto done;
+			}
+			
+			items[target++] = buffer[cursor1++];
+			if (--length1 == 1)
+				goto done;
+			
+			--minGallop;
+		}
+		while (count1 >= sortMinGallop || count2 >= sortMinGallop);
+		
+		if (minGallop < 0)
+			minGallop = 0;
+		
+		minGallop += 2;
+	}
+	
+done:
+	sort->minGallop = minGallop < 1? 1: minGallop;
+	
+	if (length1 == 1 && length2)
+	{
+		memmove(items + target, items + cursor2, sizeof(*items) * length2);
+		items[target + length2] = buffer[cursor1];
+	}
+	else if (length1)
+		memcpy(items + target, buffer + cursor1, sizeof(*items) * length1);
+}
+
+static
+void mergeHigh (struct TimSort *sort, uint32_t base1, uint32_t length1, uint32_t base2, uint32_t length2)
+{
+	struct Sorted *items = sort->items, *buffer = reserveBuffer(sort, length2);
+	int32_t cursor1 = base1 + length1 - 1, cursor2 = length2 - 1, target = base2 + length2 - 1;
+	uint32_t count1, count2;
+	int32_t minGallop = sort->minGallop;
+	
+	// the second run moves to the buffer, both merge from the right
+	
+	memcpy(buffer, items + base2, sizeof(*items) * length2);
+	items[target--] = items[cursor1--];
+	
+	if (--length1 == 0)
+		goto done;
+	
+	if (length2 == 1)
+		goto done;
+	
+	for (;;)
+	{
+		count1 = count2 = 0;
+		
+		do
+		{
+			if (sortedLess(sort, &buffer[cursor2], &items[cursor1]))
+			{
+				items[target--] = items[cursor1--];
+				++count1;
+				count2 = 0;
+				if (--length1 == 0)
+					goto done;
+			}
+			else
+			{
+				items[target--] = buffer[cursor2--];
+				++count2;
+				count1 = 0;
+				if (--length2 == 1)
+					goto done;
+			}
+		}
+		while ((count1 | count2) < (uint32_t)minGallop);
+		
+		do
+		{
+			if (( count1 = length1 - gallopRight(sort, &buffer[cursor2], items + base1, length1, length1 - 1) ))
+			{
+				target -= count1;
+				cursor1 -= count1;
+				length1 -= count1;
+				memmove(items + target + 1, items + cursor1 + 1, sizeof(*items) * count1);
+				if (length1 == 0)
+					goto done;
+			}
+			
+			items[target--] = buffer[cursor2--];
+			if (--length2 == 1)
+				goto done;
+			
+			if (( count2 = length2 - gallopLeft(sort, &items[cursor1], buffer, length2, length2 - 1) ))
+			{
+				target -= count2;
+				cursor2 -= count2;
+				length2 -= count2;
+				memcpy(items + target + 1, buffer + cursor2 + 1, sizeof(*items) * count2);
+				if (length2 <= 1)
+					goto done;
+			}
+			
+			items[target--] = items[cursor1--];
+			if (--length1 == 0)
+				goto done;
+			
+			--minGallop;
+		}
+		while (count1 >= sortMinGallop || count2 >= sortMinGallop);
+		
+		if (minGallop < 0)
+			minGallop = 0;
+		
+		minGallop += 2;
+	}
+	
+done:
+	sort->minGallop = minGallop < 1? 1: minGallop;
+	
+	if (length2 == 1 && length1)
+	{
+		target -= length1;
+		cursor1 -= length1;
+		memmove(items + target + 1, items + cursor1 + 1, sizeof(*items) * length1);
+		items[target] = buffer[cursor2];
+	}
+	else if (length2)
+		memcpy(items + target - (length2 - 1), buffer, sizeof(*items) * length2);
+}
+
+static
+void mergeAt (struct TimSort *sort, int index)
+{
+	struct Sorted *items = sort->items;
+	uint32_t base1 = sort->runs[index].base, length1 = sort->runs[index].length;
+	uint32_t base2 = sort->runs[index + 1].base, length2 = sort->runs[index + 1].length, skip;
+	
+	sort->runs[index].length = length1 + length2;
+	if (index == sort->runCount - 3)
+		sort->runs[index + 1] = sort->runs[index + 2];
+	
+	--sort->runCount;
+	
+	// items of a run already in place around the other are left out of the merge
+	
+	skip = gallopRight(sort, &items[base2], items + base1, length1, 0);
+	base1 += skip;
+	length1 -= skip;
+	if (!length1)
+		return;
+	
+	length2 = gallopLeft(sort, &items[base1 + length1 - 1], items + base2, length2, length2 - 1);
+	if (!length2)
+		return;
+	
+	if (length1 <= length2)
+		mergeLow(sort, base1, length1, base2, length2);
+	else
+		mergeHigh(sort, base1, length1, base2, length2);
+}
+
+static
+void mergeCollapse (struct TimSort *sort)
+{
+	struct Run *runs = sort->runs;
+	int index;
+	
+	// run lengths shrink at least as fast as fibonacci down the stack
+	
+	while (sort->runCount > 1)
+	{
+		index = sort->runCount - 2;
+		
+		if ((index > 0 && runs[index - 1].length <= runs[index].length + runs[index + 1].length)
+			|| (index > 1 && runs[index - 2].length <= runs[index - 1].length + runs[index].length))
+		{
+			if (runs[index - 1].length < runs[index + 1].length)
+				--index;
+		}
+		else if (runs[index].length > runs[index + 1].length)
+			break;
+		
+		mergeAt(sort, index);
+	}
+}
+
+static
+void timSort (struct TimSort *sort, uint32_t count)
+{
+	uint32_t first = 0, length, forced, minRun = count, rest = 0;
+	
+	while (minRun >= 64)
+	{
+		rest |= minRun & 1;
+		minRun >>= 1;
+	}
+	minRun += rest;
+	
+	while (first < count)
+	{
+		length = countRun(sort, first, count);
+		
+		if (length < minRun)
+		{
+			forced = count - first < minRun? count - first: minRun;
+			insertionSort(sort, first, first + forced, first + length);
+			length = forced;
+		}
+		
+		sort->runs[sort->runCount].base = first;
+		sort->runs[sort->runCount].length = length;
+		++sort->runCount;
+		mergeCollapse(sort);
+		
+		first += length;
+	}
+	
+	while (sort->runCount > 1)
+		mergeAt(sort, sort->runCount > 2 && sort->runs[sort->runCount - 3].length < sort->runs[sort->runCount - 1].length? sort->runCount - 3: sort->runCount - 2);
+}
+
+Ecc(useframe)
+static
+void sortDense (struct Object *object, struct Compare *cmp)
+{
+	struct TimSort sort = { cmp, NULL, NULL, 0, sortMinGallop };
+	struct Ecc *ecc = cmp->context.ecc;
+	uint32_t index, count = object->elementCount, defined = 0, undefined = 0;
+	struct Value value;
+	
+	// holes go last and undefined before them, neither is compared
+	
+	sort.items = malloc(sizeof(*sort.items) * count);
+	
+	// a comparison or a key conversion may throw: free the copy on the way out
+	if (setjmp(*Ecc.pushEnv(ecc)))
+	{
+		Ecc.popEnv(ecc);
+		free(sort.buffer), sort.buffer = NULL;
+		free(sort.items), sort.items = NULL;
+		Context.throw(cmp->context.parent, ecc->result);
+	}
+	
+	for (index = 0; index < count; ++index)
+	{
+		value = object->element[index].value;
+		if (value.check != 1)
+			continue;
+		else if (value.type == Value(undefinedType))
+			++undefined;
+		else
+			sort.items[defined++].value = value;
+	}
+	
+	if (!cmp->function)
+		for (index = 0; index < defined; ++index)
+		{
+			value = sort.items[index].value;
+			sort.items[index].key = Value.isString(value)? value: Value.toString(&cmp->context, value);
+		}
+	
+	timSort(&sort, defined);
+	
+	// a comparison may have changed the array meanwhile
+	
+	if (objectIsPlain(object) && object->elementCount == count)
+	{
+		for (index = 0; index < defined; ++index)
+		{
+			Pool.writeBarrier(sort.items[index].value);
+			object->element[index].value = sort.items[index].value;
+		}
+		
+		for (; index < defined + undefined; ++index)
+			object->element[index].value = Value(undefined);
+		
+		memset(object->element + index, 0, sizeof(*object->element) * (count - index));
+	}
+	else
+	{
+		for (index = 0; index < defined; ++index)
+			Object.putElement(&cmp->context, object, index, sort.items[index].value);
+		
+		for (; index < defined + undefined; ++index)
+			Object.putElement(&cmp->context, object, index, Value(undefined));
+		
+		for (; index < count; ++index)
+			Object.deleteElement(object, index);
+	}
+	
+	Ecc.popEnv(ecc);
+	free(sort.buffer), sort.buffer = NULL;
+	free(sort.items), sort.items = NULL;
+}
+
+static
+void sortObject (struct Object *object, struct Compare *cmp, uint32_t first, uint32_t last)
+{
+	if (!first && last > 1 && last == object->elementCount && objectIsPlain(object))
+		sortDense(object, cmp);
+	else
+		sortAndMerge(object, cmp, first, last);
+}
+
 static
 void sortInPlace (struct Context * const context, struct Object *object, struct Function *function, int first, int last)
 {
 	struct Op defaultOps = { defaultComparison, Value(undefined), Text(nativeCode) };
-	const struct Op * ops = function? function->oplist->ops: &defaultOps;
+	struct Op * ops = function? function->oplist->ops: &defaultOps;
 	
 	struct Compare cmp = {
 		{
@@ -571,7 +1201,7 @@ void sortInPlace (struct Context * const context, struct Object *object, struct
 	
 	if (function && function->flags & Function(needHeap))
 	{
-		struct Object *environment = Object.copy(&function->environment);
+		struct Object *environment = Object.copyEnvironment(&function->environment);
 		
 		cmp.context.environment = environment;
 		cmp.arguments = Arguments.createSized(2);
@@ -579,7 +1209,7 @@ void sortInPlace (struct Context * const context, struct Object *object, struct
 		
 		environment->hashmap[2].value = Value.object(cmp.arguments);
 		
-		sortAndMerge(object, &cmp, first, last);
+		sortObject(object, &cmp, first, last);
 	}
 	else
 	{
@@ -601,7 +1231,7 @@ void sortInPlace (struct Context * const context, struct Object *object, struct
 		environment.hashmap = hashmap;
 		environment.hashmap[2].value = Value.object(&arguments);
 		
-		sortAndMerge(object, &cmp, first, last);
+		sortObject(object, &cmp, first, last);
 	}
 }
 
@@ -666,6 +1296,45 @@ struct Value splice (struct Context * const context)
 	if (count > 2)
 		add = count - 2;
 	
+	if (objectIsPlain(this) && length - delete + add <= Object(ElementMax))
+	{
+		result = Array.createSized(delete);
+		if (delete)
+			memcpy(result->element, this->element + start, sizeof(*this->element) * delete);
+		
+		// the shorter side moves: the head by shifting the array, or the tail
+		if (start < length - start - delete)
+		{
+			if (delete > add)
+			{
+				memmove(this->element + delete - add, this->element, sizeof(*this->element) * start);
+				Object.shiftElement(this, delete - add);
+			}
+			else if (delete < add)
+			{
+				Object.unshiftElement(this, add - delete);
+				memmove(this->element, this->element + add - delete, sizeof(*this->element) * start);
+			}
+		}
+		else if (delete != add)
+		{
+			if (delete < add)
+				Object.resizeElement(this, length - delete + add);
+			
+			memmove(this->element + start + add, this->element + start + delete, sizeof(*this->element) * (length - start - delete));
+			
+			if (delete > add)
+				Object.resizeElement(this, length - delete + add);
+		}
+		
+		memset(this->element + start, 0, sizeof(*this->element) * add);
+		
+		for (from = 2, to = start; from < count; ++from, ++to)
+			Object.putElement(context, this, to, retain(Context.argument(context, from)));
+		
+		return Value.object(result);
+	}
+	
 	if (length - delete + add > length)
 		objectResize(context, this, length - delete + add);
 	
@@ -687,7 +1356,7 @@ struct Value splice (struct Context * const context)
 			Object.putElement(context, this, --to, Object.getElement(context, this, --from));
 	
 	for (from = 2, to = start; from < count; ++from, ++to)
-		Object.putElement(context, this, to, Context.argument(context, from));
+		Object.putElement(context, this, to, retain(Context.argument(context, from)));
 	
 	if (length - delete + add <= length)
 		objectResize(context, this, length - delete + add);
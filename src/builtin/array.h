@@ -17,8 +17,8 @@
 
 	#include "global.h"
 
-	extern struct Object * Array(prototype);
-	extern struct Function * Array(constructor);
+	extern Ecc(threadlocal) struct Object * Array(prototype);
+	extern Ecc(threadlocal) struct Function * Array(constructor);
 	extern const struct Object(Type) Array(type);
 
 #endif
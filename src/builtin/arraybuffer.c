@@ -0,0 +1,175 @@
+//
+//  arraybuffer.c
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#define Implementation
+#include "arraybuffer.h"
+
+#include "../pool.h"
+
+// MARK: - Private
+
+static void finalize (struct Object *object);
+
+Ecc(threadlocal) struct Object * ArrayBuffer(prototype) = NULL;
+Ecc(threadlocal) struct Function * ArrayBuffer(constructor) = NULL;
+
+const struct Object(Type) ArrayBuffer(type) = {
+	.text = &Text(arrayBufferType),
+	.finalize = finalize,
+};
+
+static
+void releaseOwned (void *bytes, void *user)
+{
+	free(bytes);
+}
+
+static
+void finalize (struct Object *object)
+{
+	struct ArrayBuffer *self = (struct ArrayBuffer *)object;
+	
+	if (self->release)
+		self->release(self->bytes, self->user);
+	
+	self->bytes = NULL;
+	self->length = 0;
+}
+
+static
+uint32_t relativeIndex (struct Context * const context, struct Value value, uint32_t length, uint32_t otherwise)
+{
+	double binary;
+	
+	if (value.type == Value(undefinedType))
+		return otherwise;
+	
+	binary = Value.toBinary(context, value).data.binary;
+	if (isnan(binary))
+		return 0;
+	else if (binary < 0)
+		return binary + length > 0? length + binary: 0;
+	else
+		return binary < length? binary: length;
+}
+
+static
+struct ArrayBuffer * thisBuffer (struct Context * const context)
+{
+	if (!Value.isObject(context->this) || context->this.data.object->type != &ArrayBuffer(type))
+	{
+		Context.setTextIndex(context, Context(thisIndex));
+		Context.typeError(context, Chars.create("'this' is not an array buffer"));
+	}
+	
+	return (struct ArrayBuffer *)context->this.data.object;
+}
+
+// MARK: - Static Members
+
+static
+struct Value getByteLength (struct Context * const context)
+{
+	return Value.binary(thisBuffer(context)->length);
+}
+
+static
+struct Value slice (struct Context * const context)
+{
+	struct ArrayBuffer *self = thisBuffer(context), *result;
+	uint32_t from, to;
+	
+	from = relativeIndex(context, Context.argument(context, 0), self->length, 0);
+	to = relativeIndex(context, Context.argument(context, 1), self->length, self->length);
+	
+	result = create(to > from? to - from: 0);
+	if (result->length)
+		memcpy(result->bytes, self->bytes + from, result->length);
+	
+	return Value.object(&result->object);
+}
+
+static
+struct Value isView (struct Context * const context)
+{
+	struct Value value = Context.argument(context, 0);
+	
+	return Value.truth(Value.isObject(value) && TypedArray.isTypedArray(value.data.object));
+}
+
+static
+struct Value constructor (struct Context * const context)
+{
+	struct Value value;
+	double binary = 0;
+	
+	if (!context->construct)
+	{
+		Context.setTextIndex(context, Context(callIndex));
+		Context.typeError(context, Chars.create("ArrayBuffer constructor requires 'new'"));
+	}
+	
+	value = Context.argument(context, 0);
+	if (value.type != Value(undefinedType))
+	{
+		binary = Value.toBinary(context, value).data.binary;
+		binary = isnan(binary)? 0: trunc(binary);
+	}
+	
+	if (binary < 0 || binary > UINT32_MAX)
+		Context.rangeError(context, Chars.create("invalid array buffer length"));
+	
+	return Value.object(&create(binary)->object);
+}
+
+// MARK: - Methods
+
+void setup (void)
+{
+	const enum Value(Flags) h = Value(hidden);
+	const enum Value(Flags) s = Value(sealed);
+	
+	Function.setupBuiltinObject(
+		&ArrayBuffer(constructor), constructor, 1,
+		&ArrayBuffer(prototype), Value.object(Object.create(Object(prototype))),
+		&Object(type));
+	
+	Function.addMethod(ArrayBuffer(constructor), "isView", isView, 1, h);
+	
+	Function.addToObject(ArrayBuffer(prototype), "slice", slice, 2, h);
+	
+	Object.addMember(ArrayBuffer(prototype), Key.makeWithCString("byteLength"), Function.accessor(getByteLength, NULL), h|s | Value(asOwn) | Value(asData));
+}
+
+void teardown (void)
+{
+	ArrayBuffer(prototype) = NULL;
+	ArrayBuffer(constructor) = NULL;
+}
+
+struct ArrayBuffer * create (uint32_t length)
+{
+	// zero length still gets a block, so bytes is never NULL for an owned buffer
+	return createWithBytes(calloc(length? length: 1, 1), length, releaseOwned, NULL);
+}
+
+struct ArrayBuffer * createWithBytes (void *bytes, uint32_t length, ArrayBuffer(Release) release, void *user)
+{
+	struct ArrayBuffer *self = malloc(sizeof(*self));
+	*self = ArrayBuffer.identity;
+	Object.initialize(&self->object, ArrayBuffer(prototype));
+	Pool.addObject(&self->object);
+	
+	self->object.type = &ArrayBuffer(type);
+	self->bytes = bytes;
+	self->length = length;
+	self->release = release;
+	self->user = user;
+	
+	return self;
+}
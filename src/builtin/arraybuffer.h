@@ -0,0 +1,47 @@
+//
+//  arraybuffer.h
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#ifndef io_libecc_arraybuffer_h
+#ifdef Implementation
+#undef Implementation
+#include __FILE__
+#include "../implementation.h"
+#else
+#include "../interface.h"
+#define io_libecc_arraybuffer_h
+
+	#include "global.h"
+	
+	// called once with the bytes when their buffer is collected
+	typedef void io_libecc_interface_Unwrap ((* ArrayBuffer(Release))) (void *bytes, void *user);
+	
+	extern Ecc(threadlocal) struct Object * ArrayBuffer(prototype);
+	extern Ecc(threadlocal) struct Function * ArrayBuffer(constructor);
+	extern const struct Object(Type) ArrayBuffer(type);
+
+#endif
+
+
+Interface(ArrayBuffer,
+	
+	(void, setup ,(void))
+	(void, teardown ,(void))
+	
+	(struct ArrayBuffer *, create ,(uint32_t length))
+	(struct ArrayBuffer *, createWithBytes ,(void *bytes, uint32_t length, ArrayBuffer(Release), void *user))
+	,
+	{
+		struct Object object;
+		uint8_t *bytes;
+		uint32_t length;
+		ArrayBuffer(Release) release;
+		void *user;
+	}
+)
+
+#endif
@@ -13,8 +13,8 @@
 
 // MARK: - Private
 
-struct Object * Boolean(prototype) = NULL;
-struct Function * Boolean(constructor) = NULL;
+Ecc(threadlocal) struct Object * Boolean(prototype) = NULL;
+Ecc(threadlocal) struct Function * Boolean(constructor) = NULL;
 
 const struct Object(Type) Boolean(type) = {
 	.text = &Text(booleanType),
@@ -83,8 +83,8 @@ struct Boolean * create (int truth)
 {
 	struct Boolean *self = malloc(sizeof(*self));
 	*self = Boolean.identity;
-	Pool.addObject(&self->object);
 	Object.initialize(&self->object, Boolean(prototype));
+	Pool.addObject(&self->object);
 	
 	self->truth = truth;
 	
@@ -17,8 +17,8 @@
 
 	#include "global.h"
 
-	extern struct Object * Boolean(prototype);
-	extern struct Function * Boolean(constructor);
+	extern Ecc(threadlocal) struct Object * Boolean(prototype);
+	extern Ecc(threadlocal) struct Function * Boolean(constructor);
 	extern const struct Object(Type) Boolean(type);
 
 #endif
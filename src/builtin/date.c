@@ -15,8 +15,8 @@
 
 // MARK: - Private
 
-struct Object * Date(prototype) = NULL;
-struct Function * Date(constructor) = NULL;
+Ecc(threadlocal) struct Object * Date(prototype) = NULL;
+Ecc(threadlocal) struct Function * Date(constructor) = NULL;
 
 const struct Object(Type) Date(type) = {
 	.text = &Text(dateType),
@@ -35,7 +35,7 @@ struct time {
 	int32_t ms;
 };
 
-static double localOffset;
+static Ecc(threadlocal) double localOffset;
 
 static const double msPerSecond = 1000;
 static const double msPerMinute = 60000;
@@ -1066,8 +1066,8 @@ struct Date *create (double ms)
 {
 	struct Date *self = malloc(sizeof(*self));
 	*self = Date.identity;
-	Pool.addObject(&self->object);
 	Object.initialize(&self->object, Date(prototype));
+	Pool.addObject(&self->object);
 	
 	self->ms = msClip(ms);
 	
@@ -17,8 +17,8 @@
 
 	#include "global.h"
 
-	extern struct Object * Date(prototype);
-	extern struct Function * Date(constructor);
+	extern Ecc(threadlocal) struct Object * Date(prototype);
+	extern Ecc(threadlocal) struct Function * Date(constructor);
 	extern const struct Object(Type) Date(type);
 
 #endif
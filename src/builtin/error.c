@@ -13,21 +13,21 @@
 
 // MARK: - Private
 
-struct Object * Error(prototype) = NULL;
-struct Object * Error(rangePrototype) = NULL;
-struct Object * Error(referencePrototype) = NULL;
-struct Object * Error(syntaxPrototype) = NULL;
-struct Object * Error(typePrototype) = NULL;
-struct Object * Error(uriPrototype) = NULL;
-struct Object * Error(evalPrototype) = NULL;
+Ecc(threadlocal) struct Object * Error(prototype) = NULL;
+Ecc(threadlocal) struct Object * Error(rangePrototype) = NULL;
+Ecc(threadlocal) struct Object * Error(referencePrototype) = NULL;
+Ecc(threadlocal) struct Object * Error(syntaxPrototype) = NULL;
+Ecc(threadlocal) struct Object * Error(typePrototype) = NULL;
+Ecc(threadlocal) struct Object * Error(uriPrototype) = NULL;
+Ecc(threadlocal) struct Object * Error(evalPrototype) = NULL;
 
-struct Function * Error(constructor) = NULL;
-struct Function * Error(rangeConstructor) = NULL;
-struct Function * Error(referenceConstructor) = NULL;
-struct Function * Error(syntaxConstructor) = NULL;
-struct Function * Error(typeConstructor) = NULL;
-struct Function * Error(uriConstructor) = NULL;
-struct Function * Error(evalConstructor) = NULL;
+Ecc(threadlocal) struct Function * Error(constructor) = NULL;
+Ecc(threadlocal) struct Function * Error(rangeConstructor) = NULL;
+Ecc(threadlocal) struct Function * Error(referenceConstructor) = NULL;
+Ecc(threadlocal) struct Function * Error(syntaxConstructor) = NULL;
+Ecc(threadlocal) struct Function * Error(typeConstructor) = NULL;
+Ecc(threadlocal) struct Function * Error(uriConstructor) = NULL;
+Ecc(threadlocal) struct Function * Error(evalConstructor) = NULL;
 
 const struct Object(Type) Error(type) = {
 	.text = &Text(errorType),
@@ -90,11 +90,11 @@ static
 struct Error * create (struct Object *errorPrototype, struct Text text, struct Chars *message)
 {
 	struct Error *self = malloc(sizeof(*self));
-	Pool.addObject(&self->object);
 	
 	*self = Error.identity;
 	
 	Object.initialize(&self->object, errorPrototype);
+	Pool.addObject(&self->object);
 	
 	self->text = text;
 	
@@ -17,21 +17,21 @@
 
 	#include "global.h"
 
-	extern struct Object * Error(prototype);
-	extern struct Object * Error(rangePrototype);
-	extern struct Object * Error(referencePrototype);
-	extern struct Object * Error(syntaxPrototype);
-	extern struct Object * Error(typePrototype);
-	extern struct Object * Error(uriPrototype);
-	extern struct Object * Error(evalPrototype);
-
-	extern struct Function * Error(constructor);
-	extern struct Function * Error(rangeConstructor);
-	extern struct Function * Error(referenceConstructor);
-	extern struct Function * Error(syntaxConstructor);
-	extern struct Function * Error(typeConstructor);
-	extern struct Function * Error(uriConstructor);
-	extern struct Function * Error(evalConstructor);
+	extern Ecc(threadlocal) struct Object * Error(prototype);
+	extern Ecc(threadlocal) struct Object * Error(rangePrototype);
+	extern Ecc(threadlocal) struct Object * Error(referencePrototype);
+	extern Ecc(threadlocal) struct Object * Error(syntaxPrototype);
+	extern Ecc(threadlocal) struct Object * Error(typePrototype);
+	extern Ecc(threadlocal) struct Object * Error(uriPrototype);
+	extern Ecc(threadlocal) struct Object * Error(evalPrototype);
+
+	extern Ecc(threadlocal) struct Function * Error(constructor);
+	extern Ecc(threadlocal) struct Function * Error(rangeConstructor);
+	extern Ecc(threadlocal) struct Function * Error(referenceConstructor);
+	extern Ecc(threadlocal) struct Function * Error(syntaxConstructor);
+	extern Ecc(threadlocal) struct Function * Error(typeConstructor);
+	extern Ecc(threadlocal) struct Function * Error(uriConstructor);
+	extern Ecc(threadlocal) struct Function * Error(evalConstructor);
 
 	extern const struct Object(Type) Error(type);
 
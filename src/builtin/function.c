@@ -11,6 +11,7 @@
 
 #include "../ecc.h"
 #include "../oplist.h"
+#include "../bytecode.h"
 #include "../pool.h"
 
 // MARK: - Private
@@ -20,8 +21,8 @@ static va_list empty_ap;
 static void mark (struct Object *object);
 static void capture (struct Object *object);
 
-struct Object * Function(prototype) = NULL;
-struct Function * Function(constructor) = NULL;
+Ecc(threadlocal) struct Object * Function(prototype) = NULL;
+Ecc(threadlocal) struct Function * Function(constructor) = NULL;
 
 const struct Object(Type) Function(type) = {
 	.text = &Text(functionType),
@@ -49,6 +50,15 @@ void mark (struct Object *object)
 	
 	Pool.markObject(&self->environment);
 	
+	if (self->oplist)
+	{
+		uint32_t index;
+		
+		// nested function templates & literals only live in the oplist
+		for (index = 0; index < self->oplist->count; ++index)
+			Pool.markValue(self->oplist->ops[index].value);
+	}
+	
 	if (self->refObject)
 		Pool.markObject(self->refObject);
 	
@@ -283,12 +293,12 @@ struct Function * create (struct Object *environment)
 struct Function * createSized (struct Object *environment, uint32_t size)
 {
 	struct Function *self = malloc(sizeof(*self));
-	Pool.addFunction(self);
 	
 	*self = Function.identity;
 	
 	Object.initialize(&self->object, Function(prototype));
 	Object.initializeSized(&self->environment, environment, size);
+	Pool.addFunction(self);
 	
 	return self;
 }
@@ -323,12 +333,14 @@ struct Function * copy (struct Function *original)
 	size_t byteSize;
 	
 	assert(original);
-	Pool.addObject(&self->object);
 	
 	*self = *original;
+	self->object.flags &= ~(Object(gray) | Object(black) | Object(fresh));
+	self->environment.flags &= ~(Object(gray) | Object(black) | Object(fresh));
+	Pool.addObject(&self->object);
 	
 	byteSize = sizeof(*self->object.hashmap) * self->object.hashmapCapacity;
-	self->object.hashmap = malloc(byteSize);
+	self->object.hashmap = Pool.allocate(byteSize);
 	memcpy(self->object.hashmap, original->object.hashmap, byteSize);
 	
 	return self;
@@ -344,6 +356,9 @@ void destroy (struct Function *self)
 	if (self->oplist)
 		OpList.destroy(self->oplist), self->oplist = NULL;
 	
+	if (self->bytecode)
+		Bytecode.destroy(self->bytecode), self->bytecode = NULL;
+	
 	free(self), self = NULL;
 }
 
@@ -27,8 +27,8 @@
 		Function(strictMode)    = 1 << 4,
 	};
 
-	extern struct Object * Function(prototype);
-	extern struct Function * Function(constructor);
+	extern Ecc(threadlocal) struct Object * Function(prototype);
+	extern Ecc(threadlocal) struct Function * Function(constructor);
 	extern const struct Object(Type) Function(type);
 
 #endif
@@ -61,6 +61,7 @@ Interface(Function,
 		struct Object environment;
 		struct Object *refObject;
 		struct OpList *oplist;
+		struct Bytecode *bytecode;
 		struct Function *pair;
 		struct Value boundThis;
 		struct Text text;
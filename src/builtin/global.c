@@ -360,6 +360,8 @@ void setup (void)
 	RegExp.setup();
 	JSON.setup();
 	Arguments.setup();
+	ArrayBuffer.setup();
+	TypedArray.setup();
 }
 
 void teardown (void)
@@ -376,6 +378,8 @@ void teardown (void)
 	RegExp.teardown();
 	JSON.teardown();
 	Arguments.teardown();
+	ArrayBuffer.teardown();
+	TypedArray.teardown();
 }
 
 struct Function * create (void)
@@ -419,6 +423,16 @@ struct Function * create (void)
 	Function.addValue(self, "EvalError", Value.function(Error(evalConstructor)), h);
 	Function.addValue(self, "Math", Value.object(Math(object)), h);
 	Function.addValue(self, "JSON", Value.object(JSON(object)), h);
+	Function.addValue(self, "ArrayBuffer", Value.function(ArrayBuffer(constructor)), h);
+	Function.addValue(self, "Int8Array", Value.function(TypedArray(constructors)[TypedArray(int8)]), h);
+	Function.addValue(self, "Uint8Array", Value.function(TypedArray(constructors)[TypedArray(uint8)]), h);
+	Function.addValue(self, "Uint8ClampedArray", Value.function(TypedArray(constructors)[TypedArray(uint8Clamped)]), h);
+	Function.addValue(self, "Int16Array", Value.function(TypedArray(constructors)[TypedArray(int16)]), h);
+	Function.addValue(self, "Uint16Array", Value.function(TypedArray(constructors)[TypedArray(uint16)]), h);
+	Function.addValue(self, "Int32Array", Value.function(TypedArray(constructors)[TypedArray(int32)]), h);
+	Function.addValue(self, "Uint32Array", Value.function(TypedArray(constructors)[TypedArray(uint32)]), h);
+	Function.addValue(self, "Float32Array", Value.function(TypedArray(constructors)[TypedArray(float32)]), h);
+	Function.addValue(self, "Float64Array", Value.function(TypedArray(constructors)[TypedArray(float64)]), h);
 	
 	return self;
 }
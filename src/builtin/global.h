@@ -26,6 +26,8 @@
 	#include "regexp.h"
 	#include "error.h"
 	#include "json.h"
+	#include "arraybuffer.h"
+	#include "typedarray.h"
 
 	extern const struct Object(Type) Global(type);
 
@@ -13,24 +13,57 @@
 #include "../parser.h"
 #include "../oplist.h"
 
+#if __SSE2__ && __GNUC__
+	#include <emmintrin.h>
+#elif __ARM_NEON && __aarch64__
+	#include <arm_neon.h>
+#endif
+
 // MARK: - Private
 
+enum {
+	keyCacheSize = 64,
+	shortString = 7,
+	exactDigits = 15,
+	charsCapacity = 64,
+	writeCapacity = 4096,
+};
+
 struct Parse {
 	struct Text text;
 	const char *start;
 	int line;
 	
+	// members of the arrays & objects being parsed, created once closed
+	struct Value *values;
+	uint32_t valueCount;
+	uint32_t valueCapacity;
+	
+	// property names recently seen
+	struct {
+		const char *bytes;
+		int32_t length;
+		struct Key key;
+	} keys[keyCacheSize];
+	
 	// reviver
 	
 	struct Context context;
 	struct Function * function;
 	struct Object * arguments;
-	const struct Op * ops;
+	struct Op * ops;
 };
 
 struct Stringify {
-	struct Chars(Append) chars;
+	char *bytes;
+	uint32_t length;
+	uint32_t capacity;
+	struct Chars *chars;
+	JSON(Writer) write;
+	void *user;
+	
 	char spaces[11];
+	uint8_t spaceLength;
 	int level;
 	struct Object *filter;
 	
@@ -39,7 +72,7 @@ struct Stringify {
 	struct Context context;
 	struct Function * function;
 	struct Object * arguments;
-	const struct Op * ops;
+	struct Op * ops;
 };
 
 const struct Object(Type) JSON(type) = {
@@ -52,6 +85,15 @@ struct Value error (struct Parse *parse, int length, struct Chars *chars)
 	return Value.error(Error.syntaxError(Text.make(parse->text.bytes + (length < 0? length: 0), abs(length)), chars));
 }
 
+static
+struct Value unexpected (struct Parse *parse, struct Text(Char) c)
+{
+	if (!c.units)
+		return error(parse, parse->text.bytes > parse->start? -1: 0, Chars.create("unexpected end of input"));
+	
+	return error(parse, -c.units, Chars.create("unexpected '%.*s'", c.units, parse->text.bytes - c.units));
+}
+
 static
 struct Text errorOfLine (struct Parse *parse)
 {
@@ -69,45 +111,300 @@ struct Text errorOfLine (struct Parse *parse)
 	return text;
 }
 
+static inline
+void skip (struct Parse *parse, const char *bytes)
+{
+	parse->text.length -= bytes - parse->text.bytes;
+	parse->text.bytes = bytes;
+}
+
+static
+void space (struct Parse *parse)
+{
+	const char *bytes = parse->text.bytes, *end = bytes + parse->text.length;
+	
+	for (; bytes < end; ++bytes)
+		if (*bytes == '\n' || (*bytes == '\r' && (bytes + 1 == end || bytes[1] != '\n')))
+		{
+			parse->start = bytes + 1;
+			++parse->line;
+		}
+		else if (*bytes != ' ' && *bytes != '\t' && *bytes != '\r')
+			break;
+	
+	skip(parse, bytes);
+}
+
 static
 struct Text(Char) nextc (struct Parse *parse)
 {
 	struct Text(Char) c = { 0 };
-	while (parse->text.length)
+	
+	space(parse);
+	
+	if (!parse->text.length)
+		return c;
+	else if ((uint8_t)*parse->text.bytes >= 0x80)
+		return Text.nextCharacter(&parse->text);
+	
+	c.codepoint = *parse->text.bytes;
+	c.units = 1;
+	skip(parse, parse->text.bytes + 1);
+	return c;
+}
+
+static
+const char * stringEnd (const char *bytes, const char *end)
+{
+	// first quote, backslash or control character, 16 bytes at a time where available
+	
+	#if __SSE2__ && __GNUC__
+	const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), control = _mm_set1_epi8(0x1f);
+	
+	for (; end - bytes >= 16; bytes += 16)
 	{
-		c = Text.nextCharacter(&parse->text);
+		__m128i chunk = _mm_loadu_si128((const __m128i *)bytes);
+		__m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+		int mask = _mm_movemask_epi8(stop);
 		
-		if (c.codepoint == '\r' && Text.character(parse->text).codepoint == '\n')
-			Text.advance(&parse->text, 1);
+		if (mask)
+			return bytes + __builtin_ctz(mask);
+	}
+	#elif __ARM_NEON && __aarch64__
+	const uint8x16_t quote = vdupq_n_u8('"'), backslash = vdupq_n_u8('\\'), control = vdupq_n_u8(0x20);
+	
+	for (; end - bytes >= 16; bytes += 16)
+	{
+		uint8x16_t chunk = vld1q_u8((const uint8_t *)bytes);
+		uint8x16_t stop = vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)), vcltq_u8(chunk, control));
 		
-		if (c.codepoint == '\r' || c.codepoint == '\n')
+		if (vmaxvq_u8(stop))
+			break;
+	}
+	#endif
+	
+	while (bytes < end && *bytes != '"' && *bytes != '\\' && (uint8_t)*bytes >= 0x20)
+		++bytes;
+	
+	return bytes;
+}
+
+static
+int32_t hexUnit (const char *bytes)
+{
+	int32_t unit = 0, index, c;
+	
+	for (index = 0; index < 4; ++index)
+	{
+		c = bytes[index];
+		
+		if (c >= '0' && c <= '9')
+			c -= '0';
+		else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+			c = (c | 0x20) - 'a' + 10;
+		else
+			return -1;
+		
+		unit = unit << 4 | c;
+	}
+	return unit;
+}
+
+static
+struct Value escapedString (struct Parse *parse, const char *cursor)
+{
+	const char *bytes = parse->text.bytes, *end = bytes + parse->text.length;
+	struct Chars(Append) chars;
+	struct Text(Char) c = { 0 };
+	int32_t unit;
+	
+	Chars.beginAppend(&chars);
+	
+	for (;;)
+	{
+		if (cursor > bytes)
+			Chars.append(&chars, "%.*s", (int)(cursor - bytes), bytes);
+		
+		if (cursor >= end)
 		{
-			parse->start = parse->text.bytes;
-			++parse->line;
+			skip(parse, end);
+			return unexpected(parse, c);
 		}
-		
-		if (!isspace(c.codepoint))
+		else if (*cursor == '"')
 			break;
+		else if (*cursor != '\\')
+		{
+			c.codepoint = *cursor;
+			c.units = 1;
+			skip(parse, cursor + 1);
+			return unexpected(parse, c);
+		}
+		
+		switch (cursor + 1 < end? cursor[1]: 0)
+		{
+			case '"': Chars.appendCodepoint(&chars, '"'); break;
+			case '\\': Chars.appendCodepoint(&chars, '\\'); break;
+			case '/': Chars.appendCodepoint(&chars, '/'); break;
+			case 'b': Chars.appendCodepoint(&chars, '\b'); break;
+			case 'f': Chars.appendCodepoint(&chars, '\f'); break;
+			case 'n': Chars.appendCodepoint(&chars, '\n'); break;
+			case 'r': Chars.appendCodepoint(&chars, '\r'); break;
+			case 't': Chars.appendCodepoint(&chars, '\t'); break;
+			case 'u':
+				if (end - cursor >= 6 && (unit = hexUnit(cursor + 2)) >= 0)
+				{
+					Chars.appendCodepoint(&chars, unit);
+					cursor += 4;
+					break;
+				}
+				skip(parse, cursor + (end - cursor < 6? end - cursor: 6));
+				return error(parse, (int)(cursor - parse->text.bytes), Chars.create("malformed Unicode character escape sequence"));
+				
+			default:
+				skip(parse, cursor + (end - cursor < 2? end - cursor: 2));
+				return error(parse, (int)(cursor - parse->text.bytes), Chars.create("malformed escape sequence"));
+		}
+		
+		bytes = cursor + 2;
+		cursor = stringEnd(bytes, end);
 	}
-	return c;
+	
+	skip(parse, cursor + 1);
+	return Chars.endAppend(&chars);
 }
 
 static
-struct Text string (struct Parse *parse)
+struct Value string (struct Parse *parse)
 {
-	struct Text text = { parse->text.bytes };
-	struct Text(Char) c;
+	const char *bytes = parse->text.bytes, *cursor = stringEnd(bytes, bytes + parse->text.length);
+	int32_t length = (int32_t)(cursor - bytes);
+	
+	if (length == parse->text.length || *cursor != '"')
+		return escapedString(parse, cursor);
+	
+	skip(parse, cursor + 1);
+	
+	if (length <= shortString)
+		return Value.buffer(bytes, length);
+	else
+		return Value.chars(Chars.createWithBytes(length, bytes));
+}
+
+static
+struct Value key (struct Parse *parse)
+{
+	const char *bytes = parse->text.bytes, *cursor = stringEnd(bytes, bytes + parse->text.length);
+	int32_t length = (int32_t)(cursor - bytes);
+	struct Value value;
+	uint32_t index;
+	
+	// objects of a document mostly repeat the same names: a hit skips hashing the text
 	
-	do
+	if (length == parse->text.length || *cursor != '"')
 	{
-		c = Text.nextCharacter(&parse->text);
-		if (c.codepoint == '\\')
-			Text.advance(&parse->text, 1);
+		value = escapedString(parse, cursor);
+		if (value.type == Value(errorType))
+			return value;
+		
+		return Value.key(Key.makeWithText(Value.textOf(&value), Key(copyOnCreate)));
 	}
-	while (c.codepoint != '\"' && parse->text.length);
 	
-	text.length = (int32_t)(parse->text.bytes - text.bytes - 1);
-	return text;
+	skip(parse, cursor + 1);
+	
+	index = (length * 31 + (length? (uint8_t)bytes[0] * 7 + (uint8_t)bytes[length - 1]: 0)) & (keyCacheSize - 1);
+	if (!parse->keys[index].bytes || parse->keys[index].length != length || memcmp(parse->keys[index].bytes, bytes, length))
+	{
+		parse->keys[index].bytes = bytes;
+		parse->keys[index].length = length;
+		parse->keys[index].key = Key.makeWithText(Text.make(bytes, length), Key(copyOnCreate));
+	}
+	return Value.key(parse->keys[index].key);
+}
+
+static inline
+int isDigit (char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static
+struct Value number (struct Parse *parse, const char *bytes)
+{
+	const char *cursor = bytes, *end = parse->text.bytes + parse->text.length;
+	struct Text(Char) c = { 0 };
+	int digits = 0, exact = 1;
+	double binary = 0;
+	
+	if (*cursor == '-')
+		++cursor;
+	
+	if (cursor < end && *cursor == '0')
+		++cursor, ++digits;
+	else
+		for (; cursor < end && isDigit(*cursor); ++cursor, ++digits)
+			binary = binary * 10 + (*cursor - '0');
+	
+	if (!digits)
+		goto unexpected;
+	
+	if (cursor < end && *cursor == '.')
+	{
+		exact = 0;
+		for (digits = 0, ++cursor; cursor < end && isDigit(*cursor); ++cursor)
+			++digits;
+		
+		if (!digits)
+			goto unexpected;
+	}
+	
+	if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+	{
+		exact = 0;
+		if (++cursor < end && (*cursor == '+' || *cursor == '-'))
+			++cursor;
+		
+		for (digits = 0; cursor < end && isDigit(*cursor); ++cursor)
+			++digits;
+		
+		if (!digits)
+			goto unexpected;
+	}
+	
+	skip(parse, cursor);
+	
+	if (exact && digits <= exactDigits)
+		return Value.binary(*bytes == '-'? -binary: binary);
+	else
+		return Lexer.scanBinary(Text.make(bytes, (int32_t)(cursor - bytes)), 0);
+	
+unexpected:
+	skip(parse, cursor);
+	if (cursor < end)
+		c = Text.nextCharacter(&parse->text);
+	
+	return unexpected(parse, c);
+}
+
+static
+struct Value retain (struct Value value)
+{
+	if (value.type == Value(charsType))
+		++value.data.chars->referenceCount;
+	if (value.type >= Value(objectType))
+		++value.data.object->referenceCount;
+	
+	return value;
+}
+
+static
+void push (struct Parse *parse, struct Value value)
+{
+	if (parse->valueCount >= parse->valueCapacity)
+	{
+		parse->valueCapacity = parse->valueCapacity? parse->valueCapacity * 2: 64;
+		parse->values = realloc(parse->values, sizeof(*parse->values) * parse->valueCapacity);
+	}
+	parse->values[parse->valueCount++] = value;
 }
 
 static struct Value object (struct Parse *parse);
@@ -121,7 +418,7 @@ struct Value literal (struct Parse *parse)
 	switch (c.codepoint)
 	{
 		case 't':
-			if (!memcmp(parse->text.bytes, "rue", 3))
+			if (parse->text.length >= 3 && !memcmp(parse->text.bytes, "rue", 3))
 			{
 				Text.advance(&parse->text, 3);
 				return Value(true);
@@ -129,7 +426,7 @@ struct Value literal (struct Parse *parse)
 			break;
 			
 		case 'f':
-			if (!memcmp(parse->text.bytes, "alse", 4))
+			if (parse->text.length >= 4 && !memcmp(parse->text.bytes, "alse", 4))
 			{
 				Text.advance(&parse->text, 4);
 				return Value(false);
@@ -137,7 +434,7 @@ struct Value literal (struct Parse *parse)
 			break;
 			
 		case 'n':
-			if (!memcmp(parse->text.bytes, "ull", 3))
+			if (parse->text.length >= 3 && !memcmp(parse->text.bytes, "ull", 3))
 			{
 				Text.advance(&parse->text, 3);
 				return Value(null);
@@ -155,77 +452,27 @@ struct Value literal (struct Parse *parse)
 		case '7':
 		case '8':
 		case '9':
-		{
-			struct Text text = Text.make(parse->text.bytes - 1, 1);
-			
-			if (c.codepoint == '-')
-				c = Text.nextCharacter(&parse->text);
-			
-			if (c.codepoint != '0')
-				while (parse->text.length)
-				{
-					c = Text.nextCharacter(&parse->text);
-					if (!isdigit(c.codepoint))
-						break;
-				}
-			else
-				c = Text.nextCharacter(&parse->text);
-			
-			if (c.codepoint == '.')
-			{
-				while (parse->text.length)
-				{
-					c = Text.nextCharacter(&parse->text);
-					if (!isdigit(c.codepoint))
-						break;
-				}
-			}
-			
-			if (c.codepoint == 'e' || c.codepoint == 'E')
-			{
-				c = Text.nextCharacter(&parse->text);
-				if (c.codepoint == '+' || c.codepoint == '-')
-					c = Text.nextCharacter(&parse->text);
-				
-				while (parse->text.length)
-				{
-					c = Text.nextCharacter(&parse->text);
-					if (!isdigit(c.codepoint))
-						break;
-				}
-			}
-			
-			Text.advance(&parse->text, -c.units);
-			text.length = (int32_t)(parse->text.bytes - text.bytes);
-			
-			return Lexer.scanBinary(text, 0);
-		}
+			return number(parse, parse->text.bytes - 1);
 			
 		case '"':
-		{
-			struct Text text = string(parse);
-			return Value.chars(Chars.createWithBytes(text.length, text.bytes));
-			break;
-		}
+			return string(parse);
 			
 		case '{':
 			return object(parse);
-			break;
 			
 		case '[':
 			return array(parse);
-			break;
 	}
-	return error(parse, -c.units, Chars.create("unexpected '%.*s'", c.units, parse->text.bytes - c.units));
+	return unexpected(parse, c);
 }
 
 static
 struct Value object (struct Parse *parse)
 {
-	struct Object *object = Object.create(Object(prototype));
+	uint32_t base = parse->valueCount, count, index;
+	struct Object *object;
 	struct Text(Char) c;
 	struct Value value;
-	struct Key key;
 	
 	c = nextc(parse);
 	if (c.codepoint != '}')
@@ -234,7 +481,11 @@ struct Value object (struct Parse *parse)
 			if (c.codepoint != '"')
 				return error(parse, -c.units, Chars.create("expect property name"));
 			
-			key = Key.makeWithText(string(parse), Key(copyOnCreate));
+			value = key(parse);
+			if (value.type == Value(errorType))
+				return value;
+			
+			push(parse, value);
 			
 			c = nextc(parse);
 			if (c.codepoint != ':')
@@ -244,7 +495,7 @@ struct Value object (struct Parse *parse)
 			if (value.type == Value(errorType))
 				return value;
 			
-			Object.addMember(object, key, value, 0);
+			push(parse, value);
 			
 			c = nextc(parse);
 			
@@ -253,37 +504,66 @@ struct Value object (struct Parse *parse)
 			else if (c.codepoint == ',')
 				c = nextc(parse);
 			else
-				return error(parse, -c.units, Chars.create("unexpected '%.*s'", c.units, parse->text.bytes - c.units));
+				return unexpected(parse, c);
 		}
 	
+	count = (parse->valueCount - base) / 2;
+	
+	if (count > 4 && count < UINT16_MAX / 2 - 1)
+		object = Object.createSized(Object(prototype), 2 + count * 2);
+	else
+		object = Object.create(Object(prototype));
+	
+	// members are counted as by an object literal, or reference collection would reclaim them
+	object->flags |= Object(mark);
+	
+	for (index = base; index < parse->valueCount; index += 2)
+		Object.addMember(object, parse->values[index].data.key, retain(parse->values[index + 1]), 0);
+	
+	parse->valueCount = base;
 	return Value.object(object);
 }
 
 static
 struct Value array (struct Parse *parse)
 {
-	struct Object *object = Array.create();
+	uint32_t base = parse->valueCount, count, index;
+	struct Object *object;
 	struct Text(Char) c;
 	struct Value value;
 	
-	for (;;)
-	{
-		value = literal(parse);
-		if (value.type == Value(errorType))
-			return value;
-		
-		Object.addElement(object, object->elementCount, value, 0);
-		
-		c = nextc(parse);
-		
-		if (c.codepoint == ',')
-			continue;
-		
-		if (c.codepoint == ']')
-			break;
-		
-		return error(parse, -c.units, Chars.create("unexpected '%.*s'", c.units, parse->text.bytes - c.units));
-	}
+	space(parse);
+	
+	if (parse->text.length && *parse->text.bytes == ']')
+		skip(parse, parse->text.bytes + 1);
+	else
+		for (;;)
+		{
+			value = literal(parse);
+			if (value.type == Value(errorType))
+				return value;
+			
+			push(parse, value);
+			
+			c = nextc(parse);
+			
+			if (c.codepoint == ',')
+				continue;
+			
+			if (c.codepoint == ']')
+				break;
+			
+			return unexpected(parse, c);
+		}
+	
+	count = parse->valueCount - base;
+	object = Array.createSized(count);
+	object->flags |= Object(mark);
+	
+	for (index = 0; index < count; ++index)
+		object->element[index].value = retain(parse->values[base + index]);
+	
+	parse->valueCount = base;
 	return Value.object(object);
 }
 
@@ -330,7 +610,7 @@ struct Value revive (struct Parse *parse, struct Value this, struct Value proper
 	parse->context.this = this;
 	parse->arguments->element[0].value = property;
 	parse->arguments->element[1].value = value;
-	return parse->context.ops->native(&parse->context);
+	return Op.dispatch(&parse->context);
 }
 
 static
@@ -356,7 +636,12 @@ struct Value walker (struct Parse *parse, struct Value this, struct Value proper
 		for (index = 2; index < object->hashmapCount; ++index)
 		{
 			if (object->hashmap[index].value.check == 1)
-				object->hashmap[index].value = walker(parse, this, Value.key(object->hashmap[index].value.key), object->hashmap[index].value);
+			{
+				// the reviver's result carries no key, the slot keeps its own
+				struct Key key = object->hashmap[index].value.key;
+				object->hashmap[index].value = walker(parse, this, Value.key(key), object->hashmap[index].value);
+				object->hashmap[index].value.key = key;
+			}
 		}
 	}
 	return revive(parse, this, property, value);
@@ -385,6 +670,10 @@ struct Value jsonParse (struct Context * const context)
 	parse.ops = parse.function? parse.function->oplist->ops: NULL;
 	
 	result = json(&parse);
+	free(parse.values), parse.values = NULL;
+	
+	if (result.type != Value(errorType))
+		space(&parse);
 	
 	if (result.type != Value(errorType) && parse.text.length)
 	{
@@ -403,7 +692,7 @@ struct Value jsonParse (struct Context * const context)
 	
 	if (parse.function && parse.function->flags & Function(needHeap))
 	{
-		struct Object *environment = Object.copy(&parse.function->environment);
+		struct Object *environment = Object.copyEnvironment(&parse.function->environment);
 		
 		parse.context.environment = environment;
 		parse.arguments = Arguments.createSized(2);
@@ -462,7 +751,163 @@ struct Value replace (struct Stringify *stringify, struct Value this, struct Val
 	stringify->context.this = this;
 	stringify->arguments->element[0].value = property;
 	stringify->arguments->element[1].value = value;
-	return stringify->context.ops->native(&stringify->context);
+	return Op.dispatch(&stringify->context);
+}
+
+// output goes to a byte buffer: the result chars itself when stringifying
+// for a script, or a fixed buffer flushed to the writer when streaming
+
+static
+void flush (struct Stringify *stringify)
+{
+	if (stringify->length)
+		stringify->write(stringify->user, stringify->bytes, stringify->length);
+	
+	stringify->length = 0;
+}
+
+static
+void grow (struct Stringify *stringify, uint32_t length)
+{
+	uint32_t capacity = stringify->capacity;
+	struct Chars *chars;
+	
+	if (stringify->write)
+	{
+		flush(stringify);
+		return;
+	}
+	
+	while (capacity < stringify->length + length)
+		capacity *= 2;
+	
+	chars = Chars.createSized(capacity);
+	memcpy(chars->bytes, stringify->bytes, stringify->length);
+	stringify->chars = chars;
+	stringify->bytes = chars->bytes;
+	stringify->capacity = capacity;
+}
+
+static inline
+char * reserve (struct Stringify *stringify, uint32_t length)
+{
+	if (stringify->length + length > stringify->capacity)
+		grow(stringify, length);
+	
+	return stringify->bytes + stringify->length;
+}
+
+static
+void emit (struct Stringify *stringify, const char *bytes, uint32_t length)
+{
+	if (stringify->write && length > stringify->capacity)
+	{
+		flush(stringify);
+		stringify->write(stringify->user, bytes, length);
+		return;
+	}
+	
+	memcpy(reserve(stringify, length), bytes, length);
+	stringify->length += length;
+}
+
+static inline
+void emitByte (struct Stringify *stringify, char c)
+{
+	*reserve(stringify, 1) = c;
+	++stringify->length;
+}
+
+static
+void emitIndent (struct Stringify *stringify)
+{
+	int level;
+	
+	if (!stringify->spaceLength)
+		return;
+	
+	emitByte(stringify, '\n');
+	for (level = stringify->level; level--;)
+		emit(stringify, stringify->spaces, stringify->spaceLength);
+}
+
+static
+void emitInteger (struct Stringify *stringify, int64_t integer)
+{
+	stringify->length += Chars.writeInteger(reserve(stringify, Chars(binaryLength)), integer);
+}
+
+static
+void emitBinary (struct Stringify *stringify, double binary)
+{
+	if (isfinite(binary))
+		stringify->length += Chars.writeBinary(reserve(stringify, Chars(binaryLength)), binary);
+	else
+		emit(stringify, "null", 4);
+}
+
+static
+void emitString (struct Stringify *stringify, struct Text text)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *bytes = text.bytes, *end = text.bytes + text.length, *stop;
+	uint8_t c;
+	char *escape;
+	
+	emitByte(stringify, '"');
+	
+	while ((stop = stringEnd(bytes, end)) < end)
+	{
+		emit(stringify, bytes, (uint32_t)(stop - bytes));
+		
+		c = *stop;
+		escape = reserve(stringify, 6);
+		escape[0] = '\\';
+		
+		if (c == '"' || c == '\\')
+			escape[1] = c;
+		else if (c == '\b')
+			escape[1] = 'b';
+		else if (c == '\f')
+			escape[1] = 'f';
+		else if (c == '\n')
+			escape[1] = 'n';
+		else if (c == '\r')
+			escape[1] = 'r';
+		else if (c == '\t')
+			escape[1] = 't';
+		else
+		{
+			escape[1] = 'u';
+			escape[2] = '0';
+			escape[3] = '0';
+			escape[4] = hex[c >> 4];
+			escape[5] = hex[c & 0xf];
+			stringify->length += 4;
+		}
+		stringify->length += 2;
+		bytes = stop + 1;
+	}
+	
+	emit(stringify, bytes, (uint32_t)(end - bytes));
+	emitByte(stringify, '"');
+}
+
+static
+void emitKey (struct Stringify *stringify, struct Value property)
+{
+	if (property.type == Value(integerType))
+	{
+		emitByte(stringify, '"');
+		emitInteger(stringify, property.data.integer);
+		emitByte(stringify, '"');
+	}
+	else
+		emitString(stringify, Value.textOf(&property));
+	
+	emitByte(stringify, ':');
+	if (stringify->spaceLength)
+		emitByte(stringify, ' ');
 }
 
 static
@@ -470,6 +915,10 @@ int stringifyValue (struct Stringify *stringify, struct Value this, struct Value
 {
 	uint32_t index, count;
 	
+	// element indices are only turned into strings when a script gets to see them
+	if (property.type == Value(integerType) && (stringify->function || (stringify->filter && !isArray)))
+		property = Value.toString(&stringify->context, property);
+	
 	if (stringify->function)
 		value = replace(stringify, this, property, value);
 	
@@ -501,87 +950,112 @@ int stringifyValue (struct Stringify *stringify, struct Value this, struct Value
 	}
 	
 	if (addComa)
-		Chars.append(&stringify->chars, ",%s", strlen(stringify->spaces)? "\n": "");
+		emitByte(stringify, ',');
 	
-	for (index = 0, count = stringify->level; index < count; ++index)
-		Chars.append(&stringify->chars, "%s", stringify->spaces);
+	if (stringify->level)
+		emitIndent(stringify);
 	
 	if (!isArray)
-		Chars.append(&stringify->chars, "\"%.*s\":%s", Value.stringLength(&property), Value.stringBytes(&property), strlen(stringify->spaces)? " ": "");
+		emitKey(stringify, property);
 	
-	if (value.type == Value(functionType) || value.type == Value(undefinedType))
-		Chars.append(&stringify->chars, "null");
-	else if (Value.isObject(value))
+	switch ((enum Value(Type))value.type)
 	{
-		struct Object *object = value.data.object;
-		int isArray = Value.objectIsArray(object);
-		struct Chars(Append) chars;
-		const struct Text *property;
-		int hasValue = 0;
+		case Value(nullType):
+		case Value(undefinedType):
+		case Value(functionType):
+		case Value(dispatchType):
+			emit(stringify, "null", 4);
+			break;
 		
-		Chars.append(&stringify->chars, "%s%s", isArray? "[": "{", strlen(stringify->spaces)? "\n": "");
-		++stringify->level;
+		case Value(falseType):
+			emit(stringify, "false", 5);
+			break;
 		
-		for (index = 0, count = object->elementCount < Object(ElementMax)? object->elementCount: Object(ElementMax); index < count; ++index)
-		{
-			if (object->element[index].value.check == 1)
-			{
-				Chars.beginAppend(&chars);
-				Chars.append(&chars, "%d", index);
-				hasValue |= stringifyValue(stringify, value, Chars.endAppend(&chars), object->element[index].value, isArray, hasValue);
-			}
-		}
+		case Value(trueType):
+			emit(stringify, "true", 4);
+			break;
 		
-		if (!isArray)
-		{
-			for (index = 0; index < object->hashmapCount; ++index)
-			{
-				if (object->hashmap[index].value.check == 1)
-				{
-					property = Key.textOf(object->hashmap[index].value.key);
-					hasValue |= stringifyValue(stringify, value, Value.text(property), object->hashmap[index].value, isArray, hasValue);
-				}
-			}
-		}
+		case Value(booleanType):
+			if (value.data.boolean->truth)
+				emit(stringify, "true", 4);
+			else
+				emit(stringify, "false", 5);
+			break;
+		
+		case Value(integerType):
+			emitInteger(stringify, value.data.integer);
+			break;
+		
+		case Value(binaryType):
+			emitBinary(stringify, value.data.binary);
+			break;
+		
+		case Value(numberType):
+			emitBinary(stringify, value.data.number->value);
+			break;
 		
-		Chars.append(&stringify->chars, "%s", strlen(stringify->spaces)? "\n": "");
+		case Value(keyType):
+		case Value(textType):
+		case Value(charsType):
+		case Value(bufferType):
+			emitString(stringify, Value.textOf(&value));
+			break;
 		
-		--stringify->level;
-		for (index = 0, count = stringify->level; index < count; ++index)
-			Chars.append(&stringify->chars, "%s", stringify->spaces);
+		case Value(stringType):
+			emitString(stringify, Text.make(value.data.string->value->bytes, value.data.string->value->length));
+			break;
 		
-		Chars.append(&stringify->chars, "%s", isArray? "]": "}");
+		case Value(objectType):
+		case Value(errorType):
+		case Value(regexpType):
+		case Value(dateType):
+		case Value(hostType):
+		case Value(referenceType):
+		{
+			struct Object *object = value.data.object;
+			int isArray = Value.objectIsArray(object);
+			int hasValue = 0;
+			
+			emitByte(stringify, isArray? '[': '{');
+			++stringify->level;
+			
+			for (index = 0, count = object->elementCount < Object(ElementMax)? object->elementCount: Object(ElementMax); index < count; ++index)
+				if (object->element[index].value.check == 1)
+					hasValue |= stringifyValue(stringify, value, Value.integer(index), object->element[index].value, isArray, hasValue);
+			
+			if (!isArray)
+				for (index = 0; index < object->hashmapCount; ++index)
+					if (object->hashmap[index].value.check == 1)
+						hasValue |= stringifyValue(stringify, value, Value.text(Key.textOf(object->hashmap[index].value.key)), object->hashmap[index].value, isArray, hasValue);
+			
+			--stringify->level;
+			if (hasValue)
+				emitIndent(stringify);
+			
+			emitByte(stringify, isArray? ']': '}');
+			break;
+		}
 	}
-	else
-		Chars.appendValue(&stringify->chars, &stringify->context, value);
 	
 	return 1;
 }
 
 static
-struct Value jsonStringify (struct Context * const context)
+void stringifyRoot (struct Stringify *stringify, struct Context * const context, struct Value value, struct Value replacer, struct Value space)
 {
-	struct Value value, replacer, space;
-	struct Stringify stringify = {
-		.context = {
-			.parent = context,
-			.ecc = context->ecc,
-			.depth = context->depth + 1,
-			.textIndex = Context(callIndex),
-		},
-		.spaces = { 0 },
+	stringify->context = (struct Context){
+		.parent = context,
+		.ecc = context->ecc,
+		.depth = context->depth + 1,
+		.textIndex = Context(callIndex),
 	};
 	
-	value = Context.argument(context, 0);
-	replacer = Context.argument(context, 1);
-	space = Context.argument(context, 2);
-	
-	stringify.filter = replacer.type == Value(objectType) && replacer.data.object->type == &Array(type)? replacer.data.object: NULL;
-	stringify.function = replacer.type == Value(functionType)? replacer.data.function: NULL;
-	stringify.ops = stringify.function? stringify.function->oplist->ops: NULL;
+	stringify->filter = replacer.type == Value(objectType) && replacer.data.object->type == &Array(type)? replacer.data.object: NULL;
+	stringify->function = replacer.type == Value(functionType)? replacer.data.function: NULL;
+	stringify->ops = stringify->function? stringify->function->oplist->ops: NULL;
 	
 	if (Value.isString(space))
-		snprintf(stringify.spaces, sizeof(stringify.spaces), "%.*s", (int)Value.stringLength(&space), Value.stringBytes(&space));
+		snprintf(stringify->spaces, sizeof(stringify->spaces), "%.*s", (int)Value.stringLength(&space), Value.stringBytes(&space));
 	else if (Value.isNumber(space))
 	{
 		int i = Value.toInteger(context, space).data.integer;
@@ -593,50 +1067,69 @@ struct Value jsonStringify (struct Context * const context)
 			i = 10;
 		
 		while (i--)
-			strcat(stringify.spaces, " ");
+			strcat(stringify->spaces, " ");
 	}
+	stringify->spaceLength = strlen(stringify->spaces);
 	
-	Chars.beginAppend(&stringify.chars);
-	
-	if (stringify.function && stringify.function->flags & Function(needHeap))
+	if (stringify->function && stringify->function->flags & Function(needHeap))
 	{
-		struct Object *environment = Object.copy(&stringify.function->environment);
+		struct Object *environment = Object.copyEnvironment(&stringify->function->environment);
 		
-		stringify.context.environment = environment;
-		stringify.arguments = Arguments.createSized(2);
-		++stringify.arguments->referenceCount;
+		stringify->context.environment = environment;
+		stringify->arguments = Arguments.createSized(2);
+		++stringify->arguments->referenceCount;
 		
-		environment->hashmap[2].value = Value.object(stringify.arguments);
+		environment->hashmap[2].value = Value.object(stringify->arguments);
 		
-		stringifyValue(&stringify, value, Value.text(&Text(empty)), value, 1, 0);
+		stringifyValue(stringify, value, Value.text(&Text(empty)), value, 1, 0);
 	}
-	else if (stringify.function)
+	else if (stringify->function)
 	{
-		struct Object environment = stringify.function->environment;
+		struct Object environment = stringify->function->environment;
 		struct Object arguments = Object.identity;
-		union Object(Hashmap) hashmap[stringify.function->environment.hashmapCapacity];
+		union Object(Hashmap) hashmap[stringify->function->environment.hashmapCapacity];
 		union Object(Element) element[2];
 		
-		memcpy(hashmap, stringify.function->environment.hashmap, sizeof(hashmap));
-		stringify.context.environment = &environment;
-		stringify.arguments = &arguments;
+		memcpy(hashmap, stringify->function->environment.hashmap, sizeof(hashmap));
+		stringify->context.environment = &environment;
+		stringify->arguments = &arguments;
 		
 		arguments.element = element;
 		arguments.elementCount = 2;
 		environment.hashmap = hashmap;
 		environment.hashmap[2].value = Value.object(&arguments);
 		
-		stringifyValue(&stringify, value, Value.text(&Text(empty)), value, 1, 0);
+		stringifyValue(stringify, value, Value.text(&Text(empty)), value, 1, 0);
 	}
 	else
-		stringifyValue(&stringify, value, Value.text(&Text(empty)), value, 1, 0);
+		stringifyValue(stringify, value, Value.text(&Text(empty)), value, 1, 0);
+}
+
+static
+struct Value jsonStringify (struct Context * const context)
+{
+	struct Stringify stringify = { 0 };
+	
+	stringify.chars = Chars.createSized(charsCapacity);
+	stringify.bytes = stringify.chars->bytes;
+	stringify.capacity = charsCapacity;
+	
+	stringifyRoot(&stringify, context, Context.argument(context, 0), Context.argument(context, 1), Context.argument(context, 2));
 	
-	return Chars.endAppend(&stringify.chars);
+	stringify.chars->length = stringify.length;
+	stringify.chars->bytes[stringify.length] = '\0';
+	return Value.chars(stringify.chars);
+}
+
+static
+void writeFile (void *user, const char *bytes, uint32_t length)
+{
+	fwrite(bytes, 1, length, user);
 }
 
 // MARK: - Public
 
-struct Object * JSON(object) = NULL;
+Ecc(threadlocal) struct Object * JSON(object) = NULL;
 
 void setup ()
 {
@@ -652,3 +1145,22 @@ void teardown (void)
 {
 	JSON(object) = NULL;
 }
+
+void stringify (struct Context * const context, struct Value value, struct Value replacer, struct Value space, JSON(Writer) write, void *user)
+{
+	char buffer[writeCapacity];
+	struct Stringify stringify = { 0 };
+	
+	stringify.bytes = buffer;
+	stringify.capacity = sizeof(buffer);
+	stringify.write = write;
+	stringify.user = user;
+	
+	stringifyRoot(&stringify, context, value, replacer, space);
+	flush(&stringify);
+}
+
+void stringifyToFile (struct Context * const context, struct Value value, struct Value space, FILE *file)
+{
+	stringify(context, value, Value(undefined), space, writeFile, file);
+}
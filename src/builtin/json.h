@@ -16,8 +16,11 @@
 #define json_h
 
 	#include "global.h"
+	
+	// receives stringified output in order, in chunks of any size
+	typedef void io_libecc_interface_Unwrap ((* JSON(Writer))) (void *user, const char *bytes, uint32_t length);
 
-	extern struct Object * JSON(object);
+	extern Ecc(threadlocal) struct Object * JSON(object);
 	extern const struct Object(Type) JSON(type);
 
 #endif
@@ -27,6 +30,9 @@ Interface(JSON,
 	
 	(void, setup ,(void))
 	(void, teardown ,(void))
+	
+	(void, stringify ,(struct Context * const, struct Value value, struct Value replacer, struct Value space, JSON(Writer), void *user))
+	(void, stringifyToFile ,(struct Context * const, struct Value value, struct Value space, FILE *))
 	,
 	{
 		char empty;
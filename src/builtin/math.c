@@ -260,7 +260,7 @@ struct Value mathTan (struct Context * const context)
 
 // MARK: - Public
 
-struct Object * Math(object) = NULL;
+Ecc(threadlocal) struct Object * Math(object) = NULL;
 
 void setup ()
 {
@@ -14,8 +14,8 @@
 
 // MARK: - Private
 
-struct Object * Number(prototype) = NULL;
-struct Function * Number(constructor) = NULL;
+Ecc(threadlocal) struct Object * Number(prototype) = NULL;
+Ecc(threadlocal) struct Function * Number(constructor) = NULL;
 
 const struct Object(Type) Number(type) = {
 	.text = &Text(numberType),
@@ -227,8 +227,8 @@ struct Number * create (double binary)
 {
 	struct Number *self = malloc(sizeof(*self));
 	*self = Number.identity;
-	Pool.addObject(&self->object);
 	Object.initialize(&self->object, Number(prototype));
+	Pool.addObject(&self->object);
 	
 	self->value = binary;
 	
@@ -17,8 +17,8 @@
 
 	#include "global.h"
 
-	extern struct Object * Number(prototype);
-	extern struct Function * Number(constructor);
+	extern Ecc(threadlocal) struct Object * Number(prototype);
+	extern Ecc(threadlocal) struct Function * Number(constructor);
 	extern const struct Object(Type) Number(type);
 
 #endif
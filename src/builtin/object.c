@@ -20,8 +20,11 @@ const uint32_t Object(ElementMax) = 0xffffff;
 
 static const int defaultSize = 8;
 
-struct Object * Object(prototype) = NULL;
-struct Function * Object(constructor) = NULL;
+// bumped when a watched object (on the chain of a cached lookup) gains a member, or a new one gets watched
+static Ecc(threadlocal) uint32_t watchEpoch = 1;
+
+Ecc(threadlocal) struct Object * Object(prototype) = NULL;
+Ecc(threadlocal) struct Function * Object(constructor) = NULL;
 
 const struct Object(Type) Object(type) = {
 	.text = &Text(objectType),
@@ -29,18 +32,66 @@ const struct Object(Type) Object(type) = {
 
 // MARK: - Static Members
 
+static
+void watchChain (struct Object *self, struct Object *holder, struct Object(Cache) *cache)
+{
+	struct Object *object;
+	
+	for (object = self->prototype; object != holder; object = object->prototype)
+		if (!(object->flags & Object(watched)))
+		{
+			object->flags |= Object(watched);
+			++watchEpoch;
+		}
+	
+	cache->prototype = self->prototype;
+	cache->epoch = watchEpoch;
+}
+
+static inline
+int keyDepth (const struct Key key)
+{
+	return key.data.integer < Key(longBase)? Key(shortDepth): Key(longDepth);
+}
+
+static inline
+uint8_t keyNibble (const struct Key key, int depth)
+{
+	uint32_t number = key.data.integer;
+	
+	if (number < Key(longBase))
+		return number >> ((Key(shortDepth) - 1 - depth) * 4) & 0xf;
+	else if (depth)
+		return (number - Key(longBase)) >> ((Key(longDepth) - 1 - depth) * 4) & 0xf;
+	else
+		return 0xf;
+}
+
 static inline
 uint16_t getSlot (const struct Object * const self, const struct Key key)
 {
-	return
-		self->hashmap[
-		self->hashmap[
-		self->hashmap[
-		self->hashmap[1]
-		.slot[key.data.depth[0]]]
-		.slot[key.data.depth[1]]]
-		.slot[key.data.depth[2]]]
-		.slot[key.data.depth[3]];
+	uint32_t number = key.data.integer;
+	
+	if (number < Key(longBase))
+		return
+			self->hashmap[
+			self->hashmap[
+			self->hashmap[
+			self->hashmap[1]
+			.slot[number >> 12]]
+			.slot[number >> 8 & 0xf]]
+			.slot[number >> 4 & 0xf]]
+			.slot[number & 0xf];
+	else
+	{
+		uint16_t slot = 1;
+		int depth;
+		
+		for (depth = 0; depth < Key(longDepth); ++depth)
+			slot = self->hashmap[slot].slot[keyNibble(key, depth)];
+		
+		return slot;
+	}
 }
 
 static inline
@@ -51,7 +102,10 @@ uint32_t getIndexOrKey (struct Value property, struct Key *key)
 	assert(Value.isPrimitive(property));
 	
 	if (property.type == Value(keyType))
-		*key = property.data.key;
+	{
+		if (key)
+			*key = property.data.key;
+	}
 	else
 	{
 		if (property.type == Value(integerType) && property.data.integer >= 0)
@@ -61,7 +115,7 @@ uint32_t getIndexOrKey (struct Value property, struct Key *key)
 		else if (Value.isString(property))
 		{
 			struct Text text = Value.textOf(&property);
-			if ((index = Lexer.scanElement(text)) == UINT32_MAX)
+			if ((index = Lexer.scanElement(text)) == UINT32_MAX && key)
 				*key = Key.makeWithText(text, Key(copyOnCreate));
 		}
 		else
@@ -71,6 +125,36 @@ uint32_t getIndexOrKey (struct Value property, struct Key *key)
 	return index;
 }
 
+// numbers & numeric strings that are not indices of a typed array are no members of it either
+
+static
+int isTypedNumericKey (struct Object *self, struct Value property)
+{
+	char buffer[Chars(binaryLength)];
+	struct Text text;
+	double binary;
+	
+	if (!TypedArray.isTypedArray(self) || getIndexOrKey(property, NULL) < UINT32_MAX)
+		return 0;
+	
+	if (Value.isNumber(property))
+		return 1;
+	else if (!Value.isString(property))
+		return 0;
+	
+	text = Value.textOf(&property);
+	binary = Lexer.scanBinary(text, 0).data.binary;
+	
+	if (isnan(binary))
+		return text.length == 3 && !memcmp(text.bytes, "NaN", 3);
+	else if (isinf(binary))
+		return text.length == 8 + (binary < 0) && !memcmp(text.bytes, "-Infinity" + (binary > 0), text.length);
+	else if (binary == 0 && signbit(binary))
+		return text.length == 2 && !memcmp(text.bytes, "-0", 2);
+	
+	return Chars.writeBinary(buffer, binary) == text.length && !memcmp(buffer, text.bytes, text.length);
+}
+
 static inline
 struct Key keyOfIndex (uint32_t index, int create)
 {
@@ -158,6 +242,9 @@ struct Value hasOwnProperty (struct Context * const context)
 	
 	self = Value.toObject(context, Context.this(context)).data.object;
 	value = Value.toPrimitive(context, Context.argument(context, 0), Value(hintString));
+	if (isTypedNumericKey(self, value))
+		return Value(false);
+	
 	index = getIndexOrKey(value, &key);
 	
 	if (index < UINT32_MAX)
@@ -288,6 +375,10 @@ struct Value getOwnPropertyNames (struct Context * const context)
 		if (object->element[index].value.check == 1)
 			addElement(result, length++, Value.chars(Chars.create("%d", index)), 0);
 	
+	if (TypedArray.isTypedArray(object))
+		for (index = 0, count = ((struct TypedArray *)object)->length; index < count; ++index)
+			addElement(result, length++, Value.chars(Chars.create("%d", index)), 0);
+	
 	parent = object;
 	while (( parent = parent->prototype ))
 	{
@@ -622,6 +713,10 @@ struct Value keys (struct Context * const context)
 		if (object->element[index].value.check == 1 && !(object->element[index].value.flags & Value(hidden)))
 			addElement(result, length++, Value.chars(Chars.create("%d", index)), 0);
 	
+	if (TypedArray.isTypedArray(object))
+		for (index = 0, count = ((struct TypedArray *)object)->length; index < count; ++index)
+			addElement(result, length++, Value.chars(Chars.create("%d", index)), 0);
+	
 	parent = object;
 	while (( parent = parent->prototype ))
 	{
@@ -688,9 +783,11 @@ struct Object * create (struct Object *prototype)
 
 struct Object * createSized (struct Object *prototype, uint16_t size)
 {
-	struct Object *self = calloc(sizeof(*self), 1);
+	struct Object *self = Pool.allocate(sizeof(*self));
+	initializeSized(self, prototype, size);
+	self->flags |= Object(slab);
 	Pool.addObject(self);
-	return initializeSized(self, prototype, size);
+	return self;
 }
 
 struct Object * createTyped (const struct Object(Type) *type)
@@ -727,7 +824,7 @@ struct Object * initializeSized (struct Object * restrict self, struct Object *
 		self->hashmapCapacity = size;
 		
 		byteSize = sizeof(*self->hashmap) * self->hashmapCapacity;
-		self->hashmap = malloc(byteSize);
+		self->hashmap = Pool.allocate(byteSize);
 		memset(self->hashmap, 0, byteSize);
 	}
 	else
@@ -744,8 +841,8 @@ struct Object * finalize (struct Object *self)
 	if (self->type->finalize)
 		self->type->finalize(self);
 	
-	free(self->hashmap), self->hashmap = NULL;
-	free(self->element), self->element = NULL;
+	Pool.deallocate(self->hashmap, sizeof(*self->hashmap) * self->hashmapCapacity), self->hashmap = NULL;
+	free(self->element - self->elementOffset), self->element = NULL;
 	
 	return self;
 }
@@ -754,18 +851,56 @@ struct Object * copy (const struct Object *original)
 {
 	size_t byteSize;
 	
-	struct Object *self = malloc(sizeof(*self));
-	Pool.addObject(self);
+	struct Object *self = Pool.allocate(sizeof(*self));
 	
 	*self = *original;
+	self->flags &= ~(Object(gray) | Object(black) | Object(fresh) | Object(watched));
+	self->flags |= Object(slab);
+	Pool.addObject(self);
 	
-	byteSize = sizeof(*self->element) * self->elementCount;
-	self->element = malloc(byteSize);
-	memcpy(self->element, original->element, byteSize);
+	if (self->elementCount)
+	{
+		byteSize = sizeof(*self->element) * self->elementCount;
+		self->element = malloc(byteSize);
+		memcpy(self->element, original->element, byteSize);
+	}
+	else
+		self->element = NULL;
+	
+	self->elementCapacity = self->elementCount;
+	self->elementOffset = 0;
 	
 	byteSize = sizeof(*self->hashmap) * self->hashmapCount;
-	self->hashmap = malloc(byteSize);
+	self->hashmap = Pool.allocate(byteSize);
 	memcpy(self->hashmap, original->hashmap, byteSize);
+	self->hashmapCapacity = self->hashmapCount;
+	
+	return self;
+}
+
+struct Object * copyEnvironment (const struct Object *original)
+{
+	union Object(Hashmap) *hashmap;
+	struct Object *self;
+	
+	// environments of calls die in numbers: the pool keeps those it collects, hashmap included
+	
+	if (original->elementCount || !(self = Pool.reuseEnvironment(original->hashmapCount)))
+	{
+		self = copy(original);
+		self->flags |= Object(environment);
+		return self;
+	}
+	
+	hashmap = self->hashmap;
+	*self = *original;
+	self->flags &= ~(Object(gray) | Object(black) | Object(fresh) | Object(watched));
+	self->flags |= Object(slab) | Object(environment);
+	Pool.addObject(self);
+	
+	self->hashmap = hashmap;
+	memcpy(self->hashmap, original->hashmap, sizeof(*self->hashmap) * self->hashmapCount);
+	self->hashmapCapacity = self->hashmapCount;
 	
 	return self;
 }
@@ -774,7 +909,10 @@ void destroy (struct Object *self)
 {
 	assert(self);
 	
-	free(self), self = NULL;
+	if (self->flags & Object(slab))
+		Pool.deallocate(self, sizeof(*self)), self = NULL;
+	else
+		free(self), self = NULL;
 }
 
 struct Value * member (struct Object *self, struct Key member, enum Value(Flags) flags)
@@ -800,6 +938,95 @@ struct Value * member (struct Object *self, struct Key member, enum Value(Flags)
 	return NULL;
 }
 
+uint16_t ownSlot (const struct Object *self, struct Key key)
+{
+	uint16_t slot;
+	int depth;
+	
+	assert(self);
+	
+	if (( slot = getSlot(self, key) ) && self->hashmap[slot].value.check == 1)
+		return slot;
+	
+	for (depth = 0; depth < 16; ++depth)
+		if (self->hashmap[1].slot[depth])
+			return 0;
+	
+	// stripped map, only the packed slots are left
+	
+	for (slot = self->hashmapCount; slot-- > 2;)
+		if (self->hashmap[slot].value.check == 1 && Key.isEqual(self->hashmap[slot].value.key, key))
+			return slot;
+	
+	return 0;
+}
+
+struct Value * memberCached (struct Object *self, struct Key member, enum Value(Flags) flags, struct Object(Cache) *cache)
+{
+	int lookupChain = !(flags & Value(asOwn));
+	struct Object *object = self;
+	struct Value *ref = NULL;
+	uint32_t slot, depth;
+	
+	assert(self);
+	assert(cache);
+	
+	// hit: the cached slot still holds the member, and no object below it has one;
+	// for a member up the chain only the receiver is probed: the prototypes below were watched
+	// when the cache was filled, and the epoch moves if any of them gains a member since
+	
+	if (cache->depth)
+	{
+		if (cache->epoch != watchEpoch || self->prototype != cache->prototype || (( slot = getSlot(self, member) ) && self->hashmap[slot].value.check == 1))
+			object = NULL;
+		else
+			for (object = self->prototype, depth = cache->depth - 1; depth && object; --depth)
+				object = object->prototype;
+	}
+	
+	if (object && cache->slot < object->hashmapCount)
+	{
+		ref = &object->hashmap[cache->slot].value;
+		if (ref->check == 1 && ref->key.data.integer == member.data.integer)
+		{
+			#if DEBUG
+			++cache->hit;
+			#endif
+			return lookupChain || object == self || (ref->flags & flags) ? ref: NULL;
+		}
+	}
+	
+	#if DEBUG
+	++cache->miss;
+	#endif
+	object = self;
+	depth = 0;
+	
+	do
+	{
+		if (( slot = getSlot(object, member) ))
+		{
+			ref = &object->hashmap[slot].value;
+			if (ref->check == 1)
+			{
+				if (depth <= UINT16_MAX)
+				{
+					cache->slot = slot;
+					cache->depth = depth;
+					
+					if (depth)
+						watchChain(self, object, cache);
+				}
+				return lookupChain || object == self || (ref->flags & flags) ? ref: NULL;
+			}
+		}
+		++depth;
+	}
+	while ((object = object->prototype));
+	
+	return NULL;
+}
+
 struct Value * element (struct Object *self, uint32_t index, enum Value(Flags) flags)
 {
 	int lookupChain = !(flags & Value(asOwn));
@@ -814,6 +1041,8 @@ struct Value * element (struct Object *self, uint32_t index, enum Value(Flags) f
 		ref->check = 0;
 		return ref;
 	}
+	else if (TypedArray.isTypedArray(self))
+		return index < ((struct TypedArray *)self)->length? TypedArray.indexRef((struct TypedArray *)self, index): NULL;
 	else if (index > Object(ElementMax))
 	{
 		struct Key key = keyOfIndex(index, 0);
@@ -838,7 +1067,12 @@ struct Value * element (struct Object *self, uint32_t index, enum Value(Flags) f
 struct Value * property (struct Object *self, struct Value property, enum Value(Flags) flags)
 {
 	struct Key key;
-	uint32_t index = getIndexOrKey(property, &key);
+	uint32_t index;
+	
+	if (isTypedNumericKey(self, property))
+		return NULL;
+	
+	index = getIndexOrKey(property, &key);
 	
 	if (index < UINT32_MAX)
 		return element(self, index, flags);
@@ -876,6 +1110,8 @@ struct Value getElement (struct Context *context, struct Object *self, uint32_t
 {
 	if (self->type == &String(type))
 		return String.valueAtIndex((struct String *)self, index);
+	else if (TypedArray.isTypedArray(self))
+		return TypedArray.getIndex((struct TypedArray *)self, index);
 	else
 		return getValue(context, self, element(self, index, 0));
 }
@@ -883,7 +1119,12 @@ struct Value getElement (struct Context *context, struct Object *self, uint32_t
 struct Value getProperty (struct Context *context, struct Object *self, struct Value property)
 {
 	struct Key key;
-	uint32_t index = getIndexOrKey(property, &key);
+	uint32_t index;
+	
+	if (isTypedNumericKey(self, property))
+		return Value(undefined);
+	
+	index = getIndexOrKey(property, &key);
 	
 	if (index < UINT32_MAX)
 		return getElement(context, self, index);
@@ -893,7 +1134,12 @@ struct Value getProperty (struct Context *context, struct Object *self, struct V
 
 struct Value putValue (struct Context *context, struct Object *self, struct Value *ref, struct Value value)
 {
-	if (ref->flags & Value(accessor))
+	if (TypedArray.isTypedArray(self) && ref == &((struct TypedArray *)self)->ref)
+	{
+		TypedArray.putIndex(context, (struct TypedArray *)self, ((struct TypedArray *)self)->refIndex, value);
+		return value;
+	}
+	else if (ref->flags & Value(accessor))
 	{
 		assert(context);
 		
@@ -920,6 +1166,8 @@ struct Value putValue (struct Context *context, struct Object *self, struct Valu
 			value.flags = ref->flags;
 	}
 	
+	value.key = ref->key;
+	Pool.writeBarrier(value);
 	return *ref = value;
 }
 
@@ -947,7 +1195,12 @@ struct Value putElement (struct Context *context, struct Object *self, uint32_t
 {
 	struct Value *ref;
 	
-	if (index > Object(ElementMax))
+	if (TypedArray.isTypedArray(self))
+	{
+		TypedArray.putIndex(context, (struct TypedArray *)self, index, value);
+		return value;
+	}
+	else if (index > Object(ElementMax))
 	{
 		if (self->elementCapacity <= index)
 			resizeElement(self, index < UINT32_MAX? index + 1: index);
@@ -976,7 +1229,12 @@ struct Value putElement (struct Context *context, struct Object *self, uint32_t
 struct Value putProperty (struct Context *context, struct Object *self, struct Value primitive, struct Value value)
 {
 	struct Key key;
-	uint32_t index = getIndexOrKey(primitive, &key);
+	uint32_t index;
+	
+	if (isTypedNumericKey(self, primitive))
+		return value;
+	
+	index = getIndexOrKey(primitive, &key);
 	
 	if (index < UINT32_MAX)
 		return putElement(context, self, index, value);
@@ -987,46 +1245,53 @@ struct Value putProperty (struct Context *context, struct Object *self, struct V
 struct Value * addMember (struct Object *self, struct Key key, struct Value value, enum Value(Flags) flags)
 {
 	uint32_t slot = 1;
-	int depth = 0;
+	int depth = 0, depthCount = keyDepth(key);
 	
 	assert(self);
 	
 	do
 	{
-		if (!self->hashmap[slot].slot[key.data.depth[depth]])
+		if (!self->hashmap[slot].slot[keyNibble(key, depth)])
 		{
-			int need = 4 - depth - (self->hashmapCapacity - self->hashmapCount);
+			int need = depthCount - depth - (self->hashmapCapacity - self->hashmapCount);
 			if (need > 0)
 			{
 				uint16_t capacity = self->hashmapCapacity;
-				self->hashmapCapacity = self->hashmapCapacity? self->hashmapCapacity * 2: 2;
-				self->hashmap = realloc(self->hashmap, sizeof(*self->hashmap) * self->hashmapCapacity);
+				do
+					self->hashmapCapacity = self->hashmapCapacity? self->hashmapCapacity * 2: 2;
+				while (self->hashmapCapacity - capacity < need);
+				
+				self->hashmap = Pool.reallocate(self->hashmap, sizeof(*self->hashmap) * capacity, sizeof(*self->hashmap) * self->hashmapCapacity);
 				memset(self->hashmap + capacity, 0, sizeof(*self->hashmap) * (self->hashmapCapacity - capacity));
 			}
 			
 			do
 			{
 				assert(self->hashmapCount < UINT16_MAX);
-				slot = self->hashmap[slot].slot[key.data.depth[depth]] = self->hashmapCount++;
-			} while (++depth < 4);
+				slot = self->hashmap[slot].slot[keyNibble(key, depth)] = self->hashmapCount++;
+			} while (++depth < depthCount);
 			break;
 		}
 		else
 			assert(self->hashmap[slot].value.check != 1);
 		
-		slot = self->hashmap[slot].slot[key.data.depth[depth]];
+		slot = self->hashmap[slot].slot[keyNibble(key, depth)];
 		assert(slot != 1);
 		assert(slot < self->hashmapCount);
-	} while (++depth < 4);
+	} while (++depth < depthCount);
 	
 	if (value.flags & Value(accessor))
 		if (self->hashmap[slot].value.check == 1 && self->hashmap[slot].value.flags & Value(accessor))
 			if ((self->hashmap[slot].value.flags & Value(accessor)) != (value.flags & Value(accessor)))
 				value.data.function->pair = self->hashmap[slot].value.data.function;
 	
+	if (self->flags & Object(watched) && self->hashmap[slot].value.check != 1)
+		++watchEpoch;
+	
 	value.key = key;
 	value.flags |= flags;
 	
+	Pool.writeBarrier(value);
 	self->hashmap[slot].value = value;
 	
 	return &self->hashmap[slot].value;
@@ -1049,6 +1314,10 @@ struct Value * addElement (struct Object *self, uint32_t index, struct Value val
 	ref = &self->element[index].value;
 	
 	value.flags |= flags;
+	if (value.flags)
+		self->flags |= Object(flaggedElement);
+	
+	Pool.writeBarrier(value);
 	*ref = value;
 	
 	return ref;
@@ -1057,7 +1326,13 @@ struct Value * addElement (struct Object *self, uint32_t index, struct Value val
 struct Value * addProperty (struct Object *self, struct Value primitive, struct Value value, enum Value(Flags) flags)
 {
 	struct Key key;
-	uint32_t index = getIndexOrKey(primitive, &key);
+	uint32_t index;
+	
+	// past the end of the array: reads undefined, ignores writes
+	if (isTypedNumericKey(self, primitive))
+		return TypedArray.indexRef((struct TypedArray *)self, UINT32_MAX);
+	
+	index = getIndexOrKey(primitive, &key);
 	
 	if (index < UINT32_MAX)
 		return addElement(self, index, value, flags);
@@ -1068,20 +1343,16 @@ struct Value * addProperty (struct Object *self, struct Value primitive, struct
 int deleteMember (struct Object *self, struct Key member)
 {
 	struct Object *object = self;
-	uint32_t slot, refSlot;
+	uint32_t slot, refSlot = 1;
+	int depth, depthCount = keyDepth(member);
 	
 	assert(object);
 	assert(member.data.integer);
 	
-	refSlot =
-		self->hashmap[
-		self->hashmap[
-		self->hashmap[1]
-		.slot[member.data.depth[0]]]
-		.slot[member.data.depth[1]]]
-		.slot[member.data.depth[2]];
+	for (depth = 0; depth < depthCount - 1; ++depth)
+		refSlot = self->hashmap[refSlot].slot[keyNibble(member, depth)];
 	
-	slot = self->hashmap[refSlot].slot[member.data.depth[3]];
+	slot = self->hashmap[refSlot].slot[keyNibble(member, depthCount - 1)];
 	
 	if (!slot || !(object->hashmap[slot].value.check == 1))
 		return 1;
@@ -1090,7 +1361,7 @@ int deleteMember (struct Object *self, struct Key member)
 		return 0;
 	
 	object->hashmap[slot].value = Value(undefined);
-	self->hashmap[refSlot].slot[member.data.depth[3]] = 0;
+	self->hashmap[refSlot].slot[keyNibble(member, depthCount - 1)] = 0;
 	return 1;
 }
 
@@ -1098,7 +1369,9 @@ int deleteElement (struct Object *self, uint32_t index)
 {
 	assert(self);
 	
-	if (index > Object(ElementMax))
+	if (TypedArray.isTypedArray(self))
+		return index >= ((struct TypedArray *)self)->length;
+	else if (index > Object(ElementMax))
 	{
 		struct Key key = keyOfIndex(index, 0);
 		if (key.data.integer)
@@ -1121,7 +1394,12 @@ int deleteElement (struct Object *self, uint32_t index)
 int deleteProperty (struct Object *self, struct Value primitive)
 {
 	struct Key key;
-	uint32_t index = getIndexOrKey(primitive, &key);
+	uint32_t index;
+	
+	if (isTypedNumericKey(self, primitive))
+		return 1;
+	
+	index = getIndexOrKey(primitive, &key);
 	
 	if (index < UINT32_MAX)
 		return deleteElement(self, index);
@@ -1159,7 +1437,7 @@ void packValue (struct Object *self)
 			self->hashmap[valueIndex++] = data;
 		}
 	
-	self->hashmap = realloc(self->hashmap, sizeof(*self->hashmap) * (self->hashmapCount));
+	self->hashmap = Pool.reallocate(self->hashmap, sizeof(*self->hashmap) * self->hashmapCapacity, sizeof(*self->hashmap) * self->hashmapCount);
 	self->hashmapCapacity = self->hashmapCount;
 	
 	if (self->elementCount)
@@ -1175,15 +1453,15 @@ void stripMap (struct Object *self)
 	while (index < self->hashmapCount && self->hashmap[index].value.check == 1)
 		++index;
 	
+	self->hashmap = Pool.reallocate(self->hashmap, sizeof(*self->hashmap) * self->hashmapCapacity, sizeof(*self->hashmap) * index);
 	self->hashmapCapacity = self->hashmapCount = index;
-	self->hashmap = realloc(self->hashmap, sizeof(*self->hashmap) * self->hashmapCapacity);
 	
 	memset(self->hashmap + 1, 0, sizeof(*self->hashmap));
 }
 
 void reserveSlots (struct Object *self, uint16_t slots)
 {
-	int need = (slots * 4) - (self->hashmapCapacity - self->hashmapCount);
+	int need = (slots * Key(shortDepth)) - (self->hashmapCapacity - self->hashmapCount);
 	
 	assert(slots < self->hashmapCapacity);
 	
@@ -1191,14 +1469,31 @@ void reserveSlots (struct Object *self, uint16_t slots)
 	{
 		uint16_t capacity = self->hashmapCapacity;
 		self->hashmapCapacity = self->hashmapCapacity? self->hashmapCapacity * 2: 2;
-		self->hashmap = realloc(self->hashmap, sizeof(*self->hashmap) * self->hashmapCapacity);
+		self->hashmap = Pool.reallocate(self->hashmap, sizeof(*self->hashmap) * capacity, sizeof(*self->hashmap) * self->hashmapCapacity);
 		memset(self->hashmap + capacity, 0, sizeof(*self->hashmap) * (self->hashmapCapacity - capacity));
 	}
 }
 
 int resizeElement (struct Object *self, uint32_t size)
 {
-	uint32_t capacity;
+	uint32_t capacity, reserve = 0;
+	
+	if (self->elementOffset && size > self->elementCapacity)
+	{
+		// give the slots left ahead by shift back to the tail,
+		// with enough room that a queue shifts as many elements as it holds before coming back
+		union Object(Element) *block = self->element - self->elementOffset;
+		uint32_t count = self->elementCount < self->elementCapacity? self->elementCount: self->elementCapacity;
+		
+		if (self->elementOffset < count)
+			reserve = count * 2;
+		
+		memmove(block, self->element, sizeof(*self->element) * count);
+		self->element = block;
+		self->elementCapacity += self->elementOffset;
+		self->elementOffset = 0;
+		memset(self->element + count, 0, sizeof(*self->element) * (self->elementCapacity - count));
+	}
 	
 	if (size <= self->elementCapacity)
 		capacity = self->elementCapacity;
@@ -1222,6 +1517,9 @@ int resizeElement (struct Object *self, uint32_t size)
 		++capacity;
 	}
 	
+	if (capacity < reserve && reserve <= Object(ElementMax))
+		capacity = reserve;
+	
 	assert(self);
 	
 	if (capacity != self->elementCapacity)
@@ -1294,6 +1592,52 @@ int resizeElement (struct Object *self, uint32_t size)
 	return 0;
 }
 
+void shiftElement (struct Object *self, uint32_t count)
+{
+	assert(self);
+	assert(self->elementCount <= Object(ElementMax));
+	assert(count <= self->elementCount && self->elementCount <= self->elementCapacity);
+	
+	// leading slots are only skipped: the allocation starts elementOffset slots before element
+	
+	self->element += count;
+	self->elementOffset += count;
+	self->elementCapacity -= count;
+	self->elementCount -= count;
+}
+
+void unshiftElement (struct Object *self, uint32_t count)
+{
+	uint32_t size, room;
+	union Object(Element) *block;
+	
+	assert(self);
+	assert(self->elementCount <= self->elementCapacity);
+	assert(self->elementCount + count <= Object(ElementMax));
+	
+	if (self->elementOffset < count)
+	{
+		// room ahead grows with the array, so a run of unshift moves each element a few times only
+		size = self->elementCount + count;
+		room = size < 64? 64 - size: size;
+	
+		block = malloc(sizeof(*block) * (room + size));
+		if (self->elementCount)
+			memcpy(block + room + count, self->element, sizeof(*block) * self->elementCount);
+		free(self->element - self->elementOffset);
+	
+		self->element = block + room + count;
+		self->elementOffset = room + count;
+		self->elementCapacity = self->elementCount;
+	}
+	
+	self->element -= count;
+	self->elementOffset -= count;
+	self->elementCapacity += count;
+	self->elementCount += count;
+	memset(self->element, 0, sizeof(*self->element) * count);
+}
+
 void populateElementWithCList (struct Object *self, uint32_t count, const char * list[])
 {
 	double binary;
@@ -26,14 +26,37 @@
 		void (*finalize)(struct Object *);
 	};
 
+	// inline cache of a member lookup, kept by the op doing it;
+	// objects filled in the same order share slot layout, so one slot often serves them all
+	struct Object(Cache)
+	{
+		// for a member found up the chain: the receiver's prototype, and the epoch it was found in
+		struct Object *prototype;
+		uint32_t epoch;
+		uint16_t slot;
+		uint16_t depth;
+		#if DEBUG
+		// counts shown by OpList.dumpTo, kept out of release ops
+		uint32_t hit;
+		uint32_t miss;
+		#endif
+	};
+
 	enum Object(Flags)
 	{
 		Object(mark) = 1 << 0,
 		Object(sealed) = 1 << 1,
+		Object(slab) = 1 << 2,
+		Object(gray) = 1 << 3,
+		Object(black) = 1 << 4,
+		Object(fresh) = 1 << 5,
+		Object(environment) = 1 << 6,
+		Object(flaggedElement) = 1 << 7,
+		Object(watched) = 1 << 8,
 	};
 
-	extern struct Object * Object(prototype);
-	extern struct Function * Object(constructor);
+	extern Ecc(threadlocal) struct Object * Object(prototype);
+	extern Ecc(threadlocal) struct Function * Object(constructor);
 	extern const struct Object(Type) Object(type);
 	
 	extern const uint32_t Object(ElementMax);
@@ -53,11 +76,14 @@ Interface(Object,
 	(struct Object *, initializeSized ,(struct Object * restrict, struct Object * restrict prototype, uint16_t size))
 	(struct Object *, finalize ,(struct Object *))
 	(struct Object *, copy ,(const struct Object * original))
+	(struct Object *, copyEnvironment ,(const struct Object * original))
 	(void, destroy ,(struct Object *))
 	
 	(struct Value, getMember ,(struct Context * const, struct Object *, struct Key key))
 	(struct Value, putMember ,(struct Context * const, struct Object *, struct Key key, struct Value))
 	(struct Value *, member ,(struct Object *, struct Key key, enum Value(Flags)))
+	(struct Value *, memberCached ,(struct Object *, struct Key key, enum Value(Flags), struct Object(Cache) *))
+	(uint16_t, ownSlot ,(const struct Object *, struct Key key))
 	(struct Value *, addMember ,(struct Object *, struct Key key, struct Value, enum Value(Flags)))
 	(int, deleteMember ,(struct Object *, struct Key key))
 	
@@ -81,6 +107,8 @@ Interface(Object,
 	(void, reserveSlots ,(struct Object *, uint16_t slots))
 	
 	(int, resizeElement ,(struct Object *, uint32_t size))
+	(void, shiftElement ,(struct Object *, uint32_t count))
+	(void, unshiftElement ,(struct Object *, uint32_t count))
 	(void, populateElementWithCList ,(struct Object *, uint32_t count, const char * list[]))
 	
 	(struct Value, toString ,(struct Context * const))
@@ -102,11 +130,12 @@ Interface(Object,
 		
 		uint32_t elementCount;
 		uint32_t elementCapacity;
+		uint32_t elementOffset;
 		uint16_t hashmapCount;
 		uint16_t hashmapCapacity;
 		
 		int16_t referenceCount;
-		uint8_t flags;
+		uint16_t flags;
 	}
 )
 
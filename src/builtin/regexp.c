@@ -19,8 +19,8 @@ static void mark (struct Object *object);
 static void capture (struct Object *object);
 static void finalize (struct Object *object);
 
-struct Object * RegExp(prototype) = NULL;
-struct Function * RegExp(constructor) = NULL;
+Ecc(threadlocal) struct Object * RegExp(prototype) = NULL;
+Ecc(threadlocal) struct Function * RegExp(constructor) = NULL;
 
 const struct Object(Type) RegExp(type) = {
 	.text = &Text(regexpType),
@@ -57,6 +57,8 @@ enum Opcode {
 	opBytes,
 	opJump,
 	opMatch,
+	opClear,
+	opProgress,
 };
 
 struct RegExp(Node) {
@@ -109,6 +111,7 @@ void finalize (struct Object *object)
 	}
 	
 	free(self->program), self->program = NULL;
+	free(self->linear), self->linear = NULL;
 	
 	--self->pattern->referenceCount;
 	--self->source->referenceCount;
@@ -145,6 +148,8 @@ void printNode (struct RegExp(Node) *n)
 		case opBytes: fprintf(stderr, "bytes "); break;
 		case opJump: fprintf(stderr, "jump "); break;
 		case opMatch: fprintf(stderr, "match "); break;
+		case opClear: fprintf(stderr, "clear "); break;
+		case opProgress: fprintf(stderr, "progress "); break;
 	}
 	fprintf(stderr, "%d", n->offset);
 	if (n->bytes)
@@ -795,6 +800,140 @@ int forkMatch (struct RegExp(State) * const s, struct RegExp(Node) *n, struct Te
 	return result;
 }
 
+static
+int assertion (const struct RegExp(State) * const s, struct RegExp(Node) *n, struct Text text)
+{
+	switch ((enum Opcode)n->opcode)
+	{
+		case opStart:
+			return text.bytes == s->start;
+			
+		case opEnd:
+			return text.bytes == s->end;
+			
+		case opLineStart:
+		{
+			struct Text prev = Text.make(text.bytes, (int32_t)(text.bytes - s->start));
+			return text.bytes == s->start || Text.isLineFeed(Text.prevCharacter(&prev));
+		}
+			
+		case opLineEnd:
+			return text.bytes == s->end || Text.isLineFeed(Text.character(text));
+			
+		case opBoundary:
+		{
+			struct Text prev = Text.make(text.bytes, (int32_t)(text.bytes - s->start));
+			if (text.bytes == s->start)
+				return Text.isWord(Text.character(text)) == n->offset;
+			else if (text.bytes == s->end)
+				return Text.isWord(Text.prevCharacter(&prev)) == n->offset;
+			else
+				return (Text.isWord(Text.prevCharacter(&prev)) != Text.isWord(Text.character(text))) == n->offset;
+		}
+			
+		default:
+			break;
+	}
+	abort();
+}
+
+static
+int consume (struct RegExp(Node) *n, struct Text *text)
+{
+	switch ((enum Opcode)n->opcode)
+	{
+		case opDigit:
+			return text->length >= 1 && Text.isDigit(Text.nextCharacter(text)) == n->offset;
+			
+		case opSpace:
+			return text->length >= 1 && Text.isSpace(Text.nextCharacter(text)) == n->offset;
+			
+		case opWord:
+			return text->length >= 1 && Text.isWord(Text.nextCharacter(text)) == n->offset;
+			
+		case opBytes:
+			if (text->length < n->offset || memcmp(n->bytes, text->bytes, n->offset))
+				return 0;
+			
+			Text.advance(text, n->offset);
+			return 1;
+			
+		case opOneOf:
+		case opNeitherOf:
+		{
+			char buffer[5];
+			struct Text(Char) c;
+			
+			if (!text->length)
+				return 0;
+			
+			c = Text.character(*text);
+			memcpy(buffer, text->bytes, c.units);
+			buffer[c.units] = '\0';
+			
+			if ((n->bytes && strstr(n->bytes, buffer)) != (n->opcode == opOneOf))
+				return 0;
+			
+			Text.nextCharacter(text);
+			return 1;
+		}
+			
+		case opInRange:
+		case opInRangeCase:
+		{
+			struct Text range = Text.make(n->bytes, n->offset);
+			struct Text(Char) from, to, c;
+			
+			if (!text->length)
+				return 0;
+			
+			from = Text.nextCharacter(&range);
+			Text.advance(&range, 1);
+			to = Text.nextCharacter(&range);
+			c = Text.character(*text);
+			
+			if (n->opcode == opInRangeCase)
+			{
+				char buffer[c.units];
+				struct Text casetext = Text.make(buffer, 0);
+				
+				casetext.length = (int32_t)(Text.toLower(Text.make(text->bytes, (int32_t)sizeof(buffer)), buffer) - buffer);
+				c = Text.character(casetext);
+				if (c.units == casetext.length && (c.codepoint >= from.codepoint && c.codepoint <= to.codepoint))
+				{
+					Text.nextCharacter(text);
+					return 1;
+				}
+				
+				casetext.length = (int32_t)(Text.toUpper(Text.make(text->bytes, (int32_t)sizeof(buffer)), buffer) - buffer);
+				c = Text.character(casetext);
+				if (c.units == casetext.length && (c.codepoint >= from.codepoint && c.codepoint <= to.codepoint))
+				{
+					Text.nextCharacter(text);
+					return 1;
+				}
+			}
+			else
+			{
+				if ((c.codepoint >= from.codepoint && c.codepoint <= to.codepoint))
+				{
+					Text.nextCharacter(text);
+					return 1;
+				}
+			}
+			
+			return 0;
+		}
+			
+		case opAny:
+			return text->length >= 1 && !Text.isLineFeed(Text.nextCharacter(text));
+			
+		default:
+			break;
+	}
+	abort();
+}
+
 
 int match (struct RegExp(State) * const s, struct RegExp(Node) *n, struct Text text)
 {
@@ -819,56 +958,15 @@ start:
 			return 0;
 			
 		case opStart:
-			if (text.bytes != s->start)
-				return 0;
-			
-			goto next;
-			
 		case opEnd:
-			if (text.bytes != s->end)
-				return 0;
-			
-			goto next;
-			
 		case opLineStart:
-		{
-			struct Text prev = Text.make(text.bytes, (int32_t)(text.bytes - s->start));
-			if (text.bytes != s->start && !Text.isLineFeed(Text.prevCharacter(&prev)))
-				return 0;
-			
-			goto next;
-		}
-			
 		case opLineEnd:
-			if (text.bytes != s->end && !Text.isLineFeed(Text.character(text)))
+		case opBoundary:
+			if (!assertion(s, n, text))
 				return 0;
 			
 			goto next;
 			
-		case opBoundary:
-		{
-			struct Text prev = Text.make(text.bytes, (int32_t)(text.bytes - s->start));
-			if (text.bytes == s->start)
-			{
-				if (Text.isWord(Text.character(text)) != n->offset)
-					return 0;
-			}
-			else if (text.bytes == s->end)
-			{
-				if (Text.isWord(Text.prevCharacter(&prev)) != n->offset)
-					return 0;
-			}
-			else
-			{
-				if ((Text.isWord(Text.prevCharacter(&prev))
-					!=
-					Text.isWord(Text.character(text))) != n->offset
-					)
-					return 0;
-			}
-			goto next;
-		}
-			
 		case opSplit:
 			if (forkMatch(s, n, text, 1))
 				return 1;
@@ -942,137 +1040,602 @@ start:
 		}
 			
 		case opDigit:
-			if (text.length < 1 || Text.isDigit(Text.nextCharacter(&text)) != n->offset)
-				return 0;
-			
-			goto next;
-			
 		case opSpace:
-			if (text.length < 1 || Text.isSpace(Text.nextCharacter(&text)) != n->offset)
-				return 0;
-			
-			goto next;
-			
 		case opWord:
-			if (text.length < 1 || Text.isWord(Text.nextCharacter(&text)) != n->offset)
-				return 0;
-			
-			goto next;
-			
 		case opBytes:
-			if (text.length < n->offset || memcmp(n->bytes, text.bytes, n->offset))
+		case opOneOf:
+		case opNeitherOf:
+		case opInRange:
+		case opInRangeCase:
+		case opAny:
+			if (!consume(n, &text))
 				return 0;
 			
-			Text.advance(&text, n->offset);
 			goto next;
 			
-		case opOneOf:
-		{
-			char buffer[5];
-			struct Text(Char) c;
+		case opJump:
+			goto jump;
 			
-			if (!text.length)
-				return 0;
+		case opMatch:
+			s->capture[1] = text.bytes;
+			return 1;
 			
-			c = Text.character(text);
-			memcpy(buffer, text.bytes, c.units);
-			buffer[c.units] = '\0';
+		case opClear:
+		case opProgress:
+		case opOver:
+			break;
+	}
+	abort();
+	
+jump:
+	n += n->offset;
+	goto start;
+}
+
+
+//MARK: linear matching
+
+// programs without references nor lookaheads run over a thread list
+// (pike vm): each input character is read once whatever the pattern,
+// the leftmost thread wins as it would when backtracking
+
+enum {
+	linearLimit = 0x1000,
+	linearCaptures = 0x10000,
+};
+
+struct Compile {
+	struct RegExp(Node) *program;
+	struct RegExp(Node) *nodes;
+	int count;
+	int capacity;
+	int slots;
+	int depth;
+	int registers;
+};
+
+struct Optional {
+	int from;
+	int target;
+	int split;
+	int check;
+};
+
+struct Threads {
+	int count;
+	uint16_t *pc;
+	const char **capture;
+};
+
+struct Linear {
+	const struct RegExp(State) *state;
+	struct RegExp(Node) *program;
+	uint32_t *seen;
+	uint32_t generation;
+	int slots;
+};
+
+static
+int isCharacter (struct RegExp(Node) *n)
+{
+	if (n->opcode == opBytes)
+		return Text.character(Text.make(n->bytes, n->offset)).units == n->offset;
+	
+	return n->opcode >= opAny && n->opcode <= opWord;
+}
+
+static
+int emit (struct Compile *c, enum Opcode opcode, int16_t offset, char *bytes)
+{
+	if (c->count >= linearLimit)
+		return -1;
+	
+	if (c->count >= c->capacity)
+	{
+		c->capacity = c->capacity? c->capacity * 2: 32;
+		c->nodes = realloc(c->nodes, sizeof(*c->nodes) * c->capacity);
+	}
+	
+	c->nodes[c->count].bytes = bytes;
+	c->nodes[c->count].offset = offset;
+	c->nodes[c->count].opcode = opcode;
+	c->nodes[c->count].depth = 0;
+	return c->count++;
+}
+
+static int compileRange (struct Compile *c, int from, int to);
+
+static
+int compileIteration (struct Compile *c, int from, int to, int check)
+{
+	int index;
+	
+	// an optional iteration must not match empty
+	if (check >= 0 && emit(c, opSave, check, NULL) < 0)
+		return -1;
+	
+	// captures of a repeated atom are reset at each iteration
+	for (index = from; index < to; ++index)
+		if (c->program[index].opcode == opSave && emit(c, opClear, c->program[index].offset, NULL) < 0)
+			return -1;
+	
+	if (compileRange(c, from, to) < 0)
+		return -1;
+	
+	if (check >= 0 && emit(c, opProgress, check, NULL) < 0)
+		return -1;
+	
+	return 0;
+}
+
+static
+int compileLoop (struct Compile *c, int from, int to)
+{
+	struct RegExp(Node) *redo = c->program + to;
+	int min = (uint8_t)redo->bytes[0], max = (uint8_t)redo->bytes[1], lazy = redo->bytes[2];
+	int exits[0x100], count = 0, index, loop, check = c->slots + c->depth;
+	
+	// loops nested at the same depth never overlap: they share a register
+	if (++c->depth > c->registers)
+		c->registers = c->depth;
+	
+	// body then redo: at least one iteration, a preceding split covers none
+	for (index = 0; index < (min? min: 1); ++index)
+		if (compileIteration(c, from, to, index < min? -1: check) < 0)
+			return -1;
+	
+	if (!max)
+	{
+		loop = c->count;
+		if (lazy)
+		{
+			if (emit(c, opSplit, 2, NULL) < 0)
+				return -1;
 			
-			if (n->bytes && strstr(n->bytes, buffer))
+			exits[count++] = emit(c, opJump, 0, NULL);
+		}
+		else
+			exits[count++] = emit(c, opSplit, 0, NULL);
+		
+		if (exits[count - 1] < 0 || compileIteration(c, from, to, check) < 0 || emit(c, opJump, loop - c->count, NULL) < 0)
+			return -1;
+	}
+	else
+		for (; index < max; ++index)
+		{
+			if (lazy)
 			{
-				Text.nextCharacter(&text);
-				goto next;
+				if (emit(c, opSplit, 2, NULL) < 0)
+					return -1;
+				
+				exits[count++] = emit(c, opJump, 0, NULL);
 			}
-			return 0;
-		}
+			else
+				exits[count++] = emit(c, opSplit, 0, NULL);
 			
-		case opNeitherOf:
+			if (exits[count - 1] < 0 || compileIteration(c, from, to, check) < 0)
+				return -1;
+		}
+	
+	while (count--)
+		c->nodes[exits[count]].offset = c->count - exits[count];
+	
+	--c->depth;
+	return 0;
+}
+
+static
+int closeOptionals (struct Compile *c, struct Optional *open, int *openCount, struct Optional *closed, int *closedCount, int index)
+{
+	struct Optional *optional;
+	
+	while (*openCount && open[*openCount - 1].target == index)
+	{
+		optional = closed + (*closedCount)++;
+		*optional = open[--*openCount];
+		optional->check = c->count;
+		
+		if (emit(c, opProgress, c->slots + --c->depth, NULL) < 0)
+			return -1;
+		
+		c->nodes[optional->split].offset = c->count - optional->split;
+	}
+	return 0;
+}
+
+int compileRange (struct Compile *c, int from, int to)
+{
+	int length = to - from + 1, index = from, count = 0, openCount = 0, closedCount = 0, loop, target, jump, inner;
+	int *map = malloc(sizeof(*map) * length * 3), *jumps = map + length;
+	struct Optional *open = malloc(sizeof(*open) * length * 2), *closed = open + length;
+	struct RegExp(Node) *n;
+	
+	while (index < to)
+	{
+		n = c->program + index;
+		
+		if (closeOptionals(c, open, &openCount, closed, &closedCount, index) < 0)
+			goto error;
+		
+		map[index - from] = c->count;
+		
+		for (loop = to - 1; loop > index; --loop)
+			if (c->program[loop].opcode == opRedo && loop + c->program[loop].offset == index)
+				break;
+		
+		if (loop > index)
 		{
-			char buffer[5];
-			struct Text(Char) c;
+			if (compileLoop(c, index, loop) < 0)
+				goto error;
 			
-			if (!text.length)
-				return 0;
-			
-			c = Text.character(text);
-			memcpy(buffer, text.bytes, c.units);
-			buffer[c.units] = '\0';
+			while (++index <= loop)
+				map[index - from] = -1;
 			
-			if (n->bytes && strstr(n->bytes, buffer))
-				return 0;
-			
-			Text.nextCharacter(&text);
-			goto next;
+			continue;
 		}
-			
-		case opInRange:
-		case opInRangeCase:
+		
+		switch ((enum Opcode)n->opcode)
 		{
-			struct Text range = Text.make(n->bytes, n->offset);
-			struct Text(Char) from, to, c;
-			
-			if (!text.length)
-				return 0;
-			
-			from = Text.nextCharacter(&range);
-			Text.advance(&range, 1);
-			to = Text.nextCharacter(&range);
-			c = Text.character(text);
-			
-			if (n->opcode == opInRangeCase)
-			{
-				char buffer[c.units];
-				struct Text casetext = Text.make(buffer, 0);
+			case opSplit:
+				target = index + n->offset;
 				
-				casetext.length = (int32_t)(Text.toLower(Text.make(text.bytes, (int32_t)sizeof(buffer)), buffer) - buffer);
-				c = Text.character(casetext);
-				if (c.units == casetext.length && (c.codepoint >= from.codepoint && c.codepoint <= to.codepoint))
+				// greedy optional term, the same empty check as a loop
+				if (n->offset > 1 && target <= to && c->program[target - 1].opcode != opJump
+					&& !(c->program[target - 1].opcode == opRedo && target - 1 + c->program[target - 1].offset == index + 1))
 				{
-					Text.nextCharacter(&text);
-					goto next;
+					open[openCount].target = target;
+					open[openCount].from = index;
+					if ((open[openCount++].split = emit(c, opSplit, 0, NULL)) < 0 || emit(c, opSave, c->slots + c->depth, NULL) < 0)
+						goto error;
+					
+					if (++c->depth > c->registers)
+						c->registers = c->depth;
+					
+					break;
 				}
 				
-				casetext.length = (int32_t)(Text.toUpper(Text.make(text.bytes, (int32_t)sizeof(buffer)), buffer) - buffer);
-				c = Text.character(casetext);
-				if (c.units == casetext.length && (c.codepoint >= from.codepoint && c.codepoint <= to.codepoint))
+			case opJump:
+				jumps[count * 2] = index;
+				if ((jumps[count++ * 2 + 1] = emit(c, n->opcode, index + n->offset, NULL)) < 0)
+					goto error;
+				
+				break;
+				
+			case opLookahead:
+			case opNLookahead:
+				// the one character tests of classes
+				if (n->offset != 3 || !isCharacter(n + 1) || n[2].opcode != opMatch)
+					goto error;
+				
+				if (emit(c, n->opcode, 3, NULL) < 0 || emit(c, n[1].opcode, n[1].offset, n[1].bytes) < 0 || emit(c, opMatch, 0, NULL) < 0)
+					goto error;
+				
+				map[++index - from] = -1;
+				map[++index - from] = -1;
+				break;
+				
+			case opBytes:
+			{
+				struct Text text = Text.make(n->bytes, n->offset);
+				const char *bytes;
+				
+				while (text.length)
 				{
+					bytes = text.bytes;
 					Text.nextCharacter(&text);
-					goto next;
+					if (emit(c, opBytes, text.bytes - bytes, (char *)bytes) < 0)
+						goto error;
 				}
+				break;
 			}
-			else
+				
+			case opStart:
+			case opEnd:
+			case opLineStart:
+			case opLineEnd:
+			case opBoundary:
+			case opSave:
+			case opAny:
+			case opOneOf:
+			case opNeitherOf:
+			case opInRange:
+			case opInRangeCase:
+			case opDigit:
+			case opSpace:
+			case opWord:
+			case opMatch:
+				if (emit(c, n->opcode, n->offset, n->bytes) < 0)
+					goto error;
+				
+				break;
+				
+			case opReference:
+			case opRedo:
+			case opNSave:
+			case opClear:
+			case opProgress:
+			case opOver:
+				goto error;
+		}
+		++index;
+	}
+	if (closeOptionals(c, open, &openCount, closed, &closedCount, to) < 0 || openCount)
+		goto error;
+	
+	map[to - from] = c->count;
+	
+	while (count--)
+	{
+		jump = jumps[count * 2 + 1];
+		target = c->nodes[jump].offset;
+		if (target < from || target > to || map[target - from] < 0)
+			goto error;
+		
+		// leaving an optional term by its end still checks it
+		for (index = 0, inner = -1; index < closedCount; ++index)
+			if (closed[index].target == target && closed[index].from < jumps[count * 2] && (inner < 0 || closed[index].from > closed[inner].from))
+				inner = index;
+		
+		c->nodes[jump].offset = (inner < 0? map[target - from]: closed[inner].check) - jump;
+	}
+	
+	free(open), open = NULL;
+	free(map), map = NULL;
+	return 0;
+	
+error:
+	free(open), open = NULL;
+	free(map), map = NULL;
+	return -1;
+}
+
+static
+struct RegExp(Node) * compileLinear (struct RegExp(Node) *program, uint8_t count, uint16_t *length, uint16_t *slots)
+{
+	struct Compile c = { program, NULL, 0, 0, count * 2 };
+	uint16_t index, programLength = nlen(program);
+	int repeats = 0;
+	
+	// straight programs do not backtrack
+	for (index = 0; index < programLength; ++index)
+		if (program[index].opcode == opSplit || program[index].opcode == opRedo)
+			repeats = 1;
+	
+	if (!repeats || programLength > linearLimit)
+		return NULL;
+	
+	if (compileRange(&c, 0, programLength) < 0 || emit(&c, opOver, 0, NULL) < 0 || (c.count - 1) * (c.slots + c.registers) > linearCaptures)
+	{
+		free(c.nodes), c.nodes = NULL;
+		return NULL;
+	}
+	
+	*length = c.count - 1;
+	*slots = c.slots + c.registers;
+	return c.nodes;
+}
+
+static
+void addThread (struct Linear *vm, struct Threads *list, uint16_t pc, struct Text text, const char **capture)
+{
+	struct RegExp(Node) *n;
+	
+	for (;;)
+	{
+		if (vm->seen[pc] == vm->generation)
+			return;
+		
+		vm->seen[pc] = vm->generation;
+		n = vm->program + pc;
+		
+		switch ((enum Opcode)n->opcode)
+		{
+			case opSplit:
+				addThread(vm, list, pc + 1, text, capture);
+				pc += n->offset;
+				continue;
+				
+			case opJump:
+				pc += n->offset;
+				continue;
+				
+			case opSave:
+			case opClear:
 			{
-				if ((c.codepoint >= from.codepoint && c.codepoint <= to.codepoint))
-				{
-					Text.nextCharacter(&text);
-					goto next;
-				}
+				const char *saved = capture[n->offset];
+				capture[n->offset] = n->opcode == opSave? text.bytes: NULL;
+				addThread(vm, list, pc + 1, text, capture);
+				capture[n->offset] = saved;
+				return;
 			}
-			
-			return 0;
+				
+			case opStart:
+			case opEnd:
+			case opLineStart:
+			case opLineEnd:
+			case opBoundary:
+				if (!assertion(vm->state, n, text))
+					return;
+				
+				++pc;
+				continue;
+				
+			case opProgress:
+				if (text.bytes == capture[n->offset])
+					return;
+				
+				++pc;
+				continue;
+				
+			case opLookahead:
+			case opNLookahead:
+			{
+				struct Text lookahead = text;
+				if (consume(n + 1, &lookahead) != n->opcode - 1)
+					return;
+				
+				pc += n->offset;
+				continue;
+			}
+				
+			default:
+				list->pc[list->count] = pc;
+				memcpy(list->capture + list->count * vm->slots, capture, sizeof(*capture) * vm->slots);
+				++list->count;
+				return;
 		}
+	}
+}
+
+static
+const char * findLiteral (const char *bytes, const char *end, struct RegExp(Node) *literal)
+{
+	const char *last = end - literal->offset;
+	
+	while (bytes <= last)
+	{
+		if (!(bytes = memchr(bytes, literal->bytes[0], last - bytes + 1)))
+			return NULL;
+		
+		if (!memcmp(bytes + 1, literal->bytes + 1, literal->offset - 1))
+			return bytes;
+		
+		++bytes;
+	}
+	return NULL;
+}
+
+static
+int matchLinear (struct RegExp *self, struct RegExp(State) *state)
+{
+	int slots = self->linearSlots, result = 0, index;
+	struct Text text = Text.make(state->start, (int32_t)(state->end - state->start)), next;
+	struct Threads lists[2], *current = lists, *following = lists + 1, *swap;
+	struct Linear vm = { state, self->linear, NULL, 1, slots };
+	const char *capture[slots], *found;
+	char *block;
+	
+	block = calloc(self->linearLength, (sizeof(*vm.seen) + 2 * sizeof(*current->pc) + 2 * slots * sizeof(*current->capture)));
+	lists[0].capture = (const char **)block;
+	lists[1].capture = lists[0].capture + self->linearLength * slots;
+	vm.seen = (uint32_t *)(lists[1].capture + self->linearLength * slots);
+	lists[0].pc = (uint16_t *)(vm.seen + self->linearLength);
+	lists[1].pc = lists[0].pc + self->linearLength;
+	lists[0].count = lists[1].count = 0;
+	
+	for (;;)
+	{
+		if (!result && (text.bytes == state->start || !self->anchored))
+		{
+			if (!current->count && self->prefix && !self->anchored)
+			{
+				if (!(found = findLiteral(text.bytes, state->end, self->prefix)))
+					break;
+				
+				Text.advance(&text, (int32_t)(found - text.bytes));
+			}
 			
-		case opAny:
-			if (text.length >= 1 && !Text.isLineFeed(Text.nextCharacter(&text)))
-				goto next;
-			
-			return 0;
+			memset(capture, 0, sizeof(capture));
+			capture[0] = text.bytes;
+			addThread(&vm, current, 0, text, capture);
+		}
+		
+		if (!current->count)
+		{
+			if (result || !text.length || self->anchored)
+				break;
 			
-		case opJump:
-			goto jump;
+			++vm.generation;
+			Text.nextCharacter(&text);
+			continue;
+		}
+		
+		++vm.generation;
+		following->count = 0;
+		
+		for (index = 0; index < current->count; ++index)
+		{
+			const char **threadCapture = current->capture + index * slots;
 			
-		case opMatch:
-			s->capture[1] = text.bytes;
-			return 1;
+			if (self->linear[current->pc[index]].opcode == opMatch)
+			{
+				// lower threads would only match further right or later
+				memcpy(state->capture, threadCapture, sizeof(*threadCapture) * self->count * 2);
+				state->capture[1] = text.bytes;
+				result = 1;
+				break;
+			}
 			
-		case opOver:
+			next = text;
+			if (consume(self->linear + current->pc[index], &next))
+				addThread(&vm, following, current->pc[index] + 1, next, threadCapture);
+		}
+		
+		if (!text.length)
 			break;
+		
+		Text.nextCharacter(&text);
+		swap = current, current = following, following = swap;
 	}
-	abort();
 	
-jump:
-	n += n->offset;
-	goto start;
+	free(block), block = NULL;
+	return result;
+}
+
+static
+void prefilter (struct RegExp *self)
+{
+	struct RegExp(Node) *n = self->program;
+	uint16_t index, count = nlen(n);
+	int reach = 0, consumed = 0, mandatory;
+	
+	// nodes no split nor jump can skip are on every path of a match
+	for (index = 0; index < count; ++index, ++n)
+	{
+		mandatory = index >= reach;
+		
+		switch ((enum Opcode)n->opcode)
+		{
+			case opSplit:
+			case opJump:
+			case opLookahead:
+			case opNLookahead:
+				if (index + n->offset > reach)
+					reach = index + n->offset;
+				
+				break;
+				
+			case opStart:
+				if (mandatory && !consumed)
+					self->anchored = 1;
+				
+				break;
+				
+			case opBytes:
+				if (mandatory)
+				{
+					if (!consumed)
+						self->prefix = n;
+					else if (!self->required || n->offset > self->required->offset)
+						self->required = n;
+				}
+				consumed = 1;
+				break;
+				
+			case opEnd:
+			case opLineStart:
+			case opLineEnd:
+			case opBoundary:
+			case opSave:
+			case opNSave:
+			case opMatch:
+				break;
+				
+			default:
+				consumed = 1;
+				break;
+		}
+	}
 }
 
 
@@ -1108,6 +1671,7 @@ struct Value exec (struct Context * const context)
 	Context.assertThisType(context, Value(regexpType));
 	
 	value = Value.toString(context, Context.argument(context, 0));
+	String.prepareIndex(value);
 	lastIndex = self->global? Value.toInteger(context, Object.getMember(context, &self->object, Key(lastIndex))): Value.integer(0);
 	
 	Object.putMember(context, &self->object, Key(lastIndex), Value.integer(0));
@@ -1164,6 +1728,7 @@ struct Value test (struct Context * const context)
 	Context.assertThisType(context, Value(regexpType));
 	
 	value = Value.toString(context, Context.argument(context, 0));
+	String.prepareIndex(value);
 	lastIndex = Value.toInteger(context, Object.getMember(context, &self->object, Key(lastIndex)));
 	
 	Object.putMember(context, &self->object, Key(lastIndex), Value.integer(0));
@@ -1221,9 +1786,9 @@ struct RegExp * create (struct Chars *s, struct Error **error, enum RegExp(Optio
 	
 	struct RegExp *self = malloc(sizeof(*self));
 	*self = RegExp.identity;
-	Pool.addObject(&self->object);
 	
 	Object.initialize(&self->object, RegExp(prototype));
+	Pool.addObject(&self->object);
 	
 	p.c = s->bytes;
 	p.end = s->bytes + s->length;
@@ -1247,6 +1812,8 @@ struct RegExp * create (struct Chars *s, struct Error **error, enum RegExp(Optio
 	self->pattern = s;
 	self->program = pattern(&p, error);
 	self->count = p.count + 1;
+	self->linear = compileLinear(self->program, self->count, &self->linearLength, &self->linearSlots);
+	prefilter(self);
 	self->source = Chars.createWithBytes((int32_t)(p.c - self->pattern->bytes - 1), self->pattern->bytes + 1);
 	
 //	++self->pattern->referenceCount;
@@ -1379,6 +1946,7 @@ int matchWithState (struct RegExp *self, struct RegExp(State) *state)
 	int result = 0;
 	uint16_t index, count;
 	struct Text text = Text.make(state->start, (int32_t)(state->end - state->start));
+	const char *found;
 	
 #if DUMP_REGEXP
 	struct RegExp(Node) *n = self->program;
@@ -1386,15 +1954,33 @@ int matchWithState (struct RegExp *self, struct RegExp(State) *state)
 		printNode(n++);
 #endif
 	
+	if (self->required && !findLiteral(state->start, state->end, self->required))
+		return 0;
+	
+	if (self->linear)
+		return matchLinear(self, state);
+	
 	do
 	{
+		if (self->prefix && !self->anchored)
+		{
+			if (!(found = findLiteral(text.bytes, state->end, self->prefix)))
+				break;
+			
+			Text.advance(&text, (int32_t)(found - text.bytes));
+		}
+		
 		memset(state->capture, 0, sizeof(*state->capture) * (self->count * 2));
 		memset(state->index, 0, sizeof(*state->index) * (self->count * 2));
 		state->capture[0] = state->index[0] = text.bytes;
 		result = match(state, self->program, text);
+		
+		if (!text.length)
+			break;
+		
 		Text.nextCharacter(&text);
 	}
-	while (!result && text.length);
+	while (!result && !self->anchored);
 	
 	/* XXX: cleanup */
 	
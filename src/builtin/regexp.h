@@ -17,8 +17,8 @@
 
 	#include "global.h"
 
-	extern struct Object * RegExp(prototype);
-	extern struct Function * RegExp(constructor);
+	extern Ecc(threadlocal) struct Object * RegExp(prototype);
+	extern Ecc(threadlocal) struct Function * RegExp(constructor);
 	extern const struct Object(Type) RegExp(type);
 
 	struct RegExp(State) {
@@ -53,10 +53,16 @@ Interface(RegExp,
 		struct Chars *pattern;
 		struct Chars *source;
 		struct RegExp(Node) *program;
+		struct RegExp(Node) *linear;
+		struct RegExp(Node) *prefix;
+		struct RegExp(Node) *required;
+		uint16_t linearLength;
+		uint16_t linearSlots;
 		uint8_t count;
 		uint8_t global:1;
 		uint8_t ignoreCase:1;
 		uint8_t multiline:1;
+		uint8_t anchored:1;
 	}
 )
 
@@ -15,19 +15,44 @@
 // MARK: - Private
 
 static void mark (struct Object *object);
-static void capture (struct Object *object);
 static void finalize (struct Object *object);
 
-struct Object * String(prototype) = NULL;
-struct Function * String(constructor) = NULL;
+Ecc(threadlocal) struct Object * String(prototype) = NULL;
+Ecc(threadlocal) struct Function * String(constructor) = NULL;
 
 const struct Object(Type) String(type) = {
 	.text = &Text(stringType),
 	.mark = mark,
-	.capture = capture,
 	.finalize = finalize,
 };
 
+// UTF-16 breadcrumbs of indexed chars: crumb k is the last
+// character boundary at or before unit k * indexStride
+enum {
+	indexStride = 64,
+	indexMinimumLength = 64,
+};
+
+struct Index {
+	const char *bytes;
+	int32_t length;
+	struct Chars *chars;
+	struct Chars *copy;
+	int32_t units;
+	int32_t count;
+	struct {
+		int32_t unit;
+		int32_t offset;
+	} *crumbs;
+};
+
+// indices are kept by their bytes, in an open-addressed table at most half full:
+// until the chars is destroyed, or for texts (no chars), until their input or key is
+static Ecc(threadlocal) struct Index *indexTable = NULL;
+static Ecc(threadlocal) uint32_t indexCapacity = 0;
+static Ecc(threadlocal) uint32_t indexCount = 0;
+static Ecc(threadlocal) uint32_t textIndexCount = 0;
+
 static
 void mark (struct Object *object)
 {
@@ -37,19 +62,158 @@ void mark (struct Object *object)
 }
 
 static
-void capture (struct Object *object)
+void finalize (struct Object *object)
 {
 	struct String *self = (struct String *)object;
 	
-	++self->value->referenceCount;
+	--self->value->referenceCount;
+}
+
+static inline
+uint32_t indexBucket (const char *bytes)
+{
+	return ((uint32_t)((uintptr_t)bytes >> 4) * 2654435761u) & (indexCapacity - 1);
 }
 
 static
-void finalize (struct Object *object)
+struct Index *findIndex (const char *bytes, int32_t length)
 {
-	struct String *self = (struct String *)object;
+	uint32_t mask = indexCapacity - 1, bucket;
 	
-	--self->value->referenceCount;
+	if (length < indexMinimumLength || !indexCount)
+		return NULL;
+	
+	for (bucket = indexBucket(bytes); indexTable[bucket].bytes; bucket = (bucket + 1) & mask)
+		if (indexTable[bucket].bytes == bytes && indexTable[bucket].length == length)
+			return indexTable + bucket;
+	
+	return NULL;
+}
+
+static
+struct Index *insertIndex (const char *bytes)
+{
+	uint32_t mask = indexCapacity - 1, bucket;
+	
+	for (bucket = indexBucket(bytes); indexTable[bucket].bytes; bucket = (bucket + 1) & mask);
+	
+	return indexTable + bucket;
+}
+
+static
+void growIndexTable (void)
+{
+	struct Index *table = indexTable, *index;
+	uint32_t capacity = indexCapacity;
+	
+	indexCapacity = indexCapacity? indexCapacity * 2: 0x40;
+	indexTable = calloc(indexCapacity, sizeof(*indexTable));
+	
+	for (index = table; index < table + capacity; ++index)
+		if (index->bytes)
+			*insertIndex(index->bytes) = *index;
+	
+	free(table), table = NULL;
+}
+
+static
+void removeIndex (struct Index *index)
+{
+	uint32_t mask = indexCapacity - 1, bucket = (uint32_t)(index - indexTable), next, home;
+	
+	if (index->chars)
+		index->chars->flags &= ~Chars(indexed);
+	else
+	{
+		--textIndexCount;
+		
+		if (index->copy)
+			--index->copy->referenceCount;
+	}
+	
+	free(index->crumbs);
+	--indexCount;
+	
+	// backward shift following entries, so probing never stops at a hole
+	
+	next = bucket;
+	while (indexTable[next = (next + 1) & mask].bytes)
+	{
+		home = indexBucket(indexTable[next].bytes);
+		
+		if (((next - home) & mask) >= ((next - bucket) & mask))
+		{
+			indexTable[bucket] = indexTable[next];
+			bucket = next;
+		}
+	}
+	
+	memset(indexTable + bucket, 0, sizeof(*indexTable));
+}
+
+static
+void buildIndex (const char *bytes, int32_t length, struct Chars *chars)
+{
+	struct Index *index;
+	struct Text text = Text.make(bytes, length);
+	struct Text(Char) c;
+	int32_t unit = 0, next = 0, capacity = 0;
+	
+	if ((indexCount + 1) * 2 > indexCapacity)
+		growIndexTable();
+	
+	index = insertIndex(bytes);
+	index->bytes = bytes;
+	index->length = length;
+	index->chars = chars;
+	++indexCount;
+	
+	if (chars)
+		chars->flags |= Chars(indexed);
+	else
+		++textIndexCount;
+	
+	while (text.length)
+	{
+		int32_t offset = (int32_t)(text.bytes - bytes);
+		
+		c = Text.nextCharacter(&text);
+		
+		if (c.units > 1 && !index->crumbs)
+		{
+			// first non-ASCII character, crumbs of the ASCII prefix are implicit
+			capacity = length / indexStride + 2;
+			index->crumbs = malloc(sizeof(*index->crumbs) * capacity);
+			for (; next * indexStride <= unit; ++next)
+			{
+				index->crumbs[next].unit = next * indexStride;
+				index->crumbs[next].offset = next * indexStride;
+			}
+		}
+		
+		if (index->crumbs)
+			for (; next * indexStride < unit + (c.codepoint > 0xffff? 2: 1); ++next)
+			{
+				index->crumbs[next].unit = unit;
+				index->crumbs[next].offset = offset;
+			}
+		
+		unit += c.codepoint > 0xffff? 2: 1;
+	}
+	
+	if (index->crumbs)
+	{
+		for (; next * indexStride <= unit; ++next)
+		{
+			index->crumbs[next].unit = unit;
+			index->crumbs[next].offset = length;
+		}
+		index->count = next;
+	}
+	else if (chars)
+		chars->flags |= Chars(asciiOnly);
+	
+	index->units = unit;
 }
 
 // MARK: - Static Members
@@ -80,6 +244,7 @@ struct Value charAt (struct Context * const context)
 	Context.assertThisCoerciblePrimitive(context);
 	
 	context->this = Value.toString(context, context->this);
+	prepareIndex(context->this);
 	chars = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	index = Value.toInteger(context, Context.argument(context, 0)).data.integer;
@@ -121,6 +286,7 @@ struct Value charCodeAt (struct Context * const context)
 	Context.assertThisCoerciblePrimitive(context);
 	
 	context->this = Value.toString(context, context->this);
+	prepareIndex(context->this);
 	chars = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	index = Value.toInteger(context, Context.argument(context, 0)).data.integer;
@@ -176,6 +342,7 @@ struct Value indexOf (struct Context * const context)
 	Context.assertThisCoerciblePrimitive(context);
 	
 	context->this = Value.toString(context, Context.this(context));
+	prepareIndex(context->this);
 	chars = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	
@@ -218,6 +385,7 @@ struct Value lastIndexOf (struct Context * const context)
 	Context.assertThisCoerciblePrimitive(context);
 	
 	context->this = Value.toString(context, Context.this(context));
+	prepareIndex(context->this);
 	chars = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	
@@ -282,6 +450,7 @@ struct Value match (struct Context * const context)
 	struct Value value, lastIndex;
 	
 	context->this = Value.toString(context, Context.this(context));
+	prepareIndex(context->this);
 	
 	value = Context.argument(context, 0);
 	if (value.type == Value(regexpType))
@@ -422,6 +591,18 @@ void replaceText (struct Chars(Append) *chars, struct Text replace, struct Text
 	}
 }
 
+static
+void retainArguments (struct Object *arguments)
+{
+	uint32_t index;
+	
+	// the collector releases these when it cleans up the array; 'this' may be
+	// chars held elsewhere, such as the flat copy of a rope
+	for (index = 0; index < arguments->elementCount; ++index)
+		if (arguments->element[index].value.type == Value(charsType))
+			++arguments->element[index].value.data.chars->referenceCount;
+}
+
 static
 struct Value replace (struct Context * const context)
 {
@@ -435,6 +616,7 @@ struct Value replace (struct Context * const context)
 	Context.assertThisCoerciblePrimitive(context);
 	
 	context->this = Value.toString(context, Context.this(context));
+	prepareIndex(context->this);
 	bytes = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	text = Text.make(bytes, length);
@@ -479,6 +661,7 @@ struct Value replace (struct Context * const context)
 					}
 					arguments->element[regexp->count].value = Value.integer(String.unitIndex(bytes, length, (int32_t)(capture[0] - bytes)));
 					arguments->element[regexp->count + 1].value = context->this;
+					retainArguments(arguments);
 					
 					result = Value.toString(context, Op.callFunctionArguments(context, 0, replace.data.function, Value(undefined), arguments));
 					Chars.append(&chars, "%.*s", Value.stringLength(&result), Value.stringBytes(&result));
@@ -536,6 +719,7 @@ struct Value replace (struct Context * const context)
 			arguments->element[0].value = Value.chars(Chars.createWithBytes(text.length, text.bytes));
 			arguments->element[1].value = Value.integer(String.unitIndex(bytes, length, (int32_t)(text.bytes - bytes)));
 			arguments->element[2].value = context->this;
+			retainArguments(arguments);
 			
 			result = Value.toString(context, Op.callFunctionArguments(context, 0, replace.data.function, Value(undefined), arguments));
 			Chars.append(&chars, "%.*s", Value.stringLength(&result), Value.stringBytes(&result));
@@ -564,6 +748,7 @@ struct Value search (struct Context * const context)
 	Context.assertThisCoerciblePrimitive(context);
 	
 	context->this = Value.toString(context, Context.this(context));
+	prepareIndex(context->this);
 	
 	value = Context.argument(context, 0);
 	if (value.type == Value(regexpType))
@@ -599,6 +784,7 @@ struct Value slice (struct Context * const context)
 	if (!Value.isString(context->this))
 		context->this = Value.toString(context, Context.this(context));
 	
+	prepareIndex(context->this);
 	chars = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	
@@ -710,7 +896,7 @@ struct Value split (struct Context * const context)
 			if (size >= limit)
 				break;
 			
-			if (seek.length && RegExp.matchWithState(regexp, &state))
+			if (seek.length && RegExp.matchWithState(regexp, &state) && capture[0] < state.end)
 			{
 				if (capture[1] <= text.bytes)
 				{
@@ -821,6 +1007,7 @@ struct Value substring (struct Context * const context)
 	uint32_t headcp = 0;
 	
 	context->this = Value.toString(context, Context.this(context));
+	prepareIndex(context->this);
 	chars = Value.stringBytes(&context->this);
 	length = Value.stringLength(&context->this);
 	
@@ -1023,6 +1210,20 @@ void setup ()
 
 void teardown (void)
 {
+	struct Index *index;
+	
+	for (index = indexTable; index < indexTable + indexCapacity; ++index)
+		if (index->bytes)
+		{
+			if (index->chars)
+				index->chars->flags &= ~Chars(indexed);
+			
+			free(index->crumbs);
+		}
+	
+	free(indexTable), indexTable = NULL;
+	indexCapacity = indexCount = textIndexCount = 0;
+	
 	String(prototype) = NULL;
 	String(constructor) = NULL;
 }
@@ -1036,14 +1237,18 @@ struct String * create (struct Chars *chars)
 	
 	struct String *self = malloc(sizeof(*self));
 	*self = String.identity;
-	Pool.addObject(&self->object);
 	
 	Object.initialize(&self->object, String(prototype));
+	Pool.addObject(&self->object);
 	
+	prepareIndex(Value.chars(chars));
 	length = unitIndex(chars->bytes, chars->length, chars->length);
 	Object.addMember(&self->object, Key(length), Value.integer(length), r|h|s);
 	
+	// held for the wrapper's lifetime, matching the release in finalize;
+	// a flattened rope keeps its own hold on the same chars
 	self->value = chars;
+	++chars->referenceCount;
 	if (length == chars->length)
 		chars->flags |= Chars(asciiOnly);
 	
@@ -1055,6 +1260,7 @@ struct Value valueAtIndex (struct String *self, int32_t index)
 	struct Text(Char) c;
 	struct Text text;
 	
+	prepareIndex(Value.chars(self->value));
 	text = textAtIndex(self->value->bytes, self->value->length, index, 0);
 	c = Text.character(text);
 	
@@ -1086,6 +1292,26 @@ struct Text textAtIndex (const char *chars, int32_t length, int32_t position, in
 {
 	struct Text text = Text.make(chars, length), prev;
 	struct Text(Char) c;
+	struct Index *index = findIndex(chars, length);
+	
+	if (index)
+	{
+		if (position < 0 && enableReverse)
+			position = position + index->units < 0? 0: position + index->units;
+		
+		if (position > index->units)
+			position = index->units;
+		
+		if (position >= 0 && !index->crumbs)
+			return Text.make(chars + position, length - position);
+		else if (position >= 0)
+		{
+			int32_t offset = index->crumbs[position / indexStride].offset;
+			
+			position -= index->crumbs[position / indexStride].unit;
+			text = Text.make(chars + offset, length - offset);
+		}
+	}
 	
 	if (position >= 0)
 	{
@@ -1130,6 +1356,28 @@ int32_t unitIndex (const char *chars, int32_t max, int32_t unit)
 	struct Text text = Text.make(chars, max);
 	int32_t position = 0;
 	struct Text(Char) c;
+	struct Index *index = findIndex(chars, max);
+	
+	if (index && !index->crumbs)
+		return unit;
+	else if (index && unit > 0)
+	{
+		int32_t lo = 0, hi = index->count - 1, mid;
+		
+		// last crumb at or before the byte offset
+		while (lo < hi)
+		{
+			mid = (lo + hi + 1) / 2;
+			if (index->crumbs[mid].offset <= unit)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		
+		position = index->crumbs[lo].unit;
+		unit -= index->crumbs[lo].offset;
+		text = Text.make(chars + index->crumbs[lo].offset, max - index->crumbs[lo].offset);
+	}
 	
 	while (unit > 0)
 	{
@@ -1146,3 +1394,116 @@ int32_t unitIndex (const char *chars, int32_t max, int32_t unit)
 	
 	return position;
 }
+
+void prepareIndex (struct Value value)
+{
+	struct Chars *chars;
+	
+	if (value.type == Value(charsType))
+		chars = Chars.flatten(value.data.chars);
+	else if (value.type == Value(stringType))
+		chars = value.data.string->value;
+	else if (value.type == Value(textType) || value.type == Value(keyType))
+	{
+		const struct Text *text = value.type == Value(textType)? value.data.text: Key.textOf(value.data.key);
+		
+		if (text->length >= indexMinimumLength && !findIndex(text->bytes, text->length))
+			buildIndex(text->bytes, text->length, NULL);
+		
+		return;
+	}
+	else
+		return;
+	
+	if (chars->length >= indexMinimumLength && !(chars->flags & Chars(indexed)))
+		buildIndex(chars->bytes, chars->length, chars);
+}
+
+struct Chars * copyText (const struct Text *text)
+{
+	struct Index *index, *copy;
+	struct Chars *chars;
+	
+	if (text->length < indexMinimumLength)
+		return Chars.createWithBytes(text->length, text->bytes);
+	
+	// wrappers of a long text share one copy, indexed with the crumbs of the text
+	
+	if ((indexCount + 2) * 2 > indexCapacity)
+		growIndexTable();
+	
+	if (!(index = findIndex(text->bytes, text->length)))
+	{
+		buildIndex(text->bytes, text->length, NULL);
+		index = findIndex(text->bytes, text->length);
+	}
+	
+	if (index->copy)
+		return index->copy;
+	
+	chars = Chars.createWithBytes(text->length, text->bytes);
+	
+	copy = insertIndex(chars->bytes);
+	*copy = *index;
+	copy->bytes = chars->bytes;
+	copy->chars = chars;
+	copy->copy = NULL;
+	++indexCount;
+	chars->flags |= Chars(indexed);
+	
+	if (index->crumbs)
+	{
+		copy->crumbs = malloc(sizeof(*copy->crumbs) * index->count);
+		memcpy(copy->crumbs, index->crumbs, sizeof(*copy->crumbs) * index->count);
+	}
+	else
+		chars->flags |= Chars(asciiOnly);
+	
+	// held until the text is gone, marked meanwhile
+	index->copy = chars;
+	++chars->referenceCount;
+	
+	return chars;
+}
+
+void markTextCopies (void)
+{
+	struct Index *index;
+	
+	if (!textIndexCount)
+		return;
+	
+	for (index = indexTable; index < indexTable + indexCapacity; ++index)
+		if (index->copy)
+			Pool.markValue(Value.chars(index->copy));
+}
+
+void forgetIndex (struct Chars *chars)
+{
+	uint32_t mask = indexCapacity - 1, bucket;
+	
+	if (!indexCount)
+		return;
+	
+	for (bucket = indexBucket(chars->bytes); indexTable[bucket].bytes; bucket = (bucket + 1) & mask)
+		if (indexTable[bucket].chars == chars)
+		{
+			removeIndex(indexTable + bucket);
+			return;
+		}
+}
+
+void forgetTextIndices (const char *bytes, uint32_t length)
+{
+	uint32_t bucket;
+	
+	if (!textIndexCount || length < indexMinimumLength)
+		return;
+	
+	// removal shifts entries back: look at the same bucket again
+	for (bucket = 0; bucket < indexCapacity;)
+		if (indexTable[bucket].bytes && !indexTable[bucket].chars && indexTable[bucket].bytes >= bytes && indexTable[bucket].bytes < bytes + length)
+			removeIndex(indexTable + bucket);
+		else
+			++bucket;
+}
@@ -17,8 +17,8 @@
 
 	#include "global.h"
 
-	extern struct Object * String(prototype);
-	extern struct Function * String(constructor);
+	extern Ecc(threadlocal) struct Object * String(prototype);
+	extern Ecc(threadlocal) struct Function * String(constructor);
 	extern const struct Object(Type) String(type);
 
 #endif
@@ -34,6 +34,12 @@ Interface(String,
 	
 	(struct Text, textAtIndex ,(const char *chars, int32_t length, int32_t index, int enableReverse))
 	(int32_t, unitIndex ,(const char *chars, int32_t max, int32_t unit))
+	
+	(void, prepareIndex ,(struct Value))
+	(struct Chars *, copyText ,(const struct Text *))
+	(void, markTextCopies ,(void))
+	(void, forgetIndex ,(struct Chars *))
+	(void, forgetTextIndices ,(const char *bytes, uint32_t length))
 	,
 	{
 		struct Object object;
@@ -0,0 +1,548 @@
+//
+//  typedarray.c
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#define Implementation
+#include "typedarray.h"
+
+#include "../pool.h"
+
+// MARK: - Private
+
+static void mark (struct Object *object);
+static void capture (struct Object *object);
+
+Ecc(threadlocal) struct Object * TypedArray(prototype) = NULL;
+Ecc(threadlocal) struct Object * TypedArray(prototypes)[TypedArray(kindCount)] = { NULL };
+Ecc(threadlocal) struct Function * TypedArray(constructors)[TypedArray(kindCount)] = { NULL };
+
+const struct Object(Type) TypedArray(types)[TypedArray(kindCount)] = {
+	{ .text = &Text(int8ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(uint8ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(uint8ClampedArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(int16ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(uint16ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(int32ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(uint32ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(float32ArrayType), .mark = mark, .capture = capture, },
+	{ .text = &Text(float64ArrayType), .mark = mark, .capture = capture, },
+};
+
+const uint8_t TypedArray(sizes)[TypedArray(kindCount)] = { 1, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+static const char * const names[TypedArray(kindCount)] = {
+	"Int8Array",
+	"Uint8Array",
+	"Uint8ClampedArray",
+	"Int16Array",
+	"Uint16Array",
+	"Int32Array",
+	"Uint32Array",
+	"Float32Array",
+	"Float64Array",
+};
+
+static
+void mark (struct Object *object)
+{
+	Pool.markObject(&((struct TypedArray *)object)->buffer->object);
+}
+
+static
+void capture (struct Object *object)
+{
+	++((struct TypedArray *)object)->buffer->object.referenceCount;
+}
+
+static
+uint32_t toIndex (struct Context * const context, int argument, uint32_t limit, const char *name)
+{
+	struct Value value = Context.argument(context, argument);
+	double binary = 0;
+	
+	if (value.type != Value(undefinedType))
+	{
+		binary = Value.toBinary(context, value).data.binary;
+		binary = isnan(binary)? 0: trunc(binary);
+	}
+	
+	if (binary < 0 || binary > limit)
+	{
+		Context.setTextIndexArgument(context, argument);
+		Context.rangeError(context, Chars.create("invalid %s", name));
+	}
+	
+	return binary;
+}
+
+static
+uint32_t relativeIndex (struct Context * const context, struct Value value, uint32_t length, uint32_t otherwise)
+{
+	double binary;
+	
+	if (value.type == Value(undefinedType))
+		return otherwise;
+	
+	binary = Value.toBinary(context, value).data.binary;
+	if (isnan(binary))
+		return 0;
+	else if (binary < 0)
+		return binary + length > 0? length + binary: 0;
+	else
+		return binary < length? binary: length;
+}
+
+static
+struct TypedArray * thisTyped (struct Context * const context)
+{
+	if (!Value.isObject(context->this) || !isTypedArray(context->this.data.object))
+	{
+		Context.setTextIndex(context, Context(thisIndex));
+		Context.typeError(context, Chars.create("'this' is not a typed array"));
+	}
+	
+	return (struct TypedArray *)context->this.data.object;
+}
+
+static
+struct Value construct (struct Context * const context, enum TypedArray(Kind) kind)
+{
+	const uint32_t size = TypedArray(sizes)[kind];
+	struct TypedArray *self;
+	struct Value value;
+	uint32_t index, length, offset;
+	
+	if (!context->construct)
+	{
+		Context.setTextIndex(context, Context(callIndex));
+		Context.typeError(context, Chars.create("%s constructor requires 'new'", names[kind]));
+	}
+	
+	value = Context.argument(context, 0);
+	if (Value.isObject(value) && value.data.object->type == &ArrayBuffer(type))
+	{
+		struct ArrayBuffer *buffer = (struct ArrayBuffer *)value.data.object;
+		
+		offset = toIndex(context, 1, buffer->length, "typed array offset");
+		if (offset % size)
+		{
+			Context.setTextIndexArgument(context, 1);
+			Context.rangeError(context, Chars.create("start offset of %s should be a multiple of %u", names[kind], size));
+		}
+		
+		if (Context.argument(context, 2).type != Value(undefinedType))
+			length = toIndex(context, 2, (buffer->length - offset) / size, "typed array length");
+		else if ((buffer->length - offset) % size)
+		{
+			Context.setTextIndexArgument(context, 0);
+			Context.rangeError(context, Chars.create("byte length of %s should be a multiple of %u", names[kind], size));
+		}
+		else
+			length = (buffer->length - offset) / size;
+		
+		self = createWithBuffer(kind, buffer, offset, length);
+	}
+	else if (Value.isObject(value))
+	{
+		struct Object *source = value.data.object;
+		
+		if (isTypedArray(source))
+			length = ((struct TypedArray *)source)->length;
+		else
+		{
+			length = Value.toInteger(context, Object.getMember(context, source, Key(length))).data.integer;
+			if (length > UINT32_MAX / size)
+			{
+				Context.setTextIndexArgument(context, 0);
+				Context.rangeError(context, Chars.create("invalid typed array length"));
+			}
+		}
+		
+		self = create(kind, length);
+		for (index = 0; index < length; ++index)
+			putIndex(context, self, index, Object.getElement(context, source, index));
+	}
+	else
+		self = create(kind, toIndex(context, 0, UINT32_MAX / size, "typed array length"));
+	
+	return Value.object(&self->object);
+}
+
+// MARK: - Static Members
+
+static
+struct Value int8Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(int8));
+}
+
+static
+struct Value uint8Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(uint8));
+}
+
+static
+struct Value uint8ClampedConstructor (struct Context * const context)
+{
+	return construct(context, TypedArray(uint8Clamped));
+}
+
+static
+struct Value int16Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(int16));
+}
+
+static
+struct Value uint16Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(uint16));
+}
+
+static
+struct Value int32Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(int32));
+}
+
+static
+struct Value uint32Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(uint32));
+}
+
+static
+struct Value float32Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(float32));
+}
+
+static
+struct Value float64Constructor (struct Context * const context)
+{
+	return construct(context, TypedArray(float64));
+}
+
+static
+struct Value getLength (struct Context * const context)
+{
+	return Value.binary(thisTyped(context)->length);
+}
+
+static
+struct Value getByteLength (struct Context * const context)
+{
+	struct TypedArray *self = thisTyped(context);
+	
+	return Value.binary((double)self->length * TypedArray(sizes)[self->kind]);
+}
+
+static
+struct Value getByteOffset (struct Context * const context)
+{
+	return Value.binary(thisTyped(context)->byteOffset);
+}
+
+static
+struct Value getBuffer (struct Context * const context)
+{
+	return Value.object(&thisTyped(context)->buffer->object);
+}
+
+static
+struct Value subarray (struct Context * const context)
+{
+	struct TypedArray *self = thisTyped(context);
+	uint32_t from, to;
+	
+	from = relativeIndex(context, Context.argument(context, 0), self->length, 0);
+	to = relativeIndex(context, Context.argument(context, 1), self->length, self->length);
+	
+	return Value.object(&createWithBuffer(self->kind, self->buffer, self->byteOffset + from * TypedArray(sizes)[self->kind], to > from? to - from: 0)->object);
+}
+
+static
+struct Value slice (struct Context * const context)
+{
+	struct TypedArray *self = thisTyped(context), *result;
+	const uint32_t size = TypedArray(sizes)[self->kind];
+	uint32_t from, to;
+	
+	from = relativeIndex(context, Context.argument(context, 0), self->length, 0);
+	to = relativeIndex(context, Context.argument(context, 1), self->length, self->length);
+	
+	result = create(self->kind, to > from? to - from: 0);
+	if (result->length)
+		memcpy(result->bytes, self->bytes + from * size, result->length * size);
+	
+	return Value.object(&result->object);
+}
+
+static
+struct Value set (struct Context * const context)
+{
+	struct TypedArray *self = thisTyped(context), *typed = NULL;
+	struct Object *source;
+	uint32_t index, length, offset;
+	
+	source = Value.toObject(context, Context.argument(context, 0)).data.object;
+	offset = toIndex(context, 1, self->length, "typed array offset");
+	
+	if (isTypedArray(source))
+	{
+		typed = (struct TypedArray *)source;
+		length = typed->length;
+	}
+	else
+		length = Value.toInteger(context, Object.getMember(context, source, Key(length))).data.integer;
+	
+	if (length > self->length - offset)
+	{
+		Context.setTextIndex(context, Context(callIndex));
+		Context.rangeError(context, Chars.create("source is too large"));
+	}
+	
+	if (typed && typed->kind == self->kind)
+	{
+		memmove(self->bytes + offset * TypedArray(sizes)[self->kind], typed->bytes, length * TypedArray(sizes)[self->kind]);
+		return Value(undefined);
+	}
+	else if (typed && typed->buffer == self->buffer)
+	{
+		// converting in place would read elements already overwritten
+		struct TypedArray *copy = create(typed->kind, length);
+		memcpy(copy->bytes, typed->bytes, length * TypedArray(sizes)[typed->kind]);
+		typed = copy;
+	}
+	
+	for (index = 0; index < length; ++index)
+		putIndex(context, self, offset + index, typed? getIndex(typed, index): Object.getElement(context, source, index));
+	
+	return Value(undefined);
+}
+
+static
+struct Value fill (struct Context * const context)
+{
+	struct TypedArray *self = thisTyped(context);
+	struct Value value;
+	uint32_t from, to;
+	
+	value = Value.toBinary(context, Context.argument(context, 0));
+	from = relativeIndex(context, Context.argument(context, 1), self->length, 0);
+	to = relativeIndex(context, Context.argument(context, 2), self->length, self->length);
+	
+	for (; from < to; ++from)
+		putIndex(context, self, from, value);
+	
+	return Value.object(&self->object);
+}
+
+static
+void setupKind (enum TypedArray(Kind) kind, const Native(Function) native)
+{
+	const enum Value(Flags) r = Value(readonly);
+	const enum Value(Flags) h = Value(hidden);
+	const enum Value(Flags) s = Value(sealed);
+	
+	// prototypes are plain objects, so the one made by 'new' before calling the constructor has no hooks to run
+	Function.setupBuiltinObject(
+		&TypedArray(constructors)[kind], native, 3,
+		&TypedArray(prototypes)[kind], Value.object(Object.create(TypedArray(prototype))),
+		&Object(type));
+	
+	Object.addMember(&TypedArray(constructors)[kind]->object, Key.makeWithCString("BYTES_PER_ELEMENT"), Value.integer(TypedArray(sizes)[kind]), r|h|s);
+	Object.addMember(TypedArray(prototypes)[kind], Key.makeWithCString("BYTES_PER_ELEMENT"), Value.integer(TypedArray(sizes)[kind]), r|h|s);
+}
+
+// MARK: - Methods
+
+void setup (void)
+{
+	const enum Value(Flags) h = Value(hidden);
+	const enum Value(Flags) s = Value(sealed);
+	const char * const generics[] = { "toString", "toLocaleString", "join", "reverse", "indexOf", "lastIndexOf" };
+	struct Key key;
+	uint32_t index;
+	
+	TypedArray(prototype) = Object.create(Object(prototype));
+	
+	// element access is generic in those, they work on typed arrays as they are
+	for (index = 0; index < sizeof(generics) / sizeof(*generics); ++index)
+	{
+		key = Key.makeWithCString(generics[index]);
+		Object.addMember(TypedArray(prototype), key, Object.getMember(NULL, Array(prototype), key), h);
+	}
+	
+	Function.addToObject(TypedArray(prototype), "set", set, -1, h);
+	Function.addToObject(TypedArray(prototype), "subarray", subarray, 2, h);
+	Function.addToObject(TypedArray(prototype), "slice", slice, 2, h);
+	Function.addToObject(TypedArray(prototype), "fill", fill, -1, h);
+	
+	Object.addMember(TypedArray(prototype), Key(length), Function.accessor(getLength, NULL), h|s | Value(asOwn) | Value(asData));
+	Object.addMember(TypedArray(prototype), Key.makeWithCString("byteLength"), Function.accessor(getByteLength, NULL), h|s | Value(asOwn) | Value(asData));
+	Object.addMember(TypedArray(prototype), Key.makeWithCString("byteOffset"), Function.accessor(getByteOffset, NULL), h|s | Value(asOwn) | Value(asData));
+	Object.addMember(TypedArray(prototype), Key.makeWithCString("buffer"), Function.accessor(getBuffer, NULL), h|s | Value(asOwn) | Value(asData));
+	
+	setupKind(TypedArray(int8), int8Constructor);
+	setupKind(TypedArray(uint8), uint8Constructor);
+	setupKind(TypedArray(uint8Clamped), uint8ClampedConstructor);
+	setupKind(TypedArray(int16), int16Constructor);
+	setupKind(TypedArray(uint16), uint16Constructor);
+	setupKind(TypedArray(int32), int32Constructor);
+	setupKind(TypedArray(uint32), uint32Constructor);
+	setupKind(TypedArray(float32), float32Constructor);
+	setupKind(TypedArray(float64), float64Constructor);
+}
+
+void teardown (void)
+{
+	uint32_t index;
+	
+	for (index = 0; index < TypedArray(kindCount); ++index)
+	{
+		TypedArray(prototypes)[index] = NULL;
+		TypedArray(constructors)[index] = NULL;
+	}
+	
+	TypedArray(prototype) = NULL;
+}
+
+struct TypedArray * create (enum TypedArray(Kind) kind, uint32_t length)
+{
+	return createWithBuffer(kind, ArrayBuffer.create(length * TypedArray(sizes)[kind]), 0, length);
+}
+
+struct TypedArray * createWithBuffer (enum TypedArray(Kind) kind, struct ArrayBuffer *buffer, uint32_t byteOffset, uint32_t length)
+{
+	struct TypedArray *self = malloc(sizeof(*self));
+	*self = TypedArray.identity;
+	Object.initialize(&self->object, TypedArray(prototypes)[kind]);
+	Pool.addObject(&self->object);
+	
+	assert(byteOffset + (uint64_t)length * TypedArray(sizes)[kind] <= buffer->length);
+	
+	self->object.type = &TypedArray(types)[kind];
+	self->buffer = buffer;
+	self->bytes = buffer->bytes + byteOffset;
+	self->length = length;
+	self->byteOffset = byteOffset;
+	self->kind = kind;
+	
+	return self;
+}
+
+int isTypedArray (struct Object *object)
+{
+	return object->type >= TypedArray(types) && object->type < TypedArray(types) + TypedArray(kindCount);
+}
+
+struct Value getIndex (struct TypedArray *self, uint32_t index)
+{
+	if (index >= self->length)
+		return Value(undefined);
+	
+	switch ((enum TypedArray(Kind))self->kind)
+	{
+		case TypedArray(int8):
+			return Value.binary(((int8_t *)self->bytes)[index]);
+		
+		case TypedArray(uint8):
+		case TypedArray(uint8Clamped):
+			return Value.binary(((uint8_t *)self->bytes)[index]);
+		
+		case TypedArray(int16):
+			return Value.binary(((int16_t *)self->bytes)[index]);
+		
+		case TypedArray(uint16):
+			return Value.binary(((uint16_t *)self->bytes)[index]);
+		
+		case TypedArray(int32):
+			return Value.binary(((int32_t *)self->bytes)[index]);
+		
+		case TypedArray(uint32):
+			return Value.binary(((uint32_t *)self->bytes)[index]);
+		
+		case TypedArray(float32):
+			return Value.binary(((float *)self->bytes)[index]);
+		
+		case TypedArray(float64):
+			return Value.binary(((double *)self->bytes)[index]);
+		
+		case TypedArray(kindCount):
+			break;
+	}
+	
+	return Value(undefined);
+}
+
+void putIndex (struct Context * const context, struct TypedArray *self, uint32_t index, struct Value value)
+{
+	double binary;
+	int32_t integer;
+	
+	binary = value.type == Value(binaryType)? value.data.binary: Value.toBinary(context, value).data.binary;
+	
+	if (index >= self->length)
+		return;
+	
+	if (self->kind == TypedArray(float64))
+	{
+		((double *)self->bytes)[index] = binary;
+		return;
+	}
+	else if (self->kind == TypedArray(float32))
+	{
+		((float *)self->bytes)[index] = binary;
+		return;
+	}
+	else if (self->kind == TypedArray(uint8Clamped))
+	{
+		((uint8_t *)self->bytes)[index] = binary > 0? binary < 255? nearbyint(binary): 255: 0;
+		return;
+	}
+	
+	// integer kinds wrap modulo 2^32 then keep their low bits
+	if (binary >= INT32_MIN && binary <= INT32_MAX)
+		integer = binary;
+	else
+		integer = Value.toInteger(context, Value.binary(binary)).data.integer;
+	
+	switch ((enum TypedArray(Kind))self->kind)
+	{
+		case TypedArray(int8):
+		case TypedArray(uint8):
+			((uint8_t *)self->bytes)[index] = integer;
+			break;
+		
+		case TypedArray(int16):
+		case TypedArray(uint16):
+			((uint16_t *)self->bytes)[index] = integer;
+			break;
+		
+		case TypedArray(int32):
+		case TypedArray(uint32):
+			((uint32_t *)self->bytes)[index] = integer;
+			break;
+		
+		case TypedArray(uint8Clamped):
+		case TypedArray(float32):
+		case TypedArray(float64):
+		case TypedArray(kindCount):
+			break;
+	}
+}
+
+struct Value * indexRef (struct TypedArray *self, uint32_t index)
+{
+	self->ref = getIndex(self, index);
+	self->ref.flags = Value(sealed);
+	self->refIndex = index;
+	
+	return &self->ref;
+}
@@ -0,0 +1,73 @@
+//
+//  typedarray.h
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#ifndef io_libecc_typedarray_h
+#ifdef Implementation
+#undef Implementation
+#include __FILE__
+#include "../implementation.h"
+#else
+#include "../interface.h"
+#define io_libecc_typedarray_h
+
+	#include "global.h"
+	
+	enum TypedArray(Kind)
+	{
+		TypedArray(int8),
+		TypedArray(uint8),
+		TypedArray(uint8Clamped),
+		TypedArray(int16),
+		TypedArray(uint16),
+		TypedArray(int32),
+		TypedArray(uint32),
+		TypedArray(float32),
+		TypedArray(float64),
+		
+		TypedArray(kindCount),
+	};
+	
+	// methods & accessors shared by all kinds
+	extern Ecc(threadlocal) struct Object * TypedArray(prototype);
+	
+	extern Ecc(threadlocal) struct Object * TypedArray(prototypes)[TypedArray(kindCount)];
+	extern Ecc(threadlocal) struct Function * TypedArray(constructors)[TypedArray(kindCount)];
+	extern const struct Object(Type) TypedArray(types)[TypedArray(kindCount)];
+	extern const uint8_t TypedArray(sizes)[TypedArray(kindCount)];
+
+#endif
+
+
+Interface(TypedArray,
+	
+	(void, setup ,(void))
+	(void, teardown ,(void))
+	
+	(struct TypedArray *, create ,(enum TypedArray(Kind), uint32_t length))
+	(struct TypedArray *, createWithBuffer ,(enum TypedArray(Kind), struct ArrayBuffer *, uint32_t byteOffset, uint32_t length))
+	(int, isTypedArray ,(struct Object *))
+	
+	(struct Value, getIndex ,(struct TypedArray *, uint32_t index))
+	(void, putIndex ,(struct Context * const, struct TypedArray *, uint32_t index, struct Value))
+	(struct Value *, indexRef ,(struct TypedArray *, uint32_t index))
+	,
+	{
+		struct Object object;
+		struct ArrayBuffer *buffer;
+		uint8_t *bytes;
+		uint32_t length;
+		uint32_t byteOffset;
+		uint8_t kind;
+		
+		// elements have no value slot: references to them go through this one
+		struct Value ref;
+		uint32_t refIndex;
+	}
+)
+
+#endif
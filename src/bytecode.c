@@ -0,0 +1,1493 @@
+//
+//  bytecode.c
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#define Implementation
+#include "bytecode.h"
+
+#include "ecc.h"
+#include "pool.h"
+
+// MARK: - Private
+
+enum {
+	operandA = 1 << 0,
+	operandB = 1 << 1,
+	operandC = 1 << 2,
+};
+
+#define io_libecc_bytecode_List \
+	_( move , operandA | operandB )\
+	_( escape , operandA )\
+	_( setSlot , operandA | operandB )\
+	_( getParent , operandA )\
+	_( setParent , operandA )\
+	\
+	_( add , operandA | operandB | operandC )\
+	_( minus , operandA | operandB | operandC )\
+	_( multiply , operandA | operandB | operandC )\
+	_( divide , operandA | operandB | operandC )\
+	_( modulo , operandA | operandB | operandC )\
+	_( leftShift , operandA | operandB | operandC )\
+	_( rightShift , operandA | operandB | operandC )\
+	_( unsignedRightShift , operandA | operandB | operandC )\
+	_( bitwiseAnd , operandA | operandB | operandC )\
+	_( bitwiseXor , operandA | operandB | operandC )\
+	_( bitwiseOr , operandA | operandB | operandC )\
+	\
+	_( equal , operandA | operandB | operandC )\
+	_( notEqual , operandA | operandB | operandC )\
+	_( identical , operandA | operandB | operandC )\
+	_( notIdentical , operandA | operandB | operandC )\
+	_( less , operandA | operandB | operandC )\
+	_( lessOrEqual , operandA | operandB | operandC )\
+	_( more , operandA | operandB | operandC )\
+	_( moreOrEqual , operandA | operandB | operandC )\
+	\
+	_( positive , operandA | operandB )\
+	_( negative , operandA | operandB )\
+	_( invert , operandA | operandB )\
+	_( not , operandA | operandB )\
+	_( increment , operandA | operandB )\
+	\
+	_( guard , operandB )\
+	_( jump , 0 )\
+	_( jumpIf , operandB )\
+	_( jumpIfNot , operandB )\
+	_( jumpCompare , operandB | operandC )\
+	_( mark , 0 )\
+	_( collect , 0 )\
+	_( recycle , 0 )\
+	_( loop , operandB | operandC )\
+	_( step , operandA | operandB )\
+	_( result , operandA )\
+
+#define _(X, O) X ## Code,
+enum Code {
+	io_libecc_bytecode_List
+};
+#undef _
+
+#define _(X, O) #X,
+static const char * const codeNames[] = {
+	io_libecc_bytecode_List
+};
+#undef _
+
+#define _(X, O) O,
+static const uint8_t codeOperands[] = {
+	io_libecc_bytecode_List
+};
+#undef _
+
+enum {
+	slotOperand = 0x8000,
+	constantOperand = 0x4000,
+	operandMask = 0x3fff,
+	
+	// flags
+	rightFirst = 1 << 0,
+	decrement = 1 << 0,
+	postfix = 1 << 1,
+	whenTrue = 1 << 7,
+	loopDepthShift = 3,
+	loopDepthLimit = 1 << 4,
+	
+	noLabel = UINT32_MAX,
+};
+
+struct Loop {
+	uint32_t next;
+	uint32_t exit;
+};
+
+struct Fixup {
+	uint32_t instruction;
+	uint32_t label;
+};
+
+struct Compiler {
+	jmp_buf bail;
+	struct Op *ops;
+	uint32_t opCount;
+	
+	struct Bytecode(Instruction) *code;
+	struct Bytecode(Origin) *origins;
+	uint32_t codeCount;
+	uint32_t codeCapacity;
+	
+	struct Value *constants;
+	uint32_t constantCount;
+	uint32_t constantCapacity;
+	
+	uint32_t *labels;
+	uint32_t labelCount;
+	uint32_t labelCapacity;
+	
+	struct Fixup *fixups;
+	uint32_t fixupCount;
+	uint32_t fixupCapacity;
+	
+	struct Loop loops[0xff];
+	uint32_t loopCount;
+	
+	uint32_t top;
+	uint32_t registerCount;
+	uint32_t indexCount;
+};
+
+static uint32_t measure (struct Compiler *, uint32_t index);
+static uint16_t expression (struct Compiler *, uint32_t index);
+static uint32_t statements (struct Compiler *, uint32_t index, uint32_t end, uint32_t next);
+
+static
+void unsupported (struct Compiler *self)
+{
+	longjmp(self->bail, 1);
+}
+
+static
+void *grow (void *items, uint32_t *capacity, uint32_t count, size_t size)
+{
+	if (count >= *capacity)
+	{
+		*capacity = *capacity? *capacity * 2: 16;
+		items = realloc(items, *capacity * size);
+	}
+	return items;
+}
+
+static
+const struct Op *opAt (struct Compiler *self, uint32_t index)
+{
+	if (index >= self->opCount)
+		unsupported(self);
+	
+	return &self->ops[index];
+}
+
+// MARK: emit
+
+static
+uint32_t emit (struct Compiler *self, enum Code code, uint32_t origin, uint32_t alt, uint8_t flag, uint16_t a, uint16_t b, uint16_t c)
+{
+	if (self->codeCount >= UINT16_MAX)
+		unsupported(self);
+	
+	if (self->codeCount >= self->codeCapacity)
+	{
+		self->codeCapacity = self->codeCapacity? self->codeCapacity * 2: 64;
+		self->code = realloc(self->code, sizeof(*self->code) * self->codeCapacity);
+		self->origins = realloc(self->origins, sizeof(*self->origins) * self->codeCapacity);
+	}
+	
+	self->code[self->codeCount] = (struct Bytecode(Instruction)){ code, flag, a, b, c };
+	self->origins[self->codeCount] = (struct Bytecode(Origin)){ origin, alt };
+	return self->codeCount++;
+}
+
+static
+uint32_t label (struct Compiler *self)
+{
+	self->labels = grow(self->labels, &self->labelCapacity, self->labelCount, sizeof(*self->labels));
+	self->labels[self->labelCount] = noLabel;
+	return self->labelCount++;
+}
+
+static
+uint32_t opLabel (struct Compiler *self, uint32_t index)
+{
+	// ops label themselves, other labels come after
+	if (index > self->opCount)
+		unsupported(self);
+	
+	return index;
+}
+
+static
+void bind (struct Compiler *self, uint32_t label)
+{
+	self->labels[label] = self->codeCount;
+}
+
+static
+void emitJump (struct Compiler *self, enum Code code, uint32_t label, uint32_t origin, uint32_t alt, uint8_t flag, uint16_t b, uint16_t c)
+{
+	self->fixups = grow(self->fixups, &self->fixupCapacity, self->fixupCount, sizeof(*self->fixups));
+	self->fixups[self->fixupCount].instruction = emit(self, code, origin, alt, flag, 0, b, c);
+	self->fixups[self->fixupCount].label = label;
+	++self->fixupCount;
+}
+
+// MARK: operands
+
+static
+uint16_t temporary (struct Compiler *self)
+{
+	if (self->top >= operandMask)
+		unsupported(self);
+	
+	if (++self->top > self->registerCount)
+		self->registerCount = self->top;
+	
+	return self->top - 1;
+}
+
+static
+uint16_t constant (struct Compiler *self, struct Value value)
+{
+	uint32_t index;
+	
+	for (index = 0; index < self->constantCount; ++index)
+		if (self->constants[index].type == value.type
+			&& self->constants[index].flags == value.flags
+			&& !memcmp(&self->constants[index].data, &value.data, sizeof(value.data))
+			)
+			return constantOperand | index;
+	
+	if (index >= operandMask)
+		unsupported(self);
+	
+	self->constants = grow(self->constants, &self->constantCapacity, self->constantCount, sizeof(*self->constants));
+	self->constants[self->constantCount++] = value;
+	return constantOperand | index;
+}
+
+static
+uint16_t slot (struct Compiler *self, uint32_t index)
+{
+	int32_t slot = opAt(self, index)->value.data.integer;
+	
+	if (slot < 0 || slot >= slotOperand)
+		unsupported(self);
+	
+	return slotOperand | slot;
+}
+
+static
+uint16_t moveTo (struct Compiler *self, uint16_t target, uint16_t source, uint32_t origin)
+{
+	if (target != source)
+		emit(self, moveCode, origin, origin, 0, target, source, 0);
+	
+	return target;
+}
+
+static
+int isPure (struct Compiler *self, uint32_t index)
+{
+	const Native(Function) native = opAt(self, index)->native;
+	
+	return native == Op.value
+		|| native == Op.text
+		|| native == Op.this
+		|| native == Op.getLocalSlot
+		|| native == Op.getParentSlot
+		;
+}
+
+static
+int binaryCode (Native(Function) native)
+{
+	native = Op.generic(native);
+	
+	#define _(X) if (native == Op.X) return X ## Code;
+	_(add) _(minus) _(multiply) _(divide) _(modulo)
+	_(leftShift) _(rightShift) _(unsignedRightShift)
+	_(bitwiseAnd) _(bitwiseXor) _(bitwiseOr)
+	_(equal) _(notEqual) _(identical) _(notIdentical)
+	_(less) _(lessOrEqual) _(more) _(moreOrEqual)
+	#undef _
+	return -1;
+}
+
+static
+int unaryCode (const Native(Function) native)
+{
+	#define _(X) if (native == Op.X) return X ## Code;
+	_(positive) _(negative) _(invert) _(not)
+	#undef _
+	return -1;
+}
+
+static
+int assignCode (const Native(Function) native)
+{
+	#define _(X, C) if (native == Op.X) return C ## Code;
+	_(addAssignRef, add) _(minusAssignRef, minus) _(multiplyAssignRef, multiply)
+	_(divideAssignRef, divide) _(moduloAssignRef, modulo)
+	_(leftShiftAssignRef, leftShift) _(rightShiftAssignRef, rightShift)
+	_(unsignedRightShiftAssignRef, unsignedRightShift)
+	_(bitAndAssignRef, bitwiseAnd) _(bitXorAssignRef, bitwiseXor) _(bitOrAssignRef, bitwiseOr)
+	#undef _
+	return -1;
+}
+
+static
+int incrementFlag (const Native(Function) native)
+{
+	if (native == Op.incrementRef)
+		return 0;
+	else if (native == Op.decrementRef)
+		return decrement;
+	else if (native == Op.postIncrementRef)
+		return postfix;
+	else if (native == Op.postDecrementRef)
+		return postfix | decrement;
+	
+	return -1;
+}
+
+static
+int32_t operandCount (const struct Op *op)
+{
+	const Native(Function) native = op->native;
+	
+	if (native == Op.value
+		|| native == Op.valueConstRef
+		|| native == Op.text
+		|| native == Op.function
+		|| native == Op.regexp
+		|| native == Op.this
+		|| native == Op.createLocalRef
+		|| native == Op.getLocalRefOrNull
+		|| native == Op.getLocalRef
+		|| native == Op.getLocal
+		|| native == Op.deleteLocal
+		|| native == Op.getLocalSlotRef
+		|| native == Op.getLocalSlot
+		|| native == Op.deleteLocalSlot
+		|| native == Op.getParentSlotRef
+		|| native == Op.getParentSlot
+		|| native == Op.deleteParentSlot
+		)
+		return 0;
+	
+	if (native == Op.setLocal
+		|| native == Op.setLocalSlot
+		|| native == Op.setParentSlot
+		|| native == Op.getMemberRef
+		|| native == Op.getMember
+		|| native == Op.deleteMember
+		|| native == Op.exchange
+		|| native == Op.typeOf
+		|| native == Op.positive
+		|| native == Op.negative
+		|| native == Op.invert
+		|| native == Op.not
+		|| incrementFlag(native) >= 0
+		)
+		return 1;
+	
+	if (native == Op.setMember
+		|| native == Op.getPropertyRef
+		|| native == Op.getProperty
+		|| native == Op.deleteProperty
+		|| native == Op.instanceOf
+		|| native == Op.in
+		|| native == Op.logicalAnd
+		|| native == Op.logicalOr
+		|| native == Op.discard
+		|| binaryCode(native) >= 0
+		|| assignCode(native) >= 0
+		)
+		return 2;
+	
+	if (native == Op.setProperty)
+		return 3;
+	
+	if (native == Op.object)
+		return op->value.data.integer * 2;
+	
+	if (native == Op.array || native == Op.eval)
+		return op->value.data.integer;
+	
+	if (native == Op.call
+		|| native == Op.construct
+		|| native == Op.callMember
+		|| native == Op.callProperty
+		)
+		return op->value.data.integer + 1;
+	
+	return -1;
+}
+
+static
+uint32_t conditional (struct Compiler *self, uint32_t index, uint32_t *whenTrue, uint32_t *jump, uint32_t *whenFalse)
+{
+	// condition ? a : b, where a ends with a jump over b
+	
+	int32_t offset = opAt(self, index)->value.data.integer;
+	
+	*whenTrue = index + 1 + measure(self, index + 1);
+	*jump = *whenTrue + offset - 1;
+	*whenFalse = *jump + 1;
+	
+	if (offset < 2 || opAt(self, *jump)->native != Op.jump || measure(self, *whenTrue) != (uint32_t)offset - 1)
+		unsupported(self);
+	
+	offset = self->ops[*jump].value.data.integer;
+	if (offset < 1 || measure(self, *whenFalse) != (uint32_t)offset)
+		unsupported(self);
+	
+	return *whenFalse + offset - index;
+}
+
+static
+uint32_t measure (struct Compiler *self, uint32_t index)
+{
+	uint32_t end = index + 1, whenTrue, jump, whenFalse;
+	int32_t count = operandCount(opAt(self, index));
+	
+	if (self->ops[index].native == Op.jumpIfNot)
+		return conditional(self, index, &whenTrue, &jump, &whenFalse);
+	
+	if (count < 0)
+		unsupported(self);
+	
+	while (count--)
+		end += measure(self, end);
+	
+	if (end > self->opCount)
+		unsupported(self);
+	
+	return end - index;
+}
+
+// MARK: expression
+
+static
+uint16_t escape (struct Compiler *self, uint32_t index)
+{
+	uint16_t result = temporary(self);
+	
+	emit(self, escapeCode, index, index, 0, result, 0, 0);
+	return result;
+}
+
+static
+uint32_t operands (struct Compiler *self, uint32_t index, uint16_t *a, uint16_t *b)
+{
+	uint32_t left = index + 1, right = left + measure(self, left);
+	
+	*a = expression(self, left);
+	
+	// a slot may change while the right side runs
+	if (*a & slotOperand && !isPure(self, right))
+		*a = moveTo(self, temporary(self), *a, left);
+	
+	*b = expression(self, right);
+	return right;
+}
+
+static
+void discarded (struct Compiler *self, uint32_t index)
+{
+	uint32_t top = self->top;
+	
+	if (!isPure(self, index))
+		expression(self, index);
+	
+	self->top = top;
+}
+
+static
+void branch (struct Compiler *self, uint32_t index, uint32_t target, int when)
+{
+	const struct Op *op = opAt(self, index);
+	uint32_t top = self->top, right;
+	uint16_t a, b;
+	int code;
+	
+	if (op->native == Op.not)
+		branch(self, index + 1, target, !when);
+	else if (op->native == Op.value)
+	{
+		if (Value.isTrue(op->value) == when)
+			emitJump(self, jumpCode, target, index, index, 0, 0, 0);
+	}
+	else if (op->native == Op.logicalAnd || op->native == Op.logicalOr)
+	{
+		right = index + 1 + measure(self, index + 1);
+		
+		if (when == (op->native == Op.logicalOr))
+		{
+			branch(self, index + 1, target, when);
+			branch(self, right, target, when);
+		}
+		else
+		{
+			uint32_t skip = label(self);
+			branch(self, index + 1, skip, !when);
+			branch(self, right, target, when);
+			bind(self, skip);
+		}
+	}
+	else if ((code = binaryCode(op->native)) >= equalCode && code <= moreOrEqualCode)
+	{
+		right = operands(self, index, &a, &b);
+		emitJump(self, jumpCompareCode, target, index, right, (code - equalCode) | (when? whenTrue: 0), a, b);
+	}
+	else
+	{
+		a = expression(self, index);
+		emitJump(self, when? jumpIfCode: jumpIfNotCode, target, index, index, 0, a, 0);
+	}
+	
+	self->top = top;
+}
+
+static
+uint16_t expression (struct Compiler *self, uint32_t index)
+{
+	const struct Op *op = opAt(self, index);
+	uint32_t top = self->top, right;
+	uint16_t a, b, result;
+	int code;
+	
+	if (op->native == Op.value)
+		return constant(self, op->value);
+	else if (op->native == Op.text)
+		return constant(self, Value.text(&op->text));
+	else if (op->native == Op.getLocalSlot)
+		return slot(self, index);
+	else if (op->native == Op.getParentSlot)
+	{
+		result = temporary(self);
+		emit(self, getParentCode, index, index, 0, result, op->value.data.integer >> 16, op->value.data.integer & 0xffff);
+		return result;
+	}
+	else if (op->native == Op.setLocalSlot)
+	{
+		a = slot(self, index);
+		b = expression(self, index + 1);
+		emit(self, setSlotCode, index, index, 0, a, b, 0);
+		return b;
+	}
+	else if (op->native == Op.setParentSlot)
+	{
+		b = expression(self, index + 1);
+		emit(self, setParentCode, index, index, 0, b, op->value.data.integer >> 16, op->value.data.integer & 0xffff);
+		return b;
+	}
+	else if ((code = binaryCode(op->native)) >= 0)
+	{
+		right = operands(self, index, &a, &b);
+		self->top = top;
+		result = temporary(self);
+		emit(self, code, index, right, 0, result, a, b);
+		return result;
+	}
+	else if ((code = unaryCode(op->native)) >= 0)
+	{
+		a = expression(self, index + 1);
+		self->top = top;
+		result = temporary(self);
+		emit(self, code, index, index + 1, 0, result, a, 0);
+		return result;
+	}
+	else if (op->native == Op.exchange)
+	{
+		discarded(self, index + 1);
+		return constant(self, op->value);
+	}
+	else if (op->native == Op.discard)
+	{
+		discarded(self, index + 1);
+		return expression(self, index + 1 + measure(self, index + 1));
+	}
+	else if (op->native == Op.logicalAnd || op->native == Op.logicalOr)
+	{
+		uint32_t end = label(self);
+		
+		right = index + 1 + measure(self, index + 1);
+		result = temporary(self);
+		moveTo(self, result, expression(self, index + 1), index);
+		self->top = result + 1;
+		emitJump(self, op->native == Op.logicalAnd? jumpIfNotCode: jumpIfCode, end, index, index, 0, result, 0);
+		moveTo(self, result, expression(self, right), index);
+		self->top = result + 1;
+		bind(self, end);
+		return result;
+	}
+	else if (op->native == Op.jumpIfNot)
+	{
+		uint32_t whenTrue, jump, whenFalse, otherwise = label(self), end = label(self);
+		
+		conditional(self, index, &whenTrue, &jump, &whenFalse);
+		result = temporary(self);
+		branch(self, index + 1, otherwise, 0);
+		moveTo(self, result, expression(self, whenTrue), index);
+		self->top = result + 1;
+		emitJump(self, jumpCode, end, jump, jump, 0, 0, 0);
+		bind(self, otherwise);
+		moveTo(self, result, expression(self, whenFalse), index);
+		self->top = result + 1;
+		bind(self, end);
+		return result;
+	}
+	else if ((code = incrementFlag(op->native)) >= 0 && opAt(self, index + 1)->native == Op.getLocalSlotRef)
+	{
+		result = temporary(self);
+		emit(self, incrementCode, index, index, code, result, slot(self, index + 1), 0);
+		return result;
+	}
+	else if ((code = assignCode(op->native)) >= 0 && opAt(self, index + 1)->native == Op.getLocalSlotRef)
+	{
+		// readonly & accessor slots take the ops
+		uint32_t slow = label(self), end = label(self);
+		uint16_t target = slot(self, index + 1);
+		
+		result = temporary(self);
+		emitJump(self, guardCode, slow, index, index, 0, target, 0);
+		b = expression(self, index + 2);
+		emit(self, code, index, index + 2, code == addCode? 0: rightFirst, result, target, b);
+		emit(self, setSlotCode, index, index, 0, target, result, 0);
+		self->top = result + 1;
+		emitJump(self, jumpCode, end, index, index, 0, 0, 0);
+		bind(self, slow);
+		emit(self, escapeCode, index, index, 0, result, 0, 0);
+		bind(self, end);
+		return result;
+	}
+	else
+		return escape(self, index);
+}
+
+// MARK: statement
+
+static
+uint32_t loop (struct Compiler *self, uint32_t index)
+{
+	uint32_t jump = index + 1, skip = opAt(self, index)->value.data.integer, last, end, condition, body, step = 0;
+	uint32_t start = label(self), next = label(self), test = label(self), exit = label(self), depth = self->loopCount;
+	int doWhile;
+	
+	if (opAt(self, jump)->native != Op.jump || self->ops[jump].value.data.integer < 1)
+		unsupported(self);
+	
+	last = jump + self->ops[jump].value.data.integer;
+	end = last + 1;
+	doWhile = opAt(self, last)->native == Op.jump;
+	
+	if (!doWhile && skip)
+	{
+		if (opAt(self, jump + 1)->native != Op.discard || 1 + measure(self, jump + 2) != skip)
+			unsupported(self);
+		
+		step = jump + 2;
+	}
+	
+	condition = jump + 1 + (doWhile? 0: skip);
+	body = condition + measure(self, condition);
+	
+	if (doWhile)
+	{
+		if (opAt(self, last - 1)->native != Op.value)
+			unsupported(self);
+		
+		last -= 2;
+	}
+	
+	if (body > last || opAt(self, last)->native != Op.noop || depth >= sizeof(self->loops) / sizeof(*self->loops))
+		unsupported(self);
+	
+	if (self->indexCount <= depth)
+		self->indexCount = depth + 1;
+	
+	// each test collects what the iteration before it left behind
+	emit(self, markCode, index, index, 0, depth, 0, 0);
+	
+	if (!doWhile)
+		emitJump(self, jumpCode, test, index, index, 0, 0, 0);
+	
+	bind(self, start);
+	self->loops[self->loopCount++] = (struct Loop){ next, exit };
+	statements(self, body, last + 1, next);
+	--self->loopCount;
+	bind(self, next);
+	
+	if (step)
+		discarded(self, step);
+	
+	bind(self, test);
+	emit(self, recycleCode, index, index, 0, depth, 0, 0);
+	branch(self, condition, start, 1);
+	bind(self, exit);
+	return end;
+}
+
+static
+uint32_t countLoop (struct Compiler *self, uint32_t index, enum Code compare)
+{
+	const struct Op *op = opAt(self, index);
+	uint32_t last = index + op->value.data.integer, top = self->top, depth = self->loopCount;
+	uint32_t start = label(self), next = label(self), test = label(self), exit = label(self);
+	uint16_t step, counter, limit;
+	
+	if (last < index + 4 || opAt(self, last)->native != Op.noop || depth >= sizeof(self->loops) / sizeof(*self->loops))
+		unsupported(self);
+	
+	if (opAt(self, index + 1)->native != Op.value || opAt(self, index + 2)->native != Op.getLocalSlotRef)
+		unsupported(self);
+	
+	step = constant(self, self->ops[index + 1].value);
+	counter = slot(self, index + 2);
+	
+	if (opAt(self, index + 3)->native != Op.getLocalSlotRef
+		&& self->ops[index + 3].native != Op.valueConstRef
+		&& self->ops[index + 3].native != Op.getParentSlotRef
+		)
+		unsupported(self);
+	
+	if (self->indexCount <= depth)
+		self->indexCount = depth + 1;
+	
+	emit(self, markCode, index, index, 0, depth, 0, 0);
+	emitJump(self, jumpCode, test, index, index, 0, 0, 0);
+	bind(self, start);
+	self->loops[self->loopCount++] = (struct Loop){ next, exit };
+	statements(self, index + 4, last + 1, next);
+	--self->loopCount;
+	bind(self, next);
+	emit(self, stepCode, index, index, compare >= moreCode? decrement: 0, counter, step, 0);
+	bind(self, test);
+	
+	if (self->ops[index + 3].native == Op.getLocalSlotRef)
+		limit = slot(self, index + 3);
+	else if (self->ops[index + 3].native == Op.valueConstRef)
+		limit = constant(self, self->ops[index + 3].value);
+	else
+	{
+		int32_t integer = self->ops[index + 3].value.data.integer;
+		limit = temporary(self);
+		emit(self, getParentCode, index + 3, index + 3, 0, limit, integer >> 16, integer & 0xffff);
+	}
+	
+	if (depth < loopDepthLimit)
+		emitJump(self, loopCode, start, index, index + 3, (compare - equalCode) | depth << loopDepthShift, counter, limit);
+	else
+	{
+		emit(self, recycleCode, index, index, 0, depth, 0, 0);
+		emitJump(self, jumpCompareCode, start, index, index + 3, (compare - equalCode) | whenTrue, counter, limit);
+	}
+	self->top = top;
+	bind(self, exit);
+	return last + 1;
+}
+
+static
+uint32_t statement (struct Compiler *self, uint32_t index, uint32_t end, uint32_t next)
+{
+	const struct Op *op = opAt(self, index);
+	uint32_t top = self->top, count;
+	uint16_t a;
+	
+	if (op->native == Op.noop)
+	{
+		if (index + 1 < end)
+			emitJump(self, jumpCode, next, index, index, 0, 0, 0);
+		
+		return index + 1;
+	}
+	else if (op->native == Op.next)
+		return index + 1;
+	else if (op->native == Op.discard)
+	{
+		discarded(self, index + 1);
+		return index + 1 + measure(self, index + 1);
+	}
+	else if (op->native == Op.discardN)
+	{
+		for (count = op->value.data.integer, ++index; count--; index += measure(self, index))
+			discarded(self, index);
+		
+		return index;
+	}
+	else if (op->native == Op.autoreleaseDiscard)
+	{
+		if (self->indexCount <= self->loopCount)
+			self->indexCount = self->loopCount + 1;
+		
+		emit(self, markCode, index, index, 0, self->loopCount, 0, 0);
+		discarded(self, index + 1);
+		emit(self, collectCode, index, index, 0, self->loopCount, 0, 0);
+		return index + 1 + measure(self, index + 1);
+	}
+	else if (op->native == Op.jump)
+	{
+		emitJump(self, jumpCode, opLabel(self, index + 1 + op->value.data.integer), index, index, 0, 0, 0);
+		return index + 1;
+	}
+	else if (op->native == Op.jumpIf || op->native == Op.jumpIfNot)
+	{
+		count = measure(self, index + 1);
+		branch(self, index + 1, opLabel(self, index + 1 + count + op->value.data.integer), op->native == Op.jumpIf);
+		return index + 1 + count;
+	}
+	else if (op->native == Op.result)
+	{
+		a = expression(self, index + 1);
+		emit(self, resultCode, index, index, 0, a, 0, 0);
+		self->top = top;
+		return index + 1 + measure(self, index + 1);
+	}
+	else if (op->native == Op.resultVoid)
+	{
+		emit(self, resultCode, index, index, 0, constant(self, Value(undefined)), 0, 0);
+		return index + 1;
+	}
+	else if (op->native == Op.breaker)
+	{
+		// loops count for two levels of breaker: continue, then break
+		int32_t breaker = op->value.data.integer, level = (breaker - 1) / 2;
+		
+		if (breaker < 1 || level >= (int32_t)self->loopCount)
+			unsupported(self);
+		
+		emitJump(self, jumpCode, breaker - level * 2 == 1
+			? self->loops[self->loopCount - 1 - level].next
+			: self->loops[self->loopCount - 1 - level].exit
+			, index, index, 0, 0, 0);
+		
+		return index + 1;
+	}
+	else if (op->native == Op.throw)
+	{
+		escape(self, index);
+		self->top = top;
+		return index + 1 + measure(self, index + 1);
+	}
+	else if (op->native == Op.iterate)
+		return loop(self, index);
+	else if (op->native == Op.iterateLessRef)
+		return countLoop(self, index, lessCode);
+	else if (op->native == Op.iterateLessOrEqualRef)
+		return countLoop(self, index, lessOrEqualCode);
+	else if (op->native == Op.iterateMoreRef)
+		return countLoop(self, index, moreCode);
+	else if (op->native == Op.iterateMoreOrEqualRef)
+		return countLoop(self, index, moreOrEqualCode);
+	
+	unsupported(self);
+	return index;
+}
+
+static
+uint32_t statements (struct Compiler *self, uint32_t index, uint32_t end, uint32_t next)
+{
+	while (index < end)
+	{
+		bind(self, opLabel(self, index));
+		index = statement(self, index, end, next);
+	}
+	
+	if (index != end)
+		unsupported(self);
+	
+	return index;
+}
+
+static
+void finalizeCompiler (struct Compiler *self)
+{
+	free(self->code), self->code = NULL;
+	free(self->origins), self->origins = NULL;
+	free(self->constants), self->constants = NULL;
+	free(self->labels), self->labels = NULL;
+	free(self->fixups), self->fixups = NULL;
+}
+
+// MARK: execute
+
+static
+struct Value retain (struct Value value)
+{
+	if (value.type == Value(charsType))
+		++value.data.chars->referenceCount;
+	if (value.type >= Value(objectType))
+		++value.data.object->referenceCount;
+	
+	Pool.writeBarrier(value);
+	return value;
+}
+
+static
+struct Value release (struct Value value)
+{
+	if (value.type == Value(charsType))
+		--value.data.chars->referenceCount;
+	if (value.type >= Value(objectType))
+		--value.data.object->referenceCount;
+	
+	return value;
+}
+
+static Ecc(inline)
+struct Value binary (double binary)
+{
+	return (struct Value){
+		.data = { .binary = binary },
+		.type = Value(binaryType),
+		.check = 1,
+	};
+}
+
+static Ecc(inline)
+struct Value truth (int truth)
+{
+	return (struct Value){
+		.type = truth? Value(trueType): Value(falseType),
+		.check = 1,
+	};
+}
+
+static Ecc(inline)
+int toNumber (const struct Value *value, double *binary)
+{
+	// reads fields one by one, slots are often written that way just before
+	if (value->type == Value(binaryType))
+		*binary = value->data.binary;
+	else if (value->type == Value(integerType))
+		*binary = value->data.integer;
+	else
+		return 0;
+	
+	return 1;
+}
+
+static
+void toBinaries (struct Context * const context, struct Value *a, struct Value *b, int flag)
+{
+	if (flag & rightFirst)
+		*b = Value.toBinary(context, *b);
+	
+	*a = Value.toBinary(context, *a);
+	
+	if (!(flag & rightFirst))
+		*b = Value.toBinary(context, *b);
+}
+
+static
+void toIntegers (struct Context * const context, struct Value *a, struct Value *b, int flag)
+{
+	if (flag & rightFirst)
+		*b = Value.toInteger(context, *b);
+	
+	*a = Value.toInteger(context, *a);
+	
+	if (!(flag & rightFirst))
+		*b = Value.toInteger(context, *b);
+}
+
+static Ecc(inline)
+int compareBinaries (int compare, double a, double b)
+{
+	// branches rather than a table, a compare site keeps the same kind
+	compare += equalCode;
+	
+	if (compare == lessCode)
+		return a < b;
+	else if (compare == lessOrEqualCode)
+		return a <= b;
+	else if (compare == moreCode)
+		return a > b;
+	else if (compare == moreOrEqualCode)
+		return a >= b;
+	else if (compare == equalCode || compare == identicalCode)
+		return a == b;
+	else
+		return a != b;
+}
+
+static
+struct Value compareValues (struct Context * const context, int compare, struct Value a, struct Value b)
+{
+	switch (compare + equalCode)
+	{
+		case equalCode:
+			return Value.equals(context, a, b);
+		
+		case notEqualCode:
+			return Value.truth(!Value.isTrue(Value.equals(context, a, b)));
+		
+		case identicalCode:
+			return Value.same(context, a, b);
+		
+		case notIdenticalCode:
+			return Value.truth(!Value.isTrue(Value.same(context, a, b)));
+		
+		case lessCode:
+			return Value.less(context, a, b);
+		
+		case lessOrEqualCode:
+			return Value.lessOrEqual(context, a, b);
+		
+		case moreCode:
+			return Value.more(context, a, b);
+		
+		case moreOrEqualCode:
+			return Value.moreOrEqual(context, a, b);
+	}
+	return Value(false);
+}
+
+static Ecc(inline)
+int stepInteger (int32_t *integer, int32_t step)
+{
+	if (step >= 0? *integer > INT32_MAX - step: *integer < INT32_MIN - step)
+		return 0;
+	
+	*integer += step;
+	return 1;
+}
+
+// MARK: - Static Members
+
+// MARK: - Methods
+
+struct Bytecode * create (struct OpList *oplist)
+{
+	struct Compiler compiler = { .ops = oplist->ops, .opCount = oplist->count };
+	struct Compiler *self = &compiler;
+	struct Bytecode *bytecode;
+	uint32_t index, field;
+	
+	if (setjmp(self->bail))
+	{
+		finalizeCompiler(self);
+		return NULL;
+	}
+	
+	for (index = 0; index <= self->opCount; ++index)
+		label(self);
+	
+	{
+		uint32_t end = label(self);
+		statements(self, 0, self->opCount, end);
+		bind(self, opLabel(self, self->opCount));
+		bind(self, end);
+		emit(self, resultCode, self->opCount - 1, self->opCount - 1, 0, constant(self, Value(undefined)), 0, 0);
+	}
+	
+	if (self->registerCount + self->constantCount >= slotOperand)
+		unsupported(self);
+	
+	for (index = 0; index < self->fixupCount; ++index)
+	{
+		if (self->labels[self->fixups[index].label] == noLabel)
+			unsupported(self);
+		
+		self->code[self->fixups[index].instruction].a = self->labels[self->fixups[index].label];
+	}
+	
+	for (index = 0; index < self->codeCount; ++index)
+		for (field = 0; field < 3; ++field)
+		{
+			uint16_t *operand = field == 0? &self->code[index].a: field == 1? &self->code[index].b: &self->code[index].c;
+			
+			if (codeOperands[self->code[index].code] & (1 << field) && (*operand & ~operandMask) == constantOperand)
+				*operand = self->registerCount + (*operand & operandMask);
+		}
+	
+	bytecode = malloc(sizeof(*bytecode));
+	*bytecode = Bytecode.identity;
+	bytecode->code = self->code;
+	bytecode->origins = self->origins;
+	bytecode->constants = self->constants;
+	bytecode->ops = self->ops;
+	bytecode->codeCount = self->codeCount;
+	bytecode->registerCount = self->registerCount;
+	bytecode->constantCount = self->constantCount;
+	bytecode->indexCount = self->indexCount;
+	
+	self->code = NULL;
+	self->origins = NULL;
+	self->constants = NULL;
+	finalizeCompiler(self);
+	
+	return bytecode;
+}
+
+void destroy (struct Bytecode *self)
+{
+	assert(self);
+	
+	free(self->code), self->code = NULL;
+	free(self->origins), self->origins = NULL;
+	free(self->constants), self->constants = NULL;
+	free(self), self = NULL;
+}
+
+struct Value execute (struct Bytecode *self, struct Context * const context)
+{
+	const struct Bytecode(Instruction) * const code = self->code;
+	const struct Bytecode(Instruction) *i = code;
+	struct Value frame[self->registerCount + self->constantCount + 1];
+	uint32_t indices[self->indexCount + 1][3];
+	const struct Value *left, *right;
+	struct Value a, b, *ref;
+	double x, y;
+	
+	#define operand(X) ((X) & slotOperand? context->environment->hashmap[(X) & ~slotOperand].value: frame[X])
+	#define slotRef(X) (&context->environment->hashmap[(X) & ~slotOperand].value)
+	#define operandRef(X) ((X) & slotOperand? slotRef(X): &frame[X])
+	#define origin() (self->origins[i - code])
+	#define seek() (context->ops = self->ops + origin().op)
+	#define texts() Context.setTexts(context, &self->ops[origin().op + 1].text, &self->ops[origin().alt].text)
+	
+	#if __GNUC__
+		// each instruction jumps to the next on its own, which predicts better than a shared switch
+		#define _(X, O) && X ## Label,
+		static const void * const labels[] = {
+			io_libecc_bytecode_List
+		};
+		#undef _
+		#define instruction(X) case X ## Code: X ## Label
+		#define next() goto *labels[(++i)->code]
+		#define jump() { i = code + i->a; goto *labels[i->code]; }
+	#else
+		#define instruction(X) case X ## Code
+		#define next() break
+		#define jump() { i = code + i->a; continue; }
+	#endif
+	
+	memcpy(frame + self->registerCount, self->constants, sizeof(*frame) * self->constantCount);
+	
+	for (;;)
+	{
+		switch ((enum Code)i->code)
+		{
+			instruction(move):
+				frame[i->a] = operand(i->b);
+				next();
+			
+			instruction(escape):
+				seek();
+				frame[i->a] = Op.dispatch(context);
+				next();
+			
+			instruction(setSlot):
+				ref = slotRef(i->a);
+				if (!(ref->flags & Value(readonly)))
+				{
+					a = retain(operand(i->b));
+					release(*ref);
+					ref->data = a.data;
+					ref->type = a.type;
+				}
+				next();
+			
+			instruction(getParent):
+			{
+				struct Object *object = context->environment;
+				uint16_t level = i->b;
+				
+				while (level--)
+					object = object->prototype;
+				
+				frame[i->a] = object->hashmap[i->c].value;
+				next();
+			}
+			
+			instruction(setParent):
+			{
+				struct Object *object = context->environment;
+				uint16_t level = i->b;
+				
+				while (level--)
+					object = object->prototype;
+				
+				ref = &object->hashmap[i->c].value;
+				if (ref->flags & Value(readonly))
+				{
+					if (context->strictMode)
+					{
+						struct Text property = *Key.textOf(ref->key);
+						seek();
+						Context.setText(context, &self->ops[origin().op].text);
+						Context.typeError(context, Chars.create("'%.*s' is read-only", property.length, property.bytes));
+					}
+				}
+				else
+				{
+					a = retain(operand(i->a));
+					release(*ref);
+					ref->data = a.data;
+					ref->type = a.type;
+				}
+				next();
+			}
+			
+			instruction(add):
+				left = operandRef(i->b), right = operandRef(i->c);
+				if (toNumber(left, &x) && toNumber(right, &y))
+					frame[i->a] = binary(x + y);
+				else
+				{
+					a = *left, b = *right;
+					seek();
+					texts();
+					frame[i->a] = Value.add(context, a, b);
+				}
+				next();
+			
+			#define binaryCase(CODE, EXPRESSION) \
+				instruction(CODE): \
+					left = operandRef(i->b), right = operandRef(i->c); \
+					if (!toNumber(left, &x) || !toNumber(right, &y)) \
+					{ \
+						a = *left, b = *right; \
+						seek(); \
+						toBinaries(context, &a, &b, i->flag); \
+						x = a.data.binary, y = b.data.binary; \
+					} \
+					frame[i->a] = binary(EXPRESSION); \
+					next();
+			
+			binaryCase(minus, x - y)
+			binaryCase(multiply, x * y)
+			binaryCase(divide, x / y)
+			binaryCase(modulo, fmod(x, y))
+			
+			#define integerCase(CODE, EXPRESSION) \
+				instruction(CODE): \
+					left = operandRef(i->b), right = operandRef(i->c); \
+					if (left->type == Value(integerType) && right->type == Value(integerType)) \
+						a.data.integer = left->data.integer, b.data.integer = right->data.integer; \
+					else \
+					{ \
+						a = *left, b = *right; \
+						seek(); \
+						toIntegers(context, &a, &b, i->flag); \
+					} \
+					frame[i->a] = binary(EXPRESSION); \
+					next();
+			
+			integerCase(leftShift, (int32_t)((uint32_t)a.data.integer << (b.data.integer & 0x1f)))
+			integerCase(rightShift, a.data.integer >> (b.data.integer & 0x1f))
+			integerCase(unsignedRightShift, (uint32_t)a.data.integer >> (b.data.integer & 0x1f))
+			integerCase(bitwiseAnd, a.data.integer & b.data.integer)
+			integerCase(bitwiseXor, a.data.integer ^ b.data.integer)
+			integerCase(bitwiseOr, a.data.integer | b.data.integer)
+			
+			instruction(equal):
+			instruction(notEqual):
+			instruction(identical):
+			instruction(notIdentical):
+			instruction(less):
+			instruction(lessOrEqual):
+			instruction(more):
+			instruction(moreOrEqual):
+				left = operandRef(i->b), right = operandRef(i->c);
+				if (toNumber(left, &x) && toNumber(right, &y))
+					frame[i->a] = truth(compareBinaries(i->code - equalCode, x, y));
+				else
+				{
+					a = *left, b = *right;
+					seek();
+					texts();
+					frame[i->a] = compareValues(context, i->code - equalCode, a, b);
+				}
+				next();
+			
+			instruction(positive):
+				a = operand(i->b);
+				frame[i->a] = a.type == Value(binaryType)? a: (seek(), Value.toBinary(context, a));
+				next();
+			
+			instruction(negative):
+				a = operand(i->b);
+				if (a.type != Value(binaryType))
+					seek(), a = Value.toBinary(context, a);
+				
+				frame[i->a] = binary(-a.data.binary);
+				next();
+			
+			instruction(invert):
+				a = operand(i->b);
+				seek();
+				frame[i->a] = binary(~Value.toInteger(context, a).data.integer);
+				next();
+			
+			instruction(not):
+				frame[i->a] = truth(!Value.isTrue(operand(i->b)));
+				next();
+			
+			instruction(increment):
+			{
+				ref = slotRef(i->b);
+				if (ref->flags & (Value(readonly) | Value(accessor)))
+				{
+					seek();
+					frame[i->a] = Op.dispatch(context);
+					next();
+				}
+				
+				if (!toNumber(ref, &x))
+				{
+					seek();
+					x = Value.toBinary(context, release(*ref)).data.binary;
+					ref = slotRef(i->b);
+				}
+				
+				y = x + (i->flag & decrement? -1: 1);
+				ref->data.binary = y;
+				ref->type = Value(binaryType);
+				frame[i->a] = binary(i->flag & postfix? x: y);
+				next();
+			}
+			
+			instruction(guard):
+				if (slotRef(i->b)->flags & (Value(readonly) | Value(accessor)))
+					jump();
+				
+				next();
+			
+			instruction(jump):
+				jump();
+			
+			instruction(jumpIf):
+				if (Value.isTrue(operand(i->b)))
+					jump();
+				
+				next();
+			
+			instruction(jumpIfNot):
+				if (!Value.isTrue(operand(i->b)))
+					jump();
+				
+				next();
+			
+			instruction(jumpCompare):
+			{
+				int truth;
+				
+				left = operandRef(i->b), right = operandRef(i->c);
+				if (toNumber(left, &x) && toNumber(right, &y))
+					truth = compareBinaries(i->flag & ~whenTrue, x, y);
+				else
+				{
+					a = *left, b = *right;
+					seek();
+					texts();
+					truth = Value.isTrue(compareValues(context, i->flag & ~whenTrue, a, b));
+				}
+				
+				if (truth == !!(i->flag & whenTrue))
+					jump();
+				
+				next();
+			}
+			
+			instruction(mark):
+				Pool.getIndices(indices[i->a]);
+				next();
+			
+			instruction(collect):
+				Pool.collectUnreferencedFromIndices(indices[i->a]);
+				next();
+			
+			instruction(recycle):
+				Pool.collectUnreferencedFromIndices(indices[i->a]);
+				Pool.getIndices(indices[i->a]);
+				next();
+			
+			instruction(loop):
+			{
+				uint32_t *loopIndices = indices[i->flag >> loopDepthShift];
+				int truth;
+				
+				Pool.collectUnreferencedFromIndices(loopIndices);
+				Pool.getIndices(loopIndices);
+				
+				left = operandRef(i->b), right = operandRef(i->c);
+				if (toNumber(left, &x) && toNumber(right, &y))
+					truth = compareBinaries(i->flag & ((1 << loopDepthShift) - 1), x, y);
+				else
+				{
+					a = *left, b = *right;
+					seek();
+					truth = Value.isTrue(compareValues(context, i->flag & ((1 << loopDepthShift) - 1), a, b));
+				}
+				
+				if (truth)
+					jump();
+				
+				next();
+			}
+			
+			instruction(step):
+				ref = slotRef(i->a);
+				b = operand(i->b);
+				
+				if (ref->type == Value(integerType) && b.type == Value(integerType) && stepInteger(&ref->data.integer, i->flag & decrement? -b.data.integer: b.data.integer))
+					next();
+				else if (ref->type == Value(binaryType) && b.type == Value(integerType))
+					ref->data.binary += i->flag & decrement? -b.data.integer: b.data.integer;
+				else
+				{
+					seek();
+					a = retain((i->flag & decrement? Value.subtract: Value.add)(context, *ref, b));
+					ref = slotRef(i->a);
+					release(*ref);
+					ref->data = a.data;
+					ref->type = a.type;
+				}
+				next();
+			
+			instruction(result):
+				return operand(i->a);
+		}
+		++i;
+	}
+	
+	#undef operand
+	#undef slotRef
+	#undef operandRef
+	#undef origin
+	#undef seek
+	#undef texts
+	#undef instruction
+	#undef next
+	#undef jump
+	#undef binaryCase
+	#undef integerCase
+}
+
+void dumpTo (struct Bytecode *self, FILE *file)
+{
+	uint32_t index, field;
+	
+	assert(self);
+	
+	for (index = 0; index < self->codeCount; ++index)
+	{
+		const struct Bytecode(Instruction) *instruction = &self->code[index];
+		
+		fprintf(file, "[%04u] %-18s", index, codeNames[instruction->code]);
+		
+		for (field = 0; field < 3; ++field)
+		{
+			uint16_t operand = field == 0? instruction->a: field == 1? instruction->b: instruction->c;
+			
+			if (!(codeOperands[instruction->code] & (1 << field)))
+				fprintf(file, " %u", operand);
+			else if (operand & slotOperand)
+				fprintf(file, " s%u", operand & ~slotOperand);
+			else if (operand >= self->registerCount)
+			{
+				fputs(" ", file);
+				Value.dumpTo(self->constants[operand - self->registerCount], file);
+			}
+			else
+				fprintf(file, " r%u", operand);
+		}
+		
+		fprintf(file, " ; %s\n", Op.toChars(self->ops[self->origins[index].op].native));
+	}
+}
@@ -0,0 +1,67 @@
+//
+//  bytecode.h
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#ifndef io_libecc_bytecode_h
+#ifdef Implementation
+#undef Implementation
+#include __FILE__
+#include "implementation.h"
+#else
+#include "interface.h"
+#define io_libecc_bytecode_h
+
+	#include "oplist.h"
+	
+	// register code compiled from the ops of a function, as a second backend:
+	//
+	//   instruction: u8:code u8:flag u16:a u16:b u16:c
+	//
+	// operands below 0x8000 index the frame of a call, registers then constants
+	// copied from the pool; from 0x8000 they are slots of the environment.
+	// each instruction keeps the index of its origin op, which places texts
+	// for errors & backtraces, and expressions without instruction run as ops
+	// from there
+	
+	struct Bytecode(Instruction) {
+		uint8_t code;
+		uint8_t flag;
+		uint16_t a;
+		uint16_t b;
+		uint16_t c;
+	};
+	
+	struct Bytecode(Origin) {
+		uint32_t op;
+		uint32_t alt;
+	};
+
+#endif
+
+
+Interface(Bytecode,
+	
+	(struct Bytecode *, create ,(struct OpList *))
+	(void, destroy ,(struct Bytecode *))
+	
+	(struct Value, execute ,(struct Bytecode *, struct Context * const))
+	
+	(void, dumpTo ,(struct Bytecode *, FILE *file))
+	,
+	{
+		struct Bytecode(Instruction) *code;
+		struct Bytecode(Origin) *origins;
+		struct Value *constants;
+		struct Op *ops;
+		uint32_t codeCount;
+		uint16_t registerCount;
+		uint16_t constantCount;
+		uint16_t indexCount;
+	}
+)
+
+#endif
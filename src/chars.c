@@ -14,6 +14,15 @@
 
 // MARK: - Private
 
+// a rope node keeps its left operand and the appended tail, in bytes:
+// [struct Rope][tail bytes]; length is the total length of the string
+struct Rope {
+	struct Chars *left;
+	int32_t tail;
+};
+
+static const int32_t ropeMinimumLength = 256;
+
 static inline
 uint32_t nextPowerOfTwo(uint32_t v)
 {
@@ -38,6 +47,25 @@ uint32_t sizeForLength(uint32_t length)
 		return nextPowerOfTwo(size);
 }
 
+static inline
+struct Chars *allocate (uint32_t length)
+{
+	uint32_t size = sizeForLength(length);
+	
+	if (size <= Pool(slabLimit))
+		return Pool.allocate(size);
+	else
+		return malloc(size);
+}
+
+static inline
+struct Rope ropeOf (const struct Chars *self)
+{
+	struct Rope rope;
+	memcpy(&rope, self->bytes, sizeof(rope));
+	return rope;
+}
+
 static
 struct Chars *reuseOrCreate (struct Chars(Append) *chars, uint32_t length)
 {
@@ -53,12 +81,14 @@ struct Chars *reuseOrCreate (struct Chars(Append) *chars, uint32_t length)
 		if (length < 8)
 			return NULL;
 		
-		self = malloc(sizeForLength(length));
-		Pool.addChars(self);
+		self = allocate(length);
 	}
 	
 	if (reuse)
+	{
 		memcpy(self, reuse, sizeof(*self) + reuse->length);
+		self->flags &= ~Chars(slab);
+	}
 	else
 	{
 		*self = Chars.identity;
@@ -66,10 +96,237 @@ struct Chars *reuseOrCreate (struct Chars(Append) *chars, uint32_t length)
 		memcpy(self->bytes, chars->buffer, chars->units);
 	}
 	
+	if (sizeForLength(length) <= Pool(slabLimit))
+		self->flags |= Chars(slab);
+	
+	Pool.addChars(self);
 	chars->value = self;
 	return self;
 }
 
+// shortest round-trip digits of a double (Grisu3, after Loitsch's "Printing
+// Floating-Point Numbers Quickly and Accurately with Integers"); the few
+// inputs it cannot decide are settled by exactDigits
+
+struct DiyFp {
+	uint64_t f;
+	int e;
+};
+
+static const struct {
+	uint64_t f;
+	int16_t e;
+	int16_t exponent;
+} cachedPowers[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220, -348 }, { 0xbaaee17fa23ebf76ULL, -1193, -340 },
+	{ 0x8b16fb203055ac76ULL, -1166, -332 }, { 0xcf42894a5dce35eaULL, -1140, -324 },
+	{ 0x9a6bb0aa55653b2dULL, -1113, -316 }, { 0xe61acf033d1a45dfULL, -1087, -308 },
+	{ 0xab70fe17c79ac6caULL, -1060, -300 }, { 0xff77b1fcbebcdc4fULL, -1034, -292 },
+	{ 0xbe5691ef416bd60cULL, -1007, -284 }, { 0x8dd01fad907ffc3cULL, -980, -276 },
+	{ 0xd3515c2831559a83ULL, -954, -268 }, { 0x9d71ac8fada6c9b5ULL, -927, -260 },
+	{ 0xea9c227723ee8bcbULL, -901, -252 }, { 0xaecc49914078536dULL, -874, -244 },
+	{ 0x823c12795db6ce57ULL, -847, -236 }, { 0xc21094364dfb5637ULL, -821, -228 },
+	{ 0x9096ea6f3848984fULL, -794, -220 }, { 0xd77485cb25823ac7ULL, -768, -212 },
+	{ 0xa086cfcd97bf97f4ULL, -741, -204 }, { 0xef340a98172aace5ULL, -715, -196 },
+	{ 0xb23867fb2a35b28eULL, -688, -188 }, { 0x84c8d4dfd2c63f3bULL, -661, -180 },
+	{ 0xc5dd44271ad3cdbaULL, -635, -172 }, { 0x936b9fcebb25c996ULL, -608, -164 },
+	{ 0xdbac6c247d62a584ULL, -582, -156 }, { 0xa3ab66580d5fdaf6ULL, -555, -148 },
+	{ 0xf3e2f893dec3f126ULL, -529, -140 }, { 0xb5b5ada8aaff80b8ULL, -502, -132 },
+	{ 0x87625f056c7c4a8bULL, -475, -124 }, { 0xc9bcff6034c13053ULL, -449, -116 },
+	{ 0x964e858c91ba2655ULL, -422, -108 }, { 0xdff9772470297ebdULL, -396, -100 },
+	{ 0xa6dfbd9fb8e5b88fULL, -369, -92 }, { 0xf8a95fcf88747d94ULL, -343, -84 },
+	{ 0xb94470938fa89bcfULL, -316, -76 }, { 0x8a08f0f8bf0f156bULL, -289, -68 },
+	{ 0xcdb02555653131b6ULL, -263, -60 }, { 0x993fe2c6d07b7facULL, -236, -52 },
+	{ 0xe45c10c42a2b3b06ULL, -210, -44 }, { 0xaa242499697392d3ULL, -183, -36 },
+	{ 0xfd87b5f28300ca0eULL, -157, -28 }, { 0xbce5086492111aebULL, -130, -20 },
+	{ 0x8cbccc096f5088ccULL, -103, -12 }, { 0xd1b71758e219652cULL, -77, -4 },
+	{ 0x9c40000000000000ULL, -50, 4 }, { 0xe8d4a51000000000ULL, -24, 12 },
+	{ 0xad78ebc5ac620000ULL, 3, 20 }, { 0x813f3978f8940984ULL, 30, 28 },
+	{ 0xc097ce7bc90715b3ULL, 56, 36 }, { 0x8f7e32ce7bea5c70ULL, 83, 44 },
+	{ 0xd5d238a4abe98068ULL, 109, 52 }, { 0x9f4f2726179a2245ULL, 136, 60 },
+	{ 0xed63a231d4c4fb27ULL, 162, 68 }, { 0xb0de65388cc8ada8ULL, 189, 76 },
+	{ 0x83c7088e1aab65dbULL, 216, 84 }, { 0xc45d1df942711d9aULL, 242, 92 },
+	{ 0x924d692ca61be758ULL, 269, 100 }, { 0xda01ee641a708deaULL, 295, 108 },
+	{ 0xa26da3999aef774aULL, 322, 116 }, { 0xf209787bb47d6b85ULL, 348, 124 },
+	{ 0xb454e4a179dd1877ULL, 375, 132 }, { 0x865b86925b9bc5c2ULL, 402, 140 },
+	{ 0xc83553c5c8965d3dULL, 428, 148 }, { 0x952ab45cfa97a0b3ULL, 455, 156 },
+	{ 0xde469fbd99a05fe3ULL, 481, 164 }, { 0xa59bc234db398c25ULL, 508, 172 },
+	{ 0xf6c69a72a3989f5cULL, 534, 180 }, { 0xb7dcbf5354e9beceULL, 561, 188 },
+	{ 0x88fcf317f22241e2ULL, 588, 196 }, { 0xcc20ce9bd35c78a5ULL, 614, 204 },
+	{ 0x98165af37b2153dfULL, 641, 212 }, { 0xe2a0b5dc971f303aULL, 667, 220 },
+	{ 0xa8d9d1535ce3b396ULL, 694, 228 }, { 0xfb9b7cd9a4a7443cULL, 720, 236 },
+	{ 0xbb764c4ca7a44410ULL, 747, 244 }, { 0x8bab8eefb6409c1aULL, 774, 252 },
+	{ 0xd01fef10a657842cULL, 800, 260 }, { 0x9b10a4e5e9913129ULL, 827, 268 },
+	{ 0xe7109bfba19c0c9dULL, 853, 276 }, { 0xac2820d9623bf429ULL, 880, 284 },
+	{ 0x80444b5e7aa7cf85ULL, 907, 292 }, { 0xbf21e44003acdd2dULL, 933, 300 },
+	{ 0x8e679c2f5e44ff8fULL, 960, 308 }, { 0xd433179d9c8cb841ULL, 986, 316 },
+	{ 0x9e19db92b4e31ba9ULL, 1013, 324 }, { 0xeb96bf6ebadf77d9ULL, 1039, 332 },
+	{ 0xaf87023b9bf0ee6bULL, 1066, 340 },
+};
+
+enum {
+	cachedPowersFirst = -348,
+	cachedPowersStep = 8,
+	targetExponent = -60,
+};
+
+static const char digitPairs[] =
+	"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+	"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static inline
+struct DiyFp multiplyDiyFp (struct DiyFp x, struct DiyFp y)
+{
+	uint64_t a = x.f >> 32, b = x.f & 0xffffffff, c = y.f >> 32, d = y.f & 0xffffffff;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t middle = (bd >> 32) + (ad & 0xffffffff) + (bc & 0xffffffff) + (1U << 31);
+	
+	return (struct DiyFp){ ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64 };
+}
+
+static inline
+struct DiyFp normalizeDiyFp (struct DiyFp x)
+{
+	while (!(x.f & 0xffc0000000000000ULL))
+		x.f <<= 10, x.e -= 10;
+	
+	while (!(x.f & 0x8000000000000000ULL))
+		x.f <<= 1, --x.e;
+	
+	return x;
+}
+
+static
+int roundWeed (char *digits, int length, uint64_t distance, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t unit)
+{
+	uint64_t smallDistance = distance - unit, bigDistance = distance + unit;
+	
+	// walk the last digit down while it brings the result closer to the input
+	while (rest < smallDistance && delta - rest >= tenKappa
+		&& (rest + tenKappa < smallDistance || smallDistance - rest >= rest + tenKappa - smallDistance))
+	{
+		--digits[length - 1];
+		rest += tenKappa;
+	}
+	
+	if (rest < bigDistance && delta - rest >= tenKappa
+		&& (rest + tenKappa < bigDistance || bigDistance - rest > rest + tenKappa - bigDistance))
+		return 0;
+	
+	return 2 * unit <= rest && rest <= delta - 4 * unit;
+}
+
+static
+int generateDigits (struct DiyFp low, struct DiyFp w, struct DiyFp high, char *digits, int *length, int *kappa)
+{
+	static const uint32_t powersOfTen[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+	uint64_t unit = 1;
+	struct DiyFp tooLow = { low.f - unit, low.e }, tooHigh = { high.f + unit, high.e };
+	uint64_t unsafeInterval = tooHigh.f - tooLow.f;
+	int shift = -w.e;
+	uint64_t one = (uint64_t)1 << shift;
+	uint32_t integral = (uint32_t)(tooHigh.f >> shift), divisor;
+	uint64_t fractional = tooHigh.f & (one - 1), rest;
+	
+	*kappa = 10;
+	while (*kappa > 1 && integral < powersOfTen[*kappa - 1])
+		--*kappa;
+	
+	divisor = powersOfTen[*kappa - 1];
+	*length = 0;
+	
+	while (*kappa > 0)
+	{
+		digits[(*length)++] = '0' + integral / divisor;
+		integral %= divisor;
+		--*kappa;
+		
+		rest = ((uint64_t)integral << shift) + fractional;
+		if (rest < unsafeInterval)
+			return roundWeed(digits, *length, tooHigh.f - w.f, unsafeInterval, rest, (uint64_t)divisor << shift, unit);
+		
+		divisor /= 10;
+	}
+	
+	for (;;)
+	{
+		fractional *= 10;
+		unit *= 10;
+		unsafeInterval *= 10;
+		
+		digits[(*length)++] = '0' + (char)(fractional >> shift);
+		fractional &= one - 1;
+		--*kappa;
+		
+		if (fractional < unsafeInterval)
+			return roundWeed(digits, *length, (tooHigh.f - w.f) * unit, unsafeInterval, fractional, one, unit);
+	}
+}
+
+static
+int grisuDigits (double binary, char *digits, int *exponent)
+{
+	uint64_t bits;
+	struct DiyFp v, w, plus, minus, power;
+	int k, index, length, kappa;
+	
+	memcpy(&bits, &binary, sizeof(bits));
+	
+	if (bits & 0x7ff0000000000000ULL)
+		v = (struct DiyFp){ (bits & 0x000fffffffffffffULL) | 0x0010000000000000ULL, (int)(bits >> 52 & 0x7ff) - 1075 };
+	else
+		v = (struct DiyFp){ bits & 0x000fffffffffffffULL, -1074 };
+	
+	// boundaries halfway to the neighbouring doubles, closer below at powers of two
+	w = normalizeDiyFp(v);
+	plus = normalizeDiyFp((struct DiyFp){ (v.f << 1) + 1, v.e - 1 });
+	if (!(bits & 0x000fffffffffffffULL) && bits & 0x7ff0000000000000ULL)
+		minus = (struct DiyFp){ (v.f << 2) - 1, v.e - 2 };
+	else
+		minus = (struct DiyFp){ (v.f << 1) - 1, v.e - 1 };
+	
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+	
+	// a power of ten bringing w to a binary exponent in [-60, -32]
+	k = (int)ceil((targetExponent - 64 - w.e + 63) * 0.30102999566398114);
+	index = (k - cachedPowersFirst - 1) / cachedPowersStep + 1;
+	power = (struct DiyFp){ cachedPowers[index].f, cachedPowers[index].e };
+	
+	if (!generateDigits(multiplyDiyFp(minus, power), multiplyDiyFp(w, power), multiplyDiyFp(plus, power), digits, &length, &kappa))
+		return 0;
+	
+	*exponent = kappa - cachedPowers[index].exponent;
+	return length;
+}
+
+static
+int exactDigits (double binary, char *digits, int *exponent)
+{
+	char buffer[Chars(binaryLength)];
+	int precision, low = 1, high = 17, length = 0, index;
+	
+	// precisions that read back only grow from the shortest, and printf rounds it closest
+	while (low < high)
+	{
+		precision = (low + high) / 2;
+		snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, binary);
+		if (strtod(buffer, NULL) == binary)
+			high = precision;
+		else
+			low = precision + 1;
+	}
+	precision = low;
+	snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, binary);
+	
+	digits[length++] = buffer[0];
+	for (index = 2; length < precision; ++index)
+		digits[length++] = buffer[index];
+	
+	*exponent = atoi(strchr(buffer, 'e') + 1) - (length - 1);
+	return length;
+}
+
 // MARK: - Static Members
 
 // MARK: - Methods
@@ -103,10 +360,14 @@ struct Chars * create (const char *format, ...)
 
 struct Chars * createSized (int32_t length)
 {
-	struct Chars *self = malloc(sizeForLength(length));
-	Pool.addChars(self);
+	struct Chars *self = allocate(length);
 	*self = Chars.identity;
 	
+	if (sizeForLength(length) <= Pool(slabLimit))
+		self->flags |= Chars(slab);
+	
+	Pool.addChars(self);
+	
 	self->length = length;
 	self->bytes[length] = '\0';
 	
@@ -115,10 +376,14 @@ struct Chars * createSized (int32_t length)
 
 struct Chars * createWithBytes (int32_t length, const char *bytes)
 {
-	struct Chars *self = malloc(sizeForLength(length));
-	Pool.addChars(self);
+	struct Chars *self = allocate(length);
 	*self = Chars.identity;
 	
+	if (sizeForLength(length) <= Pool(slabLimit))
+		self->flags |= Chars(slab);
+	
+	Pool.addChars(self);
+	
 	self->length = length;
 	memcpy(self->bytes, bytes, length);
 	self->bytes[length] = '\0';
@@ -126,6 +391,81 @@ struct Chars * createWithBytes (int32_t length, const char *bytes)
 	return self;
 }
 
+struct Chars * concatenate (struct Chars *left, struct Text tail)
+{
+	struct Chars *self;
+	struct Rope rope = { left, tail.length };
+	struct Text(Char) c;
+	
+	if (left->length < ropeMinimumLength || !tail.length)
+		return NULL;
+	
+	// joining surrogate halves rewrites the end of left
+	c = Text.character(tail);
+	if (c.units == 3 && c.codepoint >= 0xDC00 && c.codepoint <= 0xDFFF)
+		return NULL;
+	
+	self = allocate(sizeof(rope) + tail.length);
+	*self = Chars.identity;
+	
+	if (sizeForLength(sizeof(rope) + tail.length) <= Pool(slabLimit))
+		self->flags |= Chars(slab);
+	
+	self->flags |= Chars(rope);
+	self->length = left->length + tail.length;
+	memcpy(self->bytes, &rope, sizeof(rope));
+	memcpy(self->bytes + sizeof(rope), tail.bytes, tail.length);
+	++left->referenceCount;
+	
+	Pool.addChars(self);
+	
+	return self;
+}
+
+struct Chars * flatten (struct Chars *self)
+{
+	struct Chars *flat, *chars;
+	struct Rope rope;
+	int32_t length;
+	
+	if (!(self->flags & Chars(rope)))
+		return self;
+	
+	rope = ropeOf(self);
+	
+	// flattened already
+	if (rope.left->length == self->length)
+		return rope.left;
+	
+	flat = createSized(self->length);
+	
+	for (chars = self, length = self->length; chars->flags & Chars(rope); chars = rope.left)
+	{
+		rope = ropeOf(chars);
+		if (rope.left->length != chars->length)
+		{
+			length -= rope.tail;
+			memcpy(flat->bytes + length, chars->bytes + sizeof(rope), rope.tail);
+		}
+	}
+	memcpy(flat->bytes, chars->bytes, length);
+	
+	// the node now leads to the flat copy, the chain is left to the collector
+	rope = ropeOf(self);
+	--rope.left->referenceCount;
+	++flat->referenceCount;
+	rope.left = flat;
+	memcpy(self->bytes, &rope, sizeof(rope));
+	
+	return flat;
+}
+
+struct Chars * ropeLeft (const struct Chars *self)
+{
+	assert(self->flags & Chars(rope));
+	
+	return ropeOf(self).left;
+}
 
 void beginAppend (struct Chars(Append) *chars)
 {
@@ -265,23 +605,12 @@ void appendValue (struct Chars(Append) *chars, struct Context * const context, s
 			return;
 			
 		case Value(referenceType):
+		case Value(dispatchType):
 			break;
 	}
 	Ecc.fatal("Invalid Value(Type) : %u", value.type);
 }
 
-static
-uint32_t stripBinaryOfBytes (char *bytes, uint32_t length)
-{
-	while (bytes[length - 1] == '0')
-		bytes[--length] = '\0';
-	
-	if (bytes[length - 1] == '.')
-		bytes[--length] = '\0';
-	
-	return length;
-}
-
 static
 uint32_t normalizeBinaryOfBytes (char *bytes, uint32_t length)
 {
@@ -320,27 +649,9 @@ void appendBinary (struct Chars(Append) *chars, double binary, int base)
 	
 	if (!base || base == 10)
 	{
-		if (binary <= -1e+21 || binary >= 1e+21)
-			append(chars, "%g", binary);
-		else if ((binary < 1 && binary >= 0.000001) || (binary > -1 && binary <= -0.000001))
-		{
-			append(chars, "%.10f", binary);
-			if (chars->value)
-				chars->value->length = stripBinaryOfBytes(chars->value->bytes, chars->value->length);
-			else
-				chars->units = stripBinaryOfBytes(chars->buffer, chars->units);
-			
-			return;
-		}
-		else
-		{
-			double dblDig10 = pow(10, DBL_DIG);
-			int precision = binary >= -dblDig10 && binary <= dblDig10? DBL_DIG: 21;
-			
-			append(chars, "%.*g", precision, binary);
-		}
+		char buffer[Chars(binaryLength)];
 		
-		normalizeBinary(chars);
+		appendText(chars, Text.make(buffer, writeBinary(buffer, binary)));
 		return;
 	}
 	else
@@ -374,6 +685,92 @@ void appendBinary (struct Chars(Append) *chars, double binary, int base)
 	}
 }
 
+uint8_t writeInteger (char *bytes, int64_t integer)
+{
+	char buffer[20], *p = buffer + sizeof(buffer);
+	uint64_t digits = integer < 0? -(uint64_t)integer: (uint64_t)integer;
+	uint8_t length;
+	
+	for (; digits >= 100; digits /= 100)
+		memcpy(p -= 2, digitPairs + digits % 100 * 2, 2);
+	
+	if (digits >= 10)
+		memcpy(p -= 2, digitPairs + digits * 2, 2);
+	else
+		*--p = '0' + (char)digits;
+	
+	if (integer < 0)
+		*--p = '-';
+	
+	length = buffer + sizeof(buffer) - p;
+	memcpy(bytes, p, length);
+	return length;
+}
+
+// finite binaries only, bytes must hold Chars(binaryLength)
+uint8_t writeBinary (char *bytes, double binary)
+{
+	char digits[18], *p = bytes;
+	int length, exponent, point;
+	
+	if (binary == 0)
+	{
+		*p = '0';
+		return 1;
+	}
+	else if (binary >= -9007199254740992. && binary <= 9007199254740992. && binary == (double)(int64_t)binary)
+		return writeInteger(bytes, (int64_t)binary);
+	
+	if (binary < 0)
+	{
+		*p++ = '-';
+		binary = -binary;
+	}
+	
+	if (!(length = grisuDigits(binary, digits, &exponent)))
+		length = exactDigits(binary, digits, &exponent);
+	
+	// ECMAScript Number::toString, with the decimal point after `point` digits
+	point = length + exponent;
+	
+	if (length <= point && point <= 21)
+	{
+		memcpy(p, digits, length);
+		memset(p + length, '0', point - length);
+		p += point;
+	}
+	else if (0 < point && point <= 21)
+	{
+		memcpy(p, digits, point);
+		p[point] = '.';
+		memcpy(p + point + 1, digits + point, length - point);
+		p += length + 1;
+	}
+	else if (-6 < point && point <= 0)
+	{
+		*p++ = '0';
+		*p++ = '.';
+		memset(p, '0', -point);
+		memcpy(p - point, digits, length);
+		p += length - point;
+	}
+	else
+	{
+		*p++ = digits[0];
+		if (length > 1)
+		{
+			*p++ = '.';
+			memcpy(p, digits + 1, length - 1);
+			p += length - 1;
+		}
+		*p++ = 'e';
+		*p++ = point > 0? '+': '-';
+		p += writeInteger(p, point > 0? point - 1: 1 - point);
+	}
+	
+	return p - bytes;
+}
+
 void normalizeBinary (struct Chars(Append) *chars)
 {
 	if (chars->value)
@@ -399,7 +796,14 @@ void destroy (struct Chars *self)
 {
 	assert(self);
 	
-	free(self), self = NULL;
+	if (self->flags & Chars(indexed))
+		String.forgetIndex(self);
+	
+	// length may only have shrunk since creation, the block fits its current size class
+	if (self->flags & Chars(slab))
+		Pool.deallocate(self, sizeForLength(self->flags & Chars(rope)? sizeof(struct Rope) + ropeOf(self).tail: self->length)), self = NULL;
+	else
+		free(self), self = NULL;
 }
 
 uint8_t codepointLength (uint32_t cp)
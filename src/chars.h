@@ -25,6 +25,13 @@
 	{
 		Chars(mark) = 1 << 0,
 		Chars(asciiOnly) = 1 << 1,
+		Chars(slab) = 1 << 2,
+		Chars(rope) = 1 << 3,
+		Chars(indexed) = 1 << 4,
+	};
+	
+	enum {
+		Chars(binaryLength) = 32,
 	};
 
 	struct Chars(Append) {
@@ -42,12 +49,18 @@ Interface(Chars,
 	(struct Chars *, create ,(const char *format, ...))
 	(struct Chars *, createSized ,(int32_t length))
 	(struct Chars *, createWithBytes ,(int32_t length, const char *bytes))
+	(struct Chars *, concatenate ,(struct Chars *left, struct Text tail))
+	
+	(struct Chars *, flatten ,(struct Chars *))
+	(struct Chars *, ropeLeft ,(const struct Chars *))
 	
 	(void, beginAppend ,(struct Chars(Append) *))
 	(void, append ,(struct Chars(Append) *, const char *format, ...))
 	(void, appendCodepoint ,(struct Chars(Append) *, uint32_t cp))
 	(void, appendValue ,(struct Chars(Append) *, struct Context * const context, struct Value value))
 	(void, appendBinary ,(struct Chars(Append) *, double binary, int base))
+	(uint8_t, writeInteger ,(char *, int64_t integer))
+	(uint8_t, writeBinary ,(char *, double binary))
 	(void, normalizeBinary ,(struct Chars(Append) *))
 	(struct Value, endAppend ,(struct Chars(Append) *))
 	
@@ -29,10 +29,24 @@
 
 	#if __GNUC__
 		#define io_libecc_ecc_noreturn __attribute__((noreturn))
+		#define io_libecc_ecc_inline inline __attribute__((always_inline))
 	#else
 		#define io_libecc_ecc_noreturn
+		#define io_libecc_ecc_inline inline
 	#endif
 
+	#if __MSDOS__
+		#define io_libecc_ecc_threadlocal
+	#elif __STDC_VERSION__ >= 201112L
+		#define io_libecc_ecc_threadlocal _Thread_local
+	#elif __GNUC__
+		#define io_libecc_ecc_threadlocal __thread
+	#elif _MSC_VER
+		#define io_libecc_ecc_threadlocal __declspec(thread)
+	#else
+		#define io_libecc_ecc_threadlocal
+	#endif
+	
 	#if __GNUC__ && _WIN32 && !_MSC_VER
 		/* use ebp frame */
 		#define io_libecc_ecc_useframe __attribute__((optimize("no-omit-frame-pointer")))
@@ -59,6 +73,26 @@
 		#define longjmp _longjmp
 	#endif
 
+	/* address sanitizer only unpoisons frames skipped by library jumps */
+	#if __SANITIZE_ADDRESS__
+		#define io_libecc_ecc_sanitized 1
+	#elif defined(__has_feature)
+		#if __has_feature(address_sanitizer)
+			#define io_libecc_ecc_sanitized 1
+		#endif
+	#endif
+
+	#if __GNUC__ && (!__clang__ || __i386__ || __x86_64__) && !io_libecc_ecc_sanitized
+		/* landing pads of try statements: the compiler only saves the frame, stack & resume address */
+		typedef void * io_libecc_ecc_Landing[5];
+		#define io_libecc_ecc_land(landing) __builtin_setjmp(landing)
+		#define io_libecc_ecc_leap(landing) __builtin_longjmp(landing, 1)
+	#else
+		typedef jmp_buf io_libecc_ecc_Landing;
+		#define io_libecc_ecc_land(landing) setjmp(landing)
+		#define io_libecc_ecc_leap(landing) longjmp(landing, 1)
+	#endif
+
 	#if _WIN32
 		/* supports hex */
 		#define strtod strtold
@@ -11,6 +11,7 @@
 
 #include "ecc.h"
 #include "op.h"
+#include "pool.h"
 
 // MARK: - Private
 
@@ -48,7 +49,7 @@ void throw (struct Context * const self, struct Value value)
 	if (value.type == Value(errorType))
 		self->ecc->text = value.data.error->text;
 	
-	if (self->ecc->printLastThrow && self->ecc->envCount == 1)
+	if (self->ecc->printLastThrow && self->ecc->envCount == 1 && !self->ecc->handler)
 	{
 		struct Value name, message;
 		name = Value(undefined);
@@ -115,6 +116,8 @@ struct Value argument (struct Context * const self, int argumentIndex)
 
 void replaceArgument (struct Context * const self, int argumentIndex, struct Value value)
 {
+	Pool.writeBarrier(value);
+	
 	if (self->environment->hashmap[2].value.type == Value(objectType))
 	{
 		if (argumentIndex < self->environment->hashmap[2].value.data.object->elementCount)
@@ -72,7 +72,7 @@ Interface(Context,
 	(struct Object *, environmentRoot ,(struct Context * const context))
 	,
 	{
-		const struct Op * ops;
+		struct Op * ops;
 		struct Object * refObject;
 		struct Object * environment;
 		struct Context * parent;
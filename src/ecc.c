@@ -12,13 +12,30 @@
 #include "parser.h"
 #include "oplist.h"
 #include "pool.h"
+#include "jit.h"
+#include "snapshot.h"
 
 // MARK: - Private
 
-static int instanceCount = 0;
+// pool, keys and builtins are thread-local, and collected from the roots of one instance:
+// a thread holds a single instance, that sets its runtime up and tears it down
+static Ecc(threadlocal) struct Ecc *instance = NULL;
+
+enum {
+	// compiled sources are cached direct-mapped by hash
+	compiledCount = 64,
+};
 
 // MARK: - Static Members
 
+static
+void checkThread (const struct Ecc *self)
+{
+	// checked in release builds too: another thread's instance would corrupt this one's runtime
+	if (!self || self != instance)
+		fatal("Ecc instance used outside the thread that created it, or after destroy");
+}
+
 static
 void addInput(struct Ecc *self, struct Input *input)
 {
@@ -26,67 +43,283 @@ void addInput(struct Ecc *self, struct Input *input)
 	self->inputs[self->inputCount++] = input;
 }
 
-// MARK: - Methods
+static
+void releaseInput(struct Ecc *self, struct Input *input)
+{
+	uint32_t index;
+	
+	for (index = 0; index < self->inputCount; ++index)
+		if (self->inputs[index] == input)
+		{
+			self->inputs[index] = self->inputs[--self->inputCount];
+			break;
+		}
+	
+	self->released = realloc(self->released, sizeof(*self->released) * (self->releasedCount + 1));
+	self->released[self->releasedCount++] = input;
+}
 
-uint32_t Ecc(version) = (0 << 24) | (1 << 16) | (0 << 0);
+static
+void destroyReleasedInputs(struct Ecc *self)
+{
+	struct Input *input;
+	uint32_t index;
+	
+	// an input is kept as long as a live function or error points into it,
+	// or the last thrown text; keys naming its text take a copy instead
+	
+	if (self->envCount)
+		return;
+	
+	index = self->releasedCount;
+	while (index--)
+	{
+		input = self->released[index];
+		
+		if (Pool.referencesBytes(input->bytes, input->length)
+			|| (self->text.bytes >= input->bytes && self->text.bytes <= input->bytes + input->length)
+			|| (self->ofText.bytes >= input->bytes && self->ofText.bytes <= input->bytes + input->length))
+			continue;
+		
+		Key.copyTextsIn(input->bytes, input->length);
+		Input.destroy(input);
+		self->released[index] = self->released[--self->releasedCount];
+	}
+}
 
-struct Ecc *create (void)
+static
+uint32_t hashInput (const struct Input *input, uint8_t flags)
 {
-	struct Ecc *self;
+	uint32_t hash = 2166136261u ^ flags, index;
+	
+	for (index = 0; index < input->length; ++index)
+		hash = (hash ^ (uint8_t)input->bytes[index]) * 16777619u;
+	
+	return hash;
+}
+
+static inline
+uint32_t slotShape (const struct Object *environment, uint32_t slot)
+{
+	return environment->hashmap[slot].value.check == 1? environment->hashmap[slot].value.key.data.integer: 0;
+}
+
+static
+int isParentSlot (const Native(Function) native)
+{
+	return native == Op.getParentSlotRef || native == Op.getParentSlot || native == Op.setParentSlot || native == Op.deleteParentSlot;
+}
+
+static
+uint32_t * environmentShape (const struct Object *environment, const struct Object *global, const struct OpList *oplist, uint32_t *length)
+{
+	const struct Object *object;
+	uint32_t *shape, *cursor, slot, index, level, nearCount = 0, slotCount = 0;
+	
+	// identifiers are resolved to slots against the whole chain at compile time:
+	// environments nearer than the global are recorded whole, as count & keys,
+	// the global and what follows it only by the slots resolved in them, as level, slot & key
+	
+	*length = 2;
+	for (object = environment; object && object != global; object = object->prototype, ++nearCount)
+		*length += 1 + object->hashmapCount;
 	
-	if (!instanceCount++)
+	for (index = 0; index < oplist->count; ++index)
+		if (isParentSlot(oplist->ops[index].native) && (uint32_t)oplist->ops[index].value.data.integer >> 16 > nearCount)
+			++slotCount;
+	
+	*length += slotCount * 3;
+	
+	cursor = shape = malloc(sizeof(*shape) * *length);
+	*cursor++ = nearCount;
+	for (object = environment; object && object != global; object = object->prototype)
 	{
-		Env.setup();
-		Pool.setup();
-		Key.setup();
-		Global.setup();
+		*cursor++ = object->hashmapCount;
+		for (slot = 0; slot < object->hashmapCount; ++slot)
+			*cursor++ = slotShape(object, slot);
 	}
 	
-	self = malloc(sizeof(*self));
-	*self = Ecc.identity;
+	*cursor++ = slotCount;
+	for (index = 0; index < oplist->count; ++index)
+		if (isParentSlot(oplist->ops[index].native) && (level = (uint32_t)oplist->ops[index].value.data.integer >> 16) > nearCount)
+		{
+			slot = oplist->ops[index].value.data.integer & 0xffff;
+			
+			for (object = environment; --level; object = object->prototype);
+			
+			*cursor++ = (uint32_t)oplist->ops[index].value.data.integer >> 16;
+			*cursor++ = slot;
+			*cursor++ = slotShape(object, slot);
+		}
+	
+	return shape;
+}
+
+static
+int matchShape (const struct Ecc(Compiled) *compiled, const struct Object *environment, const struct Object *global)
+{
+	const uint32_t *shape = compiled->shape;
+	const struct Object *object = environment, *far;
+	uint32_t nearCount, slotCount, index, level, slot;
 	
-	self->global = Global.create();
-	self->maximumCallDepth = 512;
+	for (nearCount = *shape++, index = 0; index < nearCount; ++index, object = object->prototype)
+	{
+		if (!object || object == global || *shape++ != object->hashmapCount)
+			return 0;
+		
+		for (slot = 0; slot < object->hashmapCount; ++slot)
+			if (*shape++ != slotShape(object, slot))
+				return 0;
+	}
+	
+	if (object && object != global)
+		return 0;
+	
+	// a resolved slot must still hold its key, and no object before it may have gained one
+	
+	for (slotCount = *shape++; slotCount--; shape += 3)
+	{
+		struct Key key = {{ shape[2] }};
+		
+		for (far = object, level = shape[0] - 1 - nearCount; far && level; far = far->prototype, --level)
+			if (Object.ownSlot(far, key))
+				return 0;
+		
+		if (!far || shape[1] >= far->hashmapCount || slotShape(far, shape[1]) != shape[2])
+			return 0;
+	}
 	
-	return self;
+	return 1;
 }
 
-void destroy (struct Ecc *self)
+static
+void pinCompiled (struct Function *function, int16_t count)
 {
-	assert(self);
+	uint32_t index;
 	
-	while (self->inputCount--)
-		Input.destroy(self->inputs[self->inputCount]), self->inputs[self->inputCount] = NULL;
+	// nested templates & literal objects are held by the oplist only
 	
-	free(self->inputs), self->inputs = NULL;
-	free(self->envList), self->envList = NULL;
-	free(self), self = NULL;
+	function->object.referenceCount += count;
+	
+	for (index = 0; index < function->oplist->count; ++index)
+		if (function->oplist->ops[index].value.type == Value(functionType))
+			pinCompiled(function->oplist->ops[index].value.data.function, count);
+		else if (function->oplist->ops[index].value.type >= Value(objectType))
+			function->oplist->ops[index].value.data.object->referenceCount += count;
+}
+
+static
+void evictCompiled (struct Ecc(Compiled) *compiled)
+{
+	if (!compiled->function)
+		return;
+	
+	pinCompiled(compiled->function, -1);
+	free(compiled->shape), compiled->shape = NULL;
+	compiled->function = NULL;
+}
+
+static
+int isSameInput (const struct Input *input, const struct Input *other)
+{
+	return input->length == other->length
+		&& !memcmp(input->bytes, other->bytes, input->length)
+		&& !strcmp(input->name, other->name);
+}
+
+static
+struct Ecc(Compiled) * findCompiled (struct Ecc *self, struct Input **input, uint32_t hash, uint8_t flags, const struct Object *environment)
+{
+	struct Ecc(Compiled) *compiled;
+	
+	if (!self->compiled)
+		self->compiled = calloc(compiledCount, sizeof(*self->compiled));
+	
+	compiled = &self->compiled[hash % compiledCount];
 	
-	if (!--instanceCount)
+	if (compiled->input && compiled->hash == hash && compiled->flags == flags && isSameInput(compiled->input, *input))
+	{
+		// an input stays listed once kept, texts & keys may point into it:
+		// the same source is always read from the first copy
+		
+		Input.destroy(*input);
+		*input = compiled->input;
+		
+		if (compiled->function && matchShape(compiled, environment, &self->global->environment))
+			return compiled;
+	}
+	else
 	{
-		Global.teardown();
-		Key.teardown();
-		Pool.teardown();
-		Env.teardown();
+		evictCompiled(compiled);
+		addInput(self, *input);
+		
+		if (compiled->input)
+			releaseInput(self, compiled->input);
+		
+		compiled->input = *input;
+		compiled->hash = hash;
+		compiled->flags = flags;
 	}
+	
+	return NULL;
 }
 
-void addFunction (struct Ecc *self, const char *name, const Native(Function) native, int argumentCount, enum Value(Flags) flags)
+static
+struct Ecc(Compiled) * storeCompiled (struct Ecc *self, uint32_t hash, const struct Object *environment, struct Function *function)
 {
-	assert(self);
+	struct Ecc(Compiled) *compiled = &self->compiled[hash % compiledCount];
 	
-	Function.addFunction(self->global, name, native, argumentCount, flags);
+	evictCompiled(compiled);
+	
+	compiled->function = function;
+	compiled->shape = environmentShape(environment, &self->global->environment, function->oplist, &compiled->shapeLength);
+	
+	pinCompiled(function, 1);
+	
+	// every run gets its own copy of the environment template
+	function->environment.prototype = NULL;
+	
+	return compiled;
 }
 
-void addValue (struct Ecc *self, const char *name, struct Value value, enum Value(Flags) flags)
+static
+void markRoots(struct Ecc *self)
 {
-	assert(self);
+	uint32_t index, count;
 	
-	Function.addValue(self->global, name, value, flags);
+	Pool.markValue(Value.object(Arguments(prototype)));
+	Pool.markValue(Value.function(self->global));
+	String.markTextCopies();
+	
+	if (self->compiled)
+		for (index = 0; index < compiledCount; ++index)
+			if (self->compiled[index].function)
+				Pool.markValue(Value.function(self->compiled[index].function));
+	
+	for (index = 0, count = self->inputCount + self->releasedCount; index < count; ++index)
+	{
+		struct Input *input = index < self->inputCount? self->inputs[index]: self->released[index - self->inputCount];
+		uint16_t a = input->attachedCount;
+		
+		while (a--)
+			Pool.markValue(input->attached[a]);
+	}
+}
+
+static
+void evalFunction (struct Ecc *self, struct Function *function, struct Context *context)
+{
+	context->ops = function->oplist->ops;
+	context->environment = &function->environment;
+	
+	self->result = Value(undefined);
+	
+	Op.dispatch(context);
 }
 
 Ecc(useframe)
-int evalInput (struct Ecc *self, struct Input *input, enum Ecc(EvalFlags) flags)
+static
+int evaluate (struct Ecc *self, struct Input *input, struct Function *function, enum Ecc(EvalFlags) flags)
 {
 	volatile int result = EXIT_SUCCESS, trap = !self->envCount || flags & Ecc(primitiveResult), catch = 0;
 	struct Context context = {
@@ -96,8 +329,7 @@ int evalInput (struct Ecc *self, struct Input *input, enum Ecc(EvalFlags) flags)
 		.strictMode = !(flags & Ecc(sloppyMode)),
 	};
 	
-	if (!input)
-		return EXIT_FAILURE;
+	checkThread(self);
 	
 	self->sloppyMode = flags & Ecc(sloppyMode);
 	
@@ -109,6 +341,8 @@ int evalInput (struct Ecc *self, struct Input *input, enum Ecc(EvalFlags) flags)
 	
 	if (catch)
 		result = EXIT_FAILURE;
+	else if (function)
+		evalFunction(self, function, &context);
 	else
 		evalInputWithContext(self, input, &context);
 	
@@ -132,38 +366,219 @@ int evalInput (struct Ecc *self, struct Input *input, enum Ecc(EvalFlags) flags)
 	return result;
 }
 
-void evalInputWithContext (struct Ecc *self, struct Input *input, struct Context *context)
+// MARK: - Methods
+
+uint32_t Ecc(version) = (0 << 24) | (1 << 16) | (0 << 0);
+
+struct Ecc *create (void)
+{
+	struct Ecc *self;
+	
+	if (instance)
+		fatal("Ecc instance already created on this thread");
+	
+	Env.setup();
+	Pool.setup();
+	Key.setup();
+	Global.setup();
+	
+	self = malloc(sizeof(*self));
+	*self = Ecc.identity;
+	
+	self->global = Global.create();
+	self->maximumCallDepth = 512;
+	
+	return instance = self;
+}
+
+void destroy (struct Ecc *self)
+{
+	checkThread(self);
+	
+	while (self->inputCount--)
+		Input.destroy(self->inputs[self->inputCount]), self->inputs[self->inputCount] = NULL;
+	
+	while (self->releasedCount--)
+		Input.destroy(self->released[self->releasedCount]), self->released[self->releasedCount] = NULL;
+	
+	if (self->compiled)
+	{
+		uint32_t index;
+		
+		for (index = 0; index < compiledCount; ++index)
+			evictCompiled(&self->compiled[index]);
+		
+		free(self->compiled), self->compiled = NULL;
+	}
+	
+	free(self->inputs), self->inputs = NULL;
+	free(self->released), self->released = NULL;
+	free(self->envList), self->envList = NULL;
+	free(self), self = NULL;
+	instance = NULL;
+	
+	Global.teardown();
+	Key.teardown();
+	Pool.teardown();
+	Jit.teardown();
+	Env.teardown();
+}
+
+void addFunction (struct Ecc *self, const char *name, const Native(Function) native, int argumentCount, enum Value(Flags) flags)
+{
+	checkThread(self);
+	
+	Function.addFunction(self->global, name, native, argumentCount, flags);
+}
+
+void addValue (struct Ecc *self, const char *name, struct Value value, enum Value(Flags) flags)
+{
+	checkThread(self);
+	
+	Function.addValue(self->global, name, value, flags);
+}
+
+int evalInput (struct Ecc *self, struct Input *input, enum Ecc(EvalFlags) flags)
+{
+	if (!input)
+		return EXIT_FAILURE;
+	
+	return evaluate(self, input, NULL, flags);
+}
+
+int compileInput (struct Ecc *self, struct Input *input, const char *filename, enum Ecc(EvalFlags) flags)
 {
+	struct Text outputError = Text(inputErrorName);
 	struct Lexer *lexer;
 	struct Parser *parser;
 	struct Function *function;
+	struct Object *declarations;
+	FILE *file;
+	int result;
 	
-	assert(self);
-	assert(self->envCount);
+	checkThread(self);
+	assert(filename);
+	
+	if (!input)
+		return EXIT_FAILURE;
 	
 	addInput(self, input);
 	
+	// globals are unknown until load: leave them unresolved
+	// and keep sloppy mode declarations aside
+	declarations = Object.createSized(NULL, self->global->environment.hashmapCapacity);
+	
 	lexer = Lexer.createWithInput(input);
 	parser = Parser.createWithLexer(lexer);
 	
-	if (context->strictMode)
+	if (!(flags & Ecc(sloppyMode)))
 		parser->strictMode = 1;
-	
-	if (self->sloppyMode)
+	else
 		lexer->allowUnicodeOutsideLiteral = 1;
 	
-	function = Parser.parseWithEnvironment(parser, context->environment, &self->global->environment);
-	context->ops = function->oplist->ops;
-	context->environment = &function->environment;
+	function = Parser.parseWithEnvironment(parser, NULL, declarations);
+	result = parser->error? EXIT_FAILURE: EXIT_SUCCESS;
 	
 	Parser.destroy(parser), parser = NULL;
 	
+	// report like evalInput does, by throwing the syntax error
+	if (result != EXIT_SUCCESS)
+		return evaluate(self, input, function, flags);
+	
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		Env.printError(outputError.length, outputError.bytes, "cannot open file '%s'", filename);
+		return EXIT_FAILURE;
+	}
+	
+	result = Snapshot.writeTo(function, declarations, input, flags & Ecc(sloppyMode), file);
+	
+	if (fclose(file) || result != EXIT_SUCCESS)
+	{
+		Env.printError(outputError.length, outputError.bytes, "cannot write file '%s'", filename);
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
+
+int evalCompiled (struct Ecc *self, const char *filename, enum Ecc(EvalFlags) flags)
+{
+	struct Input *input;
+	struct Function *function;
+	uint32_t compiledFlags = 0;
+	
+	assert(self);
+	assert(filename);
+	
+	function = Snapshot.load(filename, &self->global->environment, &input, &compiledFlags);
+	
+	if (input)
+		addInput(self, input);
+	
+	if (!function)
+		return EXIT_FAILURE;
+	
+	return evaluate(self, input, function, (flags & ~Ecc(sloppyMode)) | (compiledFlags & Ecc(sloppyMode)));
+}
+
+void evalInputWithContext (struct Ecc *self, struct Input *input, struct Context *context)
+{
+	struct Lexer *lexer;
+	struct Parser *parser;
+	struct Function *function;
+	struct Ecc(Compiled) *compiled;
+	uint8_t flags;
+	uint32_t hash;
+	
+	assert(self);
+	assert(self->envCount);
+	
+	flags = (context->strictMode? 1: 0) | (self->sloppyMode? 2: 0);
+	hash = hashInput(input, flags);
+	
+	if (( compiled = findCompiled(self, &input, hash, flags, context->environment) ))
+		function = compiled->function;
+	else
+	{
+		lexer = Lexer.createWithInput(input);
+		parser = Parser.createWithLexer(lexer);
+		
+		if (context->strictMode)
+			parser->strictMode = 1;
+		
+		if (self->sloppyMode)
+			lexer->allowUnicodeOutsideLiteral = 1;
+		
+		function = Parser.parseWithEnvironment(parser, context->environment, &self->global->environment);
+		
+		// code declaring globals has side effects on parse, and templates of closures
+		// or direct evals would link to this one's environment: it is compiled every time
+		if (!parser->error && !parser->globalDeclarations && !parser->directEvals && !(function->flags & Function(needHeap)))
+			compiled = storeCompiled(self, hash, context->environment, function);
+		
+		Parser.destroy(parser), parser = NULL;
+	}
+	
+	context->ops = function->oplist->ops;
+	
+	if (compiled)
+	{
+		struct Object *environment = Object.copy(&function->environment);
+		environment->prototype = context->environment;
+		++context->environment->referenceCount;
+		context->environment = environment;
+	}
+	else
+		context->environment = &function->environment;
+	
 //	fprintf(stderr, "--- source:\n%.*s\n", input->length, input->bytes);
 //	OpList.dumpTo(function->oplist, stderr);
 	
 	self->result = Value(undefined);
 	
-	context->ops->native(context);
+	Op.dispatch(context);
 }
 
 jmp_buf * pushEnv(struct Ecc *self)
@@ -195,7 +610,10 @@ void jmpEnv (struct Ecc *self, struct Value value)
 	if (value.type == Value(errorType))
 		self->text = value.data.error->text;
 	
-	longjmp(self->envList[self->envCount - 1], 1);
+	if (self->handler && self->handler->envCount == self->envCount)
+		Ecc(leap)(self->handler->landing);
+	else
+		longjmp(self->envList[self->envCount - 1], 1);
 }
 
 void fatal (const char *format, ...)
@@ -222,12 +640,16 @@ void fatal (const char *format, ...)
 
 struct Input * findInput (struct Ecc *self, struct Text text)
 {
-	uint16_t i;
+	uint32_t i;
 	
 	for (i = 0; i < self->inputCount; ++i)
 		if (text.bytes >= self->inputs[i]->bytes && text.bytes <= self->inputs[i]->bytes + self->inputs[i]->length)
 			return self->inputs[i];
 	
+	for (i = 0; i < self->releasedCount; ++i)
+		if (text.bytes >= self->released[i]->bytes && text.bytes <= self->released[i]->bytes + self->released[i]->length)
+			return self->released[i];
+	
 	return NULL;
 }
 
@@ -257,20 +679,32 @@ void printTextInput (struct Ecc *self, struct Text text, int fullLine)
 
 void garbageCollect(struct Ecc *self)
 {
-	uint16_t index, count;
+	checkThread(self);
 	
 	Pool.unmarkAll();
-	Pool.markValue(Value.object(Arguments(prototype)));
-	Pool.markValue(Value.function(self->global));
+	markRoots(self);
+	Pool.collectUnmarked();
+	destroyReleasedInputs(self);
+	Key.collectUnmarked();
+}
+
+int collectStep(struct Ecc *self, uint32_t budget)
+{
+	checkThread(self);
 	
-	for (index = 0, count = self->inputCount; index < count; ++index)
+	if (!Pool.isMarking())
 	{
-		struct Input *input = self->inputs[index];
-		uint16_t a = input->attachedCount;
-		
-		while (a--)
-			Pool.markValue(input->attached[a]);
+		Pool.unmarkAll();
+		markRoots(self);
 	}
 	
+	if (!Pool.markStep(budget))
+		return 0;
+	
+	// roots may have changed since the cycle began
+	markRoots(self);
 	Pool.collectUnmarked();
+	destroyReleasedInputs(self);
+	Key.collectUnmarked();
+	return 1;
 }
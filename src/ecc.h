@@ -24,10 +24,29 @@
 		Ecc(stringResult)       = 0x6 /* 0000 0110 */,
 	};
 	
+	struct Ecc(Compiled) {
+		struct Function *function;
+		struct Input *input;
+		uint32_t *shape;
+		uint32_t shapeLength;
+		uint32_t hash;
+		uint8_t flags;
+	};
+	
+	// landing pad of a try statement, on the stack of the op running it
+	struct Ecc(Handler) {
+		struct Ecc(Handler) *previous;
+		uint16_t envCount;
+		Ecc(Landing) landing;
+	};
+	
 	extern uint32_t Ecc(version);
 	
 #endif
 
+// pool, keys and builtins are per thread: a thread holds at most one instance,
+// used, garbage collected and destroyed on that thread only (checked, a misuse is fatal);
+// other threads create instances of their own
 
 Interface(Ecc,
 	
@@ -39,6 +58,8 @@ Interface(Ecc,
 	
 	(int, evalInput ,(struct Ecc *, struct Input *, enum Ecc(EvalFlags)))
 	(void, evalInputWithContext ,(struct Ecc *, struct Input *, struct Context *context))
+	(int, compileInput ,(struct Ecc *, struct Input *, const char *filename, enum Ecc(EvalFlags)))
+	(int, evalCompiled ,(struct Ecc *, const char *filename, enum Ecc(EvalFlags)))
 	
 	(jmp_buf *, pushEnv ,(struct Ecc *))
 	(void, popEnv ,(struct Ecc *))
@@ -49,11 +70,13 @@ Interface(Ecc,
 	(void, printTextInput ,(struct Ecc *, struct Text text, int fullLine))
 	
 	(void, garbageCollect ,(struct Ecc *))
+	(int, collectStep ,(struct Ecc *, uint32_t budget))
 	,
 	{
 		jmp_buf *envList;
 		uint16_t envCount;
 		uint16_t envCapacity;
+		struct Ecc(Handler) *handler;
 		
 		struct Function *global;
 		
@@ -64,11 +87,18 @@ Interface(Ecc,
 		const char *ofInput;
 		
 		struct Input **inputs;
-		uint16_t inputCount;
+		uint32_t inputCount;
+		
+		// evicted from the compiled cache, destroyed by a collection once nothing points into them
+		struct Input **released;
+		uint32_t releasedCount;
+		
+		struct Ecc(Compiled) *compiled;
 		
 		int16_t maximumCallDepth;
 		unsigned printLastThrow:1;
 		unsigned sloppyMode:1;
+		unsigned jitLoops:1;
 	}
 )
 
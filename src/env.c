@@ -38,7 +38,7 @@ struct {
 #else
 	int terminal;
 #endif
-} static env;
+} static Ecc(threadlocal) env;
 
 void setup(void)
 {
@@ -10,6 +10,7 @@
 #include "input.h"
 
 #include "chars.h"
+#include "builtin/string.h"
 
 // MARK: - Private
 
@@ -110,6 +111,8 @@ void destroy (struct Input *self)
 {
 	assert(self);
 	
+	String.forgetTextIndices(self->bytes, self->length);
+	
 	free(self->attached), self->attached = NULL;
 	free(self->bytes), self->bytes = NULL;
 	free(self->lines), self->lines = NULL;
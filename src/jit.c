@@ -0,0 +1,886 @@
+//
+//  jit.c
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#define Implementation
+#include "jit.h"
+
+#include "ecc.h"
+
+#ifndef JIT_LOOPS
+	#if (__x86_64__ || __amd64__) && ((__unix__ && !__MSDOS__) || (defined(__APPLE__) && defined(__MACH__)))
+		#define JIT_LOOPS 1
+	#else
+		#define JIT_LOOPS 0
+	#endif
+#endif
+
+#if JIT_LOOPS
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+// MARK: - Private
+
+enum {
+	hotIterations = 256,
+	missLimit = 16,
+	registerLimit = 8,
+	scratch = 8,
+	spillBytes = registerLimit * 8,
+	frameBytes = spillBytes + 8,
+	unbound = UINT32_MAX,
+};
+
+static Ecc(threadlocal) struct Jit *jitList = NULL;
+static Ecc(threadlocal) uint32_t jitCount = 0;
+static Ecc(threadlocal) uint32_t jitCapacity = 0;
+
+#if JIT_LOOPS
+
+// x86-64, System V: compiled loops are `void run (hashmap, count)`, with the
+// hashmap in rbx and the count in r12d; expressions use xmm0-7 as a stack
+
+enum Mode {
+	direct,
+	slotMemory,
+	spillMemory,
+};
+
+enum Condition {
+	below = 0x2,
+	aboveOrEqual = 0x3,
+	equal = 0x4,
+	notEqual = 0x5,
+	belowOrEqual = 0x6,
+	above = 0x7,
+	parity = 0xa,
+	less = 0xc,
+	greaterOrEqual = 0xd,
+	lessOrEqual = 0xe,
+	greater = 0xf,
+};
+
+struct Fixup {
+	uint32_t at;
+	uint32_t op;
+};
+
+struct Assembler {
+	jmp_buf bail;
+	const struct Op *ops;
+	uint32_t opCount;
+	uint32_t *offsets;
+	
+	uint8_t *bytes;
+	uint32_t byteCount;
+	uint32_t byteCapacity;
+	
+	struct Fixup *fixups;
+	uint32_t fixupCount;
+	uint32_t fixupCapacity;
+	
+	uint16_t *slots;
+	uint16_t slotCount;
+	uint16_t slotCapacity;
+	
+	int32_t indexSlot;
+	int32_t countSlot;
+	int depth;
+};
+
+static uint32_t expression (struct Assembler *, uint32_t index);
+
+static
+void unsupported (struct Assembler *self)
+{
+	longjmp(self->bail, 1);
+}
+
+static
+const struct Op *opAt (struct Assembler *self, uint32_t index)
+{
+	if (index >= self->opCount)
+		unsupported(self);
+	
+	return self->ops + index;
+}
+
+static
+void byte (struct Assembler *self, uint8_t byte)
+{
+	if (self->byteCount >= self->byteCapacity)
+	{
+		self->byteCapacity = self->byteCapacity? self->byteCapacity * 2: 256;
+		self->bytes = realloc(self->bytes, self->byteCapacity);
+	}
+	self->bytes[self->byteCount++] = byte;
+}
+
+static
+void bytes (struct Assembler *self, const char *bytes, size_t count)
+{
+	while (count--)
+		byte(self, *bytes++);
+}
+
+static
+void dword (struct Assembler *self, uint32_t dword)
+{
+	byte(self, dword);
+	byte(self, dword >> 8);
+	byte(self, dword >> 16);
+	byte(self, dword >> 24);
+}
+
+static
+void qword (struct Assembler *self, uint64_t qword)
+{
+	dword(self, (uint32_t)qword);
+	dword(self, (uint32_t)(qword >> 32));
+}
+
+static
+void patch (struct Assembler *self, uint32_t at, uint32_t target)
+{
+	uint32_t rel = target - (at + 4);
+	
+	self->bytes[at] = rel;
+	self->bytes[at + 1] = rel >> 8;
+	self->bytes[at + 2] = rel >> 16;
+	self->bytes[at + 3] = rel >> 24;
+}
+
+static
+int32_t slotOffset (uint16_t slot)
+{
+	return slot * sizeof(union Object(Hashmap)) + offsetof(struct Value, data);
+}
+
+// sse & conversion instructions, all `[prefix] [rex] 0f opcode modrm`
+
+static
+void instruction (struct Assembler *self, uint8_t prefix, int wide, uint8_t opcode, int reg, int rm, enum Mode mode, int32_t displacement)
+{
+	uint8_t rex = (wide? 8: 0) | (reg & 8? 4: 0) | (mode == direct && rm & 8? 1: 0);
+	
+	if (prefix)
+		byte(self, prefix);
+	
+	if (rex)
+		byte(self, 0x40 | rex);
+	
+	byte(self, 0x0f);
+	byte(self, opcode);
+	
+	if (mode == direct)
+		byte(self, 0xc0 | (reg & 7) << 3 | (rm & 7));
+	else if (mode == slotMemory)
+	{
+		byte(self, 0x80 | (reg & 7) << 3 | 3);
+		dword(self, displacement);
+	}
+	else
+	{
+		byte(self, 0x40 | (reg & 7) << 3 | 4);
+		byte(self, 0x24);
+		byte(self, displacement);
+	}
+}
+
+static
+void jumpTo (struct Assembler *self, int condition, uint32_t op)
+{
+	if (self->fixupCount >= self->fixupCapacity)
+	{
+		self->fixupCapacity = self->fixupCapacity? self->fixupCapacity * 2: 8;
+		self->fixups = realloc(self->fixups, sizeof(*self->fixups) * self->fixupCapacity);
+	}
+	
+	if (condition < 0)
+		byte(self, 0xe9);
+	else
+	{
+		byte(self, 0x0f);
+		byte(self, 0x80 | condition);
+	}
+	
+	self->fixups[self->fixupCount].at = self->byteCount;
+	self->fixups[self->fixupCount].op = op;
+	++self->fixupCount;
+	dword(self, 0);
+}
+
+static
+int push (struct Assembler *self)
+{
+	if (self->depth >= registerLimit)
+		unsupported(self);
+	
+	return self->depth++;
+}
+
+static
+void useSlot (struct Assembler *self, uint16_t slot)
+{
+	uint16_t index;
+	
+	if (slot == self->indexSlot || slot == self->countSlot)
+		return;
+	
+	for (index = 0; index < self->slotCount; ++index)
+		if (self->slots[index] == slot)
+			return;
+	
+	if (self->slotCount >= self->slotCapacity)
+	{
+		self->slotCapacity = self->slotCapacity? self->slotCapacity * 2: 8;
+		self->slots = realloc(self->slots, sizeof(*self->slots) * self->slotCapacity);
+	}
+	self->slots[self->slotCount++] = slot;
+}
+
+static
+uint16_t writableSlot (struct Assembler *self, uint32_t index)
+{
+	const struct Op *op = opAt(self, index);
+	
+	if (op->native != Op.getLocalSlotRef || op->value.data.integer == self->indexSlot || op->value.data.integer == self->countSlot)
+		unsupported(self);
+	
+	useSlot(self, op->value.data.integer);
+	return op->value.data.integer;
+}
+
+static
+void constant (struct Assembler *self, int r, double binary)
+{
+	uint64_t bits;
+	
+	memcpy(&bits, &binary, sizeof(bits));
+	bytes(self, "\x48\xb8", 2); // mov rax, imm64
+	qword(self, bits);
+	instruction(self, 0x66, 1, 0x6e, r, 0, direct, 0); // movq r, rax
+}
+
+static
+void load (struct Assembler *self, int r, uint16_t slot)
+{
+	if (slot == self->indexSlot || slot == self->countSlot)
+		instruction(self, 0xf2, 0, 0x2a, r, 0, slotMemory, slotOffset(slot)); // cvtsi2sd r, dword [slot]
+	else
+	{
+		useSlot(self, slot);
+		instruction(self, 0xf2, 0, 0x10, r, 0, slotMemory, slotOffset(slot)); // movsd r, [slot]
+	}
+}
+
+static
+void store (struct Assembler *self, int r, uint16_t slot)
+{
+	instruction(self, 0xf2, 0, 0x11, r, 0, slotMemory, slotOffset(slot)); // movsd [slot], r
+}
+
+static
+void move (struct Assembler *self, int to, int from)
+{
+	instruction(self, 0x66, 0, 0x28, to, from, direct, 0); // movapd
+}
+
+// calls clobber every xmm register: the stack is spilled around them
+
+static
+void spill (struct Assembler *self, uint8_t opcode)
+{
+	int r;
+	
+	for (r = 0; r < self->depth; ++r)
+		instruction(self, 0xf2, 0, opcode, r, 0, spillMemory, r * 8);
+}
+
+static
+void call (struct Assembler *self, const void *function)
+{
+	uint64_t address = (uintptr_t)function;
+	
+	bytes(self, "\x48\xb8", 2); // mov rax, imm64
+	qword(self, address);
+	bytes(self, "\xff\xd0", 2); // call rax
+}
+
+static
+int64_t toInt32 (double binary)
+{
+	return Value.toInteger(NULL, Value.binary(binary)).data.integer;
+}
+
+static
+double modulo (double a, double b)
+{
+	return fmod(a, b);
+}
+
+static
+void integer (struct Assembler *self, int r)
+{
+	uint32_t skip;
+	
+	// cvttsd2si is exact below 2^63, and returns 0x8000000000000000 otherwise
+	instruction(self, 0xf2, 1, 0x2c, 0, r, direct, 0); // cvttsd2si rax, r
+	bytes(self, "\x48\xba", 2); // mov rdx, imm64
+	qword(self, UINT64_C(0x8000000000000000));
+	bytes(self, "\x48\x39\xd0", 3); // cmp rax, rdx
+	bytes(self, "\x0f\x85", 2); // jne
+	skip = self->byteCount;
+	dword(self, 0);
+	spill(self, 0x11);
+	instruction(self, 0xf2, 0, 0x10, 0, 0, spillMemory, r * 8);
+	call(self, toInt32);
+	spill(self, 0x10);
+	patch(self, skip, self->byteCount);
+}
+
+static
+void divideRemainder (struct Assembler *self, int a, int b)
+{
+	spill(self, 0x11);
+	instruction(self, 0xf2, 0, 0x10, 0, 0, spillMemory, a * 8);
+	instruction(self, 0xf2, 0, 0x10, 1, 0, spillMemory, b * 8);
+	call(self, modulo);
+	instruction(self, 0xf2, 0, 0x11, 0, 0, spillMemory, a * 8);
+	spill(self, 0x10);
+}
+
+static
+void integers (struct Assembler *self, int a, int b, const char *operation, size_t length, int unsignedResult)
+{
+	integer(self, a);
+	bytes(self, "\x89\x44\x24\x40", 4); // mov [rsp + 64], eax
+	integer(self, b);
+	bytes(self, "\x89\xc1", 2); // mov ecx, eax
+	bytes(self, "\x8b\x44\x24\x40", 4); // mov eax, [rsp + 64]
+	bytes(self, operation, length);
+	
+	if (unsignedResult)
+	{
+		bytes(self, "\x89\xc0", 2); // mov eax, eax
+		instruction(self, 0xf2, 1, 0x2a, a, 0, direct, 0); // cvtsi2sd a, rax
+	}
+	else
+		instruction(self, 0xf2, 0, 0x2a, a, 0, direct, 0); // cvtsi2sd a, eax
+}
+
+// combine registers a & b into a
+
+static
+int arithmetic (struct Assembler *self, Native(Function) native, int a, int b)
+{
+	native = Op.generic(native);
+	
+	if (native == Op.add || native == Op.addAssignRef)
+		instruction(self, 0xf2, 0, 0x58, a, b, direct, 0);
+	else if (native == Op.minus || native == Op.minusAssignRef)
+		instruction(self, 0xf2, 0, 0x5c, a, b, direct, 0);
+	else if (native == Op.multiply || native == Op.multiplyAssignRef)
+		instruction(self, 0xf2, 0, 0x59, a, b, direct, 0);
+	else if (native == Op.divide || native == Op.divideAssignRef)
+		instruction(self, 0xf2, 0, 0x5e, a, b, direct, 0);
+	else if (native == Op.modulo || native == Op.moduloAssignRef)
+		divideRemainder(self, a, b);
+	else if (native == Op.leftShift || native == Op.leftShiftAssignRef)
+		integers(self, a, b, "\xd3\xe0", 2, 0); // shl eax, cl
+	else if (native == Op.rightShift || native == Op.rightShiftAssignRef)
+		integers(self, a, b, "\xd3\xf8", 2, 0); // sar eax, cl
+	else if (native == Op.unsignedRightShift || native == Op.unsignedRightShiftAssignRef)
+		integers(self, a, b, "\xd3\xe8", 2, 1); // shr eax, cl
+	else if (native == Op.bitwiseAnd || native == Op.bitAndAssignRef)
+		integers(self, a, b, "\x21\xc8", 2, 0); // and eax, ecx
+	else if (native == Op.bitwiseXor || native == Op.bitXorAssignRef)
+		integers(self, a, b, "\x31\xc8", 2, 0); // xor eax, ecx
+	else if (native == Op.bitwiseOr || native == Op.bitOrAssignRef)
+		integers(self, a, b, "\x09\xc8", 2, 0); // or eax, ecx
+	else
+		return 0;
+	
+	return 1;
+}
+
+static
+int isAssignment (const Native(Function) native)
+{
+	return native == Op.addAssignRef
+		|| native == Op.minusAssignRef
+		|| native == Op.multiplyAssignRef
+		|| native == Op.divideAssignRef
+		|| native == Op.moduloAssignRef
+		|| native == Op.leftShiftAssignRef
+		|| native == Op.rightShiftAssignRef
+		|| native == Op.unsignedRightShiftAssignRef
+		|| native == Op.bitAndAssignRef
+		|| native == Op.bitXorAssignRef
+		|| native == Op.bitOrAssignRef
+		;
+}
+
+static
+uint32_t expression (struct Assembler *self, uint32_t index)
+{
+	const struct Op *op = opAt(self, index);
+	int r;
+	
+	if (op->native == Op.value)
+	{
+		if (op->value.type == Value(integerType))
+			constant(self, push(self), op->value.data.integer);
+		else if (op->value.type == Value(binaryType))
+			constant(self, push(self), op->value.data.binary);
+		else
+			unsupported(self);
+		
+		return index + 1;
+	}
+	else if (op->native == Op.getLocalSlot)
+	{
+		load(self, push(self), op->value.data.integer);
+		return index + 1;
+	}
+	else if (op->native == Op.setLocalSlot)
+	{
+		if (op->value.data.integer == self->indexSlot || op->value.data.integer == self->countSlot)
+			unsupported(self);
+		
+		r = self->depth;
+		index = expression(self, index + 1);
+		useSlot(self, op->value.data.integer);
+		store(self, r, op->value.data.integer);
+		return index;
+	}
+	else if (op->native == Op.positive)
+		return expression(self, index + 1);
+	else if (op->native == Op.negative)
+	{
+		r = self->depth;
+		index = expression(self, index + 1);
+		constant(self, scratch, -0.);
+		instruction(self, 0x66, 0, 0x57, r, scratch, direct, 0); // xorpd r, sign
+		return index;
+	}
+	else if (op->native == Op.invert)
+	{
+		r = self->depth;
+		index = expression(self, index + 1);
+		integer(self, r);
+		bytes(self, "\xf7\xd0", 2); // not eax
+		instruction(self, 0xf2, 0, 0x2a, r, 0, direct, 0);
+		return index;
+	}
+	else if (op->native == Op.incrementRef || op->native == Op.decrementRef || op->native == Op.postIncrementRef || op->native == Op.postDecrementRef)
+	{
+		uint16_t slot = writableSlot(self, index + 1);
+		
+		r = push(self);
+		load(self, r, slot);
+		constant(self, scratch, op->native == Op.incrementRef || op->native == Op.postIncrementRef? 1: -1);
+		
+		if (op->native == Op.incrementRef || op->native == Op.decrementRef)
+		{
+			instruction(self, 0xf2, 0, 0x58, r, scratch, direct, 0); // addsd r, ±1
+			store(self, r, slot);
+		}
+		else
+		{
+			instruction(self, 0xf2, 0, 0x58, scratch, r, direct, 0); // addsd ±1, r
+			store(self, scratch, slot);
+		}
+		return index + 2;
+	}
+	else if (isAssignment(op->native))
+	{
+		uint16_t slot = writableSlot(self, index + 1);
+		
+		r = self->depth;
+		index = expression(self, index + 2);
+		load(self, push(self), slot);
+		arithmetic(self, op->native, r + 1, r);
+		move(self, r, r + 1);
+		--self->depth;
+		store(self, r, slot);
+		return index;
+	}
+	else
+	{
+		r = self->depth;
+		index = expression(self, expression(self, index + 1));
+		if (!arithmetic(self, op->native, r, r + 1))
+			unsupported(self);
+		
+		--self->depth;
+		return index;
+	}
+}
+
+static
+uint32_t condition (struct Assembler *self, uint32_t index, int whenTrue)
+{
+	const struct Op *op = opAt(self, index);
+	const Native(Function) native = Op.generic(op->native);
+	int r = self->depth, a, b, jump;
+	
+	if (native == Op.not)
+		return condition(self, index + 1, !whenTrue);
+	
+	if (native == Op.less || native == Op.lessOrEqual)
+		a = r + 1, b = r;
+	else if (native == Op.more || native == Op.moreOrEqual || native == Op.equal || native == Op.notEqual || native == Op.identical || native == Op.notIdentical)
+		a = r, b = r + 1;
+	else
+	{
+		// number truthiness: neither zero nor NaN (unordered sets ZF too)
+		index = expression(self, index);
+		instruction(self, 0x66, 0, 0x57, scratch, scratch, direct, 0); // xorpd
+		instruction(self, 0x66, 0, 0x2e, r, scratch, direct, 0); // ucomisd r, 0
+		jumpTo(self, whenTrue? notEqual: equal, unbound);
+		--self->depth;
+		return index;
+	}
+	
+	index = expression(self, expression(self, index + 1));
+	instruction(self, 0x66, 0, 0x2e, a, b, direct, 0); // ucomisd a, b
+	self->depth -= 2;
+	
+	if (native == Op.less || native == Op.more)
+		jumpTo(self, whenTrue? above: belowOrEqual, unbound);
+	else if (native == Op.lessOrEqual || native == Op.moreOrEqual)
+		jumpTo(self, whenTrue? aboveOrEqual: below, unbound);
+	else
+	{
+		jump = (native == Op.equal || native == Op.identical) == whenTrue;
+		if (jump)
+		{
+			// equal: ZF without PF
+			bytes(self, "\x0f\x8a\x06\x00\x00\x00", 6); // jp over the je
+			jumpTo(self, equal, unbound);
+		}
+		else
+		{
+			jumpTo(self, parity, unbound);
+			jumpTo(self, notEqual, unbound);
+		}
+	}
+	return index;
+}
+
+static
+uint32_t statement (struct Assembler *self, uint32_t index)
+{
+	const struct Op *op = opAt(self, index);
+	
+	self->offsets[index] = self->byteCount;
+	
+	if (op->native == Op.noop)
+	{
+		jumpTo(self, -1, self->opCount);
+		return index + 1;
+	}
+	else if (op->native == Op.next)
+		return index + 1;
+	else if (op->native == Op.discard)
+	{
+		index = expression(self, index + 1);
+		--self->depth;
+		return index;
+	}
+	else if (op->native == Op.discardN)
+	{
+		int32_t count = op->value.data.integer;
+		
+		++index;
+		while (count--)
+		{
+			index = expression(self, index);
+			--self->depth;
+		}
+		return index;
+	}
+	else if (op->native == Op.jump)
+	{
+		jumpTo(self, -1, index + 1 + op->value.data.integer);
+		return index + 1;
+	}
+	else if (op->native == Op.jumpIf || op->native == Op.jumpIfNot)
+	{
+		uint32_t fixup = self->fixupCount;
+		
+		index = condition(self, index + 1, op->native == Op.jumpIf);
+		for (; fixup < self->fixupCount; ++fixup)
+			if (self->fixups[fixup].op == unbound)
+				self->fixups[fixup].op = index + op->value.data.integer;
+		
+		return index;
+	}
+	
+	unsupported(self);
+	return index;
+}
+
+static
+void finalizeAssembler (struct Assembler *self)
+{
+	free(self->offsets), self->offsets = NULL;
+	free(self->bytes), self->bytes = NULL;
+	free(self->fixups), self->fixups = NULL;
+	free(self->slots), self->slots = NULL;
+}
+
+static
+int assemble (struct Jit *jit, const struct Op *ops)
+{
+	struct Assembler assembler = { .ops = ops + 4, .indexSlot = -1, .countSlot = -1 };
+	struct Assembler *self = &assembler;
+	int less = ops->native == Op.iterateLessRef || ops->native == Op.iterateLessOrEqualRef;
+	uint32_t index, test, done;
+	int32_t indexOffset;
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	void *code;
+	
+	if (setjmp(self->bail))
+	{
+		finalizeAssembler(self);
+		return 0;
+	}
+	
+	if (ops->value.data.integer < 4)
+		unsupported(self);
+	
+	self->opCount = ops->value.data.integer - 4;
+	self->indexSlot = ops[2].value.data.integer;
+	if (ops[3].native == Op.getLocalSlotRef)
+		self->countSlot = ops[3].value.data.integer;
+	
+	indexOffset = slotOffset(self->indexSlot);
+	self->offsets = malloc(sizeof(*self->offsets) * (self->opCount + 1));
+	for (index = 0; index <= self->opCount; ++index)
+		self->offsets[index] = unbound;
+	
+	bytes(self, "\x53", 1); // push rbx
+	bytes(self, "\x41\x54", 2); // push r12
+	bytes(self, "\x48\x83\xec", 3), byte(self, frameBytes); // sub rsp, frame
+	bytes(self, "\x48\x89\xfb", 3); // mov rbx, rdi
+	bytes(self, "\x41\x89\xf4", 3); // mov r12d, esi
+	
+	test = self->byteCount;
+	bytes(self, "\x8b\x83", 2), dword(self, indexOffset); // mov eax, [index]
+	bytes(self, "\x44\x39\xe0", 3); // cmp eax, r12d
+	bytes(self, "\x0f", 1), byte(self, 0x80 | (
+		ops->native == Op.iterateLessRef? greaterOrEqual:
+		ops->native == Op.iterateLessOrEqualRef? greater:
+		ops->native == Op.iterateMoreRef? lessOrEqual:
+		less));
+	done = self->byteCount;
+	dword(self, 0);
+	
+	for (index = 0; index < self->opCount;)
+		index = statement(self, index);
+	
+	self->offsets[self->opCount] = self->byteCount;
+	bytes(self, less? "\x81\x83": "\x81\xab", 2), dword(self, indexOffset), dword(self, ops[1].value.data.integer); // add/sub [index], step
+	bytes(self, "\xe9", 1), dword(self, 0);
+	patch(self, self->byteCount - 4, test);
+	
+	patch(self, done, self->byteCount);
+	bytes(self, "\x48\x83\xc4", 3), byte(self, frameBytes); // add rsp, frame
+	bytes(self, "\x41\x5c", 2); // pop r12
+	bytes(self, "\x5b", 1); // pop rbx
+	bytes(self, "\xc3", 1); // ret
+	
+	for (index = 0; index < self->fixupCount; ++index)
+	{
+		if (self->fixups[index].op > self->opCount || self->offsets[self->fixups[index].op] == unbound)
+			unsupported(self);
+		
+		patch(self, self->fixups[index].at, self->offsets[self->fixups[index].op]);
+	}
+	
+	jit->size = (self->byteCount + pageSize - 1) / pageSize * pageSize;
+	code = mmap(NULL, jit->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (code == MAP_FAILED)
+		unsupported(self);
+	
+	memcpy(code, self->bytes, self->byteCount);
+	if (mprotect(code, jit->size, PROT_READ | PROT_EXEC))
+	{
+		munmap(code, jit->size);
+		unsupported(self);
+	}
+	
+	jit->ops = ops;
+	memcpy(&jit->run, &code, sizeof(code));
+	jit->slots = self->slots;
+	jit->slotCount = self->slotCount;
+	
+	self->slots = NULL;
+	finalizeAssembler(self);
+	return 1;
+}
+
+static
+void release (struct Jit *jit)
+{
+	void *code;
+	
+	memcpy(&code, &jit->run, sizeof(code));
+	munmap(code, jit->size);
+	free(jit->slots);
+	*jit = Jit.identity;
+}
+
+#else
+
+static
+int assemble (struct Jit *jit, const struct Op *ops)
+{
+	return 0;
+}
+
+static
+void release (struct Jit *jit)
+{
+	*jit = Jit.identity;
+}
+
+#endif
+
+static
+uint16_t compile (const struct Op *ops)
+{
+	uint32_t index;
+	
+	for (index = 0; index < jitCount; ++index)
+		if (!jitList[index].ops)
+			break;
+	
+	if (index >= UINT16_MAX)
+		return 0;
+	
+	if (index == jitCount)
+	{
+		if (jitCount >= jitCapacity)
+		{
+			jitCapacity = jitCapacity? jitCapacity * 2: 8;
+			jitList = realloc(jitList, sizeof(*jitList) * jitCapacity);
+		}
+		jitList[jitCount++] = Jit.identity;
+	}
+	
+	if (!assemble(jitList + index, ops))
+		return 0;
+	
+	return index + 1;
+}
+
+// MARK: - Methods
+
+int iterate (struct Context * const context, struct Op *ops, int32_t count)
+{
+	struct Op(Loop) *loop = &ops->cache.loop;
+	union Object(Hashmap) *hashmap = context->environment->hashmap;
+	struct Value *ref;
+	struct Jit *jit;
+	uint16_t index;
+	
+	if (loop->status == Op(rejectedLoop))
+		return 0;
+	
+	if (loop->status == Op(unknownLoop))
+	{
+		int64_t iterations;
+		
+		if (ops[2].native != Op.getLocalSlotRef)
+		{
+			loop->status = Op(rejectedLoop);
+			return 0;
+		}
+		
+		iterations = ((int64_t)count - hashmap[ops[2].value.data.integer].value.data.integer) / ops[1].value.data.integer;
+		
+		if (iterations < 0)
+			iterations = -iterations;
+		
+		loop->iterations += iterations < hotIterations? iterations + 1: hotIterations;
+		if (loop->iterations < hotIterations)
+			return 0;
+		
+		if (!(loop->jit = compile(ops)))
+		{
+			loop->status = Op(rejectedLoop);
+			return 0;
+		}
+		loop->status = Op(compiledLoop);
+	}
+	
+	jit = jitList + loop->jit - 1;
+	
+	for (index = 0; index < jit->slotCount; ++index)
+	{
+		ref = &hashmap[jit->slots[index]].value;
+		
+		if (ref->flags & (Value(readonly) | Value(accessor)))
+			goto deoptimize;
+		else if (ref->type == Value(integerType))
+		{
+			double binary = ref->data.integer;
+			ref->data.binary = binary;
+			ref->type = Value(binaryType);
+		}
+		else if (ref->type != Value(binaryType))
+			goto deoptimize;
+	}
+	
+	jit->run(hashmap, count);
+	
+	// an enclosing counted loop may step one of these slots as an integer
+	for (index = 0; index < jit->slotCount; ++index)
+	{
+		ref = &hashmap[jit->slots[index]].value;
+		
+		if (ref->data.binary >= INT32_MIN && ref->data.binary <= INT32_MAX && ref->data.binary == (int32_t)ref->data.binary && !signbit(ref->data.binary))
+		{
+			int32_t integer = ref->data.binary;
+			ref->data.integer = integer;
+			ref->type = Value(integerType);
+		}
+	}
+	
+	return 1;
+
+deoptimize:
+	if (++loop->misses >= missLimit)
+		loop->status = Op(rejectedLoop);
+	
+	return 0;
+}
+
+void forget (const struct Op *ops, uint32_t count)
+{
+	uint32_t index;
+	
+	for (index = 0; index < jitCount; ++index)
+		if (jitList[index].ops >= ops && jitList[index].ops < ops + count)
+			release(jitList + index);
+}
+
+void teardown (void)
+{
+	uint32_t index;
+	
+	for (index = 0; index < jitCount; ++index)
+		if (jitList[index].ops)
+			release(jitList + index);
+	
+	free(jitList), jitList = NULL;
+	jitCount = jitCapacity = 0;
+}
@@ -0,0 +1,45 @@
+//
+//  jit.h
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#ifndef io_libecc_jit_h
+#ifdef Implementation
+#undef Implementation
+#include __FILE__
+#include "implementation.h"
+#else
+#include "interface.h"
+#define io_libecc_jit_h
+
+	#include "oplist.h"
+	
+	// machine code for hot counted loops (`for (i = a; i < n; i += k)`, as
+	// built by OpList.createLoop), when their body only computes on numbers
+	// held in local slots; enabled per instance with Ecc.jitLoops.
+	//
+	// the slots a body touches are checked at each entry: any other type than
+	// a number runs the loop as ops instead, and so does a host without backend
+
+#endif
+
+
+Interface(Jit,
+	
+	(int, iterate ,(struct Context * const, struct Op *ops, int32_t count))
+	(void, forget ,(const struct Op *ops, uint32_t count))
+	(void, teardown ,(void))
+	,
+	{
+		const struct Op *ops;
+		void (*run) (union Object(Hashmap) *hashmap, int32_t count);
+		size_t size;
+		uint16_t *slots;
+		uint16_t slotCount;
+	}
+)
+
+#endif
@@ -13,72 +13,189 @@
 #include "lexer.h"
 #include "ecc.h"
 #include "builtin/object.h"
+#include "builtin/string.h"
 
 // MARK: - Private
 
-static struct Text *keyPool = NULL;
-static uint16_t keyCount = 0;
-static uint16_t keyCapacity = 0;
+const uint32_t Key(max) = Key(longBase) + 0xffffff;
 
-static char **charsList = NULL;
-static uint16_t charsCount = 0;
+enum {
+	// texts are allocated by chunks so `textOf` pointers stay valid while the pool grows
+	chunkShift = 12,
+	chunkSize = 1 << chunkShift,
+	
+	infoMark = 1 << 6,
+	infoUnused = 1 << 7,
+};
+
+static Ecc(threadlocal) struct Text **keyChunks = NULL;
+static Ecc(threadlocal) uint32_t keyChunkCount = 0;
+
+static Ecc(threadlocal) struct {
+	uint32_t hash;
+	uint8_t flags;
+} *keyInfo = NULL;
+
+static Ecc(threadlocal) uint32_t keyCount = 0;
+
+static Ecc(threadlocal) uint32_t *freeList = NULL;
+static Ecc(threadlocal) uint32_t freeCount = 0;
+static Ecc(threadlocal) uint32_t freeCapacity = 0;
+
+// open-addressed index of the pool, holding key numbers (0 = empty bucket)
+static Ecc(threadlocal) uint32_t *keyHashmap = NULL;
+static Ecc(threadlocal) uint32_t keyHashmapCapacity = 0;
 
-struct Key Key(none) = {{{ 0 }}};
+struct Key Key(none) = {{ 0 }};
 
-#define _(X) struct Key Key(X);
+#define _(X) Ecc(threadlocal) struct Key Key(X);
 io_libecc_key_Keys
 #undef _
 
 // MARK: - Static Members
 
 static
-struct Key makeWithNumber (uint16_t number)
+struct Key makeWithNumber (uint32_t number)
 {
 	struct Key key;
 	
-	key.data.depth[0] = number >> 12 & 0xf;
-	key.data.depth[1] = number >> 8 & 0xf;
-	key.data.depth[2] = number >> 4 & 0xf;
-	key.data.depth[3] = number >> 0 & 0xf;
+	key.data.integer = number;
 	
 	return key;
 }
 
+static inline
+struct Text *textAt (uint32_t number)
+{
+	return &keyChunks[(number - 1) >> chunkShift][(number - 1) & (chunkSize - 1)];
+}
+
+static inline
+uint32_t hashOfText (const struct Text text)
+{
+	uint32_t hash = 2166136261u;
+	int32_t index;
+	
+	for (index = 0; index < text.length; ++index)
+		hash = (hash ^ (uint8_t)text.bytes[index]) * 16777619u;
+	
+	return hash;
+}
+
 static
-struct Key addWithText (const struct Text text, enum Key(Flags) flags)
+void insertNumber (uint32_t number)
+{
+	uint32_t mask = keyHashmapCapacity - 1;
+	uint32_t bucket = keyInfo[number - 1].hash & mask;
+	
+	while (keyHashmap[bucket])
+		bucket = (bucket + 1) & mask;
+	
+	keyHashmap[bucket] = number;
+}
+
+static
+void removeNumber (uint32_t number)
 {
-	if (keyCount >= keyCapacity)
+	uint32_t mask = keyHashmapCapacity - 1;
+	uint32_t bucket = keyInfo[number - 1].hash & mask;
+	uint32_t next, home;
+	
+	while (keyHashmap[bucket] != number)
+		bucket = (bucket + 1) & mask;
+	
+	// backward shift following entries, so probing never stops at a hole
+	
+	next = bucket;
+	while (keyHashmap[next = (next + 1) & mask])
 	{
-		if (keyCapacity == UINT16_MAX)
-			Ecc.fatal("No more identifier left");
+		home = keyInfo[keyHashmap[next] - 1].hash & mask;
 		
-		keyCapacity += 0xff;
-		keyPool = realloc(keyPool, keyCapacity * sizeof(*keyPool));
+		if (((next - home) & mask) >= ((next - bucket) & mask))
+		{
+			keyHashmap[bucket] = keyHashmap[next];
+			bucket = next;
+		}
 	}
 	
+	keyHashmap[bucket] = 0;
+}
+
+static
+void growHashmap (void)
+{
+	uint32_t number;
+	
+	keyHashmapCapacity = keyHashmapCapacity? keyHashmapCapacity * 2: 0x200;
+	free(keyHashmap);
+	keyHashmap = calloc(keyHashmapCapacity, sizeof(*keyHashmap));
+	
+	for (number = 1; number <= keyCount; ++number)
+		if (!(keyInfo[number - 1].flags & infoUnused))
+			insertNumber(number);
+}
+
+static
+uint32_t nextNumber (void)
+{
+	if (freeCount)
+		return freeList[--freeCount];
+	
+	if (keyCount >= Key(max))
+		Ecc.fatal("No more identifier left");
+	
+	if (!(keyCount & (chunkSize - 1)))
+	{
+		keyChunks = realloc(keyChunks, sizeof(*keyChunks) * (keyChunkCount + 1));
+		keyChunks[keyChunkCount++] = malloc(sizeof(**keyChunks) * chunkSize);
+		keyInfo = realloc(keyInfo, sizeof(*keyInfo) * keyChunkCount * chunkSize);
+	}
+	
+	return ++keyCount;
+}
+
+static
+struct Key addWithText (const struct Text text, enum Key(Flags) flags)
+{
+	uint32_t number = nextNumber();
+	
 	if ((isdigit(text.bytes[0]) || text.bytes[0] == '-') && !isnan(Lexer.scanBinary(text, 0).data.binary))
-		Env.printWarning("Creating identifier '%.*s'; %u identifier(s) left. Using array of length > 0x%x, or negative-integer/floating-point as property name is discouraged", text.length, text.bytes, UINT16_MAX - keyCount, Object(ElementMax));
+		Env.printWarning("Creating identifier '%.*s'; %u identifier(s) left. Using array of length > 0x%x, or negative-integer/floating-point as property name is discouraged", text.length, text.bytes, Key(max) - (keyCount - freeCount), Object(ElementMax));
 	
 	if (flags & Key(copyOnCreate))
 	{
 		char *chars = malloc(text.length + 1);
 		memcpy(chars, text.bytes, text.length);
 		chars[text.length] = '\0';
-		charsList = realloc(charsList, sizeof(*charsList) * (charsCount + 1));
-		charsList[charsCount++] = chars;
-		keyPool[keyCount++] = Text.make(chars, text.length);
+		*textAt(number) = Text.make(chars, text.length);
+		keyInfo[number - 1].flags = Key(copyOnCreate);
 	}
 	else
-		keyPool[keyCount++] = text;
+	{
+		*textAt(number) = text;
+		keyInfo[number - 1].flags = 0;
+	}
+	
+	textAt(number)->keyChunk = (number - 1) >> chunkShift;
+	keyInfo[number - 1].hash = hashOfText(text);
+	
+	// new keys survive the collection in progress, if any
+	keyInfo[number - 1].flags |= infoMark;
+	
+	// keep load factor under 1/2
+	if ((keyCount - freeCount) * 2 > keyHashmapCapacity)
+		growHashmap();
+	else
+		insertNumber(number);
 	
-	return makeWithNumber(keyCount);
+	return makeWithNumber(number);
 }
 
 // MARK: - Methods
 
 void setup (void)
 {
-	if (!keyPool)
+	if (!keyChunks)
 	{
 		#define _(X) Key(X) = addWithText(Text.make(#X, strlen(#X)), 0);
 		io_libecc_key_Keys
@@ -88,11 +205,19 @@ void setup (void)
 
 void teardown (void)
 {
-	while (charsCount)
-		free(charsList[--charsCount]), charsList[charsCount] = NULL;
+	uint32_t number;
 	
-	free(charsList), charsList = NULL, charsCount = 0;
-	free(keyPool), keyPool = NULL, keyCount = 0, keyCapacity = 0;
+	for (number = 1; number <= keyCount; ++number)
+		if (keyInfo[number - 1].flags & Key(copyOnCreate))
+			free((char *)textAt(number)->bytes);
+	
+	while (keyChunkCount)
+		free(keyChunks[--keyChunkCount]), keyChunks[keyChunkCount] = NULL;
+	
+	free(keyChunks), keyChunks = NULL;
+	free(keyInfo), keyInfo = NULL, keyCount = 0;
+	free(freeList), freeList = NULL, freeCount = 0, freeCapacity = 0;
+	free(keyHashmap), keyHashmap = NULL, keyHashmapCapacity = 0;
 }
 
 struct Key makeWithCString (const char *cString)
@@ -112,14 +237,21 @@ struct Key makeWithText (const struct Text text, enum Key(Flags) flags)
 
 struct Key search (const struct Text text)
 {
-	uint16_t index = 0;
+	uint32_t mask, bucket, number;
+	
+	if (!keyHashmap)
+		return makeWithNumber(0);
 	
-	for (index = 0; index < keyCount; ++index)
+	mask = keyHashmapCapacity - 1;
+	bucket = hashOfText(text) & mask;
+	
+	while (( number = keyHashmap[bucket] ))
 	{
-		if (text.length == keyPool[index].length && memcmp(keyPool[index].bytes, text.bytes, text.length) == 0)
-		{
-			return makeWithNumber(index + 1);
-		}
+		const struct Text *key = textAt(number);
+		if (text.length == key->length && memcmp(key->bytes, text.bytes, text.length) == 0)
+			return makeWithNumber(number);
+		
+		bucket = (bucket + 1) & mask;
 	}
 	return makeWithNumber(0);
 }
@@ -131,13 +263,78 @@ int isEqual (struct Key self, struct Key to)
 
 const struct Text *textOf (struct Key key)
 {
-	uint16_t number = key.data.depth[0] << 12 | key.data.depth[1] << 8 | key.data.depth[2] << 4 | key.data.depth[3];
-	if (number)
-		return &keyPool[number - 1];
+	if (key.data.integer)
+		return textAt(key.data.integer);
 	else
 		return &Text(empty);
 }
 
+void mark (struct Key key)
+{
+	if (key.data.integer && key.data.integer <= keyCount)
+		keyInfo[key.data.integer - 1].flags |= infoMark;
+}
+
+void markText (const struct Text *text)
+{
+	uint32_t chunk = text->keyChunk;
+	
+	// other texts may carry a chunk too (copies of a key's), only the address tells
+	
+	if (chunk < keyChunkCount && text >= keyChunks[chunk] && text < keyChunks[chunk] + chunkSize)
+		keyInfo[(chunk << chunkShift) + (text - keyChunks[chunk])].flags |= infoMark;
+}
+
+void collectUnmarked (void)
+{
+	uint32_t number;
+	
+	// only keys copied on creation (computed at runtime) are reclaimed;
+	// others reference static or input text and may be held by C code
+	
+	for (number = 1; number <= keyCount; ++number)
+	{
+		if (keyInfo[number - 1].flags & infoMark)
+			keyInfo[number - 1].flags &= ~infoMark;
+		else if (keyInfo[number - 1].flags & Key(copyOnCreate))
+		{
+			removeNumber(number);
+			String.forgetTextIndices(textAt(number)->bytes, textAt(number)->length);
+			free((char *)textAt(number)->bytes);
+			*textAt(number) = Text(empty);
+			keyInfo[number - 1].flags = infoUnused;
+			
+			if (freeCount >= freeCapacity)
+			{
+				freeCapacity = freeCapacity? freeCapacity * 2: 0x100;
+				freeList = realloc(freeList, sizeof(*freeList) * freeCapacity);
+			}
+			freeList[freeCount++] = number;
+		}
+	}
+}
+
+void copyTextsIn (const char *bytes, uint32_t length)
+{
+	uint32_t number;
+	
+	// keys naming text of an input about to be destroyed take their own copy,
+	// and from then on are reclaimed like computed ones
+	
+	for (number = 1; number <= keyCount; ++number)
+		if (!(keyInfo[number - 1].flags & (Key(copyOnCreate) | infoUnused)) && textAt(number)->bytes >= bytes && textAt(number)->bytes < bytes + length)
+		{
+			struct Text *text = textAt(number);
+			char *chars = malloc(text->length + 1);
+			
+			memcpy(chars, text->bytes, text->length);
+			chars[text->length] = '\0';
+			*text = Text.make(chars, text->length);
+			text->keyChunk = (number - 1) >> chunkShift;
+			keyInfo[number - 1].flags |= Key(copyOnCreate);
+		}
+}
+
 void dumpTo (struct Key key, FILE *file)
 {
 	const struct Text *text = textOf(key);
@@ -47,7 +47,7 @@
 		_( source )\
 		\
 
-	#define _(X) extern struct Key Key(X);
+	#define _(X) extern Ecc(threadlocal) struct Key Key(X);
 	io_libecc_key_Keys
 	#undef _
 
@@ -55,6 +55,17 @@
 		Key(copyOnCreate) = (1 << 0),
 	};
 
+	// key numbers below longBase are 4 nibbles deep in object hashmaps,
+	// above they take nibble 0xf then 6 nibbles (up to longBase + 0xffffff)
+	
+	enum Key(Encoding) {
+		Key(shortDepth) = 4,
+		Key(longDepth) = 7,
+		Key(longBase) = 0xf000,
+	};
+	
+	extern const uint32_t Key(max);
+
 #endif
 
 
@@ -70,11 +81,15 @@ Interface(Key,
 	(int, isEqual, (struct Key, struct Key))
 	(const struct Text *, textOf, (struct Key))
 	
+	(void, mark ,(struct Key))
+	(void, markText ,(const struct Text *))
+	(void, collectUnmarked ,(void))
+	(void, copyTextsIn ,(const char *bytes, uint32_t length))
+	
 	(void, dumpTo, (struct Key, FILE *))
 	,
 	{
 		union {
-			uint8_t depth[4];
 			uint32_t integer;
 		} data;
 	}
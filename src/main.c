@@ -7,10 +7,20 @@
 //
 
 #include "ecc.h"
+#include "op.h"
+
+#if THREADS
+	#include <pthread.h>
+#endif
+
+#if (__unix__ && !__MSDOS__) || (defined(__APPLE__) && defined(__MACH__))
+	#include <unistd.h>
+#endif
 
 static struct Ecc *ecc;
 
 static int runTest (int verbosity);
+static int runThreads (int count, const char *filename);
 static int alertUsage (void);
 
 static struct Value alert (struct Context * const context);
@@ -33,6 +43,23 @@ int main (int argc, const char * argv[])
 		result = runTest(1);
 	else if (!strcmp(argv[1], "--test-quiet"))
 		result = runTest(-1);
+	else if (!strcmp(argv[1], "--threads") && argc == 4)
+		result = runThreads(atoi(argv[2]), argv[3]);
+	else if (!strcmp(argv[1], "--compile"))
+		result = argc == 4? Ecc.compileInput(ecc, Input.createFromFile(argv[2]), argv[3], Ecc(sloppyMode)): alertUsage();
+	else if (!strcmp(argv[1], "--compiled") && argc >= 3)
+	{
+		struct Object *arguments = Arguments.createWithCList(argc - 3, &argv[3]);
+		Ecc.addValue(ecc, "arguments", Value.object(arguments), 0);
+		result = Ecc.evalCompiled(ecc, argv[2], 0);
+	}
+	else if (!strcmp(argv[1], "--jit") && argc >= 3)
+	{
+		struct Object *arguments = Arguments.createWithCList(argc - 3, &argv[3]);
+		Ecc.addValue(ecc, "arguments", Value.object(arguments), 0);
+		ecc->jitLoops = 1;
+		result = Ecc.evalInput(ecc, Input.createFromFile(argv[2]), Ecc(sloppyMode));
+	}
 	else
 	{
 		struct Object *arguments = Arguments.createWithCList(argc - 2, &argv[2]);
@@ -50,7 +77,7 @@ int main (int argc, const char * argv[])
 static int alertUsage (void)
 {
 	const char error[] = "Usage";
-	Env.printError(sizeof(error)-1, error, "libecc [<filename> | --test | --test-verbose | --test-quiet]");
+	Env.printError(sizeof(error)-1, error, "libecc [<filename> | --compile <filename> <snapshot> | --compiled <snapshot> | --jit <filename> | --threads <count> <filename> | --test | --test-verbose | --test-quiet]");
 	
 	return EXIT_FAILURE;
 }
@@ -91,6 +118,7 @@ static int testVerbosity = 0;
 static int testErrorCount = 0;
 static int testCount = 0;
 static double testTime = 0;
+static uint32_t testCollectBudget = 0;
 
 Ecc(useframe)
 static void test (const char *func, int line, const char *test, const char *expect, const char *text)
@@ -159,7 +187,10 @@ static void test (const char *func, int line, const char *test, const char *expe
 	}
 	
 	error:
-	Ecc.garbageCollect(ecc);
+	if (testCollectBudget)
+		Ecc.collectStep(ecc, testCollectBudget);
+	else
+		Ecc.garbageCollect(ecc);
 }
 #define test(i, e, t) test(__func__, __LINE__, i, e, t)
 
@@ -359,6 +390,13 @@ static void testEval (void)
 	test("var x = new String('1 + 1'); eval(x) == x", "true", NULL);
 	test("var a = 123; eval('a')", "123", NULL);
 	test("var a = 123; (1, eval)('a')", "123", NULL);
+	test("var a = [], i; for (i = 0; i < 3; ++i) a.push(eval('\"abc\" + i')); a", "abc0,abc1,abc2", NULL);
+	test("function a() { var p = 1, q = 2; return eval('[p, q, typeof r]') }; function b() { var r = 3, p = 4; return eval('[p, q, typeof r]') }; var q = 5; [a(), b(), a()].join(' ')", "1,2,undefined 4,5,number 1,2,undefined", NULL);
+	test("var a = [], i; for (i = 0; i < 3; ++i) a.push(eval('var v = typeof v; v')); a", "undefined,undefined,undefined", NULL);
+	test("var a = [], i; for (i = 0; i < 3; ++i) a.push(eval('(function(){ var k = i; return function(){ return k } })()')); a[0]() + a[1]() + a[2]()", "3", NULL);
+	test("var a = [], i; for (i = 0; i < 3; ++i) try { eval('(') } catch (e) { a.push(e) }; a.length", "3", NULL);
+	test("var fs = [], out = '', k; for (k = 0; k < 5; ++k) fs.push(eval('eval(\\'14+1\\'), function(){ return \\'v\\' + k }')); for (k = 0; k < 5; ++k) out += fs[k](); out", "v0v1v2v3v4", NULL);
+	test("var a = [], i; this.g1 = 'a'; for (i = 0; i < 2; ++i) a.push(eval('g1')); delete this.g1; this.g2 = 'b'; this.g1 = 'c'; a.push(eval('g1')); delete this.g1, delete this.g2; a", "a,a,c", NULL);
 }
 
 static void testConvertion (void)
@@ -427,6 +465,10 @@ static void testException (void)
 	test("try { throw 'a' }", "SyntaxError: expected catch or finally, got end of script"
 	,    "                 ^");
 	test("var c = 0; try{ c += 1; } finally{ c *= 2; } c", "2", NULL);
+	test("var s = 0; for (var i = 0; i < 9; ++i) try { if (i % 3) s += i; else throw i } catch (e) { s -= e } s", "18", NULL);
+	test("try { [2, 1].sort(function (){ try { throw 'a' } finally { throw 'b' } }) } catch (e) { e }", "b", NULL);
+	test("for (var i = 0; i < 3; ++i) try { break } finally {}; throw i", "0"
+	,    "                                                            ^");
 }
 
 static void testOperator (void)
@@ -447,6 +489,15 @@ static void testOperator (void)
 	test("10 ^ 3", "9", NULL);
 	test("10 | 3", "11", NULL);
 	test("var u = undefined; u += 123.;", "NaN", NULL);
+	test("var a = 2147483647; a + 1", "2147483648", NULL);
+	test("var a = -2147483648; a - 1", "-2147483649", NULL);
+	test("var a = 65536; a * 65536", "4294967296", NULL);
+	test("var a = 0; 1 / (a * -1)", "-Infinity", NULL);
+	test("var a = -4; 1 / (a % 2)", "-Infinity", NULL);
+	test("var a = -10; a % 8", "-2", NULL);
+	test("var a = 'a'; a + 1", "a1", NULL);
+	test("var a = 1; a / 4", "0.25", NULL);
+	test("var a = 1.5; a * 2", "3", NULL);
 }
 
 static void testEquality (void)
@@ -513,6 +564,10 @@ static void testRelational (void)
 	test("3 >= 3", "true", NULL);
 	test("3 < 4", "true", NULL);
 	test("3 <= 4", "true", NULL);
+	test("var a = '10'; a > 9", "true", NULL);
+	test("var a = 'b'; a < 1", "false", NULL);
+	test("var a = NaN; a <= 1 || a >= 1", "false", NULL);
+	test("var a = 1.5; a < 2", "true", NULL);
 	test("'toString' in {}", "true", NULL);
 	test("'toString' in null", "TypeError: 'null' not an object"
 	,    "              ^~~~");
@@ -604,6 +659,11 @@ static void testGlobal (void)
 	test("parseFloat('0x1')", "0", NULL);
 	test("parseFloat('infinity')", "NaN", NULL);
 	test("parseFloat('Infinity')", "Infinity", NULL);
+	test("[parseFloat('3.25e2px'), parseFloat(' -.5'), parseFloat('1e'), parseFloat('.'), parseFloat('-0x10')]", "325,-0.5,1,NaN,0", NULL);
+	test("[Number('0.1') + Number('0.2'), Number('1e-400'), Number('-1e400'), Number('+Infinity'), Number('-inf'), Number('0x1F'), Number('-0x1F')]", "0.30000000000000004,0,-Infinity,Infinity,NaN,31,NaN", NULL);
+	test("[Number('2.2250738585072011e-308') > 0, Number('4.9406564584124654e-324'), Number('9007199254740993'), Number('123456789012345678901234567890')]", "true,5e-324,9007199254740992,1.2345678901234568e+29", NULL);
+	test("[Number('1.00000000000000011102230246251565404236316680908203125') - 1, Number('1.00000000000000011102230246251565404236316680908203126') - 1]", "0,2.220446049250313e-16", NULL);
+	test("[parseInt('42px'), parseInt('-17'), parseInt('+3'), Number('12 '), Number('12x'), Number('007')]", "42,-17,3,12,NaN,7", NULL);
 	test("escape('éççäîtest./例')", "%E9%E7%E7%E4%EEtest./%u4F8B", NULL);
 	test("unescape('%E9%E7%E7%E4%EEtest./%u4F8B')", "éççäîtest./例", NULL);
 }
@@ -687,6 +747,14 @@ static void testFunction (void)
 	test("function a(){ function b(){} return b }; var c = a(), d = a(); c == d", "false", NULL);
 	test("function a(){ function b(){} return b }; var c = a(), d = a(); c.prototype == d.prototype", "false", NULL);
 	test("function a(){ function b(){} return b }; var c = a(), d = a(); c.prototype.constructor == d.prototype.constructor", "false", NULL);
+	test("(function(a, b){ a -= b; a *= 3; a <<= 2; a |= 1; a %= 7; return a })(10, 4)", "3", NULL);
+	test("(function(){ var a = 'a'; a += 1; a += 2; return a })()", "a12", NULL);
+	test("(function(x){ return x > 2 && x < 5? 'in': x || 'zero' })(0)", "zero", NULL);
+	test("(function(){ var a = 1; a += b })()", "ReferenceError: 'b' is not defined"
+	,    "                             ^    ");
+	test("function a(x){ function b(){ return x } return b() } var s = 0; for (var i = 0; i < 100; ++i) s += a(i); s", "4950", NULL);
+	test("function a(x){ function b(){ return x } return b } var l = []; for (var i = 0; i < 40; ++i){ a(-1); l[i] = a(i); } l[3]() + l[39]()", "42", NULL);
+	test("function a(){ return arguments } var l = []; for (var i = 0; i < 40; ++i){ a(0); l[i] = a(i, i); } [].join.call(l[7])", "7,7", NULL);
 }
 
 static void testLoop (void)
@@ -707,6 +775,14 @@ static void testLoop (void)
 	,    "                           ^        ");
 	test("var a = [ 'a', 123 ], b; for (b in a) b + ':' + a[b];", "1:123", NULL);
 	test("var a = [ 'a', 123 ], b; for (b in a) typeof b;", "string", NULL);
+	test("var a = [], o = ''; a[123456] = 1; for (var b in a) o += b + typeof b; o", "123456string", NULL);
+	test("function F (){ this.a = 1 }; F.prototype.a = F.prototype.b = 2; var o = '', b; for (b in new F) o += b; o", "ab", NULL);
+	test("function F (){ this.a = 1 }; F.prototype.m = F.prototype.b = 2; delete F.prototype.m; var o = [], b; for (b in new F) o.push(b); o", "a,b", NULL);
+	test("Array.prototype.q = 1; delete Array.prototype.q; var o = [], b; for (b in [1, 2]) o.push(b); o", "0,1", NULL);
+	test("var p = { a: 1, b: 2 }, c = Object.create(p), o = ''; Object.defineProperty(c, 'a', { value: 3 }); for (var b in c) o += b; o", "b", NULL);
+	test("var p = [1, 2, 3], c = Object.create(p), o = ''; c[1] = 4; for (var b in c) o += b + c[b]; o", "140123", NULL);
+	test("var a = [1, 2, 3], o = ''; for (var b in a) { o += b; a.length = 1 }; o", "0", NULL);
+	test("var o = ''; for (var b in new Int8Array(3)) o += b; o", "012", NULL);
 	test("continue abc;", "SyntaxError: continue must be inside loop"
 	,    "^~~~~~~~     ");
 	test("while (1) continue abc;", "SyntaxError: label not found"
@@ -716,6 +792,19 @@ static void testLoop (void)
 	test("while (1) break abc;", "SyntaxError: label not found"
 	,    "                ^~~ ");
 	test("var a; do a = 1; while (false); a", "1", NULL);
+	test("(function(){ var s = 0; for (var i = 0; i < 10; ++i) { if (i == 2) continue; if (i == 7) break; s += i; } return s })()", "19", NULL);
+	test("(function(){ var s = 0, j; for (var i = 0; i < 4; i++) for (j = 0; j < 4; j++) s += i * j; return s })()", "36", NULL);
+	test("(function(n){ var a = 1, b = 0; while (n--) { a = b + a; b = a - b; } return b })(10)", "55", NULL);
+	test("(function(){ var a = 5, r = ''; do r += a & 1? 'o': 'e'; while (--a); return r })()", "oeoeo", NULL);
+	
+	ecc->jitLoops = 1;
+	test("(function(){ var s = 0, x = 1.5; for (var i = 0; i < 1000; i++) { s = (s + i * 3) % 1003; x += i / 8; if (s > x) x -= s; else x *= -1; s++ } return s + ',' + x })()", "15,-421004", NULL);
+	test("(function(){ var c = 3, e = 1e20; for (var i = 300; i > 0; i -= 3) { c ^= i; c = c << 3 | c >>> 29; e *= -1.5; c |= e } return c })()", "-1846242845", NULL);
+	test("function f(v){ for (var i = 0; i < 300; i++) v = v + 1; return v }; [ f(0), f('a').length, f(.5), f(-1) ].join()", "300,301,300.5,299", NULL);
+	test("(function(){ var n = 400, t = 0; for (var i = 0; i < n; ++i) { if (!(i % 3)) continue; t -= -i } return t })()", "53067", NULL);
+	test("function f(){ var s = 0, n = 0, i, j; for (i = 0; i < 300; i++) { n++; for (j = 0; j < 300; j++) s += i ^ j } return s + ':' + n }; f()", "17048664:300", NULL);
+	test("function f(){ var s = 0, n = 0, i, j; for (i = 0; i < 4; i++) { n++; for (j = 0; j < 300; j++) s += i + j } return s + ':' + n }; f()", "181200:4", NULL);
+	ecc->jitLoops = 0;
 }
 
 static void testThis (void)
@@ -738,6 +827,7 @@ static void testObject (void)
 	test("var a = { a: 1, 'b': 2, 1: 3 }; a[1]", "3", NULL);
 	test("var a = { a: 1, 'b': 2, '1': 3 }; a[1]", "3", NULL);
 	test("var a = { a: 1, 'b': 2, '1': 3 }, c = 1; a[c]", "3", NULL);
+	test("var a = { 'k\\x41': 1, '\\x31': 2, 'long\\tescaped\\tkey': 3 }; a.kA + a[1] + a['long\\tescaped\\tkey']", "6", NULL);
 	test("var a = { a: 1, 'b': 2, '1': 3 }; delete a['a']; a['a']", "undefined", NULL);
 	test("var a = { a: 1, 'b': 2, '1': 3 }; delete a['a']; a['a'] = 123; a['a']", "123", NULL);
 	test("var a = { a: 123 }; a.toString()", "[object Object]", NULL);
@@ -756,6 +846,18 @@ static void testObject (void)
 	test("var a = { a: 123 }; Object.getOwnPropertyDescriptor(a, 'a').writable", "true", NULL);
 	test("Object.getOwnPropertyNames({ a:'!', 2:'@', 'b':'#'}).toString()", "2,a,b", NULL);
 	test("var a = {}, o = ''; a['a'] = 'abc'; a['c'] = 123; a['b'] = undefined; for (var b in a) o += b + a[b]; o", "aabcc123bundefined", NULL);
+	test("var a = {}; for (var i = 0; i < 1000; ++i) a['key' + i] = i; var s = 0; for (var i = 0; i < 1000; ++i) s += a['key' + i]; s", "499500", NULL);
+	test("var a = {}; for (var i = 0; i < 70000; ++i) a['key' + i]; a.key69999 = 123; a.key0 = 456; a.key69999 + a.key0", "579", NULL);
+	test("var a = { b: 1 }, c = { d: 2 }; a.b = c.d; Object.keys(a)", "b", NULL);
+	test("Object.keys(JSON.parse('{\"reclaimed\":1}'))", "reclaimed", NULL);
+	test("var a = {}; for (var i = 0; i < 1000; ++i) a['other' + i]; var b = { reclaimed: 2 }; JSON.parse('{\"reclaimed\":1}').reclaimed + b.reclaimed", "3", NULL);
+	test("function f(o) { return o.b } [ f({ a: 1, b: 2 }), f({ b: 3 }), f({ c: 1, b: 4 }), f(Object.create({ b: 5 })) ].join()", "2,3,4,5", NULL);
+	test("var p = { x: 1 }, o = Object.create(p), r = []; for (var i = 0; i < 3; ++i) { r[i] = o.x; if (i == 1) o.x = 2; } r.join()", "1,1,2", NULL);
+	test("var o = { a: 1, b: 2 }, r = []; for (var i = 0; i < 3; ++i) { r[i] = o.b; if (i == 1) delete o.b; } r.join()", "2,2,", NULL);
+	test("var p = { set x(v) { this._x = v * 2 } }, o = Object.create(p), r = []; for (var i = 0; i < 2; ++i) { o.x = i + 1; r[i] = o._x } r.join()", "2,4", NULL);
+	test("var h = { m: 'h' }, p = Object.create(h), r = []; for (var i = 0; i < 4; ++i) { r[i] = Object.create(p).m; if (i == 1) p.m = 'p'; } r.join()", "h,h,p,p", NULL);
+	test("var h = { m: 'h' }, p = Object.create(h), q = Object.create(h), o = [Object.create(p), Object.create(q), Object.create(p)], r = []; q.m = 'q'; for (var i = 0; i < 3; ++i) r[i] = o[i].m; r.join()", "h,q,h", NULL);
+	test("var s = 0; for (var i = 0; i < 10000; ++i) { var o = { v: 'x' + i }; s += o.v.length } s", "48890", NULL);
 	test("var a = {}; a.null = 123; a.null", "123", NULL);
 	test("var a = {}; a.function = 123; a.function", "123", NULL);
 	test("typeof Object", "function", NULL);
@@ -960,6 +1062,17 @@ static void testArray (void)
 	test("var a = [123, 'abc', 'def']; Object.defineProperty(a, 1, {get: function(){ return this[2]; },set: function(v){}}); a.shift()", "123", NULL);
 	test("var a = [123, 'abc', 'def']; Object.defineProperty(a, 1, {get: function(){ return this[2]; },set: function(v){}}); a.shift(); a", "def,", NULL);
 	test("var a = [123, 'abc', 'def']; Object.defineProperty(a, 1, {get: function(){ return this.length },set: function(v){}}); a.shift(); a.push(123, 456); a", "3,4,123,456", NULL);
+	test("var a = [], s = 0; for (var i = 0; i < 1000; ++i) a.push(i); while (a.length > 1) { s += a.shift(); a.push(a.shift()); } s + ',' + a", "498525,975", NULL);
+	test("var a = []; for (var i = 0; i < 100; ++i) a.unshift(i); a.push('x'); a.shift() + ',' + a.length + ',' + a[98] + ',' + a[99]", "99,100,0,x", NULL);
+	test("var a = [1,,3]; a.shift(); (0 in a) + ',' + a", "false,,3", NULL);
+	test("var a = [1, 2]; a.shift(); Object.freeze(a); a.unshift(3)", "TypeError: object is not extensible"
+	,    "                                             ^~~~~~~~~~~~");
+	test("var a = [1, 2, 3, 4, 5, 6, 7, 8]; [a.splice(1, 2), a]", "2,3,1,4,5,6,7,8", NULL);
+	test("var a = [1, 2, 3, 4, 5, 6, 7, 8]; [a.splice(1, 1, 'a', 'b'), a]", "2,1,a,b,3,4,5,6,7,8", NULL);
+	test("var a = [1, 2, 3, 4, 5, 6, 7, 8]; [a.splice(6, 1), a]", "7,1,2,3,4,5,6,8", NULL);
+	test("var a = [1, 2, 3, 4, 5, 6, 7, 8]; [a.splice(6, 0, 'a', 'b'), a]", ",1,2,3,4,5,6,a,b,7,8", NULL);
+	test("var a = [1, 2, 3]; [a.splice(1, 0, 'x'), a]", ",1,x,2,3", NULL);
+	test("var a = [1, 2, 3, 4, 5, 6, 7, 8]; [a.splice(2, 3, 'a'), a.length, a]", "3,4,5,6,1,2,a,6,7,8", NULL);
 	test("var a = [1, 2, 'abc', null, 456]; a.slice().toString()", "1,2,abc,,456", NULL);
 	test("var a = [1, 2, 'abc', null, 456]; a.slice(2).toString()", "abc,,456", NULL);
 	test("var a = [1, 2, 'abc', null, 456]; a.slice(2,4).toString()", "abc,", NULL);
@@ -1016,6 +1129,11 @@ static void testArray (void)
 	test("function f(x,y){return arguments[0]<y?-1: x>arguments[1]?+1: 0};var a=['araignée',,,,'zèbre'];a.sort(f)", "araignée,zèbre,,,", NULL);
 	test("function f(x){return x<arguments[1]?-1: x>arguments[1]?+1: 0};var a=['araignée',,,,'zèbre'];a.sort(f)", "araignée,zèbre,,,", NULL);
 	test("function f(){return arguments[0]<arguments[1]?-1: arguments[0]>arguments[1]?+1: 0};var a=['araignée',,,,'zèbre'];a.sort(f)", "araignée,zèbre,,,", NULL);
+	test("var a = [3, undefined, , 1, 'b', 10, 2]; a.sort(); a + ',' + a.length + ',' + (5 in a) + ',' + (6 in a)", "1,10,2,3,b,,,7,true,false", NULL);
+	test("var a = []; for (var i = 0; i < 300; ++i) a[i] = { k: i % 7, i: i }; a.sort(function(x, y){ return x.k - y.k; }); var r = true; for (var i = 1; i < 300; ++i) r = r && (a[i - 1].k < a[i].k || a[i - 1].k == a[i].k && a[i - 1].i < a[i].i); r", "true", NULL);
+	test("var a = []; for (var i = 0; i < 300; ++i) a.push(i * 7919 % 300); a.sort(function(x, y){ return y - x; }); a.slice(0, 3) + ',' + a.slice(-2)", "299,298,297,1,0", NULL);
+	test("var a = [3, 2, 1]; a.sort(function(x, y){ a.length = 1; return x - y; }); a.length", "3", NULL);
+	test("var a = [], b = []; for (var i = 0; i < 300; ++i) { a.push('p' + i); a.unshift('u' + i); b.splice(0, 0, 's' + i); } a.sort(); a.slice(0, 2) + ',' + a.slice(-1) + ',' + b[0] + b[299]", "p0,p1,u99,s299s0", NULL);
 	test("var a = [], b = ''; a[34] = 34; Object.defineProperty(a, 12, {value: 12}); for (var i in a) b += i", "34", NULL);
 }
 
@@ -1086,8 +1204,10 @@ static void testNumber (void)
 	test("(-2147483647).toString(2)", "-1111111111111111111111111111111", NULL);
 	test("2147483647..toString(8)", "17777777777", NULL);
 	test("(-2147483647).toString(8)", "-17777777777", NULL);
-	test("Number.MAX_VALUE.toString(10)", "1.79769e+308", NULL);
-	test("Number.MIN_VALUE.toString(10)", "4.94065645841247e-324", NULL);
+	test("Number.MAX_VALUE.toString(10)", "1.7976931348623157e+308", NULL);
+	test("Number.MIN_VALUE.toString(10)", "5e-324", NULL);
+	test("[0.1 + 0.2, 1 / 3, 123.456, 0.000001, 1e-7, 1.5e-7, 1e21, 123e18, 2 / 3 * 1e300]", "0.30000000000000004,0.3333333333333333,123.456,0.000001,1e-7,1.5e-7,1e+21,123000000000000000000,6.666666666666667e+299", NULL);
+	test("[-0, -1.25, 9007199254740993, 2e-323, 1.7976931348623155e308, 4.35, 0.1234567890123]", "0,-1.25,9007199254740992,2e-323,1.7976931348623155e+308,4.35,0.1234567890123", NULL);
 	test("(2147483647).toString(16)", "7fffffff", NULL);
 	test("(-2147483647).toString(16)", "-7fffffff", NULL);
 	test("-2147483647..toString(16)", "NaN", NULL);
@@ -1360,10 +1480,21 @@ static void testString (void)
 	test("'uuabc123abc'.replace('abc', function (){ return arguments[1] })", "uu2123abc", NULL);
 	test("'$1,$2'.replace(/(\\$(\\d))/g, '$$1-$1$2')", "$1-$11,$1-$22", NULL);
 	test("'$1,$2'.replace('$1', '$$1-$1$2')", "$1-$1$2,$2", NULL);
+	test("var s = '', n = 0; for (var i = 0; i < 200; ++i) s += 'word' + i; for (var r = 0; r < 5; ++r) s.replace(/word1/g, function (){ ++n; return arguments[2].length > 0 }); n + s.length", "1845", NULL);
 	test("' abc  '.trim()", "abc", NULL);
 	test("'\\u00A0 abc  \\u00A0'.trim()", "abc", NULL);
 	test("'\\u2029 abc  \\u2029'.trim()", "abc", NULL);
 	test("var s = new String('123'); ++s[2]; ++s[2] + s", "4123", NULL);
+	test("var s = ''; for (var i = 0; i < 1000; ++i) s += i % 10; s.length + s.slice(-12)", "1000890123456789", NULL);
+	test("var s = Array(300).join('a'); var t = s + 'b'; (s + (s += 'c')).length + s.slice(-2) + t.slice(-2)", "599acab", NULL);
+	test("var s = Array(300).join('a') + '\\ud801'; s += '\\udc37'; s.length + s.slice(-3)", "301a𐐷", NULL);
+	test("var s = 'b' + Array(40).join('a€𝄞'); [ s.charCodeAt(63), s.charCodeAt(64), s.charCodeAt(65), s.charCodeAt(128), s.length ].join()", "55348,56606,97,56606,157", NULL);
+	test("var s = 'b' + Array(40).join('a€𝄞'); [ s.slice(65, 70), s.substring(70, 65), s.slice(-3), s[65], new String(s).length ].join()", "a€𝄞a,a€𝄞a,€𝄞,a,157", NULL);
+	test("var s = 'b' + Array(40).join('a€𝄞'); [ s.indexOf('€', 100), s.lastIndexOf('a'), s.search(/𝄞/) ].join()", "102,153,3", NULL);
+	test("var s = 'b' + Array(40).join('a€𝄞'), r = /€/g; r.lastIndex = 100; r.exec(s); r.lastIndex", "103", NULL);
+	test("var s = 'aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞aé€𝄞'; [ s.charCodeAt(63), s.charCodeAt(64), s.charCodeAt(65), s[96], s.slice(65, 70), s.length, new String(s).length ].join()", "55348,56606,97,é,aé€𝄞,100,100", NULL);
+	test("var a = Array(41).join('b' + Array(40).join('a€𝄞') + '#').split('#'), r = '', i, j; a.pop(); for (i = 0; i < 2; ++i) for (j = 0; j < a.length; ++j) r += a[j].charCodeAt(64 + i * 64); r == Array(41).join('56606') + Array(41).join('56606')", "true", NULL);
+	test("var s = 'b' + Array(40).join('a€𝄞'), o = '', p = Object.prototype, b; p[1] = p[3] = p[200] = 0; for (b in new String('ab')) o += b; for (b in new String(s)) o += b; delete p[1], delete p[3], delete p[200]; o", "3200200", NULL);
 }
 
 static void testRegExp (void)
@@ -1445,14 +1576,39 @@ static void testRegExp (void)
 	test("/\\0477/.exec('\\''+'77')", "'7", NULL);
 	test("/[a-z][^1-9][a-z]/.exec('a1b  b2c  c3d  def  f4g')", "def", NULL);
 	test("/[\\d][\\12-\\14]{1,}[^\\d]/.exec('line1\\n\\n\\n\\n\\nline2')", "1\n\n\n\n\nl", NULL);
+	test("/(a|ab)(c|bcd)(d*)/.exec('abcd')", "abcd,a,bcd,", NULL);
+	test("/(z)((a+)?(b+)?(c))*/.exec('zaacbbbcac')", "zaacbbbcac,z,ac,a,,c", NULL);
+	test("/(a*)*b/.exec('aaab')", "aaab,aaa", NULL);
+	test("/(a*)+/.exec('b')", ",", NULL);
+	test("/x{2,3}?y/.exec('xxxxy')", "xxxy", NULL);
+	test("/(?:fox|dog)s?\\b/.exec('the foxes dogs')", "dogs", NULL);
+	test("/^ab|cd/.exec('xcd')", "cd", NULL);
+	test("var s = 'ab'; while (s.length < 4000) s += s; /(a|b)*c/.exec(s)", "null", NULL);
+	test("var s = 'ab'; while (s.length < 4000) s += s; /(a|b)*$/.exec(s)[0].length", "4096", NULL);
 	test("RegExp('\\d', '1')", "SyntaxError: invalid flag"
 	,             "   " "^");
 	test("RegExp('\\d', 'igg')", "SyntaxError: invalid flag"
 	,             "   " "  ^");
 }
 
+static void appendJSON (void *user, const char *bytes, uint32_t length)
+{
+	Chars.append(user, "%.*s", (int)length, bytes);
+}
+
+static struct Value streamJSON (struct Context * const context)
+{
+	struct Chars(Append) chars;
+	
+	Chars.beginAppend(&chars);
+	JSON.stringify(context, Context.argument(context, 0), Value(undefined), Context.argument(context, 1), appendJSON, &chars);
+	return Chars.endAppend(&chars);
+}
+
 static void testJSON (void)
 {
+	Ecc.addFunction(ecc, "streamJSON", streamJSON, 2, 0);
+	
 	test("JSON", "[object JSON]", NULL);
 	test("JSON.parse('abc')", "SyntaxError: expect { or ["
 	,                "^  ");
@@ -1468,10 +1624,27 @@ static void testJSON (void)
 	test("JSON.parse('{\"abc\": 123.4e-2}').abc", "1.234", NULL);
 	test("JSON.parse('{\"abc\": 123,}').abc", "SyntaxError: expect property name"
 	,                  "            ^");
-	test("JSON.parse('{\"abc\": \"ab\\\\\"c\"}').abc", "ab\\\"c", NULL);
+	test("JSON.parse('{\"abc\": \"ab\\\\\"c\"}').abc", "ab\"c", NULL);
+	test("JSON.parse('[\"\\\\u00e9\\\\n\\\\/\\\\\\\\\"]')[0]", "\xc3\xa9\n/\\", NULL);
+	test("JSON.parse('[\"\\\\ud83d\\\\ude00\"]')[0].length", "2", NULL);
+	test("JSON.parse('{\"\\\\u0061b\": 1}').ab", "1", NULL);
+	test("JSON.parse('[\"a\\\\x\"]')", "SyntaxError: malformed escape sequence"
+	,                   "   ^~  ");
+	test("JSON.parse('[\"a\\tb\"]')", "SyntaxError: unexpected '\t'"
+	,                 "   ^  ");
+	test("JSON.parse(' [ ] ').length", "0", NULL);
+	test("JSON.parse('[{}, [], 1, -0.5, 2E-3, \"abcdefgh\", \"\"]').join('|')", "[object Object]||1|-0.5|0.002|abcdefgh|", NULL);
+	test("var a = JSON.parse('[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4}]'); a[0].x + a[1].y", "5", NULL);
+	test("JSON.parse('[1, ')", "SyntaxError: unexpected end of input"
+	,                "   ^");
+	test("JSON.parse('[1.]')", "SyntaxError: unexpected ']'"
+	,                "   ^");
+	test("JSON.parse('[-]')", "SyntaxError: unexpected ']'"
+	,                "  ^");
 	test("JSON.parse('{\"abc\": [0,1,2,3]}').abc", "0,1,2,3", NULL);
 	test("JSON.parse('{\"abc\": [false,true,null]}').abc", "false,true,", NULL);
 	test("JSON.parse('{\"abc\": [0,1,2,3]}', function(k,v){ return typeof v == 'number'? v * 2: v }).abc", "0,2,4,6", NULL);
+	test("JSON.stringify(JSON.parse('{\"a\":[1,{\"b\":2}]}', function(k,v){ return typeof v == 'number'? v * 10: v }))", "{\"a\":[10,{\"b\":20}]}", NULL);
 	test("var r=''; JSON.parse('[1, 2, { \"a\": 4, \"b\": {\"c\": 6}}]', function(key, value) { r += key+','; return value; }); r", "0,1,a,c,b,2,,", NULL);
 	test("JSON.stringify({ uno: 1, dos: { tres: 123 } }, null, '\t')", "{\n\t\"uno\": 1,\n\t\"dos\": {\n\t\t\"tres\": 123\n\t}\n}", NULL);
 	test("JSON.stringify({ uno: 1, dos: { tres: 123 } }, null, '  ')", "{\n  \"uno\": 1,\n  \"dos\": {\n    \"tres\": 123\n  }\n}", NULL);
@@ -1480,8 +1653,438 @@ static void testJSON (void)
 	test("var r=''; JSON.stringify({ uno: 1, dos: { tres: 123 } }, function(key,value){ r+=key; return value }); r", "unodostres", NULL);
 	test("JSON.stringify({f:'M',w:4,t:'c',M:7}, function replacer(key,value){ return typeof value=='string'?undefined:value });", "{\"w\":4,\"M\":7}", NULL);
 	test("JSON.stringify({f:'M',w:4,t:'c',M:7}, ['w','M']);", "{\"w\":4,\"M\":7}", NULL);
+	test("JSON.stringify(['a\"b', 'c\\\\d', '\\n\\t\\u0001', 'é'])", "[\"a\\\"b\",\"c\\\\d\",\"\\n\\t\\u0001\",\"é\"]", NULL);
+	test("JSON.stringify({ 'a\"b': 1 })", "{\"a\\\"b\":1}", NULL);
+	test("JSON.stringify([1.5, -0, NaN, Infinity, 1e21, 2147483648, 0.1])", "[1.5,0,null,null,1e+21,2147483648,0.1]", NULL);
+	test("JSON.stringify([new Number(3), new String('s'), new Boolean(false), null, undefined])", "[3,\"s\",false,null,null]", NULL);
+	test("JSON.stringify({ a: [], b: {} }, null, 2)", "{\n  \"a\": [],\n  \"b\": {}\n}", NULL);
+	test("JSON.stringify([1, [2]], null, 1)", "[\n 1,\n [\n  2\n ]\n]", NULL);
+	test("var r=[]; JSON.stringify(['x', 'y'], function(key,value){ r.push(typeof key + key); return value }); r.join()", "string,string0,string1", NULL);
+	test("var s = new Array(3000).join('ab\\n'); var o = [s, { k: s }, 1.25]; streamJSON(o, 2) == JSON.stringify(o, null, 2)", "true", NULL);
+}
+
+static double hostSamples[4] = { 1, 2, 3, 4 };
+
+static struct Value wrapSamples (struct Context * const context)
+{
+	struct ArrayBuffer *buffer = ArrayBuffer.createWithBytes(hostSamples, sizeof(hostSamples), NULL, NULL);
+	
+	return Value.object(&TypedArray.createWithBuffer(TypedArray(float64), buffer, 0, 4)->object);
+}
+
+static struct Value sumSamples (struct Context * const context)
+{
+	return Value.binary(hostSamples[0] + hostSamples[1] + hostSamples[2] + hostSamples[3]);
+}
+
+static void testTypedArray (void)
+{
+	Ecc.addFunction(ecc, "wrapSamples", wrapSamples, 0, 0);
+	Ecc.addFunction(ecc, "sumSamples", sumSamples, 0, 0);
+	
+	test("Float64Array", "function Float64Array() [native code]", NULL);
+	test("Object.prototype.toString.call(new Uint8ClampedArray(1))", "[object Uint8ClampedArray]", NULL);
+	test("var a = new Float64Array(4); a[0] = 1.5; a[1] += 2; a[2]++; a[3] = '7'; a + ':' + a.length + ':' + a.byteLength", "1.5,2,1,7:4:32", NULL);
+	test("new Int8Array([127, 128, 255, -129, 1.9, -1.9, NaN]).join()", "127,-128,-1,127,1,-1,0", NULL);
+	test("new Uint8ClampedArray([300, -5, 1.5, 2.5, 254.5]).join()", "255,0,2,2,254", NULL);
+	test("var a = new Uint16Array(2); a[0] = 70000; a[1] = -1; new Uint32Array([-1])[0] + ':' + a", "4294967295:4464,65535", NULL);
+	test("var a = new Int32Array(2); a[5] = 1; a[6] += 1; a[7]++; a[5] + ':' + a[6] + ':' + a.length + ':' + (1 in a) + (6 in a)", "undefined:undefined:2:truefalse", NULL);
+	test("var a = new Int32Array(2); a[1] = { valueOf: function(){ return 42 } }; a[1] |= 1; a[1]", "43", NULL);
+	test("var t = new Int32Array([1, 10]); t[0] += (t[1] += 5); t", "16,15", NULL);
+	test("var u = new Int32Array([1, 10]); u[0] += u[1]++; u", "11,11", NULL);
+	test("var w = new Int32Array([5, 7]); w[1] -= (w[0] *= 2); w", "10,-3", NULL);
+	test("var a = new Uint8Array(2); a[0] = 255; a[1] = a[0]++ + ++a[0]; a + ':' + (a[0] += 'x')", "1,0:1x", NULL);
+	test("var a = new Float32Array(1); a[0] += 1; try { null.x } catch (e) { typeof e }", "object", NULL);
+	test("var b = new ArrayBuffer(8), u = new Uint32Array(b, 4, 1); u[0] = 0x01020304; new Uint8Array(b) + ':' + u.byteOffset + (u.buffer === b)", "0,0,0,0,4,3,2,1:4true", NULL);
+	test("var a = new Int32Array([1,2,3,4]); a.set(a.subarray(0, 2), 2); a.subarray(-3, -1) + ':' + a.slice(1) + ':' + a.indexOf(2)", "2,1:2,1,2:1", NULL);
+	test("var a = new Int16Array(4); a.set([1, 2], 1); a.fill(9, -1); new Float32Array(a).reverse().join()", "9,2,1,0", NULL);
+	test("var a = new Uint8Array([1, 2, 3, 4]); new Uint16Array(a.buffer).set(a.subarray(0, 2)); a.join()", "1,0,2,0", NULL);
+	test("new Uint8Array(new ArrayBuffer(4).slice(1, -1)).length + ':' + ArrayBuffer.isView(new Int8Array(0)) + ArrayBuffer.isView([])", "2:truefalse", NULL);
+	test("Float64Array.BYTES_PER_ELEMENT + new Int16Array(0).BYTES_PER_ELEMENT", "10", NULL);
+	test("var a = new Uint8Array(3); a.x = 1; Object.keys(a) + ':' + Object.getOwnPropertyNames(new Int8Array(2)).slice(0, 3)", "0,1,2,x:0,1,length", NULL);
+	test("var a = new Int16Array(2); a[-1] = 5; a['-0'] = 1; a[1.5]++; a[NaN] = 2; a[-1] += 1; a[-1] + ':' + a['-0'] + ':' + a[1.5] + ':' + a.NaN + ':' + Object.keys(a) + ':' + (-1 in a) + a.hasOwnProperty('-1')", "undefined:undefined:undefined:undefined:0,1:falsefalse", NULL);
+	test("Int8Array(3)", "TypeError: Int8Array constructor requires 'new'"
+	,    "^~~~~~~~~~~~");
+	test("new Int32Array(new ArrayBuffer(6), 2)", "RangeError: start offset of Int32Array should be a multiple of 4"
+	,    "                                   ^ ");
+	test("new Int32Array(2).set([1, 2, 3])", "RangeError: source is too large"
+	,    "^~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~");
+	test("Int8Array.prototype.subarray.call([])", "TypeError: 'this' is not a typed array"
+	,    "                                  ^~ ");
+	test("var s = wrapSamples(); s[0] = 10; s.length + ':' + sumSamples()", "4:19", NULL);
+}
+
+static void testGarbageCollect (void)
+{
+	testCollectBudget = 1;
+	
+	test("this.g = { list: [] }; for (var i = 0; i < 50; ++i) g.list[i] = { v: 'v' + i }; g.list.length", "50", NULL);
+	test("var o = g.list[49]; g.list[49] = null; g.list[0] = o; g.list[0].v", "v49", NULL);
+	test("g.list[1] = { v: g.list[48].v + '!' }; g.list[48] = null; g.list[1].v", "v48!", NULL);
+	test("g.o = g.list[2]; delete g.list; g.o.v", "v2", NULL);
+	test("g.list = [ g.o, { v: 'new' } ]; g.list[1].v", "new", NULL);
+	test("g.s = Array(300).join('x'); for (var i = 0; i < 100; ++i) g.s += i % 10; g.s.length", "399", NULL);
+	
+	while (!Ecc.collectStep(ecc, 1));
+	
+	test("g.list[0].v + g.list[1].v + g.o.v", "v2newv2", NULL);
+	test("g.s.slice(-3) + g.s.length", "789399", NULL);
+	
+	testCollectBudget = 0;
+	
+	test("delete this.g", "true", NULL);
+}
+
+static void testInputs (void)
+{
+	char source[64];
+	uint32_t index, length, count = ecc->inputCount + ecc->releasedCount;
+	
+	// distinct sources evicted from the compiled cache (64 entries) are destroyed by the next collection
+	
+	for (index = 0; index < 500; ++index)
+	{
+		length = snprintf(source, sizeof(source), "({ key%u: %u }).key%u", index, index, index);
+		Ecc.evalInput(ecc, Input.createFromBytes(source, length, "inputs"), 0);
+	}
+	Ecc.garbageCollect(ecc);
+	
+	++testCount;
+	if (ecc->inputCount + ecc->releasedCount > count + 64)
+	{
+		++testErrorCount;
+		Env.printColor(Env(red), Env(bold), "[failure]");
+		Env.print(" %s:%d - ", __func__, __LINE__);
+		Env.printColor(0, Env(bold), "expect at most %u inputs, was %u", count + 64, ecc->inputCount + ecc->releasedCount);
+		Env.newline();
+	}
+	else if (testVerbosity >= 0)
+	{
+		Env.printColor(Env(green), Env(bold), "[success]");
+		Env.print(" %s:%d", __func__, __LINE__);
+		Env.newline();
+	}
+	
+	test("this.f = function () { return 'kept' }; ({ key7: 7 }).key7 + Object.keys({ key0: 0, key499: 1 })", "7key0,key499", NULL);
+	
+	for (index = 0; index < 100; ++index)
+	{
+		length = snprintf(source, sizeof(source), "%u", index);
+		Ecc.evalInput(ecc, Input.createFromBytes(source, length, "inputs"), 0);
+	}
+	Ecc.garbageCollect(ecc);
+	
+	test("f() + String(f)", "keptfunction anonymous() { return 'kept' }", NULL);
+	test("delete this.f", "true", NULL);
+}
+
+static const char *snapshotTests[] = {
+	"var f = function (n) { var k = 0; return function () { return n + ++k } }(10), s = '';"
+	"try { s += f(); throw Error('e') } catch (e) { s += e.message } finally { s += f() }"
+	"s + eval('var e = 3; e * f()')",
+	
+	"var o = { a: 1, b: [2, 3], get c () { return this.a * 4 } }, s = '';"
+	"for (var k in o) s += k + o[k];"
+	"s + 'x1y22z'.replace(/\\d+/g, function (m) { return '<' + m + '>' }) + /(b+)c/i.exec('aBbC')[1]",
+	
+	"function fib (n) { return n < 2? n: fib(n - 1) + fib(n - 2) }"
+	"var a = [], i; outer: for (i = 0; i < 10; ++i) { switch (i % 3) { case 0: continue outer; default: a.push(fib(i)) } }"
+	"JSON.stringify({ a: a, t: typeof fib, d: new Date(0).getTime() })",
+	
+	"function f (n) { var s = 0; try { throw n } catch (e) { s += e; try { throw 2 } catch (g) { s += g * e } } return s }"
+	"f(3) + (function (o) { var r = ''; for (var k in o) r += o[k] || k && '-'; return r })({ a: 0, b: 2 })",
+};
+
+static const char *snapshotPath (void)
+{
+	static char path[256];
+	const char *directory = getenv("TMPDIR");
+	
+	snprintf(path, sizeof(path), "%s/libecc-test.snapshot", directory? directory: "/tmp");
+	return path;
+}
+
+// evaluate the source when given, else the snapshot at path
+
+Ecc(useframe)
+static int evalSnapshot (const char *source, const char *path, char *result, size_t size)
+{
+	volatile int status = EXIT_FAILURE;
+	
+	if (!setjmp(*Ecc.pushEnv(ecc)))
+		status = source
+			? Ecc.evalInput(ecc, Input.createFromBytes(source, (uint32_t)strlen(source), "snapshot"), Ecc(stringResult))
+			: Ecc.evalCompiled(ecc, path, Ecc(stringResult));
+	
+	Ecc.popEnv(ecc);
+	
+	if (status == EXIT_SUCCESS && Value.isString(ecc->result))
+		snprintf(result, size, "%.*s", Value.stringLength(&ecc->result), Value.stringBytes(&ecc->result));
+	
+	return status;
 }
 
+static void testSnapshotResult (const char *func, int line, const char *expect, const char *result)
+{
+	++testCount;
+	
+	if (strcmp(expect, result))
+	{
+		++testErrorCount;
+		Env.printColor(Env(red), Env(bold), "[failure]");
+		Env.print(" %s:%d - ", func, line);
+		Env.printColor(0, Env(bold), "expect \"%s\" was \"%s\"", expect, result);
+		Env.newline();
+	}
+	else if (testVerbosity >= 0)
+	{
+		Env.printColor(Env(green), Env(bold), "[success]");
+		Env.print(" %s:%d", func, line);
+		Env.newline();
+	}
+	
+	Ecc.garbageCollect(ecc);
+}
+
+// load a damaged snapshot, and keep the error it reports
+
+static void evalDamagedSnapshot (const char *path, char *result, size_t size)
+{
+	char error[256];
+	size_t length;
+	int status;
+	#if (__unix__ && !__MSDOS__) || (defined(__APPLE__) && defined(__MACH__))
+	FILE *capture = tmpfile();
+	int descriptor = dup(fileno(stderr));
+	
+	fflush(stderr);
+	dup2(fileno(capture), fileno(stderr));
+	#endif
+	
+	status = evalSnapshot(NULL, path, result, size);
+	snprintf(result, size, "%s", status == EXIT_SUCCESS? "<loaded>": "InputError: invalid snapshot");
+	
+	#if (__unix__ && !__MSDOS__) || (defined(__APPLE__) && defined(__MACH__))
+	fflush(stderr);
+	dup2(descriptor, fileno(stderr));
+	close(descriptor);
+	
+	rewind(capture);
+	length = fread(error, 1, sizeof(error) - 1, capture);
+	error[length] = '\0';
+	fclose(capture), capture = NULL;
+	
+	if (status != EXIT_SUCCESS && (!strstr(error, "InputError") || !strstr(error, "invalid snapshot")))
+		snprintf(result, size, "%s", error);
+	#else
+	(void)length, (void)error;
+	#endif
+}
+
+// compiled code must evaluate like its source, and damaged snapshots must be turned down
+
+static void testSnapshot (void)
+{
+	const char *path = snapshotPath(), *source;
+	char expect[256], result[256];
+	size_t index, length;
+	uint32_t checksum;
+	uint8_t *bytes;
+	FILE *file;
+	
+	for (index = 0; index < sizeof(snapshotTests) / sizeof(*snapshotTests); ++index)
+	{
+		source = snapshotTests[index];
+		
+		strcpy(expect, "<not evaluated>");
+		evalSnapshot(source, NULL, expect, sizeof(expect));
+		Ecc.garbageCollect(ecc);
+		
+		strcpy(result, "<not compiled>");
+		if (Ecc.compileInput(ecc, Input.createFromBytes(source, (uint32_t)strlen(source), "snapshot"), path, 0) == EXIT_SUCCESS)
+			if (evalSnapshot(NULL, path, result, sizeof(result)) != EXIT_SUCCESS)
+				strcpy(result, "<not loaded>");
+		
+		testSnapshotResult(__func__, __LINE__, expect, result);
+	}
+	
+	// flip one byte of the last snapshot, and catch what loading it reports
+	file = fopen(path, "r+b");
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	fseek(file, length / 2, SEEK_SET);
+	index = fgetc(file);
+	fseek(file, length / 2, SEEK_SET);
+	fputc((int)index ^ 0x10, file);
+	fclose(file), file = NULL;
+	
+	evalDamagedSnapshot(path, result, sizeof(result));
+	testSnapshotResult(__func__, __LINE__, "InputError: invalid snapshot", result);
+	
+	// send the first jump of the last snapshot far past its op list, under a matching checksum
+	source = snapshotTests[sizeof(snapshotTests) / sizeof(*snapshotTests) - 1];
+	Ecc.compileInput(ecc, Input.createFromBytes(source, (uint32_t)strlen(source), "snapshot"), path, 0);
+	
+	file = fopen(path, "r+b");
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	rewind(file);
+	bytes = malloc(length);
+	length = fread(bytes, 1, length, file);
+	
+	for (index = 0; index + 9 < length; ++index)
+		if (bytes[index] == (Op.toIndex(Op.jump) & 0xff) && bytes[index + 1] == Op.toIndex(Op.jump) >> 8 && bytes[index + 2] == Value(integerType))
+		{
+			bytes[index + 8] = 0x40;
+			break;
+		}
+	
+	for (checksum = 2166136261u, index = 0; index < length - 4; ++index)
+		checksum = (checksum ^ bytes[index]) * 16777619u;
+	
+	for (index = 0; index < 4; ++index)
+		bytes[length - 4 + index] = checksum >> (index * 8);
+	
+	rewind(file);
+	fwrite(bytes, 1, length, file);
+	fclose(file), file = NULL;
+	free(bytes), bytes = NULL;
+	
+	evalDamagedSnapshot(path, result, sizeof(result));
+	testSnapshotResult(__func__, __LINE__, "InputError: invalid snapshot", result);
+	
+	remove(path);
+}
+
+#if THREADS
+
+// each thread runs its own runtime: no state is shared with the main one
+
+struct Thread {
+	pthread_t thread;
+	const char *filename;
+	char result[96];
+	int status;
+};
+
+static const char threadTest[] =
+	"var o = this.o = {}, a = [], s = '';"
+	"for (var i = 0; i < 2000; ++i) { o['k' + i] = [i, { v: 'x' + i }]; a[i] = JSON.stringify(o['k' + i]); }"
+	"for (var k in o) if (/^k1\\d$/.test(k)) s += k;"
+	"try { null.x } catch (e) { s += e.name }"
+	"s + a.length + a[1999]";
+
+static const char threadExpect[] = "k10k11k12k13k14k15k16k17k18k19TypeError2000[1999,{\"v\":\"x1999\"}]x7";
+
+static void *runThreadTest (void *data)
+{
+	struct Thread *self = data;
+	struct Ecc *local;
+	int round, length;
+	
+	for (round = 0; round < 5; ++round)
+	{
+		local = Ecc.create();
+		
+		Ecc.evalInput(local, Input.createFromBytes(threadTest, sizeof(threadTest) - 1, "thread"), Ecc(stringResult));
+		length = snprintf(self->result, sizeof(self->result), "%.*s", Value.stringLength(&local->result), Value.stringBytes(&local->result));
+		
+		Ecc.garbageCollect(local);
+		
+		Ecc.evalInput(local, Input.createFromBytes("o.k7[1].v", 9, "thread"), Ecc(stringResult));
+		snprintf(self->result + length, sizeof(self->result) - length, "%.*s", Value.stringLength(&local->result), Value.stringBytes(&local->result));
+		
+		Ecc.destroy(local);
+		
+		if (strcmp(self->result, threadExpect))
+			break;
+	}
+	return NULL;
+}
+
+static void testThreads (void)
+{
+	struct Thread threads[4];
+	int index;
+	
+	for (index = 0; index < 4; ++index)
+		pthread_create(&threads[index].thread, NULL, runThreadTest, &threads[index]);
+	
+	for (index = 0; index < 4; ++index)
+	{
+		pthread_join(threads[index].thread, NULL);
+		++testCount;
+		
+		if (strcmp(threads[index].result, threadExpect))
+		{
+			++testErrorCount;
+			Env.printColor(Env(red), Env(bold), "[failure]");
+			Env.print(" %s:%d - thread %d ", __func__, __LINE__, index);
+			Env.printColor(0, Env(bold), "expect \"%s\" was \"%s\"", threadExpect, threads[index].result);
+			Env.newline();
+		}
+		else if (testVerbosity >= 0)
+		{
+			Env.printColor(Env(green), Env(bold), "[success]");
+			Env.print(" %s:%d - thread %d", __func__, __LINE__, index);
+			Env.newline();
+		}
+	}
+}
+
+static void *runThreadFile (void *data)
+{
+	struct Thread *self = data;
+	struct Ecc *local = Ecc.create();
+	
+	Ecc.addFunction(local, "alert", alert, -1, 0);
+	Ecc.addFunction(local, "print", print, -1, 0);
+	
+	self->status = Ecc.evalInput(local, Input.createFromFile(self->filename), Ecc(sloppyMode));
+	
+	Ecc.destroy(local);
+	return NULL;
+}
+
+static int runThreads (int count, const char *filename)
+{
+	struct Thread *threads;
+	int index, result = EXIT_SUCCESS;
+	
+	if (count <= 0)
+		return alertUsage();
+	
+	threads = calloc(count, sizeof(*threads));
+	
+	for (index = 0; index < count; ++index)
+	{
+		threads[index].filename = filename;
+		pthread_create(&threads[index].thread, NULL, runThreadFile, &threads[index]);
+	}
+	
+	for (index = 0; index < count; ++index)
+	{
+		pthread_join(threads[index].thread, NULL);
+		if (threads[index].status != EXIT_SUCCESS)
+			result = EXIT_FAILURE;
+	}
+	
+	free(threads), threads = NULL;
+	return result;
+}
+
+#else
+
+static int runThreads (int count, const char *filename)
+{
+	const char error[] = "Usage";
+	Env.printError(sizeof(error)-1, error, "built without THREADS");
+	
+	return EXIT_FAILURE;
+}
+
+#endif
+
 static int runTest (int verbosity)
 {
 	testVerbosity = verbosity;
@@ -1513,6 +2116,13 @@ static int runTest (int verbosity)
 	testString();
 	testRegExp();
 	testJSON();
+	testTypedArray();
+	testGarbageCollect();
+	testInputs();
+	testSnapshot();
+	#if THREADS
+	testThreads();
+	#endif
 	
 	Env.newline();
 	
@@ -37,6 +37,14 @@
 #define             io_libecc_OpList(X) \
                     io_libecc_oplist_## X
 
+#define Snapshot    io_libecc_Snapshot
+#define             io_libecc_Snapshot(X) \
+                    io_libecc_snapshot_## X
+
+#define Bytecode    io_libecc_Bytecode
+#define             io_libecc_Bytecode(X) \
+                    io_libecc_bytecode_## X
+
 #define Date        io_libecc_Date
 #define             io_libecc_Date(X) \
                     io_libecc_date_## X
@@ -117,6 +125,14 @@
 #define             io_libecc_JSON(X) \
                     io_libecc_json_## X
 
+#define ArrayBuffer io_libecc_ArrayBuffer
+#define             io_libecc_ArrayBuffer(X) \
+                    io_libecc_arraybuffer_## X
+
+#define TypedArray  io_libecc_TypedArray
+#define             io_libecc_TypedArray(X) \
+                    io_libecc_typedarray_## X
+
 #define Global      io_libecc_Global
 #define             io_libecc_Global(X) \
                     io_libecc_global_## X
@@ -11,13 +11,42 @@
 
 #include "ecc.h"
 #include "oplist.h"
+#include "bytecode.h"
+#include "jit.h"
 #include "pool.h"
 
 // MARK: - Private
 
-#define nextOp() (++context->ops)->native(context)
+#if FLAT_DISPATCH
+	// an op in tail position hands the next op over to the loop of its caller
+	// instead of calling it: statements run one after the other in a flat loop
+	#define nextOp() dispatchOps((++context->ops, context))
+	#define tailOp() (++context->ops, dispatchValue)
+#else
+	#define nextOp() (++context->ops)->native(context)
+	#define tailOp() nextOp()
+#endif
 #define opValue() (context->ops)->value
 #define opText(O) &(context->ops + O)->text
+#define opCache() &(context->ops)->cache.member
+
+#if FLAT_DISPATCH
+static const struct Value dispatchValue = { .type = Value(dispatchType) };
+
+static inline
+struct Value dispatchOps (struct Context * const context)
+{
+	struct Value value;
+	
+	do
+		value = context->ops->native(context);
+	while (value.type == Value(dispatchType));
+	
+	return value;
+}
+#else
+	#define dispatchOps(context) (context)->ops->native(context)
+#endif
 
 #if DEBUG
 
@@ -44,7 +73,7 @@
 		#endif
 	#endif
 
-static int debug = 0;
+static Ecc(threadlocal) int debug = 0;
 
 extern
 void usage(void)
@@ -95,6 +124,7 @@ struct Value retain (struct Value value)
 	if (value.type >= Value(objectType))
 		++value.data.object->referenceCount;
 	
+	Pool.writeBarrier(value);
 	return value;
 }
 
@@ -147,6 +177,16 @@ int integerWontOverflowNegative(int32_t a, int32_t negative)
 
 // MARK: - Static Members
 
+// ops are numbered in list order, see snapshots
+#define _(X) { #X, X, },
+struct {
+	const char *name;
+	const Native(Function) native;
+} static const functionList[] = {
+	io_libecc_op_List
+};
+#undef _
+
 // MARK: - Methods
 
 struct Op make (const Native(Function) native, struct Value value, struct Text text)
@@ -156,24 +196,62 @@ struct Op make (const Native(Function) native, struct Value value, struct Text t
 
 const char * toChars (const Native(Function) native)
 {
-	#define _(X) { #X, X, },
-	struct {
-		const char *name;
-		const Native(Function) native;
-	} static const functionList[] = {
-		io_libecc_op_List
-	};
-	#undef _
+	int index = toIndex(native);
 	
-	int index;
-	for (index = 0; index < sizeof(functionList); ++index)
-		if (functionList[index].native == native)
-			return functionList[index].name;
+	if (index >= 0)
+		return functionList[index].name;
 	
 	assert(0);
 	return "unknow";
 }
 
+struct Value dispatch (struct Context * const context)
+{
+	return dispatchOps(context);
+}
+
+int toIndex (const Native(Function) native)
+{
+	int index;
+	for (index = 0; index < sizeof(functionList) / sizeof(*functionList); ++index)
+		if (functionList[index].native == native)
+			return index;
+	
+	return -1;
+}
+
+Native(Function) fromIndex (int index)
+{
+	if (index < 0 || index >= sizeof(functionList) / sizeof(*functionList))
+		return NULL;
+	
+	return functionList[index].native;
+}
+
+Native(Function) generic (const Native(Function) native)
+{
+	if (native == addInteger || native == addBinary)
+		return add;
+	else if (native == minusInteger || native == minusBinary)
+		return minus;
+	else if (native == multiplyInteger || native == multiplyBinary)
+		return multiply;
+	else if (native == divideBinary)
+		return divide;
+	else if (native == moduloInteger)
+		return modulo;
+	else if (native == lessInteger)
+		return less;
+	else if (native == lessOrEqualInteger)
+		return lessOrEqual;
+	else if (native == moreInteger)
+		return more;
+	else if (native == moreOrEqualInteger)
+		return moreOrEqual;
+	else
+		return native;
+}
+
 // MARK: call
 
 static
@@ -195,7 +273,7 @@ struct Value replaceRefValue (struct Value *ref, struct Value value)
 }
 
 static inline
-struct Value callOps (struct Context * const context, struct Object *environment)
+struct Value callOps (struct Context * const context, struct Object *environment, struct Function *function)
 {
 	if (context->depth >= context->ecc->maximumCallDepth)
 		Context.rangeError(context, Chars.create("maximum depth exceeded"));
@@ -205,16 +283,22 @@ struct Value callOps (struct Context * const context, struct Object *environment
 //			context->this = Value.object(&context->ecc->global->environment);
 	
 	context->environment = environment;
-	return context->ops->native(context);
+	
+	#if REGISTER_BYTECODE
+	if (function->bytecode)
+		return Bytecode.execute(function->bytecode, context);
+	#endif
+	
+	return dispatchOps(context);
 }
 
 static inline
-struct Value callOpsRelease (struct Context * const context, struct Object *environment)
+struct Value callOpsRelease (struct Context * const context, struct Object *environment, struct Function *function)
 {
 	struct Value result;
 	uint16_t index, count;
 	
-	result = callOps(context, environment);
+	result = callOps(context, environment, function);
 	
 	for (index = 2, count = environment->hashmapCount; index < count; ++index)
 		release(environment->hashmap[index].value);
@@ -340,17 +424,22 @@ struct Value callFunctionArguments (struct Context * const context, enum Context
 	
 	if (function->flags & Function(needHeap))
 	{
-		struct Object *environment = Object.copy(&function->environment);
+		struct Object *environment = Object.copyEnvironment(&function->environment);
 		
 		if (function->flags & Function(needArguments))
 		{
 			struct Object *copy = Arguments.createSized(arguments->elementCount);
+			uint32_t index;
+			
 			memcpy(copy->element, arguments->element, sizeof(*copy->element) * copy->elementCount);
+			for (index = 0; index < copy->elementCount; ++index)
+				retain(copy->element[index].value);
+			
 			arguments = copy;
 		}
 		populateEnvironmentWithArguments(environment, arguments, function->parameterCount);
 		
-		return callOps(&subContext, environment);
+		return callOps(&subContext, environment, function);
 	}
 	else
 	{
@@ -361,7 +450,7 @@ struct Value callFunctionArguments (struct Context * const context, enum Context
 		environment.hashmap = hashmap;
 		populateEnvironmentWithArguments(&environment, arguments, function->parameterCount);
 		
-		return callOpsRelease(&subContext, &environment);
+		return callOpsRelease(&subContext, &environment, function);
 	}
 }
 
@@ -380,7 +469,7 @@ struct Value callFunctionVA (struct Context * const context, enum Context(Offset
 	
 	if (function->flags & Function(needHeap))
 	{
-		struct Object *environment = Object.copy(&function->environment);
+		struct Object *environment = Object.copyEnvironment(&function->environment);
 		
 		if (function->flags & Function(needArguments))
 		{
@@ -395,7 +484,7 @@ struct Value callFunctionVA (struct Context * const context, enum Context(Offset
 		else
 			populateEnvironmentWithVA(environment, function->parameterCount, argumentCount, ap);
 		
-		return callOps(&subContext, environment);
+		return callOps(&subContext, environment, function);
 	}
 	else
 	{
@@ -407,7 +496,7 @@ struct Value callFunctionVA (struct Context * const context, enum Context(Offset
 		
 		populateEnvironmentWithVA(&environment, function->parameterCount, argumentCount, ap);
 		
-		return callOpsRelease(&subContext, &environment);
+		return callOpsRelease(&subContext, &environment, function);
 	}
 }
 
@@ -427,7 +516,7 @@ struct Value callFunction (struct Context * const context, struct Function * con
 	
 	if (function->flags & Function(needHeap))
 	{
-		struct Object *environment = Object.copy(&function->environment);
+		struct Object *environment = Object.copyEnvironment(&function->environment);
 		
 		if (function->flags & Function(needArguments))
 		{
@@ -442,7 +531,7 @@ struct Value callFunction (struct Context * const context, struct Function * con
 		else
 			populateEnvironmentWithOps(context, environment, function->parameterCount, argumentCount);
 		
-		return callOps(&subContext, environment);
+		return callOps(&subContext, environment, function);
 	}
 	else if (function->flags & Function(needArguments))
 	{
@@ -457,7 +546,7 @@ struct Value callFunction (struct Context * const context, struct Function * con
 		arguments.elementCount = argumentCount;
 		populateStackEnvironmentAndArgumentsWithOps(context, &environment, &arguments, function->parameterCount, argumentCount);
 		
-		return callOpsRelease(&subContext, &environment);
+		return callOpsRelease(&subContext, &environment, function);
 	}
 	else
 	{
@@ -468,7 +557,7 @@ struct Value callFunction (struct Context * const context, struct Function * con
 		environment.hashmap = hashmap;
 		populateEnvironmentWithOps(context, &environment, function->parameterCount, argumentCount);
 		
-		return callOpsRelease(&subContext, &environment);
+		return callOpsRelease(&subContext, &environment, function);
 	}
 }
 
@@ -735,7 +824,11 @@ struct Value createLocalRef (struct Context * const context)
 
 struct Value getLocalRefOrNull (struct Context * const context)
 {
-	return Value.reference(localRef(context, opValue().data.key, opText(0), 0));
+	// typeof expects a null reference for undeclared identifiers
+	return (struct Value){
+		.data = { .reference = localRef(context, opValue().data.key, opText(0), 0) },
+		.type = Value(referenceType),
+	};
 }
 
 struct Value getLocalRef (struct Context * const context)
@@ -873,12 +966,13 @@ struct Value getMemberRef (struct Context * const context)
 {
 	const struct Text *text = opText(0);
 	struct Key key = opValue().data.key;
+	struct Object(Cache) *cache = opCache();
 	struct Value object, *ref;
 	
 	prepareObject(context, &object);
 	
 	context->refObject = object.data.object;
-	ref = Object.member(object.data.object, key, Value(asOwn));
+	ref = Object.memberCached(object.data.object, key, Value(asOwn), cache);
 	
 	if (!ref)
 	{
@@ -896,24 +990,30 @@ struct Value getMemberRef (struct Context * const context)
 struct Value getMember (struct Context * const context)
 {
 	struct Key key = opValue().data.key;
+	struct Object(Cache) *cache = opCache();
 	struct Value object;
 	
 	prepareObject(context, &object);
 	
-	return Object.getMember(context, object.data.object, key);
+	return Object.getValue(context, object.data.object, Object.memberCached(object.data.object, key, 0, cache));
 }
 
 struct Value setMember (struct Context * const context)
 {
 	const struct Text *text = opText(0);
 	struct Key key = opValue().data.key;
-	struct Value object, value;
+	struct Object(Cache) *cache = opCache();
+	struct Value object, value, *ref;
 	
 	prepareObject(context, &object);
 	value = retain(nextOp());
+	value.flags = 0;
 	
 	Context.setText(context, text);
-	Object.putMember(context, object.data.object, key, value);
+	if (( ref = Object.memberCached(object.data.object, key, Value(asOwn) | Value(accessor), cache) ))
+		Object.putValue(context, object.data.object, ref, value);
+	else
+		Object.putMember(context, object.data.object, key, value);
 	
 	return value;
 }
@@ -924,12 +1024,13 @@ struct Value callMember (struct Context * const context)
 	int32_t argumentCount = opValue().data.integer;
 	const struct Text *text = &(++context->ops)->text;
 	struct Key key = opValue().data.key;
+	struct Object(Cache) *cache = opCache();
 	struct Value object;
 	
 	prepareObject(context, &object);
 	
 	Context.setText(context, text);
-	return callValue(context, Object.getMember(context, object.data.object, key), object, argumentCount, 0, textCall);
+	return callValue(context, Object.getValue(context, object.data.object, Object.memberCached(object.data.object, key, 0, cache)), object, argumentCount, 0, textCall);
 }
 
 struct Value deleteMember (struct Context * const context)
@@ -968,15 +1069,35 @@ void prepareObjectProperty (struct Context * const context, struct Value *object
 	}
 }
 
-struct Value getPropertyRef (struct Context * const context)
+static inline
+struct TypedArray * typedElement (struct Value object, struct Value property, uint32_t *index)
 {
-	const struct Text *text = opText(1);
-	struct Value object, property;
-	struct Value *ref;
+	struct TypedArray *typed = (struct TypedArray *)object.data.object;
+	double binary;
 	
-	prepareObjectProperty(context, &object, &property);
+	if (!TypedArray.isTypedArray(&typed->object))
+		return NULL;
+	
+	if (property.type == Value(binaryType))
+		binary = property.data.binary;
+	else if (property.type == Value(integerType))
+		binary = property.data.integer;
+	else
+		return NULL;
+	
+	// indices past the end stay here too: they read undefined and ignore writes
+	if (!(binary >= 0 && binary < UINT32_MAX) || binary != (uint32_t)binary)
+		return NULL;
+	
+	*index = binary;
+	return typed;
+}
+
+static
+struct Value * propertyRef (struct Context * const context, const struct Text *text, struct Value object, struct Value property)
+{
+	struct Value *ref;
 	
-	context->refObject = object.data.object;
 	ref = Object.property(object.data.object, property, Value(asOwn));
 	
 	if (!ref)
@@ -989,15 +1110,57 @@ struct Value getPropertyRef (struct Context * const context)
 		ref = Object.addProperty(object.data.object, property, Value(undefined), 0);
 	}
 	
-	return Value.reference(ref);
+	return ref;
+}
+
+struct Value getPropertyRef (struct Context * const context)
+{
+	const struct Text *text = opText(1);
+	struct Value object, property;
+	
+	prepareObjectProperty(context, &object, &property);
+	
+	context->refObject = object.data.object;
+	
+	return Value.reference(propertyRef(context, text, object, property));
+}
+
+// typed elements have no slot of their own: instead of a ref,
+// ops writing to one get its array & index to get & put by index
+static
+struct Value * nextOpRef (struct Context * const context, struct TypedArray **typed, uint32_t *index)
+{
+	const struct Text *text;
+	struct Value object, property;
+	
+	*typed = NULL;
+	
+	if ((context->ops + 1)->native != getPropertyRef)
+		return nextOp().data.reference;
+	
+	text = opText(2);
+	++context->ops;
+	prepareObjectProperty(context, &object, &property);
+	
+	context->refObject = object.data.object;
+	
+	if (( *typed = typedElement(object, property, index) ))
+		return NULL;
+	
+	return propertyRef(context, text, object, property);
 }
 
 struct Value getProperty (struct Context * const context)
 {
 	struct Value object, property;
+	struct TypedArray *typed;
+	uint32_t index;
 	
 	prepareObjectProperty(context, &object, &property);
 	
+	if (( typed = typedElement(object, property, &index) ))
+		return TypedArray.getIndex(typed, index);
+	
 	return Object.getProperty(context, object.data.object, property);
 }
 
@@ -1005,9 +1168,19 @@ struct Value setProperty (struct Context * const context)
 {
 	const struct Text *text = opText(0);
 	struct Value object, property, value;
+	struct TypedArray *typed;
+	uint32_t index;
 	
 	prepareObjectProperty(context, &object, &property);
 	
+	if (( typed = typedElement(object, property, &index) ))
+	{
+		value = nextOp();
+		Context.setText(context, text);
+		TypedArray.putIndex(context, typed, index, value);
+		return value;
+	}
+	
 	value = retain(nextOp());
 	value.flags = 0;
 	
@@ -1372,7 +1545,7 @@ struct Value logicalAnd (struct Context * const context)
 		return value;
 	}
 	else
-		return nextOp();
+		return tailOp();
 }
 
 struct Value logicalOr (struct Context * const context)
@@ -1386,7 +1559,7 @@ struct Value logicalOr (struct Context * const context)
 		return value;
 	}
 	else
-		return nextOp();
+		return tailOp();
 }
 
 struct Value positive (struct Context * const context)
@@ -1419,15 +1592,174 @@ struct Value not (struct Context * const context)
 	return Value.truth(!Value.isTrue(a));
 }
 
+// MARK: specialised
+
+// chosen by the parser when an operand is a number constant: integers keep
+// their type while results fit, numbers of either type skip the conversion
+// calls, and anything else goes the generic way
+
+#define isNumber(value) ((value).type == Value(integerType) || (value).type == Value(binaryType))
+#define toNumber(value) ((value).type == Value(integerType)? (value).data.integer: (value).data.binary)
+
+static
+struct Value integerResult (int64_t result)
+{
+	if (result >= INT32_MIN && result <= INT32_MAX)
+		return Value.integer((int32_t)result);
+	else
+		return Value.binary(result);
+}
+
+#define specialisedCompare(OP, COMPARE) \
+	prepareAB \
+	 \
+	if (a.type == Value(integerType) && b.type == Value(integerType)) \
+		return Value.truth(a.data.integer OP b.data.integer); \
+	else if (isNumber(a) && isNumber(b)) \
+		return Value.truth(toNumber(a) OP toNumber(b)); \
+	else \
+	{ \
+		Context.setTexts(context, text, textAlt); \
+		return COMPARE(context, a, b); \
+	} \
+
+struct Value addInteger (struct Context * const context)
+{
+	prepareAB
+	
+	if (a.type == Value(integerType) && b.type == Value(integerType))
+		return integerResult((int64_t)a.data.integer + b.data.integer);
+	else if (isNumber(a) && isNumber(b))
+		return Value.binary(toNumber(a) + toNumber(b));
+	else
+	{
+		Context.setTexts(context, text, textAlt);
+		return Value.add(context, a, b);
+	}
+}
+
+struct Value minusInteger (struct Context * const context)
+{
+	struct Value a = nextOp();
+	struct Value b = nextOp();
+	if (a.type == Value(integerType) && b.type == Value(integerType))
+		return integerResult((int64_t)a.data.integer - b.data.integer);
+	else if (isNumber(a) && isNumber(b))
+		return Value.binary(toNumber(a) - toNumber(b));
+	else
+		return Value.binary(Value.toBinary(context, a).data.binary - Value.toBinary(context, b).data.binary);
+}
+
+struct Value multiplyInteger (struct Context * const context)
+{
+	struct Value a = nextOp();
+	struct Value b = nextOp();
+	if (a.type == Value(integerType) && b.type == Value(integerType))
+	{
+		int64_t result = (int64_t)a.data.integer * b.data.integer;
+		if (result || (a.data.integer >= 0 && b.data.integer >= 0))
+			return integerResult(result);
+		else
+			return Value.binary(-0.);
+	}
+	else if (isNumber(a) && isNumber(b))
+		return Value.binary(toNumber(a) * toNumber(b));
+	else
+		return Value.binary(Value.toBinary(context, a).data.binary * Value.toBinary(context, b).data.binary);
+}
+
+struct Value moduloInteger (struct Context * const context)
+{
+	struct Value a = nextOp();
+	struct Value b = nextOp();
+	if (a.type == Value(integerType) && b.type == Value(integerType) && a.data.integer >= 0 && b.data.integer > 0)
+		return Value.integer(a.data.integer % b.data.integer);
+	else if (isNumber(a) && isNumber(b))
+		return Value.binary(fmod(toNumber(a), toNumber(b)));
+	else
+		return Value.binary(fmod(Value.toBinary(context, a).data.binary, Value.toBinary(context, b).data.binary));
+}
+
+struct Value lessInteger (struct Context * const context)
+{
+	specialisedCompare(<, Value.less)
+}
+
+struct Value lessOrEqualInteger (struct Context * const context)
+{
+	specialisedCompare(<=, Value.lessOrEqual)
+}
+
+struct Value moreInteger (struct Context * const context)
+{
+	specialisedCompare(>, Value.more)
+}
+
+struct Value moreOrEqualInteger (struct Context * const context)
+{
+	specialisedCompare(>=, Value.moreOrEqual)
+}
+
+struct Value addBinary (struct Context * const context)
+{
+	prepareAB
+	
+	if (isNumber(a) && isNumber(b))
+		return Value.binary(toNumber(a) + toNumber(b));
+	else
+	{
+		Context.setTexts(context, text, textAlt);
+		return Value.add(context, a, b);
+	}
+}
+
+#define specialisedBinary(OP) \
+	struct Value a = nextOp(); \
+	struct Value b = nextOp(); \
+	if (isNumber(a) && isNumber(b)) \
+		return Value.binary(toNumber(a) OP toNumber(b)); \
+	else \
+		return Value.binary(Value.toBinary(context, a).data.binary OP Value.toBinary(context, b).data.binary); \
+
+struct Value minusBinary (struct Context * const context)
+{
+	specialisedBinary(-)
+}
+
+struct Value multiplyBinary (struct Context * const context)
+{
+	specialisedBinary(*)
+}
+
+struct Value divideBinary (struct Context * const context)
+{
+	specialisedBinary(/)
+}
+
+#undef isNumber
+#undef toNumber
+
 // MARK: assignement
 
 #define unaryBinaryOpRef(OP) \
 	struct Object *refObject = context->refObject; \
 	const struct Text *text = opText(0); \
-	struct Value *ref = nextOp().data.reference; \
+	struct TypedArray *typed; \
+	uint32_t index; \
+	struct Value *ref = nextOpRef(context, &typed, &index); \
 	struct Value a; \
 	double result; \
 	 \
+	if (typed) \
+	{ \
+		Context.setText(context, text); \
+		a = Value.toBinary(context, TypedArray.getIndex(typed, index)); \
+		result = OP; \
+		TypedArray.putIndex(context, typed, index, a); \
+		context->refObject = refObject; \
+		return Value.binary(result); \
+	} \
+	 \
 	a = *ref; \
 	if (a.flags & (Value(readonly) | Value(accessor))) \
 	{ \
@@ -1435,6 +1767,7 @@ struct Value not (struct Context * const context)
 		a = Value.toBinary(context, release(Object.getValue(context, context->refObject, ref))); \
 		result = OP; \
 		Object.putValue(context, context->refObject, ref, a); \
+		context->refObject = refObject; \
 		return Value.binary(result); \
 	} \
 	else if (a.type != Value(binaryType)) \
@@ -1468,19 +1801,33 @@ struct Value postDecrementRef (struct Context * const context)
 #define assignOpRef(OP, TYPE, CONV) \
 	struct Object *refObject = context->refObject; \
 	const struct Text *text = opText(0); \
-	struct Value *ref = nextOp().data.reference; \
+	struct TypedArray *typed; \
+	uint32_t index; \
+	struct Value *ref = nextOpRef(context, &typed, &index); \
 	struct Value a, b = nextOp(); \
 	 \
 	if (b.type != TYPE) \
 		b = CONV(context, b); \
 	 \
+	if (typed) \
+	{ \
+		Context.setText(context, text); \
+		a = CONV(context, TypedArray.getIndex(typed, index)); \
+		OP; \
+		TypedArray.putIndex(context, typed, index, a); \
+		context->refObject = refObject; \
+		return a; \
+	} \
+	 \
 	a = *ref; \
 	if (a.flags & (Value(readonly) | Value(accessor))) \
 	{ \
 		Context.setText(context, text); \
 		a = CONV(context, Object.getValue(context, context->refObject, ref)); \
 		OP; \
-		return Object.putValue(context, context->refObject, ref, a); \
+		a = Object.putValue(context, context->refObject, ref, a); \
+		context->refObject = refObject; \
+		return a; \
 	} \
 	else if (a.type != TYPE) \
 		a = CONV(context, release(a)); \
@@ -1497,23 +1844,36 @@ struct Value addAssignRef (struct Context * const context)
 {
 	struct Object *refObject = context->refObject;
 	const struct Text *text = opText(1);
-	struct Value *ref = nextOp().data.reference;
+	struct TypedArray *typed;
+	uint32_t index;
+	struct Value *ref = nextOpRef(context, &typed, &index);
 	const struct Text *textAlt = opText(1);
 	struct Value a, b = nextOp();
 	
 	Context.setTexts(context, text, textAlt);
-
+	
+	if (typed)
+	{
+		a = retain(Value.add(context, TypedArray.getIndex(typed, index), b));
+		TypedArray.putIndex(context, typed, index, a);
+		context->refObject = refObject;
+		return a;
+	}
+	
 	a = *ref;
 	if (a.flags & (Value(readonly) | Value(accessor)))
 	{
 		a = Object.getValue(context, context->refObject, ref);
 		a = retain(Value.add(context, a, b));
-		return Object.putValue(context, context->refObject, ref, a);
+		a = Object.putValue(context, context->refObject, ref, a);
+		context->refObject = refObject;
+		return a;
 	}
 	
 	if (a.type == Value(binaryType) && b.type == Value(binaryType))
 	{
 		a.data.binary += b.data.binary;
+		context->refObject = refObject;
 		return *ref = a;
 	}
 	
@@ -1589,18 +1949,23 @@ struct Value try (struct Context * const context)
 {
 	struct Object *environment = context->environment;
 	struct Object *refObject = context->refObject;
-	const struct Op *end = context->ops + opValue().data.integer;
+	struct Op *end = context->ops + opValue().data.integer;
 	struct Key key;
 	
-	const struct Op * volatile rethrowOps = NULL;
+	struct Op * volatile rethrowOps = NULL;
 	volatile int rethrow = 0, breaker = 0;
 	volatile struct Value value = Value(undefined);
 	struct Value finallyValue;
+	struct Ecc(Handler) handler;
 	uint32_t indices[3];
 	
 	Pool.getIndices(indices);
 	
-	if (!setjmp(*Ecc.pushEnv(context->ecc))) // try
+	handler.previous = context->ecc->handler;
+	handler.envCount = context->ecc->envCount;
+	context->ecc->handler = &handler;
+	
+	if (!Ecc(land)(handler.landing)) // try
 		value = nextOp();
 	else
 	{
@@ -1636,7 +2001,7 @@ struct Value try (struct Context * const context)
 			popEnvironment(context);
 	}
 	
-	Ecc.popEnv(context->ecc);
+	context->ecc->handler = handler.previous;
 	
 	breaker = context->breaker;
 	context->breaker = 0;
@@ -1656,7 +2021,7 @@ struct Value try (struct Context * const context)
 		return value;
 	}
 	else
-		return nextOp();
+		return tailOp();
 }
 
 Ecc(noreturn)
@@ -1684,12 +2049,12 @@ struct Value with (struct Context * const context)
 	if (context->breaker)
 		return value;
 	else
-		return nextOp();
+		return tailOp();
 }
 
 struct Value next (struct Context * const context)
 {
-	return nextOp();
+	return tailOp();
 }
 
 struct Value nextIf (struct Context * const context)
@@ -1699,7 +2064,7 @@ struct Value nextIf (struct Context * const context)
 	if (!Value.isTrue(trapOp(context, 1)))
 		return value;
 	
-	return nextOp();
+	return tailOp();
 }
 
 struct Value autoreleaseExpression (struct Context * const context)
@@ -1710,7 +2075,7 @@ struct Value autoreleaseExpression (struct Context * const context)
 	release(context->ecc->result);
 	context->ecc->result = retain(trapOp(context, 1));
 	Pool.collectUnreferencedFromIndices(indices);
-	return nextOp();
+	return tailOp();
 }
 
 struct Value autoreleaseDiscard (struct Context * const context)
@@ -1720,20 +2085,20 @@ struct Value autoreleaseDiscard (struct Context * const context)
 	Pool.getIndices(indices);
 	trapOp(context, 1);
 	Pool.collectUnreferencedFromIndices(indices);
-	return nextOp();
+	return tailOp();
 }
 
 struct Value expression (struct Context * const context)
 {
 	release(context->ecc->result);
 	context->ecc->result = retain(trapOp(context, 1));
-	return nextOp();
+	return tailOp();
 }
 
 struct Value discard (struct Context * const context)
 {
 	trapOp(context, 1);
-	return nextOp();
+	return tailOp();
 }
 
 struct Value discardN (struct Context * const context)
@@ -1776,14 +2141,14 @@ struct Value discardN (struct Context * const context)
 		case 1:
 			trapOp(context, 1);
 	}
-	return nextOp();
+	return tailOp();
 }
 
 struct Value jump (struct Context * const context)
 {
 	int32_t offset = opValue().data.integer;
 	context->ops += offset;
-	return nextOp();
+	return tailOp();
 }
 
 struct Value jumpIf (struct Context * const context)
@@ -1795,7 +2160,7 @@ struct Value jumpIf (struct Context * const context)
 	if (Value.isTrue(value))
 		context->ops += offset;
 	
-	return nextOp();
+	return tailOp();
 }
 
 struct Value jumpIfNot (struct Context * const context)
@@ -1807,7 +2172,7 @@ struct Value jumpIfNot (struct Context * const context)
 	if (!Value.isTrue(value))
 		context->ops += offset;
 	
-	return nextOp();
+	return tailOp();
 }
 
 struct Value result (struct Context * const context)
@@ -1821,7 +2186,7 @@ struct Value repopulate (struct Context * const context)
 {
 	uint32_t index, count, arguments = opValue().data.integer + 3;
 	int32_t offset = nextOp().data.integer;
-	const struct Op *nextOps = context->ops + offset;
+	struct Op *nextOps = context->ops + offset;
 	
 	{
 		union Object(Hashmap) hashmap[context->environment->hashmapCapacity];
@@ -1859,7 +2224,7 @@ struct Value repopulate (struct Context * const context)
 	}
 	
 	context->ops = nextOps;
-	return nextOp();
+	return tailOp();
 }
 
 struct Value resultVoid (struct Context * const context)
@@ -1872,7 +2237,7 @@ struct Value resultVoid (struct Context * const context)
 struct Value switchOp (struct Context * const context)
 {
 	int32_t offset = opValue().data.integer;
-	const struct Op *nextOps = context->ops + offset;
+	struct Op *nextOps = context->ops + offset;
 	struct Value value, caseValue;
 	const struct Text *text = opText(1);
 	
@@ -1887,6 +2252,9 @@ struct Value switchOp (struct Context * const context)
 		if (Value.isTrue(Value.same(context, value, caseValue)))
 		{
 			offset = nextOp().data.integer;
+			if (offset < 2 || offset > 2 + nextOps[2].value.data.integer)
+				Ecc.fatal("Invalid switch case : %d", offset);
+			
 			context->ops = nextOps + offset;
 			break;
 		}
@@ -1900,7 +2268,7 @@ struct Value switchOp (struct Context * const context)
 	else
 	{
 		context->ops = nextOps + 2 + nextOps[2].value.data.integer;
-		return nextOp();
+		return tailOp();
 	}
 }
 
@@ -1933,9 +2301,9 @@ struct Value breaker (struct Context * const context)
 
 struct Value iterate (struct Context * const context)
 {
-	const struct Op *startOps = context->ops;
-	const struct Op *endOps = startOps;
-	const struct Op *nextOps = startOps + 1;
+	struct Op *startOps = context->ops;
+	struct Op *endOps = startOps;
+	struct Op *nextOps = startOps + 1;
 	struct Value value;
 	int32_t skipOp = opValue().data.integer;
 	
@@ -1946,7 +2314,7 @@ struct Value iterate (struct Context * const context)
 	
 	context->ops = endOps;
 	
-	return nextOp();
+	return tailOp();
 }
 
 static
@@ -1958,11 +2326,12 @@ struct Value iterateIntegerRef (
 	struct Value io_libecc_interface_Unwrap((*valueStep)) (struct Context * const, struct Value, struct Value))
 {
 	struct Object *refObject = context->refObject;
-	const struct Op *endOps = context->ops + opValue().data.integer;
+	struct Op *iterateOps = context->ops;
+	struct Op *endOps = context->ops + opValue().data.integer;
 	struct Value stepValue = nextOp();
 	struct Value *indexRef = nextOp().data.reference;
 	struct Value *countRef = nextOp().data.reference;
-	const struct Op *nextOps = context->ops;
+	struct Op *nextOps = context->ops;
 	struct Value value;
 	
 	if (indexRef->type == Value(binaryType) && indexRef->data.binary >= INT32_MIN && indexRef->data.binary <= INT32_MAX)
@@ -1985,6 +2354,9 @@ struct Value iterateIntegerRef (
 		if (!wontOverflow(countRef->data.integer, step - 1))
 			goto deoptimize;
 		
+		if (context->ecc->jitLoops && Jit.iterate(context, iterateOps, countRef->data.integer))
+			goto done;
+		
 		for (; compareInteger(indexRef->data.integer, countRef->data.integer); indexRef->data.integer += step)
 			stepIteration(value, nextOps, goto done);
 	}
@@ -1998,7 +2370,7 @@ deoptimize:
 done:
 	context->refObject = refObject;
 	context->ops = endOps;
-	return nextOp();
+	return tailOp();
 }
 
 struct Value iterateLessRef (struct Context * const context)
@@ -2021,45 +2393,113 @@ struct Value iterateMoreOrEqualRef (struct Context * const context)
 	return iterateIntegerRef(context, integerMoreOrEqual, integerWontOverflowNegative, Value.moreOrEqual, Value.subtract);
 }
 
+static
+struct Value indexKey (uint32_t index)
+{
+	char buffer[10 + 1];
+	uint8_t length = Chars.writeInteger(buffer, index);
+	
+	// up to seven digits fit in the value itself
+	if (length <= 7)
+		return Value.buffer(buffer, length);
+	else
+		return Value.chars(Chars.createWithBytes(length, buffer));
+}
+
+static
+uint32_t stringExtent (struct Object *object)
+{
+	struct Chars *chars = ((struct String *)object)->value;
+	
+	if (chars->flags & Chars(asciiOnly))
+		return chars->length;
+	else
+		return String.unitIndex(chars->bytes, chars->length, chars->length);
+}
+
+static
+uint32_t elementExtent (struct Object *object)
+{
+	uint32_t extent = object->elementCount < object->elementCapacity? object->elementCount: object->elementCapacity;
+	
+	if (TypedArray.isTypedArray(object))
+		return ((struct TypedArray *)object)->length;
+	else if (object->type == &String(type) && extent < stringExtent(object))
+		return stringExtent(object);
+	else
+		return extent;
+}
+
+static
+int shadowsElement (struct Object *object, struct Object *owner, uint32_t index)
+{
+	for (; object != owner; object = object->prototype)
+		if (index < elementExtent(object))
+			if (TypedArray.isTypedArray(object) || (object->type == &String(type) && index < stringExtent(object)) || object->element[index].value.check == 1)
+				return 1;
+	
+	return 0;
+}
+
+static
+int shadowsMember (struct Object *object, struct Object *owner, struct Key key)
+{
+	for (; object != owner; object = object->prototype)
+		if (object->hashmapCount > 2 && Object.ownSlot(object, key))
+			return 1;
+	
+	return 0;
+}
+
 struct Value iterateInRef (struct Context * const context)
 {
 	struct Object *refObject = context->refObject;
 	struct Value *ref = nextOp().data.reference;
 	struct Value target = nextOp();
 	struct Value value = nextOp(), key;
-	struct Chars(Append) chars;
 	struct Object *object;
-	const struct Op *startOps = context->ops;
-	const struct Op *endOps = startOps + value.data.integer;
-	uint32_t index, count;
+	struct Op *startOps = context->ops;
+	struct Op *endOps = startOps + value.data.integer;
+	uint32_t index, count, reach;
+	int typed, nearerMembers;
 	
 	if (Value.isObject(target))
 	{
+		// properties nearer in the chain hide those of prototypes:
+		// only indices below `reach`, or members when a nearer object has some, need a lookup
+		
 		object = target.data.object;
+		reach = 0;
 		do
 		{
-			count = object->elementCount < object->elementCapacity? object->elementCount : object->elementCapacity;
-			for (index = 0; index < count; ++index)
+			typed = TypedArray.isTypedArray(object);
+			count = typed? ((struct TypedArray *)object)->length: 0;
+			
+			for (index = 0; typed? index < count: index < object->elementCount && index < object->elementCapacity; ++index)
 			{
-				union Object(Element) *element = object->element + index;
-				
-				if (element->value.check != 1 || (element->value.flags & Value(hidden)))
-					continue;
+				if (!typed)
+				{
+					union Object(Element) *element = object->element + index;
+					
+					if (element->value.check != 1 || (element->value.flags & Value(hidden)))
+						continue;
+				}
 				
-				if (object != target.data.object && &element->value != Object.element(target.data.object, index, 0))
+				if (index < reach && shadowsElement(target.data.object, object, index))
 					continue;
 				
-				Chars.beginAppend(&chars);
-				Chars.append(&chars, "%d", index);
-				key = Chars.endAppend(&chars);
-				replaceRefValue(ref, key);
+				replaceRefValue(ref, indexKey(index));
 				
 				stepIteration(value, startOps, break);
 			}
+			
+			if (reach < elementExtent(object))
+				reach = elementExtent(object);
 		}
 		while (( object = object->prototype ));
 		
 		object = target.data.object;
+		nearerMembers = 0;
 		do
 		{
 			count = object->hashmapCount;
@@ -2067,10 +2507,11 @@ struct Value iterateInRef (struct Context * const context)
 			{
 				union Object(Hashmap) *hashmap = object->hashmap + index;
 				
-				if (hashmap->value.check != 1 || (hashmap->value.flags & Value(hidden)))
+				// deleted members leave their slot behind, keyless
+				if (hashmap->value.check != 1 || (hashmap->value.flags & Value(hidden)) || Key.isEqual(hashmap->value.key, Key(none)))
 					continue;
 				
-				if (object != target.data.object && &hashmap->value != Object.member(target.data.object, hashmap->value.key, 0))
+				if (nearerMembers && shadowsMember(target.data.object, object, hashmap->value.key))
 					continue;
 				
 				key = Value.text(Key.textOf(hashmap->value.key));
@@ -2078,11 +2519,14 @@ struct Value iterateInRef (struct Context * const context)
 				
 				stepIteration(value, startOps, break);
 			}
+			
+			if (object->hashmapCount > 2)
+				nearerMembers = 1;
 		}
 		while (( object = object->prototype ));
 	}
 	
 	context->refObject = refObject;
 	context->ops = endOps;
-	return nextOp();
+	return tailOp();
 }
@@ -16,6 +16,22 @@
 #define io_libecc_op_h
 
 	#include "builtin/function.h"
+	
+	enum Op(LoopStatus)
+	{
+		Op(unknownLoop) = 0,
+		Op(compiledLoop),
+		Op(rejectedLoop),
+	};
+	
+	// state of a counted loop kept by its iterate op, see Jit.iterate
+	struct Op(Loop)
+	{
+		uint16_t jit;
+		uint8_t status;
+		uint8_t misses;
+		uint32_t iterations;
+	};
 
 	#define io_libecc_op_List \
 		\
@@ -90,6 +106,18 @@
 		_( negative )\
 		_( invert )\
 		_( not )\
+		_( addInteger )\
+		_( minusInteger )\
+		_( multiplyInteger )\
+		_( moduloInteger )\
+		_( lessInteger )\
+		_( lessOrEqualInteger )\
+		_( moreInteger )\
+		_( moreOrEqualInteger )\
+		_( addBinary )\
+		_( minusBinary )\
+		_( multiplyBinary )\
+		_( divideBinary )\
 		_( construct )\
 		_( call )\
 		_( eval )\
@@ -146,6 +174,10 @@ Interface(Op,
 	
 	(struct Op, make ,(const Native(Function) native, struct Value value, struct Text text))
 	(const char *, toChars ,(const Native(Function) native))
+	(int, toIndex ,(const Native(Function) native))
+	(Native(Function), fromIndex ,(int index))
+	(Native(Function), generic ,(const Native(Function) native))
+	(struct Value, dispatch ,(struct Context * const))
 	
 	(struct Value, callFunctionArguments ,(struct Context * const, enum Context(Offset), struct Function *function, struct Value this, struct Object *arguments))
 	(struct Value, callFunctionVA ,(struct Context * const, enum Context(Offset), struct Function *function, struct Value this, int argumentCount, va_list ap))
@@ -156,6 +188,10 @@ Interface(Op,
 		Native(Function) native;
 		struct Value value;
 		struct Text text;
+		union {
+			struct Object(Cache) member;
+			struct Op(Loop) loop;
+		} cache;
 	}
 )
 #undef _
@@ -8,6 +8,8 @@
 
 #define Implementation
 #include "oplist.h"
+#include "bytecode.h"
+#include "jit.h"
 
 // MARK: - Private
 
@@ -28,6 +30,7 @@ void destroy (struct OpList * self)
 {
 	assert(self);
 	
+	Jit.forget(self->ops, self->count);
 	free(self->ops), self->ops = NULL;
 	free(self), self = NULL;
 }
@@ -161,8 +164,8 @@ struct OpList * createLoop (struct OpList * initial, struct OpList * condition,
 	if (condition && step && condition->count == 3 && !reverseCondition)
 	{
 		if (condition->ops[1].native == Op.getLocal && (
-			condition->ops[0].native == Op.less ||
-			condition->ops[0].native == Op.lessOrEqual ))
+			Op.generic(condition->ops[0].native) == Op.less ||
+			Op.generic(condition->ops[0].native) == Op.lessOrEqual ))
 			if (step->count >= 2 && step->ops[1].value.data.key.data.integer == condition->ops[1].value.data.key.data.integer)
 			{
 				struct Value stepValue;
@@ -182,15 +185,15 @@ struct OpList * createLoop (struct OpList * initial, struct OpList * condition,
 				
 				body = OpList.appendNoop(OpList.unshift(Op.make(Op.getLocalRef, condition->ops[1].value, condition->ops[1].text), body));
 				body = OpList.unshift(Op.make(Op.value, stepValue, condition->ops[0].text), body);
-				body = OpList.unshift(Op.make(condition->ops[0].native == Op.less? Op.iterateLessRef: Op.iterateLessOrEqualRef, Value.integer(body->count), condition->ops[0].text), body);
+				body = OpList.unshift(Op.make(Op.generic(condition->ops[0].native) == Op.less? Op.iterateLessRef: Op.iterateLessOrEqualRef, Value.integer(body->count), condition->ops[0].text), body);
 				OpList.destroy(condition), condition = NULL;
 				OpList.destroy(step), step = NULL;
 				return OpList.join(initial, body);
 			}
 		
 		if (condition->ops[1].native == Op.getLocal && (
-			condition->ops[0].native == Op.more ||
-			condition->ops[0].native == Op.moreOrEqual ))
+			Op.generic(condition->ops[0].native) == Op.more ||
+			Op.generic(condition->ops[0].native) == Op.moreOrEqual ))
 			if (step->count >= 2 && step->ops[1].value.data.key.data.integer == condition->ops[1].value.data.key.data.integer)
 			{
 				struct Value stepValue;
@@ -210,7 +213,7 @@ struct OpList * createLoop (struct OpList * initial, struct OpList * condition,
 				
 				body = OpList.appendNoop(OpList.unshift(Op.make(Op.getLocalRef, condition->ops[1].value, condition->ops[1].text), body));
 				body = OpList.unshift(Op.make(Op.value, stepValue, condition->ops[0].text), body);
-				body = OpList.unshift(Op.make(condition->ops[0].native == Op.more? Op.iterateMoreRef: Op.iterateMoreOrEqualRef, Value.integer(body->count), condition->ops[0].text), body);
+				body = OpList.unshift(Op.make(Op.generic(condition->ops[0].native) == Op.more? Op.iterateMoreRef: Op.iterateMoreOrEqualRef, Value.integer(body->count), condition->ops[0].text), body);
 				OpList.destroy(condition), condition = NULL;
 				OpList.destroy(step), step = NULL;
 				return OpList.join(initial, body);
@@ -266,8 +269,14 @@ void optimizeWithEnvironment (struct OpList *self, struct Object *environment, u
 		
 		if (self->ops[index].native == Op.function)
 		{
+			struct Function *function = self->ops[index].value.data.function;
 			uint32_t selfIndex = index && self->ops[index - 1].native == Op.setLocalSlot? self->ops[index - 1].value.data.integer: 0;
-			optimizeWithEnvironment(self->ops[index].value.data.function->oplist, &self->ops[index].value.data.function->environment, selfIndex);
+			optimizeWithEnvironment(function->oplist, &function->environment, selfIndex);
+			
+			#if REGISTER_BYTECODE
+			if (!function->bytecode)
+				function->bytecode = Bytecode.create(function->oplist);
+			#endif
 		}
 		
 		if (self->ops[index].native == Op.pushEnvironment)
@@ -295,50 +304,44 @@ void optimizeWithEnvironment (struct OpList *self, struct Object *environment, u
 			level = environmentLevel;
 			do
 			{
-				for (slot = searchEnvironment->hashmapCount; slot--;)
+				if (( slot = Object.ownSlot(searchEnvironment, self->ops[index].value.data.key) ))
 				{
-					if (searchEnvironment->hashmap[slot].value.check == 1)
+					if (!level)
+					{
+						self->ops[index] = Op.make(
+							self->ops[index].native == Op.createLocalRef? Op.getLocalSlotRef:
+							self->ops[index].native == Op.getLocalRefOrNull? Op.getLocalSlotRef:
+							self->ops[index].native == Op.getLocalRef? Op.getLocalSlotRef:
+							self->ops[index].native == Op.getLocal? Op.getLocalSlot:
+							self->ops[index].native == Op.setLocal? Op.setLocalSlot:
+							self->ops[index].native == Op.deleteLocal? Op.deleteLocalSlot: NULL
+							, Value.integer(slot), self->ops[index].text);
+					}
+					else if (slot <= INT16_MAX && level <= INT16_MAX)
+					{
+						self->ops[index] = Op.make(
+							self->ops[index].native == Op.createLocalRef? Op.getParentSlotRef:
+							self->ops[index].native == Op.getLocalRefOrNull? Op.getParentSlotRef:
+							self->ops[index].native == Op.getLocalRef? Op.getParentSlotRef:
+							self->ops[index].native == Op.getLocal? Op.getParentSlot:
+							self->ops[index].native == Op.setLocal? Op.setParentSlot:
+							self->ops[index].native == Op.deleteLocal? Op.deleteParentSlot: NULL
+							, Value.integer((level << 16) | slot), self->ops[index].text);
+					}
+					else
+						goto notfound;
+					
+					if (index > 1 && level == 1 && slot == selfIndex)
 					{
-						if (Key.isEqual(searchEnvironment->hashmap[slot].value.key, self->ops[index].value.data.key))
+						struct Op op = self->ops[index - 1];
+						if (op.native == Op.call && self->ops[index - 2].native == Op.result)
 						{
-							if (!level)
-							{
-								self->ops[index] = Op.make(
-									self->ops[index].native == Op.createLocalRef? Op.getLocalSlotRef:
-									self->ops[index].native == Op.getLocalRefOrNull? Op.getLocalSlotRef:
-									self->ops[index].native == Op.getLocalRef? Op.getLocalSlotRef:
-									self->ops[index].native == Op.getLocal? Op.getLocalSlot:
-									self->ops[index].native == Op.setLocal? Op.setLocalSlot:
-									self->ops[index].native == Op.deleteLocal? Op.deleteLocalSlot: NULL
-									, Value.integer(slot), self->ops[index].text);
-							}
-							else if (slot <= INT16_MAX && level <= INT16_MAX)
-							{
-								self->ops[index] = Op.make(
-									self->ops[index].native == Op.createLocalRef? Op.getParentSlotRef:
-									self->ops[index].native == Op.getLocalRefOrNull? Op.getParentSlotRef:
-									self->ops[index].native == Op.getLocalRef? Op.getParentSlotRef:
-									self->ops[index].native == Op.getLocal? Op.getParentSlot:
-									self->ops[index].native == Op.setLocal? Op.setParentSlot:
-									self->ops[index].native == Op.deleteLocal? Op.deleteParentSlot: NULL
-									, Value.integer((level << 16) | slot), self->ops[index].text);
-							}
-							else
-								goto notfound;
-							
-							if (index > 1 && level == 1 && slot == selfIndex)
-							{
-								struct Op op = self->ops[index - 1];
-								if (op.native == Op.call && self->ops[index - 2].native == Op.result)
-								{
-									self->ops[index - 1] = Op.make(Op.repopulate, op.value, op.text);
-									self->ops[index] = Op.make(Op.value, Value.integer(-index - 1), self->ops[index].text);
-								}
-							}
-							
-							goto found;
+							self->ops[index - 1] = Op.make(Op.repopulate, op.value, op.text);
+							self->ops[index] = Op.make(Op.value, Value.integer(-index - 1), self->ops[index].text);
 						}
 					}
+					
+					goto found;
 				}
 				
 				++level;
@@ -388,6 +391,16 @@ void dumpTo (struct OpList *self, FILE *file)
 		if (self->ops[i].text.length)
 			fprintf(file, "  `%.*s`", (int)self->ops[i].text.length, self->ops[i].text.bytes);
 		
+		if (self->ops[i].native == Op.iterateLessRef || self->ops[i].native == Op.iterateLessOrEqualRef || self->ops[i].native == Op.iterateMoreRef || self->ops[i].native == Op.iterateMoreOrEqualRef)
+		{
+			if (self->ops[i].cache.loop.status || self->ops[i].cache.loop.iterations)
+				fprintf(file, "  (loop %s, iterations %u, misses %u)", self->ops[i].cache.loop.status == Op(compiledLoop)? "compiled": self->ops[i].cache.loop.status == Op(rejectedLoop)? "rejected": "warming", self->ops[i].cache.loop.iterations, self->ops[i].cache.loop.misses);
+		}
+		#if DEBUG
+		else if (self->ops[i].cache.member.hit || self->ops[i].cache.member.miss)
+			fprintf(file, "  (cache hit %u, miss %u)", self->ops[i].cache.member.hit, self->ops[i].cache.member.miss);
+		#endif
+		
 		fputc('\n', stderr);
 	}
 }
@@ -133,7 +133,7 @@ struct OpList * foldConstant (struct Parser *self, struct OpList * oplist)
 {
 	struct Ecc ecc = { .sloppyMode = self->lexer->allowUnicodeOutsideLiteral };
 	struct Context context = { oplist->ops, .ecc = &ecc };
-	struct Value value = context.ops->native(&context);
+	struct Value value = Op.dispatch(&context);
 	struct Text text = OpList.text(oplist);
 	OpList.destroy(oplist);
 	return OpList.create(Op.value, value, text);
@@ -163,6 +163,54 @@ struct OpList * useInteger (struct Parser *self, struct OpList * oplist)
 	return oplist;
 }
 
+static
+int isNumberConstant (struct OpList * oplist)
+{
+	return oplist->count == 1 && oplist->ops[0].native == Op.value && Value.isNumber(oplist->ops[0].value);
+}
+
+static
+Native(Function) specialise (Native(Function) native, struct OpList * a, struct OpList * b)
+{
+	struct OpList *constant;
+	struct Value value;
+	
+	if (isNumberConstant(a) == isNumberConstant(b))
+		return native;
+	
+	constant = isNumberConstant(a)? a: b;
+	value = constant->ops[0].value;
+	
+	if (native != Op.divide && (value.type == Value(integerType) || (value.data.binary >= INT32_MIN && value.data.binary <= INT32_MAX && value.data.binary == (int32_t)value.data.binary && !signbit(value.data.binary))))
+	{
+		Native(Function) specialised =
+			native == Op.add? Op.addInteger:
+			native == Op.minus? Op.minusInteger:
+			native == Op.multiply? Op.multiplyInteger:
+			native == Op.modulo? Op.moduloInteger:
+			native == Op.less? Op.lessInteger:
+			native == Op.lessOrEqual? Op.lessOrEqualInteger:
+			native == Op.more? Op.moreInteger:
+			native == Op.moreOrEqual? Op.moreOrEqualInteger:
+			NULL;
+		
+		if (specialised)
+		{
+			if (value.type != Value(integerType))
+				constant->ops[0].value = Value.integer(value.data.binary);
+			
+			return specialised;
+		}
+	}
+	
+	return
+		native == Op.add? Op.addBinary:
+		native == Op.minus? Op.minusBinary:
+		native == Op.multiply? Op.multiplyBinary:
+		native == Op.divide? Op.divideBinary:
+		native;
+}
+
 static
 struct OpList * expressionRef (struct Parser *self, struct OpList *oplist, const char *name)
 {
@@ -294,12 +342,12 @@ struct OpList * propertyAssignment (struct Parser *self)
 	}
 	else if (previewToken(self) == Lexer(escapedStringToken))
 	{
-		struct Text text = Text.make(self->lexer->value.data.chars->bytes, self->lexer->value.data.chars->length);
+		struct Text text = Value.textOf(&self->lexer->value);
 		uint32_t element = Lexer.scanElement(text);
 		if (element < UINT32_MAX)
 			oplist = OpList.create(Op.value, Value.integer(element), self->lexer->text);
 		else
-			oplist = OpList.create(Op.value, Value.key(Key.makeWithText(*self->lexer->value.data.text, 0)), self->lexer->text);
+			oplist = OpList.create(Op.value, Value.key(Key.makeWithText(text, self->lexer->value.type != Value(charsType))), self->lexer->text);
 	}
 	else if (previewToken(self) == Lexer(identifierToken))
 		oplist = OpList.create(Op.value, self->lexer->value, self->lexer->text);
@@ -548,7 +596,10 @@ struct OpList * leftHandSide (struct Parser *self)
 			text = Text.join(Text.join(text, OpList.text(oplist)), self->lexer->text);
 			
 			if (isEval)
+			{
 				oplist = OpList.unshift(Op.make(Op.eval, Value.integer(count), text), oplist);
+				++self->directEvals;
+			}
 			else if (oplist->ops->native == Op.getMember)
 				oplist = OpList.unshift(Op.make(Op.callMember, Value.integer(count), text), oplist);
 			else if (oplist->ops->native == Op.getProperty)
@@ -668,6 +719,7 @@ struct OpList * multiplicative (struct Parser *self)
 			if ((alt = useBinary(self, unary(self), 0)))
 			{
 				struct Text text = Text.join(oplist->ops->text, alt->ops->text);
+				native = specialise(native, oplist, alt);
 				oplist = OpList.unshiftJoin(Op.make(native, Value(undefined), text), oplist, alt);
 				
 				if (oplist->ops[1].native == Op.value && oplist->ops[2].native == Op.value)
@@ -702,6 +754,7 @@ struct OpList * additive (struct Parser *self)
 			if ((alt = useBinary(self, multiplicative(self), native == Op.add)))
 			{
 				struct Text text = Text.join(oplist->ops->text, alt->ops->text);
+				native = specialise(native, oplist, alt);
 				oplist = OpList.unshiftJoin(Op.make(native, Value(undefined), text), oplist, alt);
 				
 				if (oplist->ops[1].native == Op.value && oplist->ops[2].native == Op.value)
@@ -780,6 +833,7 @@ struct OpList * relational (struct Parser *self, int noIn)
 			if ((alt = shift(self)))
 			{
 				struct Text text = Text.join(oplist->ops->text, alt->ops->text);
+				native = specialise(native, oplist, alt);
 				oplist = OpList.unshiftJoin(Op.make(native, Value(undefined), text), oplist, alt);
 				
 				continue;
@@ -1131,7 +1185,10 @@ struct OpList * variableDeclaration (struct Parser *self, int noIn)
 	if (self->function->flags & Function(strictMode) || self->sourceDepth > 1)
 		Object.addMember(&self->function->environment, value.data.key, Value(undefined), Value(sealed));
 	else
+	{
 		Object.addMember(self->global, value.data.key, Value(undefined), Value(sealed));
+		++self->globalDeclarations;
+	}
 	
 	if (acceptToken(self, '='))
 	{
@@ -1537,7 +1594,7 @@ struct OpList * allStatement (struct Parser *self)
 		if (oplist->ops[0].native == Op.getLocal && oplist->count == 1 && acceptToken(self, ':'))
 		{
 			pushDepth(self, oplist->ops[0].value.data.key, 0);
-			free(oplist), oplist = NULL;
+			OpList.destroy(oplist), oplist = NULL;
 			oplist = statement(self);
 			popDepth(self);
 			return oplist;
@@ -1674,7 +1731,10 @@ struct OpList * function (struct Parser *self, int isDeclaration, int isGetter,
 		if (self->function->flags & Function(strictMode) || self->sourceDepth > 1)
 			Object.addMember(&parentFunction->environment, identifierOp.value.data.key, Value(undefined), Value(hidden));
 		else
+		{
 			Object.addMember(self->global, identifierOp.value.data.key, Value(undefined), Value(hidden));
+			++self->globalDeclarations;
+		}
 	}
 	else if (identifierOp.value.type != Value(undefinedType) && !isGetter && !isSetter)
 	{
@@ -1767,6 +1827,8 @@ struct Function * parseWithEnvironment (struct Parser * const self, struct Objec
 	self->function = function;
 	self->global = global;
 	self->reserveGlobalSlots = 0;
+	self->globalDeclarations = 0;
+	self->directEvals = 0;
 	if (self->strictMode)
 		function->flags |= Function(strictMode);
 	
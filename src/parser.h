@@ -45,6 +45,8 @@ Interface(Parser,
 		int preferInteger;
 		int strictMode;
 		int reserveGlobalSlots;
+		int globalDeclarations;
+		int directEvals;
 	}
 )
 
@@ -9,23 +9,69 @@
 #define Implementation
 #include "pool.h"
 
+#include "builtin/error.h"
+#include "oplist.h"
+
 // MARK: - Private
 
 static void markValue (struct Value value);
 static void cleanupObject(struct Object *object);
 
-static struct Pool *self = NULL;
+static Ecc(threadlocal) struct Pool *self = NULL;
+
+enum {
+	// small blocks are bumped out of chunks and recycled by size class;
+	// they do not move, so blocks surviving their first collection simply stay in place,
+	// and a chunk goes back to malloc once a collection finds all its blocks free
+	slabGranularity = 16,
+	slabClassCount = 32,
+	slabChunkSize = 64 * 1024,
+	
+	// collected environments are kept whole, listed by hashmap capacity
+	environmentClassCount = slabGranularity * slabClassCount / sizeof(union Object(Hashmap)) + 1,
+	environmentListLimit = 16,
+};
+
+const size_t Pool(slabLimit) = slabGranularity * slabClassCount;
+
+static Ecc(threadlocal) void *slabList[slabClassCount];
+static Ecc(threadlocal) struct SlabChunk {
+	char *bytes;
+	uint32_t used;
+	uint32_t free;
+} *slabChunks = NULL;
+static Ecc(threadlocal) uint32_t slabChunkCount = 0;
+static Ecc(threadlocal) char *slabCursor = NULL;
+static Ecc(threadlocal) char *slabEnd = NULL;
+
+static Ecc(threadlocal) struct Object *environmentList[environmentClassCount];
+static Ecc(threadlocal) uint8_t environmentListCount[environmentClassCount];
 
 // MARK: - Static Members
 
 void markObject (struct Object *object)
 {
-	uint32_t index, count;
-	
-	if (object->flags & Object(mark))
+	if (object->flags & (Object(gray) | Object(black)))
 		return;
 	
-	object->flags |= Object(mark);
+	object->flags |= Object(gray);
+	
+	if (self->grayCount >= self->grayCapacity)
+	{
+		self->grayCapacity = self->grayCapacity? self->grayCapacity * 2: 64;
+		self->grayList = realloc(self->grayList, self->grayCapacity * sizeof(*self->grayList));
+	}
+	
+	self->grayList[self->grayCount++] = object;
+}
+
+static
+void scanObject (struct Object *object)
+{
+	uint32_t index, count;
+	
+	object->flags &= ~Object(gray);
+	object->flags |= Object(black);
 	
 	if (object->prototype)
 		markObject(object->prototype);
@@ -36,19 +82,156 @@ void markObject (struct Object *object)
 	
 	for (index = 2, count = object->hashmapCount; index < count; ++index)
 		if (object->hashmap[index].value.check == 1)
+		{
+			Key.mark(object->hashmap[index].value.key);
 			markValue(object->hashmap[index].value);
+		}
 	
 	if (object->type->mark)
 		object->type->mark(object);
 }
 
+static
+void rescanFresh (void)
+{
+	uint32_t index, count;
+	
+	// objects created while marking got no barrier on their initial content: scan them once more
+	
+	for (index = 0, count = self->functionCount; index < count; ++index)
+		if (self->functionList[index]->object.flags & Object(fresh))
+		{
+			self->functionList[index]->object.flags &= ~Object(fresh);
+			self->functionList[index]->environment.flags &= ~Object(fresh);
+			markObject(&self->functionList[index]->object);
+			markObject(&self->functionList[index]->environment);
+		}
+	
+	for (index = 0, count = self->objectCount; index < count; ++index)
+		if (self->objectList[index]->flags & Object(fresh))
+		{
+			self->objectList[index]->flags &= ~Object(fresh);
+			markObject(self->objectList[index]);
+		}
+}
+
 static
 void markChars (struct Chars *chars)
 {
-	if (chars->flags & Chars(mark))
+	while (!(chars->flags & Chars(mark)))
+	{
+		chars->flags |= Chars(mark);
+		
+		if (!(chars->flags & Chars(rope)))
+			break;
+		
+		chars = Chars.ropeLeft(chars);
+	}
+}
+
+static inline
+uint32_t slabClass (size_t size)
+{
+	return (uint32_t)((size + slabGranularity - 1) / slabGranularity) - 1;
+}
+
+static
+int recycleEnvironment (struct Object *object)
+{
+	uint16_t capacity = object->hashmapCapacity;
+	
+	// the object block links the list through its prototype, and keeps its hashmap block
+	
+	if (object->element || object->type->finalize || capacity >= environmentClassCount || environmentListCount[capacity] >= environmentListLimit)
+		return 0;
+	
+	object->prototype = environmentList[capacity];
+	environmentList[capacity] = object;
+	++environmentListCount[capacity];
+	return 1;
+}
+
+static
+int compareChunks (const void *a, const void *b)
+{
+	const char *x = ((const struct SlabChunk *)a)->bytes, *y = ((const struct SlabChunk *)b)->bytes;
+	
+	return x < y? -1: x > y;
+}
+
+static
+struct SlabChunk * chunkOf (const char *block)
+{
+	uint32_t low = 0, high = slabChunkCount, middle;
+	
+	while (low < high)
+	{
+		middle = (low + high) / 2;
+		
+		if (block < slabChunks[middle].bytes)
+			high = middle;
+		else if (block >= slabChunks[middle].bytes + slabChunkSize)
+			low = middle + 1;
+		else
+			return &slabChunks[middle];
+	}
+	return NULL;
+}
+
+static
+void releaseSlabChunks (void)
+{
+	char *current = slabChunkCount? slabChunks[slabChunkCount - 1].bytes: NULL;
+	uint32_t index, count, released = 0;
+	void **link;
+	
+	// a chunk is free when its listed blocks add up to all it handed out;
+	// the one being bumped is kept, as are partly used ones
+	
+	if (slabChunkCount < 2)
 		return;
 	
-	chars->flags |= Chars(mark);
+	slabChunks[slabChunkCount - 1].used = (uint32_t)(slabCursor - current);
+	qsort(slabChunks, slabChunkCount, sizeof(*slabChunks), compareChunks);
+	
+	for (index = 0; index < slabChunkCount; ++index)
+		slabChunks[index].free = 0;
+	
+	for (index = 0; index < slabClassCount; ++index)
+		for (link = slabList[index]; link; link = *link)
+			chunkOf((char *)link)->free += (index + 1) * slabGranularity;
+	
+	for (index = 0; index < slabChunkCount; ++index)
+		if (slabChunks[index].bytes != current && slabChunks[index].free == slabChunks[index].used)
+			slabChunks[index].free = UINT32_MAX, ++released;
+	
+	if (released)
+	{
+		for (index = 0; index < slabClassCount; ++index)
+			for (link = &slabList[index]; *link; )
+				if (chunkOf(*link)->free == UINT32_MAX)
+					*link = *(void **)*link;
+				else
+					link = *link;
+		
+		for (index = 0, count = 0; index < slabChunkCount; ++index)
+			if (slabChunks[index].free == UINT32_MAX)
+				free(slabChunks[index].bytes);
+			else
+				slabChunks[count++] = slabChunks[index];
+		
+		slabChunkCount = count;
+	}
+	
+	// the chunk being bumped stays last
+	for (index = 0; index < slabChunkCount; ++index)
+		if (slabChunks[index].bytes == current)
+		{
+			struct SlabChunk chunk = slabChunks[index];
+			slabChunks[index] = slabChunks[slabChunkCount - 1];
+			slabChunks[slabChunkCount - 1] = chunk;
+			break;
+		}
 }
 
 // MARK: - Methods
@@ -71,8 +254,90 @@ void teardown (void)
 	free(self->functionList), self->functionList = NULL;
 	free(self->objectList), self->objectList = NULL;
 	free(self->charsList), self->charsList = NULL;
+	free(self->grayList), self->grayList = NULL;
 	
 	free(self), self = NULL;
+	
+	while (slabChunkCount)
+		free(slabChunks[--slabChunkCount].bytes);
+	
+	free(slabChunks), slabChunks = NULL;
+	slabCursor = slabEnd = NULL;
+	memset(slabList, 0, sizeof(slabList));
+	memset(environmentList, 0, sizeof(environmentList));
+	memset(environmentListCount, 0, sizeof(environmentListCount));
+}
+
+void * allocate (size_t size)
+{
+	uint32_t index;
+	void *block;
+	
+	if (size > Pool(slabLimit))
+		return malloc(size);
+	
+	if (!size)
+		size = 1;
+	
+	index = slabClass(size);
+	if (( block = slabList[index] ))
+	{
+		slabList[index] = *(void **)block;
+		return block;
+	}
+	
+	size = (index + 1) * slabGranularity;
+	if (slabCursor + size > slabEnd)
+	{
+		if (slabChunkCount)
+			slabChunks[slabChunkCount - 1].used = (uint32_t)(slabCursor - slabChunks[slabChunkCount - 1].bytes);
+		
+		slabChunks = realloc(slabChunks, sizeof(*slabChunks) * (slabChunkCount + 1));
+		slabCursor = slabChunks[slabChunkCount].bytes = malloc(slabChunkSize);
+		slabChunks[slabChunkCount++].used = 0;
+		slabEnd = slabCursor + slabChunkSize;
+	}
+	
+	block = slabCursor;
+	slabCursor += size;
+	return block;
+}
+
+void * reallocate (void *block, size_t size, size_t newSize)
+{
+	void *newBlock;
+	
+	if (!block)
+		return allocate(newSize);
+	
+	if (size > Pool(slabLimit) && newSize > Pool(slabLimit))
+		return realloc(block, newSize);
+	
+	if (size <= Pool(slabLimit) && newSize <= Pool(slabLimit) && size && slabClass(size) == slabClass(newSize))
+		return block;
+	
+	newBlock = allocate(newSize);
+	memcpy(newBlock, block, size < newSize? size: newSize);
+	deallocate(block, size);
+	return newBlock;
+}
+
+void deallocate (void *block, size_t size)
+{
+	uint32_t index;
+	
+	if (!block)
+		return;
+	
+	if (size > Pool(slabLimit))
+	{
+		free(block);
+		return;
+	}
+	
+	index = slabClass(size? size: 1);
+	*(void **)block = slabList[index];
+	slabList[index] = block;
 }
 
 void addFunction (struct Function *function)
@@ -86,6 +351,12 @@ void addFunction (struct Function *function)
 		memset(self->functionList + self->functionCount, 0, sizeof(*self->functionList) * (self->functionCapacity - self->functionCount));
 	}
 	
+	if (self->marking)
+	{
+		function->object.flags |= Object(fresh);
+		function->environment.flags |= Object(fresh);
+	}
+	
 	self->functionList[self->functionCount++] = function;
 }
 
@@ -103,6 +374,9 @@ void addObject (struct Object *object)
 		memset(self->objectList + self->objectCount, 0, sizeof(*self->objectList) * (self->objectCapacity - self->objectCount));
 	}
 	
+	if (self->marking)
+		object->flags |= Object(fresh);
+	
 	self->objectList[self->objectCount++] = object;
 }
 
@@ -117,24 +391,67 @@ void addChars (struct Chars *chars)
 		memset(self->charsList + self->charsCount, 0, sizeof(*self->charsList) * (self->charsCapacity - self->charsCount));
 	}
 	
+	if (self->marking)
+		markChars(chars);
+	
 	self->charsList[self->charsCount++] = chars;
 }
 
+struct Object * reuseEnvironment (uint16_t capacity)
+{
+	struct Object *object;
+	
+	if (capacity >= environmentClassCount || !( object = environmentList[capacity] ))
+		return NULL;
+	
+	environmentList[capacity] = object->prototype;
+	--environmentListCount[capacity];
+	return object;
+}
+
 void unmarkAll (void)
 {
+	const uint8_t colors = Object(gray) | Object(black) | Object(fresh);
 	uint32_t index, count;
 	
 	for (index = 0, count = self->functionCount; index < count; ++index)
 	{
-		self->functionList[index]->object.flags &= ~Object(mark);
-		self->functionList[index]->environment.flags &= ~Object(mark);
+		self->functionList[index]->object.flags &= ~colors;
+		self->functionList[index]->environment.flags &= ~colors;
 	}
 	
 	for (index = 0, count = self->objectCount; index < count; ++index)
-		self->objectList[index]->flags &= ~Object(mark);
+		self->objectList[index]->flags &= ~colors;
 	
 	for (index = 0, count = self->charsCount; index < count; ++index)
 		self->charsList[index]->flags &= ~Chars(mark);
+	
+	self->grayCount = 0;
+	self->marking = 1;
+}
+
+int isMarking (void)
+{
+	return self->marking;
+}
+
+int markStep (uint32_t budget)
+{
+	while (self->grayCount && budget--)
+		scanObject(self->grayList[--self->grayCount]);
+	
+	return !self->grayCount;
+}
+
+void writeBarrier (struct Value value)
+{
+	if (!self->marking)
+		return;
+	
+	if (value.key.data.integer)
+		Key.mark(value.key);
+	
+	markValue(value);
 }
 
 void markValue (struct Value value)
@@ -143,6 +460,10 @@ void markValue (struct Value value)
 		markObject(value.data.object);
 	else if (value.type == Value(charsType))
 		markChars(value.data.chars);
+	else if (value.type == Value(keyType))
+		Key.mark(value.data.key);
+	else if (value.type == Value(textType))
+		Key.markText(value.data.text);
 }
 
 static
@@ -190,15 +511,14 @@ void cleanupObject(struct Object *object)
 	if (object->prototype && object->prototype->referenceCount)
 		--object->prototype->referenceCount;
 	
-	if (object->elementCount)
-		while (object->elementCount--)
-			if ((value = object->element[object->elementCount].value).check == 1)
-				releaseValue(value);
+	// counts stop at zero, an object released by a container is visited again by the collector
+	while (object->elementCount)
+		if ((value = object->element[--object->elementCount].value).check == 1)
+			releaseValue(value);
 	
-	if (object->hashmapCount)
-		while (object->hashmapCount--)
-			if ((value = object->hashmap[object->hashmapCount].value).check == 1)
-				releaseValue(value);
+	while (object->hashmapCount)
+		if ((value = object->hashmap[--object->hashmapCount].value).check == 1)
+			releaseValue(value);
 }
 
 static
@@ -242,11 +562,18 @@ void collectUnmarked (void)
 {
 	uint32_t index;
 	
+	if (self->marking)
+	{
+		rescanFresh();
+		markStep(UINT32_MAX);
+		self->marking = 0;
+	}
+	
 	// finalize & destroy
 	
 	index = self->functionCount;
 	while (index--)
-		if (!(self->functionList[index]->object.flags & Object(mark)) && !(self->functionList[index]->environment.flags & Object(mark)))
+		if (!(self->functionList[index]->object.flags & Object(black)) && !(self->functionList[index]->environment.flags & Object(black)))
 		{
 			Function.destroy(self->functionList[index]);
 			self->functionList[index] = self->functionList[--self->functionCount];
@@ -254,13 +581,19 @@ void collectUnmarked (void)
 	
 	index = self->objectCount;
 	while (index--)
-		if (!(self->objectList[index]->flags & Object(mark)))
+		if (!(self->objectList[index]->flags & Object(black)))
 		{
 			Object.finalize(self->objectList[index]);
 			Object.destroy(self->objectList[index]);
 			self->objectList[index] = self->objectList[--self->objectCount];
 		}
 	
+	// dead ropes drop their hold on surviving left operands before anything is freed
+	index = self->charsCount;
+	while (index--)
+		if ((self->charsList[index]->flags & (Chars(mark) | Chars(rope))) == Chars(rope) && Chars.ropeLeft(self->charsList[index])->flags & Chars(mark))
+			--Chars.ropeLeft(self->charsList[index])->referenceCount;
+	
 	index = self->charsCount;
 	while (index--)
 		if (!(self->charsList[index]->flags & Chars(mark)))
@@ -268,6 +601,8 @@ void collectUnmarked (void)
 			Chars.destroy(self->charsList[index]);
 			self->charsList[index] = self->charsList[--self->charsCount];
 		}
+	
+	releaseSlabChunks();
 }
 
 void collectUnreferencedFromIndices (uint32_t indices[3])
@@ -276,9 +611,11 @@ void collectUnreferencedFromIndices (uint32_t indices[3])
 	
 	// prepare
 	
+	// gray objects are still on the mark stack, they are left to the tracing collector
+	
 	index = self->objectCount;
 	while (index-- > indices[1])
-		if (self->objectList[index]->referenceCount <= 0)
+		if (self->objectList[index]->referenceCount <= 0 && !(self->objectList[index]->flags & Object(gray)))
 			cleanupObject(self->objectList[index]);
 	
 	index = self->objectCount;
@@ -293,7 +630,8 @@ void collectUnreferencedFromIndices (uint32_t indices[3])
 	
 	index = self->functionCount;
 	while (index-- > indices[0])
-		if (!self->functionList[index]->object.referenceCount && !self->functionList[index]->environment.referenceCount)
+		if (!self->functionList[index]->object.referenceCount && !self->functionList[index]->environment.referenceCount
+			&& !((self->functionList[index]->object.flags | self->functionList[index]->environment.flags) & Object(gray)))
 		{
 			Function.destroy(self->functionList[index]);
 			self->functionList[index] = self->functionList[--self->functionCount];
@@ -301,10 +639,13 @@ void collectUnreferencedFromIndices (uint32_t indices[3])
 	
 	index = self->objectCount;
 	while (index-- > indices[1])
-		if (self->objectList[index]->referenceCount <= 0)
+		if (self->objectList[index]->referenceCount <= 0 && !(self->objectList[index]->flags & Object(gray)))
 		{
-			Object.finalize(self->objectList[index]);
-			Object.destroy(self->objectList[index]);
+			if (!(self->objectList[index]->flags & Object(environment)) || !recycleEnvironment(self->objectList[index]))
+			{
+				Object.finalize(self->objectList[index]);
+				Object.destroy(self->objectList[index]);
+			}
 			self->objectList[index] = self->objectList[--self->objectCount];
 		}
 	
@@ -312,6 +653,9 @@ void collectUnreferencedFromIndices (uint32_t indices[3])
 	while (index-- > indices[2])
 		if (self->charsList[index]->referenceCount <= 0)
 		{
+			if (self->charsList[index]->flags & Chars(rope))
+				--Chars.ropeLeft(self->charsList[index])->referenceCount;
+			
 			Chars.destroy(self->charsList[index]);
 			self->charsList[index] = self->charsList[--self->charsCount];
 		}
@@ -343,3 +687,30 @@ void getIndices (uint32_t indices[3])
 	indices[1] = self->objectCount;
 	indices[2] = self->charsCount;
 }
+
+int referencesBytes (const char *bytes, uint32_t length)
+{
+	uint32_t index;
+	
+	// ops of a function are read from the same input as its text, if any
+	
+	for (index = 0; index < self->functionCount; ++index)
+	{
+		const struct Function *function = self->functionList[index];
+		const char *at = function->text.length || !function->oplist? function->text.bytes: function->oplist->ops[0].text.bytes;
+		
+		if (at >= bytes && at < bytes + length)
+			return 1;
+	}
+	
+	for (index = 0; index < self->objectCount; ++index)
+		if (self->objectList[index]->type == &Error(type))
+		{
+			const struct Error *error = (const struct Error *)self->objectList[index];
+			
+			if (error->text.bytes >= bytes && error->text.bytes < bytes + length)
+				return 1;
+		}
+	
+	return 0;
+}
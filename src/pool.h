@@ -17,6 +17,9 @@
 
 	#include "builtin/function.h"
 
+	// blocks up to this size are served by the slab allocator
+	extern const size_t Pool(slabLimit);
+
 #endif
 
 
@@ -25,19 +28,29 @@ Interface(Pool,
 	(void, setup ,(void))
 	(void, teardown ,(void))
 	
+	(void *, allocate ,(size_t size))
+	(void *, reallocate ,(void *, size_t size, size_t newSize))
+	(void, deallocate ,(void *, size_t size))
+	
 	(void, addFunction ,(struct Function *function))
 	(void, addObject ,(struct Object *object))
 	(void, addChars ,(struct Chars *chars))
 	
+	(struct Object *, reuseEnvironment ,(uint16_t capacity))
+	
 	(void, unmarkAll ,(void))
 	(void, markValue ,(struct Value value))
 	(void, markObject ,(struct Object *object))
+	(int, isMarking ,(void))
+	(int, markStep ,(uint32_t budget))
+	(void, writeBarrier ,(struct Value value))
 	
 	(void, collectUnmarked ,(void))
 	(void, collectUnreferencedFromIndices ,(uint32_t indices[3]))
 	(void, unreferenceFromIndices ,(uint32_t indices[3]))
 	
 	(void, getIndices ,(uint32_t indices[3]))
+	(int, referencesBytes ,(const char *bytes, uint32_t length))
 	,
 	{
 		struct Function **functionList;
@@ -51,6 +64,12 @@ Interface(Pool,
 		struct Chars **charsList;
 		uint32_t charsCount;
 		uint32_t charsCapacity;
+		
+		struct Object **grayList;
+		uint32_t grayCount;
+		uint32_t grayCapacity;
+		
+		int marking;
 	}
 )
 
@@ -0,0 +1,736 @@
+//
+//  snapshot.c
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#define Implementation
+#include "snapshot.h"
+
+#if (__unix__ && !__MSDOS__) || (defined(__APPLE__) && defined(__MACH__))
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// MARK: - Private
+
+static const char magic[4] = { 'e', 'c', 'c', 'S' };
+
+enum {
+	// smallest encoded op: native, value header & text
+	opMinimumSize = 2 + 3 + 9,
+	emptyOffset = UINT32_MAX,
+};
+
+struct Writer {
+	FILE *file;
+	struct Input *input;
+	uint32_t checksum;
+	int error;
+};
+
+struct Reader {
+	const char *bytes;
+	const char *end;
+	struct Input *input;
+	int error;
+};
+
+// MARK: - Static Members
+
+static
+uint32_t checksumBytes (uint32_t hash, const char *bytes, uint32_t length)
+{
+	while (length--)
+		hash = (hash ^ (uint8_t)*bytes++) * 16777619u;
+	
+	return hash;
+}
+
+static
+uint32_t opListHash (void)
+{
+	uint32_t hash = 2166136261u;
+	const char *name;
+	int index;
+	
+	// op numbering is only valid with the exact same list
+	
+	for (index = 0; Op.fromIndex(index); ++index)
+	{
+		name = Op.toChars(Op.fromIndex(index));
+		hash = checksumBytes(hash, name, (uint32_t)strlen(name) + 1);
+	}
+	
+	return hash;
+}
+
+static
+int inInput (const struct Input *input, const char *bytes, int32_t length)
+{
+	return length >= 0 && bytes >= input->bytes && bytes + length <= input->bytes + input->length;
+}
+
+// MARK: write
+
+static
+void writeBytes (struct Writer *self, const char *bytes, uint32_t length)
+{
+	self->checksum = checksumBytes(self->checksum, bytes, length);
+	if (length && fwrite(bytes, length, 1, self->file) != 1)
+		self->error = 1;
+}
+
+static
+void writeByte (struct Writer *self, uint8_t byte)
+{
+	writeBytes(self, (const char *)&byte, 1);
+}
+
+static
+void writeUInt16 (struct Writer *self, uint16_t value)
+{
+	writeByte(self, value & 0xff);
+	writeByte(self, value >> 8);
+}
+
+static
+void writeUInt32 (struct Writer *self, uint32_t value)
+{
+	writeUInt16(self, value & 0xffff);
+	writeUInt16(self, value >> 16);
+}
+
+static
+void writeString (struct Writer *self, const char *bytes, uint32_t length)
+{
+	writeUInt32(self, length);
+	writeBytes(self, bytes, length);
+}
+
+static
+void writeText (struct Writer *self, struct Text text)
+{
+	// texts outside of the source (built-in or synthesized) are only spans for messages
+	
+	if (inInput(self->input, text.bytes, text.length))
+	{
+		writeUInt32(self, (uint32_t)(text.bytes - self->input->bytes));
+		writeUInt32(self, text.length);
+	}
+	else
+	{
+		writeUInt32(self, emptyOffset);
+		writeUInt32(self, 0);
+	}
+	writeByte(self, text.flags);
+}
+
+static
+void writeKey (struct Writer *self, struct Key key)
+{
+	const struct Text *text = Key.textOf(key);
+	
+	if (inInput(self->input, text->bytes, text->length))
+	{
+		writeByte(self, 0);
+		writeText(self, *text);
+	}
+	else
+	{
+		writeByte(self, 1);
+		writeString(self, text->bytes, text->length);
+	}
+}
+
+static void writeFunction (struct Writer *self, struct Function *function);
+
+static
+void writeValue (struct Writer *self, struct Value value)
+{
+	uint64_t bits;
+	
+	writeByte(self, (uint8_t)value.type);
+	writeByte(self, value.flags);
+	writeByte(self, (uint8_t)value.check);
+	
+	switch ((enum Value(Type))value.type)
+	{
+		case Value(undefinedType):
+		case Value(nullType):
+		case Value(falseType):
+		case Value(trueType):
+			return;
+		
+		case Value(integerType):
+			writeUInt32(self, (uint32_t)value.data.integer);
+			return;
+		
+		case Value(binaryType):
+			memcpy(&bits, &value.data.binary, sizeof(bits));
+			writeUInt32(self, (uint32_t)bits);
+			writeUInt32(self, (uint32_t)(bits >> 32));
+			return;
+		
+		case Value(keyType):
+			writeKey(self, value.data.key);
+			return;
+		
+		case Value(bufferType):
+			writeBytes(self, value.data.buffer, sizeof(value.data.buffer));
+			return;
+		
+		case Value(charsType):
+			writeString(self, value.data.chars->bytes, value.data.chars->length);
+			return;
+		
+		case Value(functionType):
+			writeFunction(self, value.data.function);
+			return;
+		
+		default:
+			self->error = 1;
+			return;
+	}
+}
+
+static
+void writeFunction (struct Writer *self, struct Function *function)
+{
+	struct Object *environment = &function->environment;
+	uint32_t index, count;
+	int native;
+	
+	writeUInt32(self, function->flags);
+	writeUInt32(self, function->parameterCount);
+	writeText(self, function->text);
+	
+	// environments are packed: slots come first, in declaration order
+	
+	for (count = 0, index = 2; index < environment->hashmapCount; ++index)
+		if (environment->hashmap[index].value.check == 1)
+			++count;
+	
+	writeUInt32(self, count);
+	for (index = 2; index < environment->hashmapCount; ++index)
+		if (environment->hashmap[index].value.check == 1)
+		{
+			struct Value value = environment->hashmap[index].value;
+			writeKey(self, value.key);
+			writeByte(self, value.flags);
+			writeByte(self, value.type == Value(functionType) && value.data.function == function);
+		}
+	
+	writeUInt32(self, function->oplist->count);
+	for (index = 0; index < function->oplist->count; ++index)
+	{
+		if ((native = Op.toIndex(function->oplist->ops[index].native)) < 0)
+			self->error = 1;
+		
+		writeUInt16(self, native);
+		writeValue(self, function->oplist->ops[index].value);
+		writeText(self, function->oplist->ops[index].text);
+	}
+}
+
+// MARK: read
+
+static
+const char * readBytes (struct Reader *self, uint32_t length)
+{
+	const char *bytes = self->bytes;
+	
+	if (self->error || length > self->end - self->bytes)
+	{
+		self->error = 1;
+		return NULL;
+	}
+	
+	self->bytes += length;
+	return bytes;
+}
+
+static
+uint8_t readByte (struct Reader *self)
+{
+	const char *bytes = readBytes(self, 1);
+	return bytes? (uint8_t)bytes[0]: 0;
+}
+
+static
+uint16_t readUInt16 (struct Reader *self)
+{
+	const uint8_t *bytes = (const uint8_t *)readBytes(self, 2);
+	return bytes? bytes[0] | bytes[1] << 8: 0;
+}
+
+static
+uint32_t readUInt32 (struct Reader *self)
+{
+	uint32_t low = readUInt16(self);
+	return low | (uint32_t)readUInt16(self) << 16;
+}
+
+static
+const char * readString (struct Reader *self, uint32_t *length)
+{
+	*length = readUInt32(self);
+	return readBytes(self, *length);
+}
+
+static
+struct Text readText (struct Reader *self)
+{
+	struct Text text = Text(empty);
+	uint32_t offset, length;
+	
+	offset = readUInt32(self);
+	length = readUInt32(self);
+	
+	if (offset != emptyOffset)
+	{
+		if (offset > self->input->length || length > self->input->length - offset)
+			self->error = 1;
+		else
+			text = Text.make(self->input->bytes + offset, length);
+	}
+	
+	text.flags = readByte(self);
+	return text;
+}
+
+static
+struct Key readKey (struct Reader *self)
+{
+	struct Text text;
+	const char *bytes;
+	uint32_t length;
+	
+	if (readByte(self) == 0)
+	{
+		text = readText(self);
+		if (!self->error)
+			return Key.makeWithText(text, 0);
+	}
+	else if (( bytes = readString(self, &length) ))
+		return Key.makeWithText(Text.make(bytes, length), Key(copyOnCreate));
+	
+	return Key(none);
+}
+
+static struct Function * readFunction (struct Reader *self, struct Object *environment);
+
+static
+int validSlot (Native(Function) native, struct Value value, struct Object *environment, uint32_t level)
+{
+	int32_t count = 0;
+	
+	if (native == Op.getParentSlotRef || native == Op.getParentSlot || native == Op.setParentSlot || native == Op.deleteParentSlot)
+		count = value.data.integer >> 16;
+	else if (!(native == Op.getLocalSlotRef || native == Op.getLocalSlot || native == Op.setLocalSlot || native == Op.deleteLocalSlot))
+		return 1;
+	
+	if (value.type != Value(integerType) || value.data.integer < 0)
+		return 0;
+	
+	// inside catch blocks, the first levels are their environments
+	if (count < (int32_t)level)
+		return 0;
+	
+	count -= level;
+	
+	while (count-- && environment)
+		environment = environment->prototype;
+	
+	return environment && (uint32_t)(value.data.integer & 0xffff) < environment->hashmapCount;
+}
+
+static
+int validTarget (const struct OpList *oplist, uint32_t index, int64_t target)
+{
+	// offsets are plain integers, the op they lead to must be in the list
+	
+	return oplist->ops[index].value.type == Value(integerType) && target >= 0 && target < oplist->count;
+}
+
+static
+int validJumps (const struct OpList *oplist)
+{
+	uint32_t index;
+	
+	for (index = 0; index < oplist->count; ++index)
+	{
+		const Native(Function) native = oplist->ops[index].native;
+		const int64_t offset = oplist->ops[index].value.data.integer;
+		
+		// where each op lands once it has added its offset, and moved to the next op
+		
+		if (native == Op.jump
+			|| native == Op.jumpIf
+			|| native == Op.jumpIfNot
+			|| native == Op.logicalAnd
+			|| native == Op.logicalOr
+			|| native == Op.iterateLessRef
+			|| native == Op.iterateLessOrEqualRef
+			|| native == Op.iterateMoreRef
+			|| native == Op.iterateMoreOrEqualRef
+			)
+		{
+			// conditions & operands sit between the op and its offset base: the base is at least the op itself
+			if (!validTarget(oplist, index, index + offset + 1) || (native != Op.jump && !validTarget(oplist, index, index + 1)))
+				return 0;
+		}
+		else if (native == Op.iterate)
+		{
+			if (!validTarget(oplist, index, index + offset + 2))
+				return 0;
+		}
+		else if (native == Op.try)
+		{
+			// finally jump at the end, then the catch key
+			if (!validTarget(oplist, index, index + offset + 2))
+				return 0;
+		}
+		else if (native == Op.switchOp)
+		{
+			// conditions, then the default & the jump past the cases; case offsets are checked when matched
+			if (!validTarget(oplist, index, index + offset + 2) || oplist->ops[index + offset + 2].native != Op.jump)
+				return 0;
+		}
+		else if (native == Op.repopulate)
+		{
+			if (index + 1 >= oplist->count || !validTarget(oplist, index + 1, index + 1 + (int64_t)oplist->ops[index + 1].value.data.integer + 1))
+				return 0;
+		}
+		else if (native == Op.iterateInRef)
+		{
+			// reference, target, then the body count
+			if (index + 3 >= oplist->count)
+				return 0;
+		}
+	}
+	
+	return 1;
+}
+
+static
+struct Value readValue (struct Reader *self, struct Object *environment)
+{
+	struct Value value = Value(undefined);
+	const char *bytes;
+	uint32_t length;
+	uint64_t bits;
+	
+	value.type = (int8_t)readByte(self);
+	value.flags = readByte(self);
+	value.check = readByte(self);
+	
+	switch ((enum Value(Type))value.type)
+	{
+		case Value(undefinedType):
+		case Value(nullType):
+		case Value(falseType):
+		case Value(trueType):
+			break;
+		
+		case Value(integerType):
+			value.data.integer = (int32_t)readUInt32(self);
+			break;
+		
+		case Value(binaryType):
+			bits = readUInt32(self);
+			bits |= (uint64_t)readUInt32(self) << 32;
+			memcpy(&value.data.binary, &bits, sizeof(bits));
+			break;
+		
+		case Value(keyType):
+			value.data.key = readKey(self);
+			break;
+		
+		case Value(bufferType):
+			if (( bytes = readBytes(self, sizeof(value.data.buffer)) ))
+				memcpy(value.data.buffer, bytes, sizeof(value.data.buffer));
+			
+			break;
+		
+		case Value(charsType):
+			if (( bytes = readString(self, &length) ))
+				value.data.chars = Input.attachValue(self->input, Value.chars(Chars.createWithBytes(length, bytes))).data.chars;
+			else
+				value = Value(undefined);
+			
+			break;
+		
+		case Value(functionType):
+			value.data.function = readFunction(self, environment);
+			break;
+		
+		default:
+			self->error = 1;
+			return Value(undefined);
+	}
+	
+	return value;
+}
+
+static
+struct Function * readFunction (struct Reader *self, struct Object *environment)
+{
+	struct Function *function = Function.create(environment);
+	struct OpList *oplist;
+	struct Value value;
+	struct Key key;
+	uint32_t index, count, level = 0;
+	uint8_t flags;
+	
+	function->flags = readUInt32(self);
+	function->parameterCount = readUInt32(self);
+	function->text = readText(self);
+	
+	count = readUInt32(self);
+	for (index = 0; index < count && !self->error; ++index)
+	{
+		key = readKey(self);
+		flags = readByte(self);
+		value = readByte(self)? Value.function(function): Value(undefined);
+		
+		if (!self->error)
+			Object.addMember(&function->environment, key, value, flags);
+	}
+	Object.packValue(&function->environment);
+	
+	Object.addMember(&function->object, Key(length), Value.integer(function->parameterCount), Value(readonly) | Value(hidden) | Value(sealed));
+	
+	count = readUInt32(self);
+	if (count > (self->end - self->bytes) / opMinimumSize)
+		self->error = 1;
+	
+	oplist = malloc(sizeof(*oplist));
+	oplist->ops = malloc(sizeof(*oplist->ops) * (count? count: 1));
+	oplist->count = 0;
+	function->oplist = oplist;
+	
+	for (index = 0; index < count && !self->error; ++index)
+	{
+		Native(Function) native = Op.fromIndex(readUInt16(self));
+		struct Value value = readValue(self, &function->environment);
+		struct Text text = readText(self);
+		
+		if (native == Op.popEnvironment && !level--)
+			self->error = 1;
+		else if (!native || !validSlot(native, value, &function->environment, level))
+			self->error = 1;
+		else
+			oplist->ops[oplist->count++] = Op.make(native, value, text);
+		
+		if (native == Op.pushEnvironment)
+			++level;
+	}
+	
+	if (!self->error && !validJumps(oplist))
+		self->error = 1;
+	
+	if (!oplist->count)
+	{
+		oplist->ops[0] = Op.make(Op.resultVoid, Value(undefined), Text(empty));
+		oplist->count = 1;
+	}
+	
+	return function;
+}
+
+// MARK: - Methods
+
+int writeTo (struct Function *function, struct Object *declarations, struct Input *input, uint32_t flags, FILE *file)
+{
+	struct Writer writer = { file, input, 2166136261u };
+	uint32_t index, count;
+	
+	assert(function);
+	assert(declarations);
+	assert(input);
+	assert(file);
+	
+	writeBytes(&writer, magic, sizeof(magic));
+	writeUInt32(&writer, Snapshot(format));
+	writeUInt32(&writer, opListHash());
+	writeUInt32(&writer, flags);
+	
+	writeString(&writer, input->name, (uint32_t)strlen(input->name));
+	writeString(&writer, input->bytes, input->length);
+	
+	writeUInt32(&writer, input->lineCount);
+	for (index = 0; index <= input->lineCount; ++index)
+		writeUInt32(&writer, input->lines[index]);
+	
+	for (count = 0, index = 2; index < declarations->hashmapCount; ++index)
+		if (declarations->hashmap[index].value.check == 1)
+			++count;
+	
+	writeUInt32(&writer, count);
+	for (index = 2; index < declarations->hashmapCount; ++index)
+		if (declarations->hashmap[index].value.check == 1)
+		{
+			writeKey(&writer, declarations->hashmap[index].value.key);
+			writeByte(&writer, declarations->hashmap[index].value.flags);
+		}
+	
+	writeFunction(&writer, function);
+	
+	// last, so that damaged files are turned down before anything is read
+	writeUInt32(&writer, writer.checksum);
+	
+	return writer.error || ferror(file)? EXIT_FAILURE: EXIT_SUCCESS;
+}
+
+struct Function * readFrom (const char *bytes, uint32_t length, struct Object *global, struct Input **input, uint32_t *flags)
+{
+	struct Reader reader = { bytes, bytes + length };
+	struct Function *function;
+	struct Key *keys = NULL;
+	uint8_t *keyFlags = NULL;
+	const char *name, *source;
+	uint32_t nameLength, sourceLength, index, count;
+	
+	assert(bytes);
+	assert(global);
+	assert(input);
+	assert(flags);
+	
+	*input = NULL;
+	
+	if (length < sizeof(magic) + 4 || memcmp(bytes, magic, sizeof(magic)))
+		return NULL;
+	
+	reader.end -= 4;
+	if (readUInt32(&(struct Reader){ reader.end, bytes + length }) != checksumBytes(2166136261u, bytes, length - 4))
+		return NULL;
+	
+	reader.bytes += sizeof(magic);
+	
+	if (readUInt32(&reader) != Snapshot(format) || readUInt32(&reader) != opListHash())
+		return NULL;
+	
+	*flags = readUInt32(&reader);
+	name = readString(&reader, &nameLength);
+	source = readString(&reader, &sourceLength);
+	if (reader.error)
+		return NULL;
+	
+	// keys & texts of the code point into the input, it belongs to the caller from here
+	
+	*input = reader.input = Input.createFromBytes(source, sourceLength, "%.*s", (int)nameLength, name);
+	
+	count = readUInt32(&reader);
+	if (count >= UINT16_MAX || count > (reader.end - reader.bytes) / 4)
+		return NULL;
+	
+	reader.input->lineCount = count;
+	reader.input->lineCapacity = count + 2;
+	reader.input->lines = realloc(reader.input->lines, sizeof(*reader.input->lines) * reader.input->lineCapacity);
+	for (index = 0; index <= count; ++index)
+		reader.input->lines[index] = readUInt32(&reader);
+	
+	count = readUInt32(&reader);
+	if (count > (reader.end - reader.bytes) / 2)
+		return NULL;
+	
+	keys = malloc(sizeof(*keys) * (count? count: 1));
+	keyFlags = malloc(sizeof(*keyFlags) * (count? count: 1));
+	for (index = 0; index < count; ++index)
+	{
+		keys[index] = readKey(&reader);
+		keyFlags[index] = readByte(&reader);
+	}
+	
+	function = readFunction(&reader, global);
+	
+	if (!reader.error && reader.bytes != reader.end)
+		reader.error = 1;
+	
+	if (!reader.error)
+	{
+		// what the parser would have done with the actual global
+		
+		for (index = 0; index < count; ++index)
+			Object.addMember(global, keys[index], Value(undefined), keyFlags[index]);
+		
+		OpList.optimizeWithEnvironment(function->oplist, &function->environment, 0);
+	}
+	
+	free(keys), keys = NULL;
+	free(keyFlags), keyFlags = NULL;
+	
+	return reader.error? NULL: function;
+}
+
+struct Function * load (const char *filename, struct Object *global, struct Input **input, uint32_t *flags)
+{
+	struct Text inputError = Text(inputErrorName);
+	struct Function *function = NULL;
+	char *bytes;
+	size_t size;
+	
+	assert(filename);
+	
+	*input = NULL;
+
+#if (__unix__ && !__MSDOS__) || (defined(__APPLE__) && defined(__MACH__))
+	{
+		struct stat status;
+		int file = open(filename, O_RDONLY);
+		
+		if (file < 0)
+		{
+			Env.printError(inputError.length, inputError.bytes, "cannot open file '%s'", filename);
+			return NULL;
+		}
+		
+		if (fstat(file, &status) || status.st_size <= 0 || status.st_size > UINT32_MAX
+			|| (bytes = mmap(NULL, size = status.st_size, PROT_READ, MAP_PRIVATE, file, 0)) == MAP_FAILED)
+		{
+			Env.printError(inputError.length, inputError.bytes, "cannot handle file '%s'", filename);
+			close(file);
+			return NULL;
+		}
+		close(file);
+		
+		function = readFrom(bytes, (uint32_t)size, global, input, flags);
+		munmap(bytes, size);
+	}
+#else
+	{
+		long length;
+		FILE *file = fopen(filename, "rb");
+		
+		if (!file)
+		{
+			Env.printError(inputError.length, inputError.bytes, "cannot open file '%s'", filename);
+			return NULL;
+		}
+		
+		if (fseek(file, 0, SEEK_END) || (length = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET))
+		{
+			Env.printError(inputError.length, inputError.bytes, "cannot handle file '%s'", filename);
+			fclose(file);
+			return NULL;
+		}
+		
+		bytes = malloc(length);
+		size = fread(bytes, sizeof(char), length, file);
+		fclose(file), file = NULL;
+		
+		function = readFrom(bytes, (uint32_t)size, global, input, flags);
+		free(bytes), bytes = NULL;
+	}
+#endif
+	
+	if (!function)
+		Env.printError(inputError.length, inputError.bytes, "invalid snapshot '%s'", filename);
+	
+	return function;
+}
@@ -0,0 +1,60 @@
+//
+//  snapshot.h
+//  libecc
+//
+//  Copyright (c) 2019 Aurélien Bouilland
+//  Licensed under MIT license, see LICENSE.txt file in project root
+//
+
+#ifndef io_libecc_snapshot_h
+#ifdef Implementation
+#undef Implementation
+#include __FILE__
+#include "implementation.h"
+#else
+#include "interface.h"
+#define io_libecc_snapshot_h
+
+	#include "oplist.h"
+	#include "input.h"
+
+	// snapshot of parsed top-level code, every integer is stored little-endian:
+	//
+	//   "eccS" u32:format u32:opListHash u32:flags
+	//   name:string source:string u32:lineCount u32[lineCount + 1]:lines
+	//   u32:declarationCount { key u8:flags }[declarationCount]
+	//   function u32:checksum
+	//
+	// function: u32:flags u32:parameterCount text
+	//           u32:slotCount { key u8:flags u8:isSelf }[slotCount]
+	//           u32:opCount { u16:native value text }[opCount]
+	// value:    i8:type u8:flags u8:check, then i32 (integer), u64 (binary),
+	//           u8[8] (buffer), key, string (chars) or function, depending on type
+	// key:      u8:0 text, or u8:1 string
+	// text:     u32:offset u32:length u8:flags, offset 0xffffffff is empty
+	// string:   u32:length bytes
+	//
+	// checksum is FNV-1a over every byte before it
+	//
+	// identifiers are resolved within functions only: references to globals
+	// are bound again on load, so a snapshot works against any global object
+
+	enum Snapshot(Format) {
+		Snapshot(format) = 1,
+	};
+
+#endif
+
+
+Interface(Snapshot,
+	
+	(int, writeTo ,(struct Function *, struct Object *declarations, struct Input *, uint32_t flags, FILE *))
+	(struct Function *, readFrom ,(const char *bytes, uint32_t length, struct Object *global, struct Input **, uint32_t *flags))
+	(struct Function *, load ,(const char *filename, struct Object *global, struct Input **, uint32_t *flags))
+	,
+	{
+		char empty;
+	}
+)
+
+#endif
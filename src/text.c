@@ -47,6 +47,16 @@ textMake(functionType, "[object Function]");
 textMake(argumentsType, "[object Arguments]");
 textMake(mathType, "[object Math]");
 textMake(jsonType, "[object JSON]");
+textMake(arrayBufferType, "[object ArrayBuffer]");
+textMake(int8ArrayType, "[object Int8Array]");
+textMake(uint8ArrayType, "[object Uint8Array]");
+textMake(uint8ClampedArrayType, "[object Uint8ClampedArray]");
+textMake(int16ArrayType, "[object Int16Array]");
+textMake(uint16ArrayType, "[object Uint16Array]");
+textMake(int32ArrayType, "[object Int32Array]");
+textMake(uint32ArrayType, "[object Uint32Array]");
+textMake(float32ArrayType, "[object Float32Array]");
+textMake(float64ArrayType, "[object Float64Array]");
 textMake(globalType, "[object Global]");
 
 textMake(errorName, "Error");
@@ -47,6 +47,16 @@
 	extern const struct Text Text(argumentsType);
 	extern const struct Text Text(mathType);
 	extern const struct Text Text(jsonType);
+	extern const struct Text Text(arrayBufferType);
+	extern const struct Text Text(int8ArrayType);
+	extern const struct Text Text(uint8ArrayType);
+	extern const struct Text Text(uint8ClampedArrayType);
+	extern const struct Text Text(int16ArrayType);
+	extern const struct Text Text(uint16ArrayType);
+	extern const struct Text Text(int32ArrayType);
+	extern const struct Text Text(uint32ArrayType);
+	extern const struct Text Text(float32ArrayType);
+	extern const struct Text Text(float64ArrayType);
 	extern const struct Text Text(globalType);
 
 	extern const struct Text Text(errorName);
@@ -95,6 +105,9 @@ Interface(Text,
 		const char *bytes;
 		int32_t length;
 		uint8_t flags;
+		
+		// chunk of the key pool holding this text, if it is a key's
+		uint16_t keyChunk;
 	}
 )
 
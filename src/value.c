@@ -356,6 +356,7 @@ struct Value toBinary (struct Context * const context, struct Value value)
 			return toBinary(context, toPrimitive(context, value, Value(hintNumber)));
 		
 		case Value(referenceType):
+		case Value(dispatchType):
 			break;
 	}
 	Ecc.fatal("Invalid Value(Type) : %u", value.type);
@@ -453,6 +454,7 @@ struct Value toString (struct Context * const context, struct Value value)
 			return toString(context, toPrimitive(context, value, Value(hintString)));
 		
 		case Value(referenceType):
+		case Value(dispatchType):
 			break;
 	}
 	Ecc.fatal("Invalid Value(Type) : %u", value.type);
@@ -484,7 +486,7 @@ const char * stringBytes (const struct Value *value)
 	switch (value->type)
 	{
 		case Value(charsType):
-			return value->data.chars->bytes;
+			return Chars.flatten(value->data.chars)->bytes;
 			
 		case Value(textType):
 			return value->data.text->bytes;
@@ -505,7 +507,7 @@ struct Text textOf (const struct Value *value)
 	switch (value->type)
 	{
 		case Value(charsType):
-			return Text.make(value->data.chars->bytes, value->data.chars->length);
+			return Text.make(Chars.flatten(value->data.chars)->bytes, value->data.chars->length);
 			
 		case Value(textType):
 			return *value->data.text;
@@ -537,8 +539,12 @@ struct Value toObject (struct Context * const context, struct Value value)
 		case Value(integerType):
 			return number(Number.create(value.data.integer));
 		
-		case Value(textType):
 		case Value(charsType):
+			return string(String.create(Chars.flatten(value.data.chars)));
+			
+		case Value(textType):
+			return string(String.create(String.copyText(value.data.text)));
+			
 		case Value(bufferType):
 			return string(String.create(Chars.createWithBytes(stringLength(&value), stringBytes(&value))));
 			
@@ -554,6 +560,7 @@ struct Value toObject (struct Context * const context, struct Value value)
 		
 		case Value(keyType):
 		case Value(referenceType):
+		case Value(dispatchType):
 		case Value(functionType):
 		case Value(objectType):
 		case Value(errorType):
@@ -600,6 +607,8 @@ struct Value objectValue (struct Object *object)
 			|| object->type == &Array(type)
 			|| object->type == &Arguments(type)
 			|| object->type == &Math(type)
+			|| object->type == &ArrayBuffer(type)
+			|| TypedArray.isTypedArray(object)
 			)
 		return Value.object((struct Object *)object);
 	else
@@ -647,6 +656,7 @@ struct Value toType (struct Value value)
 			return text(&Text(function));
 		
 		case Value(referenceType):
+		case Value(dispatchType):
 			break;
 	}
 	Ecc.fatal("Invalid Value(Type) : %u", value.type);
@@ -728,6 +738,15 @@ struct Value add (struct Context * const context, struct Value a, struct Value b
 		{
 			struct Chars(Append) chars;
 			
+			if (a.type == Value(charsType))
+			{
+				struct Chars *rope;
+				
+				b = toString(context, b);
+				if ((rope = Chars.concatenate(a.data.chars, textOf(&b))))
+					return Value.chars(rope);
+			}
+			
 			Chars.beginAppend(&chars);
 			Chars.appendValue(&chars, context, a);
 			Chars.appendValue(&chars, context, b);
@@ -860,6 +879,7 @@ const char * typeName (enum Value(Type) type)
 			return "regexp";
 			
 		case Value(referenceType):
+		case Value(dispatchType):
 			break;
 	}
 	Ecc.fatal("Invalid Value(Type) : %u", type);
@@ -948,6 +968,9 @@ void dumpTo (struct Value value, FILE *file)
 			fwrite(value.data.function->text.bytes, sizeof(char), value.data.function->text.length, file);
 			return;
 		
+		case Value(dispatchType):
+			return;
+		
 		case Value(referenceType):
 			fputs("-> ", file);
 			dumpTo(*value.data.reference, file);
@@ -56,6 +56,10 @@
 		
 		/* 0100 0110 */ Value(hostType) = 0x46,
 		/* 0100 0111 */ Value(referenceType) = 0x47,
+		
+		/* Internal, outside every mask */
+		
+		/* 0000 0010 */ Value(dispatchType) = 0x02,
 	};
 
 	enum Value(Mask) {